@@ -93,11 +93,15 @@ main (int argc, char *argv[])
   uint32_t runNum = 1;
   bool enableDelay = false;
   bool enableSACK = false;
+  bool enableTimestamps = false;
+  bool useNsc = false;
 
   CommandLine cmd;
   cmd.AddValue("numSources" , "Number of incast sources", nSources);
   cmd.AddValue("enableDelay", "Enable delay messages", enableDelay);
   cmd.AddValue("enableSACK", "Enable TCP Selective Acknowledgements",enableSACK);
+  cmd.AddValue("enableTimestamps", "Enable TCP timestamps",enableTimestamps);
+  cmd.AddValue("useNsc", "Run the sources and the sink on the NSC Linux stack",useNsc);
   cmd.AddValue("runNumber", "Specify Run Number", runNum);
   cmd.Parse(argc,argv);
 
@@ -138,22 +142,28 @@ main (int argc, char *argv[])
   InternetStackHelper stack;
   stack.Install(bottlepair.Get(0));
 
-  InternetStackHelper linstack;
-  linstack.SetTcp("ns3::NscTcpL4Protocol", "Library", StringValue("liblinux2.6.26.so"));
-  for(uint32_t i = 0; i < nSources; i++) {
-    linstack.Install(srcpair[i].Get(0));
-  }
-  linstack.Install(bottlepair.Get(1));
-
-  //Set TCP properties
-  Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_congestion_control", StringValue ("reno"));
-  Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_timestamps",StringValue("0"));
-  Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_no_metrics_save", StringValue ("1"));
-  if(enableSACK) {
-    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_sack", StringValue ("1"));
+  if(useNsc) {
+    InternetStackHelper linstack;
+    linstack.SetTcp("ns3::NscTcpL4Protocol", "Library", StringValue("liblinux2.6.26.so"));
+    for(uint32_t i = 0; i < nSources; i++) {
+      linstack.Install(srcpair[i].Get(0));
+    }
+    linstack.Install(bottlepair.Get(1));
+
+    //Set TCP properties
+    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_congestion_control", StringValue ("reno"));
+    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_timestamps",StringValue(enableTimestamps ? "1" : "0"));
+    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_no_metrics_save", StringValue ("1"));
+    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_sack", StringValue (enableSACK ? "1" : "0"));
   }
   else {
-    Config::Set ("/NodeList/*/$ns3::Ns3NscStack<linux2.6.26>/net.ipv4.tcp_sack", StringValue ("0"));
+    //The native NewReno recovers from several losses per window with SACK
+    Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (enableSACK));
+    Config::SetDefault ("ns3::TcpSocketBase::Timestamp", BooleanValue (enableTimestamps));
+    for(uint32_t i = 0; i < nSources; i++) {
+      stack.Install(srcpair[i].Get(0));
+    }
+    stack.Install(bottlepair.Get(1));
   }
 
   //Create devices
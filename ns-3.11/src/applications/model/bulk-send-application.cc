@@ -27,9 +27,11 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/tcp-socket-factory.h"
 #include "bulk-send-application.h"
+#include "flow-completion-tracker.h"
 
 NS_LOG_COMPONENT_DEFINE ("BulkSendApplication");
 
@@ -63,6 +65,10 @@ BulkSendApplication::GetTypeId (void)
                    TypeIdValue (TcpSocketFactory::GetTypeId ()),
                    MakeTypeIdAccessor (&BulkSendApplication::m_tid),
                    MakeTypeIdChecker ())
+    .AddAttribute ("FlowTracker", "The tracker recording the completion time of the transfer.",
+                   PointerValue (),
+                   MakePointerAccessor (&BulkSendApplication::m_tracker),
+                   MakePointerChecker<FlowCompletionTracker> ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&BulkSendApplication::m_txTrace))
   ;
@@ -103,6 +109,7 @@ BulkSendApplication::DoDispose (void)
   NS_LOG_FUNCTION (this);
 
   m_socket = 0;
+  m_tracker = 0;
   // chain up
   Application::DoDispose ();
 }
@@ -128,6 +135,12 @@ void BulkSendApplication::StartApplication (void) // Called at time specified by
 
       m_socket->Bind ();
       m_socket->Connect (m_peer);
+      if (m_tracker != 0)
+        {
+          Address local;
+          m_socket->GetSockName (local);
+          m_tracker->FlowStarted (local, m_maxBytes);
+        }
       m_socket->ShutdownRecv ();
       m_socket->SetConnectCallback (
         MakeCallback (&BulkSendApplication::ConnectionSucceeded, this),
@@ -148,6 +161,9 @@ void BulkSendApplication::StopApplication (void) // Called at time specified by
   if (m_socket != 0)
     {
       m_socket->Close ();
+      m_socket->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                                    MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
       m_connected = false;
     }
   else
@@ -32,6 +32,7 @@ namespace ns3 {
 class Address;
 class RandomVariable;
 class Socket;
+class FlowCompletionTracker;
 
 /**
  * \ingroup applications
@@ -47,6 +48,9 @@ class Socket;
  * and SOCK_SEQPACKET sockets are supported. 
  * For example, TCP sockets can be used, but 
  * UDP sockets can not be used.
+ *
+ * With a FlowCompletionTracker (attribute FlowTracker), the application
+ * registers its transfer as a flow of MaxBytes bytes when it starts.
  */
 class BulkSendApplication : public Application
 {
@@ -92,6 +96,7 @@ private:
   uint32_t        m_maxBytes;     // Limit total number of bytes sent
   uint32_t        m_totBytes;     // Total bytes sent so far
   TypeId          m_tid;
+  Ptr<FlowCompletionTracker> m_tracker;   // Records the flow, if any
   TracedCallback<Ptr<const Packet> > m_txTrace;
 
 private:
@@ -0,0 +1,326 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/ipv4.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "dc-workload-generator.h"
+#include "flow-send-application.h"
+#include "flow-completion-tracker.h"
+#include "packet-sink.h"
+
+NS_LOG_COMPONENT_DEFINE ("DcWorkloadGenerator");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DcWorkloadGenerator);
+
+//
+// The flow size distributions of the web search workload (DCTCP, Alizadeh
+// et al., SIGCOMM 2010) and of the data mining workload (VL2, Greenberg et
+// al., SIGCOMM 2009), as used by the pFabric simulations: sizes in packets
+// of 1460 bytes and cumulative probabilities.
+//
+static const double g_webSearchCdf[][2] = {
+  { 6, 0 }, { 6, 0.15 }, { 13, 0.2 }, { 19, 0.3 }, { 33, 0.4 }, { 53, 0.53 },
+  { 133, 0.6 }, { 667, 0.7 }, { 1333, 0.8 }, { 3333, 0.9 }, { 6667, 0.97 },
+  { 20000, 1 }
+};
+static const double g_dataMiningCdf[][2] = {
+  { 1, 0 }, { 1, 0.5 }, { 2, 0.6 }, { 3, 0.7 }, { 7, 0.8 }, { 267, 0.9 },
+  { 2107, 0.95 }, { 66667, 0.99 }, { 666667, 1 }
+};
+static const double g_cdfPacketSize = 1460;
+
+TypeId
+DcWorkloadGenerator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DcWorkloadGenerator")
+    .SetParent<Object> ()
+    .AddConstructor<DcWorkloadGenerator> ()
+    .AddAttribute ("Load", "The average load of the access links of the hosts by the background flows.",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&DcWorkloadGenerator::m_load),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LinkRate", "The rate of the access links of the hosts.",
+                   DataRateValue (DataRate ("1Gbps")),
+                   MakeDataRateAccessor (&DcWorkloadGenerator::m_linkRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("Port", "The port of the packet sinks.",
+                   UintegerValue (9000),
+                   MakeUintegerAccessor (&DcWorkloadGenerator::m_port),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("StartTime", "The time at which the first flows may start.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DcWorkloadGenerator::m_startTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("StopTime", "The time after which no flow starts.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&DcWorkloadGenerator::m_stopTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueryInterval", "The mean interval between two queries, zero for no queries.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&DcWorkloadGenerator::m_queryInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueryFanIn", "The number of hosts answering each query.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&DcWorkloadGenerator::m_queryFanIn),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("QueryResponseSize", "The size of the answer of each host to a query.",
+                   UintegerValue (2048),
+                   MakeUintegerAccessor (&DcWorkloadGenerator::m_queryResponseSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FlowTracker", "The tracker recording the completion time of the flows.",
+                   PointerValue (),
+                   MakePointerAccessor (&DcWorkloadGenerator::m_tracker),
+                   MakePointerChecker<FlowCompletionTracker> ())
+  ;
+  return tid;
+}
+
+DcWorkloadGenerator::DcWorkloadGenerator ()
+  : m_interval (1.0),
+    m_nFlows (0),
+    m_nQueries (0)
+{
+  NS_LOG_FUNCTION (this);
+  UseWebSearchCdf ();
+}
+
+DcWorkloadGenerator::~DcWorkloadGenerator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DcWorkloadGenerator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_senders.clear ();
+  m_tracker = 0;
+  Object::DoDispose ();
+}
+
+void
+DcWorkloadGenerator::UseWebSearchCdf (void)
+{
+  std::vector<std::pair<double, double> > cdf;
+  for (uint32_t i = 0; i < sizeof (g_webSearchCdf) / sizeof (g_webSearchCdf[0]); ++i)
+    {
+      cdf.push_back (std::make_pair (g_webSearchCdf[i][0] * g_cdfPacketSize, g_webSearchCdf[i][1]));
+    }
+  SetFlowSizeCdf (cdf);
+}
+
+void
+DcWorkloadGenerator::UseDataMiningCdf (void)
+{
+  std::vector<std::pair<double, double> > cdf;
+  for (uint32_t i = 0; i < sizeof (g_dataMiningCdf) / sizeof (g_dataMiningCdf[0]); ++i)
+    {
+      cdf.push_back (std::make_pair (g_dataMiningCdf[i][0] * g_cdfPacketSize, g_dataMiningCdf[i][1]));
+    }
+  SetFlowSizeCdf (cdf);
+}
+
+void
+DcWorkloadGenerator::SetFlowSizeCdf (const std::vector<std::pair<double, double> > &cdf)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (!cdf.empty (), "Empty flow size distribution");
+  m_cdf = cdf;
+  m_flowSize = EmpiricalVariable ();
+  for (uint32_t i = 0; i < cdf.size (); ++i)
+    {
+      NS_ASSERT_MSG (i == 0 || (cdf[i].first >= cdf[i - 1].first && cdf[i].second >= cdf[i - 1].second),
+                     "The points of the flow size distribution are not in increasing order");
+      m_flowSize.CDF (cdf[i].first, cdf[i].second);
+    }
+}
+
+bool
+DcWorkloadGenerator::LoadFlowSizeCdf (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream is (filename.c_str ());
+  if (!is.good ())
+    {
+      return false;
+    }
+  std::vector<std::pair<double, double> > cdf;
+  std::string line;
+  while (std::getline (is, line))
+    {
+      if (line.empty () || line[0] == '#')
+        {
+          continue;
+        }
+      std::istringstream iss (line);
+      double size;
+      double probability;
+      if (iss >> size >> probability)
+        {
+          cdf.push_back (std::make_pair (size, probability));
+        }
+    }
+  if (cdf.empty ())
+    {
+      return false;
+    }
+  SetFlowSizeCdf (cdf);
+  return true;
+}
+
+double
+DcWorkloadGenerator::GetMeanFlowSize (void) const
+{
+  // The empirical variable interpolates linearly between the points
+  double mean = m_cdf[0].first * m_cdf[0].second;
+  for (uint32_t i = 1; i < m_cdf.size (); ++i)
+    {
+      mean += (m_cdf[i].second - m_cdf[i - 1].second) * (m_cdf[i].first + m_cdf[i - 1].first) / 2;
+    }
+  return mean;
+}
+
+void
+DcWorkloadGenerator::Install (NodeContainer hosts)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_senders.empty (), "The generator is already installed");
+  NS_ASSERT_MSG (hosts.GetN () >= 2, "At least two hosts are needed");
+
+  for (NodeContainer::Iterator i = hosts.Begin (); i != hosts.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      NS_ASSERT_MSG (ipv4 != 0 && ipv4->GetNInterfaces () > 1, "Host " << node->GetId () << " has no IPv4 interface");
+      m_addresses.push_back (ipv4->GetAddress (1, 0).GetLocal ());
+
+      Ptr<PacketSink> sink = CreateObject<PacketSink> ();
+      sink->SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
+      sink->SetAttribute ("Local", AddressValue (InetSocketAddress (Ipv4Address::GetAny (), m_port)));
+      sink->SetAttribute ("FlowTracker", PointerValue (m_tracker));
+      sink->SetStartTime (m_startTime);
+      node->AddApplication (sink);
+
+      Ptr<FlowSendApplication> sender = CreateObject<FlowSendApplication> ();
+      sender->SetAttribute ("FlowTracker", PointerValue (m_tracker));
+      sender->SetStartTime (m_startTime);
+      node->AddApplication (sender);
+      m_senders.push_back (sender);
+    }
+  m_responders.resize (hosts.GetN ());
+
+  if (m_load > 0)
+    {
+      Simulator::Schedule (m_startTime - Simulator::Now (), &DcWorkloadGenerator::ScheduleNextFlow, this);
+    }
+  if (!m_queryInterval.IsZero ())
+    {
+      Simulator::Schedule (m_startTime - Simulator::Now (), &DcWorkloadGenerator::ScheduleNextQuery, this);
+    }
+}
+
+uint32_t
+DcWorkloadGenerator::GetNFlows (void) const
+{
+  return m_nFlows;
+}
+
+uint32_t
+DcWorkloadGenerator::GetNQueries (void) const
+{
+  return m_nQueries;
+}
+
+void
+DcWorkloadGenerator::ScheduleNextFlow (void)
+{
+  // All the hosts together start flows at the rate loading each of them
+  double rate = m_load * m_linkRate.GetBitRate () * m_senders.size () / (8 * GetMeanFlowSize ());
+  Time next = Seconds (m_interval.GetValue () / rate);
+  if (Simulator::Now () + next <= m_stopTime)
+    {
+      Simulator::Schedule (next, &DcWorkloadGenerator::StartFlow, this);
+    }
+}
+
+void
+DcWorkloadGenerator::StartFlow (void)
+{
+  uint32_t n = m_senders.size ();
+  uint32_t src = m_uniform.GetInteger (0, n - 1);
+  uint32_t dst = m_uniform.GetInteger (0, n - 2);
+  if (dst >= src)
+    {
+      dst++;
+    }
+  double size = m_flowSize.GetValue ();
+  Send (src, dst, size < 1 ? 1 : (uint64_t) size);
+  m_nFlows++;
+  ScheduleNextFlow ();
+}
+
+void
+DcWorkloadGenerator::ScheduleNextQuery (void)
+{
+  Time next = Seconds (m_interval.GetValue () * m_queryInterval.GetSeconds ());
+  if (Simulator::Now () + next <= m_stopTime)
+    {
+      Simulator::Schedule (next, &DcWorkloadGenerator::StartQuery, this);
+    }
+}
+
+void
+DcWorkloadGenerator::StartQuery (void)
+{
+  uint32_t n = m_senders.size ();
+  uint32_t aggregator = m_uniform.GetInteger (0, n - 1);
+  uint32_t fanIn = std::min (m_queryFanIn, n - 1);
+  NS_LOG_LOGIC ("Query " << m_nQueries << " to host " << aggregator << " from " << fanIn << " hosts");
+
+  // Draw the responders among the other hosts, without repetition
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      m_responders[i] = i;
+    }
+  std::swap (m_responders[aggregator], m_responders[n - 1]);
+  for (uint32_t i = 0; i < fanIn; ++i)
+    {
+      uint32_t j = m_uniform.GetInteger (i, n - 2);
+      std::swap (m_responders[i], m_responders[j]);
+      Send (m_responders[i], aggregator, m_queryResponseSize);
+    }
+  m_nQueries++;
+  ScheduleNextQuery ();
+}
+
+void
+DcWorkloadGenerator::Send (uint32_t src, uint32_t dst, uint64_t bytes)
+{
+  NS_LOG_FUNCTION (this << src << dst << bytes);
+  m_senders[src]->SendFlow (InetSocketAddress (m_addresses[dst], m_port), bytes);
+}
+
+} // namespace ns3
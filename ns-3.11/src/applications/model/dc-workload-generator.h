@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DC_WORKLOAD_GENERATOR_H
+#define DC_WORKLOAD_GENERATOR_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/random-variable.h"
+#include "ns3/node-container.h"
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class FlowSendApplication;
+class FlowCompletionTracker;
+
+/**
+ * \ingroup applications
+ * \brief Generate the traffic of a data center among a set of hosts
+ *
+ * Two kinds of traffic are generated between StartTime and StopTime:
+ *
+ * - background flows, whose sizes follow an empirical distribution and
+ *   which arrive as a Poisson process, between random pairs of hosts, at
+ *   the rate which loads the access link of each host (LinkRate) to the
+ *   fraction Load on average;
+ * - partition-aggregate queries, if QueryInterval is not zero: a random
+ *   aggregator requests a response of QueryResponseSize bytes from
+ *   QueryFanIn other hosts, which all answer at the same time.  Queries
+ *   arrive as a Poisson process of mean interval QueryInterval.
+ *
+ * The flow sizes come from the web search workload of the DCTCP paper
+ * (the default), the data mining workload of the VL2 paper, or any
+ * distribution given as points of its CDF, in memory or in a file.
+ *
+ * Install () adds one FlowSendApplication and one PacketSink to each
+ * host, once: every flow reuses them, so that the number of applications
+ * does not grow with the number of flows.  The flows go to the port Port
+ * of the first IPv4 interface of the hosts, which must be configured
+ * beforehand.  With a FlowCompletionTracker (attribute FlowTracker), the
+ * completion time of every flow is recorded.
+ */
+class DcWorkloadGenerator : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DcWorkloadGenerator ();
+  virtual ~DcWorkloadGenerator ();
+
+  /**
+   * \brief Draw the background flow sizes from the web search workload
+   */
+  void UseWebSearchCdf (void);
+
+  /**
+   * \brief Draw the background flow sizes from the data mining workload
+   */
+  void UseDataMiningCdf (void);
+
+  /**
+   * \param cdf the points of the distribution: the flow size in bytes and
+   *        the probability that a flow is not larger, in increasing order
+   */
+  void SetFlowSizeCdf (const std::vector<std::pair<double, double> > &cdf);
+
+  /**
+   * \brief Read the distribution of the flow sizes from a file
+   *
+   * \param filename a file with one point of the distribution per line:
+   *        the flow size in bytes and the probability that a flow is not
+   *        larger; lines starting with # are ignored
+   * \returns false if the file cannot be read or has no points
+   */
+  bool LoadFlowSizeCdf (std::string filename);
+
+  /**
+   * \returns the mean of the distribution of the flow sizes, in bytes
+   */
+  double GetMeanFlowSize (void) const;
+
+  /**
+   * \param hosts the hosts sending and receiving the traffic
+   */
+  void Install (NodeContainer hosts);
+
+  /**
+   * \returns the number of background flows started
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \returns the number of queries started
+   */
+  uint32_t GetNQueries (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void ScheduleNextFlow (void);
+  void StartFlow (void);
+  void ScheduleNextQuery (void);
+  void StartQuery (void);
+  void Send (uint32_t src, uint32_t dst, uint64_t bytes);
+
+  double m_load;
+  DataRate m_linkRate;
+  uint16_t m_port;
+  Time m_startTime;
+  Time m_stopTime;
+  Time m_queryInterval;
+  uint32_t m_queryFanIn;
+  uint32_t m_queryResponseSize;
+  Ptr<FlowCompletionTracker> m_tracker;
+
+  std::vector<std::pair<double, double> > m_cdf;
+  EmpiricalVariable m_flowSize;
+  ExponentialVariable m_interval;   //!< Mean 1, scaled to the mean interval
+  UniformVariable m_uniform;
+
+  std::vector<Ptr<FlowSendApplication> > m_senders;
+  std::vector<Ipv4Address> m_addresses;
+  std::vector<uint32_t> m_responders;   //!< Scratch space to draw the responders
+  uint32_t m_nFlows;
+  uint32_t m_nQueries;
+};
+
+} // namespace ns3
+
+#endif /* DC_WORKLOAD_GENERATOR_H */
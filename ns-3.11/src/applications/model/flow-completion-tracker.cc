@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/trace-source-accessor.h"
+#include "flow-completion-tracker.h"
+
+NS_LOG_COMPONENT_DEFINE ("FlowCompletionTracker");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FlowCompletionTracker);
+
+TypeId
+FlowCompletionTracker::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowCompletionTracker")
+    .SetParent<Object> ()
+    .AddConstructor<FlowCompletionTracker> ()
+    .AddAttribute ("Capacity",
+                   "The number of flows to reserve room for.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FlowCompletionTracker::SetCapacity,
+                                         &FlowCompletionTracker::GetCapacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SummaryFile",
+                   "The CSV file to write the completion time percentiles to "
+                   "when the simulator is destroyed; empty for none.",
+                   StringValue (""),
+                   MakeStringAccessor (&FlowCompletionTracker::SetSummaryFile),
+                   MakeStringChecker ())
+    .AddAttribute ("FlowFile",
+                   "The CSV file to write the flows to when the simulator is "
+                   "destroyed; empty for none.",
+                   StringValue (""),
+                   MakeStringAccessor (&FlowCompletionTracker::SetFlowFile),
+                   MakeStringChecker ())
+    .AddTraceSource ("FlowCompleted",
+                     "A flow has completed: its index, its size and its completion time.",
+                     MakeTraceSourceAccessor (&FlowCompletionTracker::m_completedTrace))
+  ;
+  return tid;
+}
+
+FlowCompletionTracker::FlowCompletionTracker ()
+  : m_completed (0),
+    m_writeScheduled (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_classBounds.push_back (100000);
+  m_classBounds.push_back (10000000);
+}
+
+FlowCompletionTracker::~FlowCompletionTracker ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowCompletionTracker::SetCapacity (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  m_start.reserve (capacity);
+  m_finish.reserve (capacity);
+  m_bytes.reserve (capacity);
+}
+
+uint32_t
+FlowCompletionTracker::GetCapacity (void) const
+{
+  return m_start.capacity ();
+}
+
+void
+FlowCompletionTracker::SetSizeClasses (const std::vector<uint64_t> &bounds)
+{
+  NS_LOG_FUNCTION (this);
+  m_classBounds = bounds;
+  std::sort (m_classBounds.begin (), m_classBounds.end ());
+}
+
+uint64_t
+FlowCompletionTracker::GetKey (const Address &sender)
+{
+  InetSocketAddress address = InetSocketAddress::ConvertFrom (sender);
+  return ((uint64_t) address.GetIpv4 ().Get () << 16) | address.GetPort ();
+}
+
+uint32_t
+FlowCompletionTracker::FlowStarted (const Address &sender, uint64_t bytes)
+{
+  NS_LOG_FUNCTION (this << sender << bytes);
+  uint32_t flow = m_start.size ();
+  m_start.push_back (Simulator::Now ().GetTimeStep ());
+  m_finish.push_back (-1);
+  m_bytes.push_back (bytes);
+  if (InetSocketAddress::IsMatchingType (sender))
+    {
+      m_pending[GetKey (sender)] = flow;
+    }
+  else
+    {
+      NS_LOG_WARN ("Flow " << flow << " not sent from an IPv4 socket, it cannot complete");
+    }
+  return flow;
+}
+
+bool
+FlowCompletionTracker::FlowFinished (const Address &sender)
+{
+  NS_LOG_FUNCTION (this << sender);
+  if (!InetSocketAddress::IsMatchingType (sender))
+    {
+      return false;
+    }
+  std::map<uint64_t, uint32_t>::iterator it = m_pending.find (GetKey (sender));
+  if (it == m_pending.end ())
+    {
+      return false;
+    }
+  uint32_t flow = it->second;
+  m_pending.erase (it);
+  m_finish[flow] = Simulator::Now ().GetTimeStep ();
+  m_completed++;
+  m_completedTrace (flow, m_bytes[flow], GetCompletionTime (flow));
+  return true;
+}
+
+uint32_t
+FlowCompletionTracker::GetNFlows (void) const
+{
+  return m_start.size ();
+}
+
+uint32_t
+FlowCompletionTracker::GetNCompleted (void) const
+{
+  return m_completed;
+}
+
+Time
+FlowCompletionTracker::GetCompletionTime (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_start.size ());
+  if (m_finish[flow] < 0)
+    {
+      return TimeStep (-1);
+    }
+  return TimeStep (m_finish[flow] - m_start[flow]);
+}
+
+Time
+FlowCompletionTracker::GetPercentile (double quantile, uint64_t minBytes, uint64_t maxBytes) const
+{
+  NS_ASSERT (quantile >= 0 && quantile <= 1);
+  std::vector<int64_t> fct;
+  for (uint32_t i = 0; i < m_start.size (); ++i)
+    {
+      if (m_finish[i] >= 0 && m_bytes[i] >= minBytes && m_bytes[i] < maxBytes)
+        {
+          fct.push_back (m_finish[i] - m_start[i]);
+        }
+    }
+  if (fct.empty ())
+    {
+      return Seconds (0);
+    }
+  // Nearest rank
+  uint32_t rank = std::ceil (quantile * fct.size ());
+  uint32_t index = (rank > 0) ? rank - 1 : 0;
+  std::nth_element (fct.begin (), fct.begin () + index, fct.end ());
+  return TimeStep (fct[index]);
+}
+
+void
+FlowCompletionTracker::WriteSummary (std::ostream &os) const
+{
+  os << "min_bytes,max_bytes,flows,completed,mean_us,p50_us,p99_us,p999_us" << std::endl;
+  uint64_t lower = 0;
+  for (uint32_t c = 0; c <= m_classBounds.size (); ++c)
+    {
+      uint64_t upper = (c < m_classBounds.size ()) ? m_classBounds[c] : std::numeric_limits<uint64_t>::max ();
+      uint32_t flows = 0;
+      uint32_t completed = 0;
+      double sum = 0;
+      for (uint32_t i = 0; i < m_start.size (); ++i)
+        {
+          if (m_bytes[i] < lower || m_bytes[i] >= upper)
+            {
+              continue;
+            }
+          flows++;
+          if (m_finish[i] >= 0)
+            {
+              completed++;
+              sum += TimeStep (m_finish[i] - m_start[i]).GetNanoSeconds () / 1000.0;
+            }
+        }
+      os << lower << ",";
+      if (c < m_classBounds.size ())
+        {
+          os << upper;
+        }
+      os << "," << flows << "," << completed << ","
+         << (completed > 0 ? sum / completed : 0) << ","
+         << GetPercentile (0.5, lower, upper).GetNanoSeconds () / 1000.0 << ","
+         << GetPercentile (0.99, lower, upper).GetNanoSeconds () / 1000.0 << ","
+         << GetPercentile (0.999, lower, upper).GetNanoSeconds () / 1000.0 << std::endl;
+      lower = upper;
+    }
+}
+
+void
+FlowCompletionTracker::WriteFlows (std::ostream &os) const
+{
+  os << "flow,bytes,start_us,finish_us,fct_us" << std::endl;
+  for (uint32_t i = 0; i < m_start.size (); ++i)
+    {
+      os << i << "," << m_bytes[i] << "," << TimeStep (m_start[i]).GetNanoSeconds () / 1000.0 << ",";
+      if (m_finish[i] >= 0)
+        {
+          os << TimeStep (m_finish[i]).GetNanoSeconds () / 1000.0 << ","
+             << TimeStep (m_finish[i] - m_start[i]).GetNanoSeconds () / 1000.0;
+        }
+      else
+        {
+          os << ",";
+        }
+      os << std::endl;
+    }
+}
+
+void
+FlowCompletionTracker::SetSummaryFile (std::string filename)
+{
+  m_summaryFile = filename;
+  ScheduleWrite ();
+}
+
+void
+FlowCompletionTracker::SetFlowFile (std::string filename)
+{
+  m_flowFile = filename;
+  ScheduleWrite ();
+}
+
+void
+FlowCompletionTracker::ScheduleWrite (void)
+{
+  if (m_writeScheduled || (m_summaryFile.empty () && m_flowFile.empty ()))
+    {
+      return;
+    }
+  m_writeScheduled = true;
+  Simulator::ScheduleDestroy (&FlowCompletionTracker::WriteFiles, Ptr<FlowCompletionTracker> (this));
+}
+
+void
+FlowCompletionTracker::WriteFiles (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_writeScheduled = false;
+  if (!m_summaryFile.empty ())
+    {
+      std::ofstream os (m_summaryFile.c_str ());
+      WriteSummary (os);
+    }
+  if (!m_flowFile.empty ())
+    {
+      std::ofstream os (m_flowFile.c_str ());
+      WriteFlows (os);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_COMPLETION_TRACKER_H
+#define FLOW_COMPLETION_TRACKER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <limits>
+#include "ns3/object.h"
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup applications
+ * \brief Record the completion time of the flows of a simulation
+ *
+ * A BulkSendApplication with a tracker (attribute FlowTracker) registers
+ * each flow it starts, with its size and the address and port of its
+ * socket; the PacketSink sharing the tracker completes the flow when the
+ * sender closes the connection, once every byte has been received.
+ *
+ * The start time, finish time and size of the flows are kept in columns,
+ * one vector each, that can be sized up front with the Capacity attribute
+ * so that large runs do not reallocate them.  At the end of the run the
+ * tracker writes, as CSV, the percentiles of the completion times for each
+ * class of flow size and optionally one line per flow: to the files set
+ * by the SummaryFile and FlowFile attributes when the simulator is
+ * destroyed, or to any stream with WriteSummary () and WriteFlows ().
+ */
+class FlowCompletionTracker : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FlowCompletionTracker ();
+  virtual ~FlowCompletionTracker ();
+
+  /**
+   * \param capacity the number of flows to reserve room for
+   */
+  void SetCapacity (uint32_t capacity);
+
+  /**
+   * \returns the number of flows which fit without reallocating
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \param bounds the upper bounds, in bytes, of the size classes of the
+   *        summary, in increasing order; a last class holds the larger flows
+   *
+   * The default classes are the queries, short messages and background
+   * flows of data center studies: below 100KB, below 10MB and above.
+   */
+  void SetSizeClasses (const std::vector<uint64_t> &bounds);
+
+  /**
+   * \brief Record the start of a flow, now
+   *
+   * \param sender the address and port of the socket sending the flow
+   * \param bytes the size of the flow
+   * \returns the index of the flow
+   */
+  uint32_t FlowStarted (const Address &sender, uint64_t bytes);
+
+  /**
+   * \brief Record the completion of the flow sent from an address, now
+   *
+   * \param sender the address and port of the socket sending the flow
+   * \returns false if no flow is pending for this sender
+   */
+  bool FlowFinished (const Address &sender);
+
+  /**
+   * \returns the number of flows started
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \returns the number of flows completed
+   */
+  uint32_t GetNCompleted (void) const;
+
+  /**
+   * \param flow the index of the flow
+   * \returns the completion time of the flow, or a negative time if it
+   *          has not completed
+   */
+  Time GetCompletionTime (uint32_t flow) const;
+
+  /**
+   * \param quantile the quantile, between 0 and 1
+   * \param minBytes the smallest flow size considered
+   * \param maxBytes the flow size above which flows are not considered
+   * \returns the quantile of the completion times of the completed flows
+   *          of at least minBytes and less than maxBytes, zero if none
+   */
+  Time GetPercentile (double quantile, uint64_t minBytes = 0,
+                      uint64_t maxBytes = std::numeric_limits<uint64_t>::max ()) const;
+
+  /**
+   * \brief Write one CSV line per size class: its bounds, its numbers of
+   * flows and completed flows, and the mean, p50, p99 and p99.9 of their
+   * completion times in microseconds.
+   */
+  void WriteSummary (std::ostream &os) const;
+
+  /**
+   * \brief Write one CSV line per flow: its index, size, start and finish
+   * times and completion time in microseconds; the last two are empty if
+   * the flow has not completed.
+   */
+  void WriteFlows (std::ostream &os) const;
+
+private:
+  static uint64_t GetKey (const Address &sender);
+  void SetSummaryFile (std::string filename);
+  void SetFlowFile (std::string filename);
+  void ScheduleWrite (void);
+  void WriteFiles (void);
+
+  // One column per field of the flows, indexed by flow
+  std::vector<int64_t> m_start;     //!< Start time steps
+  std::vector<int64_t> m_finish;    //!< Finish time steps, -1 while pending
+  std::vector<uint64_t> m_bytes;    //!< Flow sizes
+
+  std::map<uint64_t, uint32_t> m_pending;  //!< Flows not completed, by sender
+  uint32_t m_completed;
+  std::vector<uint64_t> m_classBounds;
+  std::string m_summaryFile;
+  std::string m_flowFile;
+  bool m_writeScheduled;
+
+  TracedCallback<uint32_t, uint64_t, Time> m_completedTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_COMPLETION_TRACKER_H */
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/tcp-socket-factory.h"
+#include "flow-send-application.h"
+#include "flow-completion-tracker.h"
+
+NS_LOG_COMPONENT_DEFINE ("FlowSendApplication");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FlowSendApplication);
+
+TypeId
+FlowSendApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowSendApplication")
+    .SetParent<Application> ()
+    .AddConstructor<FlowSendApplication> ()
+    .AddAttribute ("SendSize", "The amount of data to send each time.",
+                   UintegerValue (1448),
+                   MakeUintegerAccessor (&FlowSendApplication::m_sendSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Protocol", "The type of protocol to use.",
+                   TypeIdValue (TcpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&FlowSendApplication::m_tid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("FlowTracker", "The tracker recording the completion time of the flows.",
+                   PointerValue (),
+                   MakePointerAccessor (&FlowSendApplication::m_tracker),
+                   MakePointerChecker<FlowCompletionTracker> ())
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&FlowSendApplication::m_txTrace))
+  ;
+  return tid;
+}
+
+FlowSendApplication::FlowSendApplication ()
+  : m_running (false),
+    m_nFlows (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowSendApplication::~FlowSendApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowSendApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flows.clear ();
+  m_freeSlots.clear ();
+  m_slots.clear ();
+  m_tracker = 0;
+  // chain up
+  Application::DoDispose ();
+}
+
+void
+FlowSendApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_running = true;
+}
+
+void
+FlowSendApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_running = false;
+  while (!m_slots.empty ())
+    {
+      uint32_t slot = m_slots.begin ()->second;
+      m_flows[slot].socket->Close ();
+      ReleaseFlow (slot);
+    }
+}
+
+bool
+FlowSendApplication::SendFlow (const Address &peer, uint64_t bytes)
+{
+  NS_LOG_FUNCTION (this << peer << bytes);
+  if (!m_running)
+    {
+      return false;
+    }
+
+  uint32_t slot;
+  if (m_freeSlots.empty ())
+    {
+      slot = m_flows.size ();
+      m_flows.push_back (Flow ());
+    }
+  else
+    {
+      slot = m_freeSlots.back ();
+      m_freeSlots.pop_back ();
+    }
+  Flow &flow = m_flows[slot];
+  flow.socket = Socket::CreateSocket (GetNode (), m_tid);
+  flow.size = bytes;
+  flow.sent = 0;
+  flow.connected = false;
+  m_slots[flow.socket] = slot;
+  m_nFlows++;
+
+  flow.socket->Bind ();
+  flow.socket->Connect (peer);
+  flow.socket->ShutdownRecv ();
+  if (m_tracker != 0)
+    {
+      Address local;
+      flow.socket->GetSockName (local);
+      m_tracker->FlowStarted (local, bytes);
+    }
+  flow.socket->SetConnectCallback (
+    MakeCallback (&FlowSendApplication::ConnectionSucceeded, this),
+    MakeCallback (&FlowSendApplication::ConnectionFailed, this));
+  flow.socket->SetSendCallback (
+    MakeCallback (&FlowSendApplication::DataSend, this));
+  return true;
+}
+
+uint32_t
+FlowSendApplication::GetNFlows (void) const
+{
+  return m_nFlows;
+}
+
+uint32_t
+FlowSendApplication::GetNActiveFlows (void) const
+{
+  return m_slots.size ();
+}
+
+uint32_t
+FlowSendApplication::GetPoolSize (void) const
+{
+  return m_flows.size ();
+}
+
+void
+FlowSendApplication::SendData (uint32_t slot)
+{
+  NS_LOG_FUNCTION (this << slot);
+  Flow &flow = m_flows[slot];
+  while (flow.sent < flow.size)
+    {
+      uint32_t toSend = std::min<uint64_t> (m_sendSize, flow.size - flow.sent);
+      Ptr<Packet> packet = Create<Packet> (toSend);
+      m_txTrace (packet);
+      int actual = flow.socket->Send (packet);
+      if (actual > 0)
+        {
+          flow.sent += actual;
+        }
+      // The send buffer is full: the send callback resumes the flow
+      if ((unsigned)actual != toSend)
+        {
+          return;
+        }
+    }
+  flow.socket->Close ();
+  ReleaseFlow (slot);
+}
+
+void
+FlowSendApplication::ReleaseFlow (uint32_t slot)
+{
+  NS_LOG_FUNCTION (this << slot);
+  Flow &flow = m_flows[slot];
+  // The socket finishes the connection on its own
+  flow.socket->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                                   MakeNullCallback<void, Ptr<Socket> > ());
+  flow.socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+  m_slots.erase (flow.socket);
+  flow.socket = 0;
+  m_freeSlots.push_back (slot);
+}
+
+void
+FlowSendApplication::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_slots.find (socket);
+  if (it == m_slots.end ())
+    {
+      return;
+    }
+  m_flows[it->second].connected = true;
+  SendData (it->second);
+}
+
+void
+FlowSendApplication::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_slots.find (socket);
+  if (it != m_slots.end ())
+    {
+      ReleaseFlow (it->second);
+    }
+}
+
+void
+FlowSendApplication::DataSend (Ptr<Socket> socket, uint32_t available)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Simulator::ScheduleNow (&FlowSendApplication::ResumeFlow, this, socket);
+}
+
+void
+FlowSendApplication::ResumeFlow (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_slots.find (socket);
+  if (it != m_slots.end () && m_flows[it->second].connected)
+    {
+      SendData (it->second);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_SEND_APPLICATION_H
+#define FLOW_SEND_APPLICATION_H
+
+#include <map>
+#include <vector>
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class Socket;
+class FlowCompletionTracker;
+
+/**
+ * \ingroup applications
+ * \defgroup flowsend FlowSendApplication
+ *
+ * This traffic generator sends any number of bulk transfers, each one on
+ * its own connection and possibly to a different peer, as they are
+ * requested with SendFlow ().  It lets a workload generator drive all the
+ * flows of a host through a single application, instead of adding a
+ * BulkSendApplication to the node for each flow.
+ *
+ * The state of the flows is kept in a pool: the slot of a flow is
+ * recycled for the next flow once its data has been handed to the
+ * socket and the socket closed.  Flows requested before the application
+ * starts or after it stops are ignored.
+ */
+class FlowSendApplication : public Application
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FlowSendApplication ();
+  virtual ~FlowSendApplication ();
+
+  /**
+   * \brief Start a new flow now
+   *
+   * \param peer the address of the receiver
+   * \param bytes the number of bytes to send
+   * \returns false if the application is not running
+   */
+  bool SendFlow (const Address &peer, uint64_t bytes);
+
+  /**
+   * \returns the number of flows started
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \returns the number of flows whose data is not all sent yet
+   */
+  uint32_t GetNActiveFlows (void) const;
+
+  /**
+   * \returns the number of flow slots allocated, active or free
+   */
+  uint32_t GetPoolSize (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /**
+   * The state of a flow.
+   */
+  struct Flow
+  {
+    Ptr<Socket> socket;
+    uint64_t size;        //!< Bytes to send
+    uint64_t sent;        //!< Bytes handed to the socket
+    bool connected;
+  };
+
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  void ConnectionFailed (Ptr<Socket> socket);
+  void DataSend (Ptr<Socket> socket, uint32_t available);
+  void ResumeFlow (Ptr<Socket> socket);
+  void SendData (uint32_t slot);
+  void ReleaseFlow (uint32_t slot);
+
+  TypeId m_tid;
+  uint32_t m_sendSize;
+  Ptr<FlowCompletionTracker> m_tracker;
+  bool m_running;
+  uint32_t m_nFlows;
+
+  std::vector<Flow> m_flows;                  //!< The pool of flow slots
+  std::vector<uint32_t> m_freeSlots;          //!< The slots available
+  std::map<Ptr<Socket>, uint32_t> m_slots;    //!< The slot of each active socket
+
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_SEND_APPLICATION_H */
@@ -29,7 +29,9 @@
 #include "ns3/packet.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/pointer.h"
 #include "packet-sink.h"
+#include "flow-completion-tracker.h"
 
 using namespace std;
 
@@ -52,6 +54,10 @@ PacketSink::GetTypeId (void)
                    TypeIdValue (UdpSocketFactory::GetTypeId ()),
                    MakeTypeIdAccessor (&PacketSink::m_tid),
                    MakeTypeIdChecker ())
+    .AddAttribute ("FlowTracker", "The tracker recording the completion time of the flows received.",
+                   PointerValue (),
+                   MakePointerAccessor (&PacketSink::m_tracker),
+                   MakePointerChecker<FlowCompletionTracker> ())
     .AddTraceSource ("Rx", "A packet has been received",
                      MakeTraceSourceAccessor (&PacketSink::m_rxTrace))
   ;
@@ -94,6 +100,9 @@ void PacketSink::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_socket = 0;
   m_socketList.clear ();
+  m_socketPositions.clear ();
+  m_tracker = 0;
+  m_flowSenders.clear ();
 
   // chain up
   Application::DoDispose ();
@@ -143,11 +152,20 @@ void PacketSink::StopApplication ()     // Called at time specified by Stop
       Ptr<Socket> acceptedSocket = m_socketList.front ();
       m_socketList.pop_front ();
       acceptedSocket->Close ();
+      acceptedSocket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      acceptedSocket->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                                         MakeNullCallback<void, Ptr<Socket> > ());
     }
+  m_socketPositions.clear ();
+  m_flowSenders.clear ();
   if (m_socket) 
     {
       m_socket->Close ();
       m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket> > ());
+      m_socket->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                                   MakeNullCallback<void, Ptr<Socket>, const Address &> ());
+      m_socket->SetCloseCallbacks (MakeNullCallback<void, Ptr<Socket> > (),
+                                   MakeNullCallback<void, Ptr<Socket> > ());
     }
 }
 
@@ -180,11 +198,37 @@ void PacketSink::HandleRead (Ptr<Socket> socket)
 void PacketSink::HandlePeerClose (Ptr<Socket> socket)
 {
   NS_LOG_INFO ("PktSink, peerClose");
+  if (m_tracker != 0)
+    {
+      // Every byte sent has been received before the peer's FIN
+      std::map<Ptr<Socket>, Address>::iterator it = m_flowSenders.find (socket);
+      if (it != m_flowSenders.end ())
+        {
+          m_tracker->FlowFinished (it->second);
+          m_flowSenders.erase (it);
+        }
+    }
+  // The socket closes on its own: only the open connections are kept,
+  // once the socket is done with this callback
+  Simulator::ScheduleNow (&PacketSink::RemoveSocket, Ptr<PacketSink> (this), socket);
 }
  
 void PacketSink::HandlePeerError (Ptr<Socket> socket)
 {
   NS_LOG_INFO ("PktSink, peerError");
+  m_flowSenders.erase (socket);
+  Simulator::ScheduleNow (&PacketSink::RemoveSocket, Ptr<PacketSink> (this), socket);
+}
+
+void PacketSink::RemoveSocket (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  std::map<Ptr<Socket>, std::list<Ptr<Socket> >::iterator>::iterator it = m_socketPositions.find (socket);
+  if (it != m_socketPositions.end ())
+    {
+      m_socketList.erase (it->second);
+      m_socketPositions.erase (it);
+    }
 }
  
 
@@ -192,7 +236,11 @@ void PacketSink::HandleAccept (Ptr<Socket> s, const Address& from)
 {
   NS_LOG_FUNCTION (this << s << from);
   s->SetRecvCallback (MakeCallback (&PacketSink::HandleRead, this));
-  m_socketList.push_back (s);
+  m_socketPositions[s] = m_socketList.insert (m_socketList.end (), s);
+  if (m_tracker != 0)
+    {
+      m_flowSenders[s] = from;
+    }
 }
 
 } // Namespace ns3
@@ -26,12 +26,14 @@
 #include "ns3/ptr.h"
 #include "ns3/traced-callback.h"
 #include "ns3/address.h"
+#include <map>
 
 namespace ns3 {
 
 class Address;
 class Socket;
 class Packet;
+class FlowCompletionTracker;
 
 /**
  * \ingroup applications 
@@ -64,6 +66,9 @@ class Packet;
  * as a callback on the receiving socket.  By default, when logging is
  * enabled, it prints out the size of packets and their address, but
  * we intend to also add a tracing source to Receive() at a later date.
+ *
+ * With a FlowCompletionTracker (attribute FlowTracker), the sink completes
+ * the flow of a connected sender when the sender closes the connection.
  */
 class PacketSink : public Application 
 {
@@ -99,15 +104,19 @@ private:
   void HandleAccept (Ptr<Socket>, const Address& from);
   void HandlePeerClose (Ptr<Socket>);
   void HandlePeerError (Ptr<Socket>);
+  void RemoveSocket (Ptr<Socket>);
 
   // In the case of TCP, each socket accept returns a new socket, so the 
   // listening socket is stored seperately from the accepted sockets
   Ptr<Socket>     m_socket;       // Listening socket
   std::list<Ptr<Socket> > m_socketList; //the accepted sockets
+  std::map<Ptr<Socket>, std::list<Ptr<Socket> >::iterator> m_socketPositions; // in m_socketList
 
   Address         m_local;        // Local address to bind to
   uint32_t        m_totalRx;      // Total bytes received
   TypeId          m_tid;          // Protocol TypeId
+  Ptr<FlowCompletionTracker> m_tracker;            // Records the flows, if any
+  std::map<Ptr<Socket>, Address> m_flowSenders;    // Senders of the tracked flows
   TracedCallback<Ptr<const Packet>, const Address &> m_rxTrace;
 
 };
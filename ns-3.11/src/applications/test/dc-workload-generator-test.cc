@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/ipv4.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/flow-completion-tracker.h"
+#include "ns3/dc-workload-generator.h"
+
+using namespace ns3;
+
+/**
+ * Background flows, and queries if asked, among four hosts on a shared
+ * channel: check the number of flows generated for the load, that every
+ * flow completes and that the applications are not multiplied per flow.
+ */
+class DcWorkloadGeneratorTestCase : public TestCase
+{
+public:
+  DcWorkloadGeneratorTestCase (bool queries);
+
+private:
+  virtual void DoRun (void);
+
+  bool m_queries;
+};
+
+DcWorkloadGeneratorTestCase::DcWorkloadGeneratorTestCase (bool queries)
+  : TestCase (queries ? "Background flows and queries" : "Background flows"),
+    m_queries (queries)
+{
+}
+
+void
+DcWorkloadGeneratorTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (4);
+  InternetStackHelper internet;
+  internet.Install (n);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < n.GetN (); ++i)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetChannel (channel);
+      n.Get (i)->AddDevice (dev);
+      d.Add (dev);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (d);
+  // Every host receives every packet of the shared channel: none forwards them
+  for (uint32_t i = 0; i < n.GetN (); ++i)
+    {
+      n.Get (i)->GetObject<Ipv4> ()->SetAttribute ("IpForward", BooleanValue (false));
+    }
+
+  Ptr<FlowCompletionTracker> tracker = CreateObject<FlowCompletionTracker> ();
+  Ptr<DcWorkloadGenerator> generator = CreateObject<DcWorkloadGenerator> ();
+  std::vector<std::pair<double, double> > cdf;
+  cdf.push_back (std::make_pair (1000.0, 0.0));
+  cdf.push_back (std::make_pair (10000.0, 1.0));
+  generator->SetFlowSizeCdf (cdf);
+  NS_TEST_EXPECT_MSG_EQ_TOL (generator->GetMeanFlowSize (), 5500, 0.001, "Mean of the flow sizes");
+
+  // 4 hosts loaded at 50% of 10Mbps by flows of 5500 bytes on average:
+  // about 91 flows in 200ms
+  generator->SetAttribute ("LinkRate", DataRateValue (DataRate ("10Mbps")));
+  generator->SetAttribute ("Load", DoubleValue (0.5));
+  generator->SetAttribute ("StartTime", TimeValue (Seconds (1)));
+  generator->SetAttribute ("StopTime", TimeValue (Seconds (1.2)));
+  generator->SetAttribute ("FlowTracker", PointerValue (tracker));
+  if (m_queries)
+    {
+      generator->SetAttribute ("QueryInterval", TimeValue (MilliSeconds (20)));
+      generator->SetAttribute ("QueryFanIn", UintegerValue (3));
+    }
+  generator->Install (n);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_LT (60, generator->GetNFlows (), "Flows generated for the load");
+  NS_TEST_EXPECT_MSG_LT (generator->GetNFlows (), 125, "Flows generated for the load");
+  if (m_queries)
+    {
+      NS_TEST_EXPECT_MSG_LT (0, generator->GetNQueries (), "Queries generated");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (generator->GetNQueries (), 0, "No queries");
+    }
+  uint32_t expected = generator->GetNFlows () + 3 * generator->GetNQueries ();
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNFlows (), expected, "Every flow registered");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNCompleted (), expected, "Every flow completed");
+  for (uint32_t i = 0; i < n.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (n.Get (i)->GetNApplications (), 2, "One sender and one sink per host");
+    }
+
+  Simulator::Destroy ();
+}
+
+class DcWorkloadGeneratorTestSuite : public TestSuite
+{
+public:
+  DcWorkloadGeneratorTestSuite ();
+};
+
+DcWorkloadGeneratorTestSuite::DcWorkloadGeneratorTestSuite ()
+  : TestSuite ("dc-workload-generator", UNIT)
+{
+  AddTestCase (new DcWorkloadGeneratorTestCase (false));
+  AddTestCase (new DcWorkloadGeneratorTestCase (true));
+}
+
+static DcWorkloadGeneratorTestSuite dcWorkloadGeneratorTestSuite;
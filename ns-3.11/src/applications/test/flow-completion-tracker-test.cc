@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/flow-completion-tracker.h"
+
+using namespace ns3;
+
+/**
+ * Flows recorded by hand: check the percentiles of each size class and
+ * the summary.
+ */
+class FlowCompletionTrackerPercentileTestCase : public TestCase
+{
+public:
+  FlowCompletionTrackerPercentileTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Start (Ptr<FlowCompletionTracker> tracker, uint32_t flow, uint64_t bytes);
+  void Finish (Ptr<FlowCompletionTracker> tracker, uint32_t flow);
+};
+
+FlowCompletionTrackerPercentileTestCase::FlowCompletionTrackerPercentileTestCase ()
+  : TestCase ("Completion time percentiles per flow size class")
+{
+}
+
+void
+FlowCompletionTrackerPercentileTestCase::Start (Ptr<FlowCompletionTracker> tracker, uint32_t flow, uint64_t bytes)
+{
+  tracker->FlowStarted (InetSocketAddress (Ipv4Address ("10.0.0.1"), 1000 + flow), bytes);
+}
+
+void
+FlowCompletionTrackerPercentileTestCase::Finish (Ptr<FlowCompletionTracker> tracker, uint32_t flow)
+{
+  bool finished = tracker->FlowFinished (InetSocketAddress (Ipv4Address ("10.0.0.1"), 1000 + flow));
+  NS_TEST_EXPECT_MSG_EQ (finished, true, "Flow " << flow << " pending");
+}
+
+void
+FlowCompletionTrackerPercentileTestCase::DoRun (void)
+{
+  Ptr<FlowCompletionTracker> tracker = CreateObject<FlowCompletionTracker> ();
+  tracker->SetAttribute ("Capacity", UintegerValue (5000));
+
+  // 100 small flows and 100 large flows; flow i completes in i + 1 ms
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      uint64_t bytes = (i < 100) ? 1000 : 1000000;
+      Simulator::Schedule (Seconds (1), &FlowCompletionTrackerPercentileTestCase::Start, this, tracker, i, bytes);
+      if (i != 199)
+        {
+          Simulator::Schedule (Seconds (1) + MilliSeconds (i + 1),
+                               &FlowCompletionTrackerPercentileTestCase::Finish, this, tracker, i);
+        }
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetCapacity (), 5000, "Columns preallocated");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNFlows (), 200, "Flows started");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNCompleted (), 199, "Flows completed");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetCompletionTime (10), MilliSeconds (11), "Completion time of a flow");
+  NS_TEST_EXPECT_MSG_EQ ((tracker->GetCompletionTime (199) < Seconds (0)), true, "Pending flow");
+  bool finished = tracker->FlowFinished (InetSocketAddress (Ipv4Address ("10.0.0.1"), 1000));
+  NS_TEST_EXPECT_MSG_EQ (finished, false, "A flow completes once");
+
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetPercentile (0.5, 0, 100000), MilliSeconds (50), "p50 of the small flows");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetPercentile (0.99, 0, 100000), MilliSeconds (99), "p99 of the small flows");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetPercentile (0.999, 0, 100000), MilliSeconds (100), "p999 of the small flows");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetPercentile (0.5, 100000), MilliSeconds (150), "p50 of the large flows");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetPercentile (0.5), MilliSeconds (100), "p50 of all the flows");
+
+  std::ostringstream summary;
+  tracker->WriteSummary (summary);
+  std::string expected =
+    "min_bytes,max_bytes,flows,completed,mean_us,p50_us,p99_us,p999_us\n"
+    "0,100000,100,100,50500,50000,99000,100000\n"
+    "100000,10000000,100,99,150000,150000,199000,199000\n"
+    "10000000,,0,0,0,0,0,0\n";
+  NS_TEST_EXPECT_MSG_EQ (summary.str (), expected, "Summary");
+
+  std::ostringstream flows;
+  tracker->WriteFlows (flows);
+  std::string line;
+  std::istringstream lines (flows.str ());
+  std::getline (lines, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "flow,bytes,start_us,finish_us,fct_us", "Flows header");
+  std::getline (lines, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "0,1000,1e+06,1.001e+06,1000", "First flow");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Bulk transfers of several sizes into a packet sink: every flow is
+ * registered by its sender and completed by the sink.
+ */
+class FlowCompletionTrackerBulkSendTestCase : public TestCase
+{
+public:
+  FlowCompletionTrackerBulkSendTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowCompletionTrackerBulkSendTestCase::FlowCompletionTrackerBulkSendTestCase ()
+  : TestCase ("BulkSendApplication flows completed by a PacketSink")
+{
+}
+
+void
+FlowCompletionTrackerBulkSendTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (2);
+  InternetStackHelper internet;
+  internet.Install (n);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetChannel (channel);
+      n.Get (i)->AddDevice (dev);
+      d.Add (dev);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i = ipv4.Assign (d);
+
+  Ptr<FlowCompletionTracker> tracker = CreateObject<FlowCompletionTracker> ();
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 9));
+  sink.SetAttribute ("FlowTracker", PointerValue (tracker));
+  sink.Install (n.Get (1));
+
+  uint32_t sizes[] = { 10000, 200000, 500000 };
+  for (uint32_t j = 0; j < 3; ++j)
+    {
+      BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (i.GetAddress (1), 9));
+      source.SetAttribute ("MaxBytes", UintegerValue (sizes[j]));
+      source.SetAttribute ("FlowTracker", PointerValue (tracker));
+      ApplicationContainer apps = source.Install (n.Get (0));
+      apps.Start (Seconds (1 + j));
+    }
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNFlows (), 3, "Every transfer registered");
+  NS_TEST_EXPECT_MSG_EQ (tracker->GetNCompleted (), 3, "Every transfer completed");
+  for (uint32_t j = 0; j < 3; ++j)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((tracker->GetCompletionTime (j) >= Seconds (0)), true, "Flow " << j << " completed");
+      NS_TEST_EXPECT_MSG_EQ ((tracker->GetCompletionTime (j) < Seconds (1)), true, "Flow " << j << " done before the next");
+    }
+
+  Simulator::Destroy ();
+}
+
+class FlowCompletionTrackerTestSuite : public TestSuite
+{
+public:
+  FlowCompletionTrackerTestSuite ();
+};
+
+FlowCompletionTrackerTestSuite::FlowCompletionTrackerTestSuite ()
+  : TestSuite ("flow-completion-tracker", UNIT)
+{
+  AddTestCase (new FlowCompletionTrackerPercentileTestCase);
+  AddTestCase (new FlowCompletionTrackerBulkSendTestCase);
+}
+
+static FlowCompletionTrackerTestSuite flowCompletionTrackerTestSuite;
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/object-vector.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/bulk-send-application.h"
+#include "ns3/packet-sink.h"
+#include "ns3/flow-completion-tracker.h"
+
+using namespace ns3;
+
+/**
+ * Remove an application from the middle of the list of a node.
+ */
+class NodeRemoveApplicationTestCase : public TestCase
+{
+public:
+  NodeRemoveApplicationTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+NodeRemoveApplicationTestCase::NodeRemoveApplicationTestCase ()
+  : TestCase ("Removal of an application from a node")
+{
+}
+
+void
+NodeRemoveApplicationTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Application> apps[3];
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      apps[i] = CreateObject<PacketSink> ();
+      node->AddApplication (apps[i]);
+    }
+  node->RemoveApplication (apps[1]);
+  NS_TEST_EXPECT_MSG_EQ (node->GetNApplications (), 2, "Application removed");
+  NS_TEST_EXPECT_MSG_EQ (node->GetApplication (0), apps[0], "First application in place");
+  NS_TEST_EXPECT_MSG_EQ (node->GetApplication (1), apps[2], "Last application moved to the hole");
+  node->RemoveApplication (apps[2]);
+  node->RemoveApplication (apps[0]);
+  NS_TEST_EXPECT_MSG_EQ (node->GetNApplications (), 0, "Every application removed");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (apps[1]->GetNode (), 0, "Removed application disposed");
+  Simulator::Destroy ();
+}
+
+/**
+ * Bulk transfers one after the other, each by a new application removed
+ * when its flow completes: the applications, the sockets of the senders
+ * and the connections accepted by the sink do not pile up.
+ */
+class SocketReclamationTestCase : public TestCase
+{
+public:
+  SocketReclamationTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void StartFlow (void);
+  void FlowCompleted (uint32_t flow, uint64_t bytes, Time fct);
+  static uint32_t GetNSockets (Ptr<Node> node);
+
+  NodeContainer m_nodes;
+  Ipv4Address m_sinkAddress;
+  Ptr<FlowCompletionTracker> m_tracker;
+  Ptr<BulkSendApplication> m_source;
+  uint32_t m_nFlows;
+  uint32_t m_maxSockets;
+};
+
+SocketReclamationTestCase::SocketReclamationTestCase ()
+  : TestCase ("Applications and sockets reclaimed after their flows")
+{
+}
+
+uint32_t
+SocketReclamationTestCase::GetNSockets (Ptr<Node> node)
+{
+  ObjectVectorValue sockets;
+  node->GetObject<TcpL4Protocol> ()->GetAttribute ("SocketList", sockets);
+  return sockets.GetN ();
+}
+
+void
+SocketReclamationTestCase::StartFlow (void)
+{
+  m_source = CreateObject<BulkSendApplication> ();
+  m_source->SetAttribute ("Remote", AddressValue (InetSocketAddress (m_sinkAddress, 9)));
+  m_source->SetAttribute ("MaxBytes", UintegerValue (20000));
+  m_source->SetAttribute ("FlowTracker", PointerValue (m_tracker));
+  m_nodes.Get (0)->AddApplication (m_source);
+  m_nFlows++;
+}
+
+void
+SocketReclamationTestCase::FlowCompleted (uint32_t flow, uint64_t bytes, Time fct)
+{
+  m_maxSockets = std::max (m_maxSockets, GetNSockets (m_nodes.Get (0)));
+  m_nodes.Get (0)->RemoveApplication (m_source);
+  m_source = 0;
+  if (m_nFlows < 20)
+    {
+      Simulator::Schedule (MilliSeconds (10), &SocketReclamationTestCase::StartFlow, this);
+    }
+}
+
+void
+SocketReclamationTestCase::DoRun (void)
+{
+  m_nFlows = 0;
+  m_maxSockets = 0;
+  Config::SetDefault ("ns3::TcpSocketBase::TimeWaitTimeout", TimeValue (MilliSeconds (20)));
+
+  m_nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetChannel (channel);
+      m_nodes.Get (i)->AddDevice (dev);
+      d.Add (dev);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  m_sinkAddress = ipv4.Assign (d).GetAddress (1);
+
+  m_tracker = CreateObject<FlowCompletionTracker> ();
+  m_tracker->TraceConnectWithoutContext ("FlowCompleted",
+                                         MakeCallback (&SocketReclamationTestCase::FlowCompleted, this));
+  Ptr<PacketSink> sink = CreateObject<PacketSink> ();
+  sink->SetAttribute ("Protocol", TypeIdValue (TcpSocketFactory::GetTypeId ()));
+  sink->SetAttribute ("Local", AddressValue (InetSocketAddress (Ipv4Address::GetAny (), 9)));
+  sink->SetAttribute ("FlowTracker", PointerValue (m_tracker));
+  m_nodes.Get (1)->AddApplication (sink);
+  Simulator::Schedule (Seconds (1), &SocketReclamationTestCase::StartFlow, this);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_tracker->GetNCompleted (), 20, "Every flow completed");
+  NS_TEST_EXPECT_MSG_EQ (m_nodes.Get (0)->GetNApplications (), 0, "Every source removed");
+  NS_TEST_EXPECT_MSG_EQ (sink->GetAcceptedSockets ().size (), 0, "Closed connections pruned by the sink");
+  NS_TEST_EXPECT_MSG_LT (m_maxSockets, 3, "Sender sockets reclaimed during the run");
+  NS_TEST_EXPECT_MSG_EQ (GetNSockets (m_nodes.Get (0)), 0, "Sender sockets reclaimed");
+  NS_TEST_EXPECT_MSG_EQ (GetNSockets (m_nodes.Get (1)), 1, "Listening socket only");
+
+  Simulator::Destroy ();
+  m_tracker = 0;
+  m_nodes = NodeContainer ();
+  Config::SetDefault ("ns3::TcpSocketBase::TimeWaitTimeout", TimeValue (Seconds (0)));
+}
+
+class SocketReclamationTestSuite : public TestSuite
+{
+public:
+  SocketReclamationTestSuite ();
+};
+
+SocketReclamationTestSuite::SocketReclamationTestSuite ()
+  : TestSuite ("socket-reclamation", UNIT)
+{
+  AddTestCase (new NodeRemoveApplicationTestCase);
+  AddTestCase (new SocketReclamationTestCase);
+}
+
+static SocketReclamationTestSuite socketReclamationTestSuite;
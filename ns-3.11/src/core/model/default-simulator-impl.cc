@@ -25,10 +25,14 @@
 
 #include "ns3/ptr.h"
 #include "ns3/pointer.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
 #include <math.h>
+#include <vector>
 
 NS_LOG_COMPONENT_DEFINE ("DefaultSimulatorImpl");
 
@@ -42,6 +46,25 @@ DefaultSimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::DefaultSimulatorImpl")
     .SetParent<SimulatorImpl> ()
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CancelledEventPurge",
+                   "Policy for the events cancelled before their expiration time",
+                   EnumValue (PURGE_NONE),
+                   MakeEnumAccessor (&DefaultSimulatorImpl::m_purgeMode),
+                   MakeEnumChecker (PURGE_NONE, "None",
+                                    PURGE_ON_CANCEL, "OnCancel",
+                                    PURGE_LAZY, "Lazy"))
+    .AddAttribute ("PurgeThreshold",
+                   "Fraction of cancelled events in the event list which triggers "
+                   "its rebuilding with the Lazy policy",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&DefaultSimulatorImpl::m_purgeThreshold),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("PurgeMinEvents",
+                   "Size of the event list below which it is never rebuilt "
+                   "with the Lazy policy",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::m_purgeMinEvents),
+                   MakeUintegerChecker<uint32_t> ())
   ;
   return tid;
 }
@@ -59,6 +82,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = 0xffffffff;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+  m_purgedEvents = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
@@ -126,6 +151,10 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+  if (next.impl->IsCancelled () && m_cancelledEvents > 0)
+    {
+      m_cancelledEvents--;
+    }
   next.impl->Invoke ();
   next.impl->Unref ();
 }
@@ -296,12 +325,76 @@ DefaultSimulatorImpl::Remove (const EventId &id)
 void
 DefaultSimulatorImpl::Cancel (const EventId &id)
 {
-  if (!IsExpired (id))
+  if (IsExpired (id))
+    {
+      return;
+    }
+  if (m_purgeMode == PURGE_ON_CANCEL && id.GetUid () != 2)
+    {
+      Remove (id);
+      m_purgedEvents++;
+      return;
+    }
+  id.PeekEventImpl ()->Cancel ();
+  if (id.GetUid () == 2)
     {
-      id.PeekEventImpl ()->Cancel ();
+      // destroy events are not in the event list
+      return;
+    }
+  m_cancelledEvents++;
+  if (m_purgeMode == PURGE_LAZY
+      && (uint32_t)m_unscheduledEvents >= m_purgeMinEvents
+      && m_cancelledEvents > m_purgeThreshold * m_unscheduledEvents)
+    {
+      Purge ();
     }
 }
 
+void
+DefaultSimulatorImpl::Purge (void)
+{
+  NS_LOG_FUNCTION (this << m_unscheduledEvents << m_cancelledEvents);
+  std::vector<Scheduler::Event> live;
+  live.reserve (m_unscheduledEvents - m_cancelledEvents);
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      if (next.impl->IsCancelled ())
+        {
+          next.impl->Unref ();
+          m_unscheduledEvents--;
+          m_purgedEvents++;
+        }
+      else
+        {
+          live.push_back (next);
+        }
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = live.begin (); i != live.end (); ++i)
+    {
+      m_events->Insert (*i);
+    }
+  m_cancelledEvents = 0;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
+uint64_t
+DefaultSimulatorImpl::GetPurgedEventCount (void) const
+{
+  return m_purgedEvents;
+}
+
 bool
 DefaultSimulatorImpl::IsExpired (const EventId &ev) const
 {
@@ -31,11 +31,35 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup simulator
+ *
+ * \brief The default single-threaded simulator implementation
+ *
+ * A cancelled event is normally only flagged, and stays in the event
+ * list until its expiration time. Timers which are rescheduled often
+ * can thus fill the event list with dead events. The CancelledEventPurge
+ * attribute selects another policy: removing each event from the event
+ * list as it is cancelled (cheap with the map and calendar schedulers,
+ * linear with the heap and list schedulers), or rebuilding the event
+ * list without its dead events once they make up more than the
+ * PurgeThreshold fraction of it.
+ */
 class DefaultSimulatorImpl : public SimulatorImpl
 {
 public:
   static TypeId GetTypeId (void);
 
+  /**
+   * \brief Policies for the events cancelled before their expiration
+   */
+  enum PurgeMode
+  {
+    PURGE_NONE,      /**< keep cancelled events until they expire */
+    PURGE_ON_CANCEL, /**< remove each event from the event list when it is cancelled */
+    PURGE_LAZY       /**< rebuild the event list when too many events are cancelled */
+  };
+
   DefaultSimulatorImpl ();
   ~DefaultSimulatorImpl ();
 
@@ -60,9 +84,24 @@ public:
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
 
+  /**
+   * \returns the number of events in the event list which will be invoked
+   */
+  uint32_t GetLiveEventCount (void) const;
+  /**
+   * \returns the number of cancelled events still in the event list
+   */
+  uint32_t GetCancelledEventCount (void) const;
+  /**
+   * \returns the number of cancelled events removed from the event list
+   *          before their expiration time since the start of the simulation
+   */
+  uint64_t GetPurgedEventCount (void) const;
+
 private:
   virtual void DoDispose (void);
   void ProcessOneEvent (void);
+  void Purge (void);
   uint64_t NextTs (void) const;
   typedef std::list<EventId> DestroyEvents;
 
@@ -76,6 +115,12 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  // number of cancelled events in m_events
+  uint32_t m_cancelledEvents;
+  uint64_t m_purgedEvents;
+  enum PurgeMode m_purgeMode;
+  double m_purgeThreshold;
+  uint32_t m_purgeMinEvents;
 };
 
 } // namespace ns3
@@ -19,9 +19,174 @@
  */
 
 #include "event-impl.h"
+#include "ns3/core-config.h"
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// Without thread-local storage, the pools are only safe when the
+// simulator cannot be driven by several threads.
+#if defined (HAVE_TLS)
+#define EVENT_POOL_ENABLED 1
+#define EVENT_POOL_STORAGE static __thread
+#if defined (HAVE_PTHREAD_H)
+#define EVENT_POOL_THREAD_EXIT 1
+#endif
+#elif !defined (HAVE_PTHREAD_H)
+#define EVENT_POOL_ENABLED 1
+#define EVENT_POOL_STORAGE static
+#endif
 
 namespace ns3 {
 
+namespace {
+
+// Events are rounded up to a multiple of the granularity; larger
+// events than the last size class come from the system allocator.
+const uint32_t EVENT_POOL_GRANULARITY = 16;
+const uint32_t EVENT_POOL_CLASSES = 16;
+// Deleted events kept for reuse per size class; the others go back to
+// the system, so that a thread deleting the events created by another
+// one does not hoard them.
+const uint32_t EVENT_POOL_MAX_FREE = 4096;
+
+struct EventPoolBlock
+{
+  EventPoolBlock *m_next;
+};
+
+struct EventPool
+{
+  EventPoolBlock *m_free[EVENT_POOL_CLASSES]; // deleted events
+  uint32_t m_nFree[EVENT_POOL_CLASSES];
+  uint64_t m_allocated;
+  uint64_t m_recycled;
+  bool m_atExit;
+};
+
+#ifdef EVENT_POOL_ENABLED
+EVENT_POOL_STORAGE EventPool g_eventPool;
+#else
+EventPool g_eventPool;
+#endif
+
+#ifdef EVENT_POOL_THREAD_EXIT
+void
+ReleaseEventPool (void *p)
+{
+  EventPool *pool = static_cast<EventPool *> (p);
+  for (uint32_t i = 0; i < EVENT_POOL_CLASSES; i++)
+    {
+      while (pool->m_free[i] != 0)
+        {
+          EventPoolBlock *block = pool->m_free[i];
+          pool->m_free[i] = block->m_next;
+          ::operator delete (block);
+        }
+      pool->m_nFree[i] = 0;
+    }
+}
+
+pthread_key_t g_eventPoolKey;
+pthread_once_t g_eventPoolKeyOnce = PTHREAD_ONCE_INIT;
+
+void
+CreateEventPoolKey (void)
+{
+  pthread_key_create (&g_eventPoolKey, &ReleaseEventPool);
+}
+
+// Give the deleted events of the calling thread back to the system when
+// it exits
+void
+ReleaseEventPoolAtExit (EventPool &pool)
+{
+  pool.m_atExit = true;
+  pthread_once (&g_eventPoolKeyOnce, &CreateEventPoolKey);
+  pthread_setspecific (g_eventPoolKey, &pool);
+}
+#endif
+
+} // anonymous namespace
+
+void *
+EventImpl::operator new (size_t size)
+{
+  EventPool &pool = g_eventPool;
+#ifdef EVENT_POOL_ENABLED
+  uint32_t sizeClass = (size + EVENT_POOL_GRANULARITY - 1) / EVENT_POOL_GRANULARITY - 1;
+  if (sizeClass < EVENT_POOL_CLASSES)
+    {
+      EventPoolBlock *block = pool.m_free[sizeClass];
+      if (block != 0)
+        {
+          pool.m_free[sizeClass] = block->m_next;
+          pool.m_nFree[sizeClass]--;
+          pool.m_recycled++;
+          return block;
+        }
+      pool.m_allocated++;
+      return ::operator new ((sizeClass + 1) * EVENT_POOL_GRANULARITY);
+    }
+#endif
+  pool.m_allocated++;
+  return ::operator new (size);
+}
+
+void
+EventImpl::operator delete (void *p, size_t size)
+{
+#ifdef EVENT_POOL_ENABLED
+  uint32_t sizeClass = (size + EVENT_POOL_GRANULARITY - 1) / EVENT_POOL_GRANULARITY - 1;
+  EventPool &pool = g_eventPool;
+  if (sizeClass < EVENT_POOL_CLASSES && pool.m_nFree[sizeClass] < EVENT_POOL_MAX_FREE)
+    {
+#ifdef EVENT_POOL_THREAD_EXIT
+      if (!pool.m_atExit)
+        {
+          ReleaseEventPoolAtExit (pool);
+        }
+#endif
+      EventPoolBlock *block = static_cast<EventPoolBlock *> (p);
+      block->m_next = pool.m_free[sizeClass];
+      pool.m_free[sizeClass] = block;
+      pool.m_nFree[sizeClass]++;
+      return;
+    }
+#endif
+  ::operator delete (p);
+}
+
+uint64_t
+EventImpl::GetAllocatedCount (void)
+{
+  return g_eventPool.m_allocated;
+}
+
+uint64_t
+EventImpl::GetRecycledCount (void)
+{
+  return g_eventPool.m_recycled;
+}
+
+uint64_t
+EventImpl::GetFreeCount (void)
+{
+  uint64_t n = 0;
+  for (uint32_t i = 0; i < EVENT_POOL_CLASSES; i++)
+    {
+      n += g_eventPool.m_nFree[i];
+    }
+  return n;
+}
+
+uint64_t
+EventImpl::GetMaxFreeCount (void)
+{
+  return EVENT_POOL_MAX_FREE;
+}
+
 EventImpl::~EventImpl ()
 {
 }
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "ns3/simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +36,13 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Events are allocated from size-classed free lists rather than from the
+ * system allocator: the memory of a deleted event is kept by the thread
+ * which deletes it, and reused for the next event of the same size class
+ * created by that thread. Each thread keeps at most GetMaxFreeCount
+ * deleted events of each size class and gives the others back to the
+ * system, as well as its whole pool when it exits.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -58,6 +66,30 @@ public:
    */
   bool IsCancelled (void);
 
+  void *operator new (size_t size);
+  void operator delete (void *p, size_t size);
+
+  /**
+   * \returns the number of events created by the calling thread in
+   *          memory not used by an event before.
+   */
+  static uint64_t GetAllocatedCount (void);
+  /**
+   * \returns the number of events created by the calling thread in
+   *          the memory of a deleted event.
+   */
+  static uint64_t GetRecycledCount (void);
+  /**
+   * \returns the number of deleted events kept by the calling thread
+   *          for reuse.
+   */
+  static uint64_t GetFreeCount (void);
+  /**
+   * \returns the largest number of deleted events of one size class
+   *          a thread keeps.
+   */
+  static uint64_t GetMaxFreeCount (void);
+
 protected:
   virtual void Notify (void) = 0;
 
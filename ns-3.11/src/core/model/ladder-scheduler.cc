@@ -0,0 +1,319 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+    .AddAttribute ("BucketThreshold",
+                   "Number of events in a bucket beyond which it is spread over a new rung",
+                   UintegerValue (50),
+                   MakeUintegerAccessor (&LadderScheduler::m_threshold),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxRungs",
+                   "Maximum number of rungs in the ladder",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&LadderScheduler::m_maxRungs),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+static bool
+EventGreater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_threshold (50),
+    m_maxRungs (8),
+    m_topStart (0),
+    m_topMin (~(uint64_t)0),
+    m_topMax (0),
+    m_nRungs (0),
+    m_bottomLimit (50),
+    m_count (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.m_start + rung.m_current * rung.m_width;
+}
+
+LadderScheduler::Rung &
+LadderScheduler::PushRung (uint64_t start, uint64_t span, uint32_t nEvents)
+{
+  NS_LOG_FUNCTION (this << start << span << nEvents);
+  if (m_rungs.size () == m_nRungs)
+    {
+      m_rungs.reserve (std::max (m_maxRungs, m_nRungs + 1));
+      m_rungs.push_back (Rung ());
+    }
+  Rung &rung = m_rungs[m_nRungs];
+  m_nRungs++;
+  // One bucket per event on average
+  uint32_t n = std::max<uint32_t> (nEvents, 1);
+  rung.m_start = start;
+  rung.m_width = std::max<uint64_t> ((span + n - 1) / n, 1);
+  rung.m_nBuckets = (span + rung.m_width - 1) / rung.m_width;
+  rung.m_current = 0;
+  rung.m_count = 0;
+  if (rung.m_buckets.size () < rung.m_nBuckets)
+    {
+      rung.m_buckets.resize (rung.m_nBuckets);
+    }
+  NS_LOG_LOGIC ("rung " << m_nRungs - 1 << " start=" << start << " width=" << rung.m_width
+                        << " buckets=" << rung.m_nBuckets);
+  return rung;
+}
+
+void
+LadderScheduler::Spread (Bucket &events, Rung &rung)
+{
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      uint64_t index = (i->key.m_ts - rung.m_start) / rung.m_width;
+      NS_ASSERT (index < rung.m_nBuckets);
+      rung.m_buckets[index].push_back (*i);
+    }
+  rung.m_count += events.size ();
+  events.clear ();
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size ());
+  NS_ASSERT (!m_top.empty ());
+  Rung &rung = PushRung (m_topMin, m_topMax - m_topMin + 1, m_top.size ());
+  m_topStart = rung.m_start + rung.m_nBuckets * rung.m_width;
+  Spread (m_top, rung);
+  m_topMin = ~(uint64_t)0;
+  m_topMax = 0;
+}
+
+void
+LadderScheduler::SpawnFromBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_bottom.size ());
+  uint64_t start = m_bottom.back ().key.m_ts;
+  uint64_t limit = m_nRungs ? CurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+  m_spawn.swap (m_bottom);
+  Spread (m_spawn, PushRung (start, limit - start, m_spawn.size ()));
+  m_bottomLimit = m_threshold;
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  m_bottom.insert (std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, EventGreater), ev);
+}
+
+bool
+LadderScheduler::HasSingleTimestamp (const Bucket &bucket) const
+{
+  for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_ts != bucket.front ().key.m_ts)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_count++;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= CurrentStart (rung))
+        {
+          uint64_t index = (ts - rung.m_start) / rung.m_width;
+          NS_ASSERT (index < rung.m_nBuckets);
+          rung.m_buckets[index].push_back (ev);
+          rung.m_count++;
+          return;
+        }
+    }
+  InsertBottom (ev);
+  // Spreading the bottom again only once it has doubled keeps inserts
+  // amortized constant even with many events at the same time
+  if (m_bottom.size () > m_bottomLimit && m_nRungs < m_maxRungs
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      SpawnFromBottom ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_count == 0;
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.m_current < rung.m_nBuckets && rung.m_buckets[rung.m_current].empty ())
+        {
+          rung.m_current++;
+        }
+      if (rung.m_current == rung.m_nBuckets)
+        {
+          NS_ASSERT (rung.m_count == 0);
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.m_buckets[rung.m_current];
+      uint64_t start = CurrentStart (rung);
+      uint64_t width = rung.m_width;
+      rung.m_current++;
+      rung.m_count -= bucket.size ();
+      if (bucket.size () > m_threshold && m_nRungs < m_maxRungs && !HasSingleTimestamp (bucket))
+        {
+          // PushRung may move the rungs, so the bucket is emptied first
+          m_spawn.swap (bucket);
+          Spread (m_spawn, PushRung (start, width, m_spawn.size ()));
+          continue;
+        }
+      m_bottom.swap (bucket);
+      std::sort (m_bottom.begin (), m_bottom.end (), EventGreater);
+      m_bottomLimit = std::max<uint32_t> (m_threshold, 2 * m_bottom.size ());
+    }
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // Sorting the next bucket does not change the set of events
+  const_cast<LadderScheduler *> (this)->Refill ();
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Refill ();
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_count--;
+  return ev;
+}
+
+bool
+LadderScheduler::RemoveFrom (Bucket &bucket, const Event &ev)
+{
+  for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (i->impl == ev.impl);
+          // Buckets are not sorted
+          *i = bucket.back ();
+          bucket.pop_back ();
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  m_count--;
+  uint64_t ts = ev.key.m_ts;
+  if (ts >= m_topStart)
+    {
+      if (!RemoveFrom (m_top, ev))
+        {
+          NS_FATAL_ERROR ("Event " << ev.key.m_uid << " not found");
+        }
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= CurrentStart (rung))
+        {
+          if (!RemoveFrom (rung.m_buckets[(ts - rung.m_start) / rung.m_width], ev))
+            {
+              NS_FATAL_ERROR ("Event " << ev.key.m_uid << " not found");
+            }
+          rung.m_count--;
+          return;
+        }
+    }
+  Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, EventGreater);
+  if (i == m_bottom.end () || i->key.m_uid != ev.key.m_uid)
+    {
+      NS_FATAL_ERROR ("Event " << ev.key.m_uid << " not found");
+    }
+  m_bottom.erase (i);
+}
+
+} // namespace ns3
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in "Ladder
+ * Queue: An O(1) Priority Queue Structure for Large-Scale Discrete Event
+ * Simulation" by Wai Teng Tang, Rick Siow Mong Goh and Ian Li-Jin Thng
+ * (ACM TOMACS, 2005).
+ *
+ * Events far in the future are appended, unsorted, to the top list. When
+ * the events of the near future are exhausted, the top list is spread over
+ * the buckets of a first rung, whose width is derived from the span and
+ * number of the events it receives. A bucket holding more than
+ * BucketThreshold events is in turn spread over a finer rung, so the
+ * queue tunes itself to the event distribution instead of relying on a
+ * resizing heuristic. Only the bucket about to be consumed is sorted,
+ * into the small bottom list from which events are removed.
+ *
+ * All the lists are vectors, and the vectors of a rung are kept, cleared,
+ * when the rung is consumed, so a queue in steady state does not allocate.
+ * Insert and RemoveNext are amortized O(1); Remove is linear in the size
+ * of the list holding the event.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  struct Rung
+  {
+    uint64_t m_start;                // timestamp of the first bucket
+    uint64_t m_width;                // duration of a bucket
+    uint32_t m_current;              // index of the first bucket not consumed yet
+    uint32_t m_nBuckets;             // number of buckets in use
+    uint32_t m_count;                // number of events in the rung
+    std::vector<Bucket> m_buckets;
+  };
+
+  uint64_t CurrentStart (const Rung &rung) const;
+  Rung &PushRung (uint64_t start, uint64_t span, uint32_t nEvents);
+  void Spread (Bucket &events, Rung &rung);
+  void TransferTop (void);
+  void SpawnFromBottom (void);
+  void InsertBottom (const Event &ev);
+  bool RemoveFrom (Bucket &bucket, const Event &ev);
+  bool HasSingleTimestamp (const Bucket &bucket) const;
+  void Refill (void);
+
+  uint32_t m_threshold;              // max events in a bucket before spawning a rung
+  uint32_t m_maxRungs;               // max number of rungs
+
+  Bucket m_top;                      // unsorted events at or after m_topStart
+  uint64_t m_topStart;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  std::vector<Rung> m_rungs;         // rungs, kept allocated for reuse
+  uint32_t m_nRungs;                 // number of rungs in use
+  Bucket m_bottom;                   // events sorted in decreasing order
+  uint32_t m_bottomLimit;            // bottom size beyond which a rung is spawned from it
+  Bucket m_spawn;                    // events of a bucket being spread over a new rung
+  uint32_t m_count;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
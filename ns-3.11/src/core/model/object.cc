@@ -25,6 +25,7 @@
 #include "attribute.h"
 #include "log.h"
 #include "string.h"
+#include <algorithm>
 #include <vector>
 #include <sstream>
 #include <stdlib.h>
@@ -85,15 +86,17 @@ Object::Object ()
   : m_tid (Object::GetTypeId ()),
     m_disposed (false),
     m_started (false),
-    m_aggregates ((struct Aggregates *) malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates ((struct Aggregates *) malloc (sizeof (struct Aggregates)))
 {
   m_aggregates->n = 1;
+  m_aggregates->lookupN = 0;
+  m_aggregates->lookup = 0;
   m_aggregates->buffer[0] = this;
 }
 Object::~Object () 
 {
   // remove this object from the aggregate list
+  ClearLookup (m_aggregates);
   uint32_t n = m_aggregates->n;
   for (uint32_t i = 0; i < n; i++)
     {
@@ -118,10 +121,11 @@ Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_started (false),
-    m_aggregates ((struct Aggregates *) malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_aggregates ((struct Aggregates *) malloc (sizeof (struct Aggregates)))
 {
   m_aggregates->n = 1;
+  m_aggregates->lookupN = 0;
+  m_aggregates->lookup = 0;
   m_aggregates->buffer[0] = this;
 }
 void
@@ -135,33 +139,64 @@ Object::DoGetObject (TypeId tid) const
 {
   NS_ASSERT (CheckLoose ());
 
-  uint32_t n = m_aggregates->n;
+  struct Aggregates *aggregates = m_aggregates;
+  if (aggregates->lookup == 0)
+    {
+      BuildLookup (aggregates);
+    }
+  uint16_t uid = tid.GetUid ();
+  // An aggregated object is never of a type registered after the
+  // table was built.
+  if (uid >= aggregates->lookupN)
+    {
+      return 0;
+    }
+  return aggregates->lookup[uid];
+}
+void
+Object::BuildLookup (struct Aggregates *aggregates)
+{
   TypeId objectTid = Object::GetTypeId ();
-  for (uint32_t i = 0; i < n; i++)
+  uint32_t lookupN = objectTid.GetUid () + 1;
+  for (uint32_t i = 0; i < aggregates->n; i++)
     {
-      Object *current = m_aggregates->buffer[i];
-      TypeId cur = current->GetInstanceTypeId ();
-      while (cur != tid && cur != objectTid)
+      // A parent may be registered after its child so, we look at
+      // the whole chain.
+      for (TypeId cur = aggregates->buffer[i]->GetInstanceTypeId ();
+           cur != objectTid; cur = cur.GetParent ())
         {
-          cur = cur.GetParent ();
+          lookupN = std::max<uint32_t> (lookupN, cur.GetUid () + 1);
         }
-      if (cur == tid)
+    }
+  Object **lookup = (Object **) calloc (lookupN, sizeof (Object *));
+  for (uint32_t i = 0; i < aggregates->n; i++)
+    {
+      Object *current = aggregates->buffer[i];
+      TypeId cur = current->GetInstanceTypeId ();
+      while (true)
         {
-          // This is an attempt to 'cache' the result of this lookup.
-          // the idea is that if we perform a lookup for a TypeId on this object,
-          // we are likely to perform the same lookup later so, we make sure
-          // that the aggregate array is sorted by the number of accesses
-          // to each object.
-
-          // first, increment the access count
-          current->m_getObjectCount++;
-          // then, update the sort
-          UpdateSortedArray (m_aggregates, i);
-          // finally, return the match
-          return const_cast<Object *> (current);
+          // the first object of a type in the aggregate array is the
+          // one returned for this type.
+          if (lookup[cur.GetUid ()] == 0)
+            {
+              lookup[cur.GetUid ()] = current;
+            }
+          if (cur == objectTid)
+            {
+              break;
+            }
+          cur = cur.GetParent ();
         }
     }
-  return 0;
+  aggregates->lookup = lookup;
+  aggregates->lookupN = lookupN;
+}
+void
+Object::ClearLookup (struct Aggregates *aggregates)
+{
+  free (aggregates->lookup);
+  aggregates->lookup = 0;
+  aggregates->lookupN = 0;
 }
 void
 Object::Start (void)
@@ -211,18 +246,6 @@ restart:
         }
     }
 }
-void
-Object::UpdateSortedArray (struct Aggregates *aggregates, uint32_t j) const
-{
-  while (j > 0 && 
-         aggregates->buffer[j]->m_getObjectCount > aggregates->buffer[j-1]->m_getObjectCount)
-    {
-      Object *tmp = aggregates->buffer[j-1];
-      aggregates->buffer[j-1] = aggregates->buffer[j];
-      aggregates->buffer[j] = tmp;
-      j--;
-    }
-}
 void 
 Object::AggregateObject (Ptr<Object> o)
 {
@@ -244,6 +267,8 @@ Object::AggregateObject (Ptr<Object> o)
   struct Aggregates *aggregates = 
     (struct Aggregates *)malloc (sizeof(struct Aggregates)+(total-1)*sizeof(Object*));
   aggregates->n = total;
+  aggregates->lookupN = 0;
+  aggregates->lookup = 0;
 
   // copy our buffer to the new buffer
   memcpy (&aggregates->buffer[0], 
@@ -254,7 +279,6 @@ Object::AggregateObject (Ptr<Object> o)
   for (uint32_t i = 0; i < other->m_aggregates->n; i++)
     {
       aggregates->buffer[m_aggregates->n+i] = other->m_aggregates->buffer[i];
-      UpdateSortedArray (aggregates, m_aggregates->n + i);
     }
 
   // keep track of the old aggregate buffers for the iteration
@@ -287,6 +311,8 @@ Object::AggregateObject (Ptr<Object> o)
     }
 
   // Now that we are done with them, we can free our old aggregate buffers
+  ClearLookup (a);
+  ClearLookup (b);
   free (a);
   free (b);
 }
@@ -242,9 +242,18 @@ private:
    * chunk of memory than the struct to allow space for a larger
    * variable sized buffer whose size is indicated by the element
    * 'n'
+   *
+   * 'lookup' is a table indexed by TypeId uid which holds, for the
+   * TypeId of each aggregated object and for each of its parents, the
+   * first aggregated object of this type. It is built on the first
+   * call to DoGetObject and dropped whenever the set of aggregated
+   * objects changes. 'lookupN' is the number of entries in the table:
+   * no aggregated object has a type with a larger uid.
    */
   struct Aggregates {
     uint32_t n;
+    uint32_t lookupN;
+    Object **lookup;
     Object *buffer[1];
   };
 
@@ -269,7 +278,8 @@ private:
   */
   void Construct (const AttributeList &attributes);
 
-  void UpdateSortedArray (struct Aggregates *aggregates, uint32_t i) const;
+  static void BuildLookup (struct Aggregates *aggregates);
+  static void ClearLookup (struct Aggregates *aggregates);
   /**
    * Attempt to delete this object. This method iterates
    * over all aggregated objects to check if they all 
@@ -299,13 +309,6 @@ private:
    * so the size of the array is indirectly a reference count.
    */
   struct Aggregates * m_aggregates;
-  /**
-   * Indicates the number of times the object was accessed with a
-   * call to GetObject. This integer is used to implement a
-   * heuristic to sort the array of aggregates to put at the start
-   * of the array the most-frequently accessed elements.
-   */
-  uint32_t m_getObjectCount;
 };
 
 /**
@@ -388,20 +391,14 @@ template <typename T>
 Ptr<T> 
 Object::GetObject () const
 {
-  // This is an optimization: if the cast works (which is likely),
-  // things will be pretty fast.
-  T *result = dynamic_cast<T *> (m_aggregates->buffer[0]);
-  if (result != 0)
-    {
-      return Ptr<T> (result);
-    }
-  // if the cast does not work, we try to do a full type check.
   Ptr<Object> found = DoGetObject (T::GetTypeId ());
   if (found != 0)
     {
       return Ptr<T> (static_cast<T *> (PeekPointer (found)));
     }
-  return 0;
+  // An object which was not created with CreateObject does not know
+  // its TypeId, but may still be of the requested type.
+  return Ptr<T> (dynamic_cast<T *> (m_aggregates->buffer[0]));
 }
 
 template <typename T>
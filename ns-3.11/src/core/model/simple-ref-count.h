@@ -24,6 +24,7 @@
 
 #include "empty.h"
 #include "default-deleter.h"
+#include "ns3/core-config.h"
 #include <stdint.h>
 
 namespace ns3 {
@@ -55,6 +56,10 @@ namespace ns3 {
  *      SimpleRefCount template detects that no references to the object
  *      it manages exist anymore.
  *
+ * When ns-3 is configured with --enable-multithreaded-simulator, the
+ * reference count is updated atomically so that objects can be shared
+ * by the threads of the multithreaded simulator.
+ *
  * Interesting users of this class include ns3::Object as well as ns3::Packet.
  */
 template <typename T, typename PARENT = empty, typename DELETER = DefaultDeleter<T> >
@@ -79,7 +84,11 @@ public:
    */
   inline void Ref (void) const
   {
+#ifdef NS3_MULTITHREADED
+    __sync_add_and_fetch (&m_count, 1);
+#else
     m_count++;
+#endif
   }
   /**
    * Decrement the reference count. This method should not be called
@@ -89,8 +98,12 @@ public:
    */
   inline void Unref (void) const
   {
+#ifdef NS3_MULTITHREADED
+    if (__sync_sub_and_fetch (&m_count, 1) == 0)
+#else
     m_count--;
     if (m_count == 0)
+#endif
       {
         DELETER::Delete (static_cast<T*> (const_cast<SimpleRefCount *> (this)));
       }
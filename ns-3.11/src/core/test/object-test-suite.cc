@@ -89,6 +89,22 @@ public:
   }
 };
 
+// Not registered at startup: its TypeId is registered the first time
+// it is used.
+class LateC : public ns3::Object
+{
+public:
+  static ns3::TypeId GetTypeId (void) {
+    static ns3::TypeId tid = ns3::TypeId ("LateC")
+      .SetParent (Object::GetTypeId ())
+      .HideFromDocumentation ()
+      .AddConstructor<LateC> ();
+    return tid;
+  }
+  LateC ()
+  {}
+};
+
 NS_OBJECT_ENSURE_REGISTERED (BaseA);
 NS_OBJECT_ENSURE_REGISTERED (DerivedA);
 NS_OBJECT_ENSURE_REGISTERED (BaseB);
@@ -335,6 +351,58 @@ AggregateObjectTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (baseA, 0, "Unable to GetObject on released object");
 }
 
+// ===========================================================================
+// Test case to make sure that the GetObject lookup table follows the
+// aggregates.
+// ===========================================================================
+class GetObjectLookupTestCase : public TestCase
+{
+public:
+  GetObjectLookupTestCase ();
+  virtual ~GetObjectLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+GetObjectLookupTestCase::GetObjectLookupTestCase ()
+  : TestCase ("Check the GetObject lookup table")
+{
+}
+
+GetObjectLookupTestCase::~GetObjectLookupTestCase ()
+{
+}
+
+void
+GetObjectLookupTestCase::DoRun (void)
+{
+  Ptr<DerivedA> derivedA = CreateObject<DerivedA> ();
+  Ptr<DerivedB> derivedB = CreateObject<DerivedB> ();
+  derivedA->AggregateObject (derivedB);
+
+  //
+  // The parents of the aggregated objects are found too.
+  //
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<BaseB> (), derivedB, "GetObject() of a parent type failed");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<BaseA> (), derivedA, "GetObject() of a parent type failed");
+  NS_TEST_ASSERT_MSG_EQ (derivedB->GetObject<Object> (), derivedA, "GetObject<Object> () should return the first object");
+
+  //
+  // A type registered after the table was built is not in the table.
+  //
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<LateC> (), 0, "GetObject() of a new type returns nonzero pointer");
+
+  //
+  // Aggregating an object must drop the table of all the objects.
+  //
+  Ptr<LateC> lateC = CreateObject<LateC> ();
+  derivedB->AggregateObject (lateC);
+  NS_TEST_ASSERT_MSG_EQ (derivedA->GetObject<LateC> (), lateC, "GetObject() after AggregateObject failed");
+  NS_TEST_ASSERT_MSG_EQ (lateC->GetObject<DerivedA> (), derivedA, "GetObject() after AggregateObject failed");
+  NS_TEST_ASSERT_MSG_EQ (lateC->GetObject<BaseB> (), derivedB, "GetObject() after AggregateObject failed");
+}
+
 // ===========================================================================
 // Test case to make sure that an Object factory can create Objects
 // ===========================================================================
@@ -421,6 +489,7 @@ ObjectTestSuite::ObjectTestSuite ()
 {
   AddTestCase (new CreateObjectTestCase);
   AddTestCase (new AggregateObjectTestCase);
+  AddTestCase (new GetObjectLookupTestCase);
   AddTestCase (new ObjectFactoryTestCase);
 }
 
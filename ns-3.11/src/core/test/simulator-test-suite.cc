@@ -24,6 +24,12 @@
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
 #include "ns3/ns2-calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -460,6 +466,210 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+private:
+  uint32_t Random (uint32_t max);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_seed;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the event order of " + schedulerFactory.GetTypeId ().GetName ()
+              + " against ns3::MapScheduler"),
+    m_schedulerFactory (schedulerFactory),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (uint32_t max)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 8) % max;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  // A hold model mixing near and far events, bursts of events at the
+  // same time, and removals of arbitrary events
+  for (uint32_t i = 0; i < 20000; i++)
+    {
+      uint32_t burst = (i % 1000 == 0) ? 200 : 1 + Random (2);
+      for (uint32_t j = 0; j < burst; j++)
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + ((i % 1000 == 0) ? 5 : Random (4) == 0 ? Random (1000000) : Random (100));
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          pending.push_back (ev);
+        }
+      if (Random (8) == 0 && !pending.empty ())
+        {
+          uint32_t k = Random (pending.size ());
+          if (pending[k].key.m_ts > now)
+            {
+              scheduler->Remove (pending[k]);
+              reference->Remove (pending[k]);
+            }
+          pending[k] = pending.back ();
+          pending.pop_back ();
+        }
+      for (uint32_t j = 0; j < 2 && !reference->IsEmpty (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "Scheduler should not be empty");
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid, expected.key.m_uid, "Wrong next event");
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.key.m_uid, "Wrong event order");
+          now = ev.key.m_ts;
+        }
+    }
+  while (!reference->IsEmpty ())
+    {
+      Scheduler::Event expected = reference->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, expected.key.m_uid, "Wrong event order");
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "Scheduler should be empty");
+}
+
+class EventPoolTestCase : public TestCase
+{
+public:
+  EventPoolTestCase ();
+  virtual void DoRun (void);
+  void Count (uint32_t a);
+  void CountMore (uint32_t a, uint64_t b, double c, uint32_t d);
+  uint32_t m_count;
+};
+
+EventPoolTestCase::EventPoolTestCase ()
+  : TestCase ("Check that the memory of expired events is reused")
+{
+}
+
+void
+EventPoolTestCase::Count (uint32_t a)
+{
+  m_count += a;
+}
+
+void
+EventPoolTestCase::CountMore (uint32_t a, uint64_t b, double c, uint32_t d)
+{
+  m_count += a + d;
+}
+
+void
+EventPoolTestCase::DoRun (void)
+{
+  m_count = 0;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventPoolTestCase::Count, this, 1);
+      Simulator::Schedule (MicroSeconds (i), &EventPoolTestCase::CountMore, this, 1, 2, 3.0, 1);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_count, 3000, "Events did not run");
+
+  uint64_t allocated = EventImpl::GetAllocatedCount ();
+  uint64_t recycled = EventImpl::GetRecycledCount ();
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventPoolTestCase::Count, this, 1);
+      Simulator::Schedule (MicroSeconds (i), &EventPoolTestCase::CountMore, this, 1, 2, 3.0, 1);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_count, 6000, "Events did not run");
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetAllocatedCount () + EventImpl::GetRecycledCount (),
+                         allocated + recycled + 2000, "Every event should be counted");
+  NS_TEST_ASSERT_MSG_EQ (EventImpl::GetAllocatedCount (), allocated, "Expired events should be reused");
+  Simulator::Destroy ();
+}
+
+class CancelledEventPurgeTestCase : public TestCase
+{
+public:
+  CancelledEventPurgeTestCase (std::string mode);
+  virtual void DoRun (void);
+  void Timeout (uint32_t i);
+  std::string m_mode;
+  std::vector<EventId> m_timers;
+  uint32_t m_expired;
+};
+
+CancelledEventPurgeTestCase::CancelledEventPurgeTestCase (std::string mode)
+  : TestCase ("Check the accounting of cancelled events with the " + mode + " purge policy"),
+    m_mode (mode)
+{
+}
+
+void
+CancelledEventPurgeTestCase::Timeout (uint32_t i)
+{
+  m_expired++;
+}
+
+void
+CancelledEventPurgeTestCase::DoRun (void)
+{
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Default simulator implementation expected");
+  impl->SetAttribute ("CancelledEventPurge", StringValue (m_mode));
+  impl->SetAttribute ("PurgeMinEvents", UintegerValue (100));
+
+  m_expired = 0;
+  m_timers.clear ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      m_timers.push_back (Simulator::Schedule (Seconds (1), &CancelledEventPurgeTestCase::Timeout, this, i));
+    }
+  // Timers rescheduled over and over, like the TCP retransmission timer
+  for (uint32_t round = 0; round < 20; round++)
+    {
+      for (uint32_t i = 0; i < m_timers.size (); i++)
+        {
+          m_timers[i].Cancel ();
+          m_timers[i] = Simulator::Schedule (Seconds (2 + round), &CancelledEventPurgeTestCase::Timeout, this, i);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (impl->GetLiveEventCount (), 100, "Wrong number of live events");
+  uint32_t total = impl->GetLiveEventCount () + impl->GetCancelledEventCount ();
+  if (m_mode == "None")
+    {
+      NS_TEST_ASSERT_MSG_EQ (impl->GetCancelledEventCount (), 2000, "Cancelled events should be kept");
+      NS_TEST_ASSERT_MSG_EQ (impl->GetPurgedEventCount (), 0, "No event should be purged");
+    }
+  else if (m_mode == "OnCancel")
+    {
+      NS_TEST_ASSERT_MSG_EQ (impl->GetCancelledEventCount (), 0, "Cancelled events should be removed");
+      NS_TEST_ASSERT_MSG_EQ (impl->GetPurgedEventCount (), 2000, "Cancelled events should be removed");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_LT (total, 300, "The event list should have been rebuilt");
+      NS_TEST_ASSERT_MSG_EQ (impl->GetPurgedEventCount () + impl->GetCancelledEventCount (), 2000,
+                             "Every cancelled event should be accounted for");
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_expired, 100, "Only the last timers should expire");
+  NS_TEST_ASSERT_MSG_EQ (impl->GetLiveEventCount (), 0, "No event should be left");
+  NS_TEST_ASSERT_MSG_EQ (impl->GetCancelledEventCount (), 0, "No event should be left");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -478,6 +688,16 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory));
     factory.SetTypeId (Ns2CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory));
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory));
+    AddTestCase (new SchedulerOrderTestCase (factory));
+    factory.Set ("BucketThreshold", UintegerValue (4));
+    factory.Set ("MaxRungs", UintegerValue (3));
+    AddTestCase (new SchedulerOrderTestCase (factory));
+    AddTestCase (new EventPoolTestCase ());
+    AddTestCase (new CancelledEventPurgeTestCase ("None"));
+    AddTestCase (new CancelledEventPurgeTestCase ("OnCancel"));
+    AddTestCase (new CancelledEventPurgeTestCase ("Lazy"));
   }
 } g_simulatorTestSuite;
 
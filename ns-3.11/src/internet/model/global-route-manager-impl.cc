@@ -699,8 +699,10 @@ GlobalRouteManagerImpl::InitializeRoutes ()
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
 
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != MpiInterface::GetSystemId ()) 
+      // Ignore nodes that are not assigned to our systemId (distributed sim);
+      // without MPI, the system ids are the partitions of the multithreaded
+      // simulator, which all live in this process
+      if (MpiInterface::IsEnabled () && node->GetSystemId () != MpiInterface::GetSystemId ()) 
         {
           continue;
         }
@@ -715,6 +717,21 @@ GlobalRouteManagerImpl::InitializeRoutes ()
         }
     }
   NS_LOG_INFO ("Finished SPF calculation");
+//
+// Now that every routing table is complete, compile the forwarding tables
+// used on the lookup fast path so that the first packets do not pay for it.
+//
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0
+          || (MpiInterface::IsEnabled () && node->GetSystemId () != MpiInterface::GetSystemId ()))
+        {
+          continue;
+        }
+      rtr->GetRoutingProtocol ()->CompileFib ();
+    }
 }
 
 //
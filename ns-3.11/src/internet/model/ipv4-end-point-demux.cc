@@ -26,8 +26,44 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+// The ephemeral ports are 49152 to 65535
+static const uint16_t EPHEMERAL_FIRST = 49152;
+
+Ipv4EndPointDemux::FourTuple::FourTuple (Ipv4Address localAddress, uint16_t localPort,
+                                         Ipv4Address peerAddress, uint16_t peerPort)
+  : m_localAddress (localAddress.Get ()),
+    m_peerAddress (peerAddress.Get ()),
+    m_localPort (localPort),
+    m_peerPort (peerPort)
+{
+}
+
+bool
+Ipv4EndPointDemux::FourTuple::operator == (const FourTuple &o) const
+{
+  return m_localAddress == o.m_localAddress && m_peerAddress == o.m_peerAddress
+         && m_localPort == o.m_localPort && m_peerPort == o.m_peerPort;
+}
+
+size_t
+Ipv4EndPointDemux::FourTupleHash::operator () (const FourTuple &x) const
+{
+  uint32_t h = x.m_localAddress * 0x9e3779b1;
+  h = (h ^ (h >> 15) ^ x.m_peerAddress) * 0x85ebca6b;
+  h = (h ^ (h >> 13) ^ ((uint32_t)x.m_localPort << 16 | x.m_peerPort)) * 0xc2b2ae35;
+  return h ^ (h >> 16);
+}
+
+size_t
+Ipv4EndPointDemux::PortHash::operator () (uint16_t x) const
+{
+  return x;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152)
+  : m_ephemeral (EPHEMERAL_FIRST),
+    m_nEndPoints (0),
+    m_ephemeralPorts ((65536 - EPHEMERAL_FIRST) / 32, 0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -35,41 +71,116 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPoints endPoints = GetAllEndPoints ();
+  m_connected.clear ();
+  m_unconnected.clear ();
+  m_portCounts.clear ();
+  m_localCounts.clear ();
+  m_nEndPoints = 0;
+  for (EndPointsI i = endPoints.begin (); i != endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
-  m_endPoints.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return endPoint->GetPeerPort () != 0 
+         && endPoint->GetPeerAddress () != Ipv4Address::GetAny ();
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  uint16_t port = endPoint->GetLocalPort ();
+  if (IsConnected (endPoint))
+    {
+      FourTuple key (endPoint->GetLocalAddress (), port,
+                     endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      m_connected[key].push_back (endPoint);
+    }
+  else
+    {
+      m_unconnected[port].push_back (endPoint);
+    }
+  if (m_portCounts[port]++ == 0 && port >= EPHEMERAL_FIRST)
+    {
+      uint32_t bit = port - EPHEMERAL_FIRST;
+      m_ephemeralPorts[bit / 32] |= 1U << (bit % 32);
+    }
+  m_localCounts[FourTuple (endPoint->GetLocalAddress (), port, Ipv4Address::GetAny (), 0)]++;
+}
+
+void
+Ipv4EndPointDemux::Remove (Ipv4EndPoint *endPoint)
+{
+  uint16_t port = endPoint->GetLocalPort ();
+  if (IsConnected (endPoint))
+    {
+      FourTuple key (endPoint->GetLocalAddress (), port,
+                     endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      ConnectedEndPoints::iterator bucket = m_connected.find (key);
+      NS_ASSERT (bucket != m_connected.end ());
+      bucket->second.remove (endPoint);
+      if (bucket->second.empty ())
+        {
+          m_connected.erase (bucket);
+        }
+    }
+  else
+    {
+      PortEndPoints::iterator bucket = m_unconnected.find (port);
+      NS_ASSERT (bucket != m_unconnected.end ());
+      bucket->second.remove (endPoint);
+      if (bucket->second.empty ())
+        {
+          m_unconnected.erase (bucket);
+        }
+    }
+  PortCounts::iterator count = m_portCounts.find (port);
+  NS_ASSERT (count != m_portCounts.end ());
+  if (--count->second == 0)
     {
-      if ((*i)->GetLocalPort  () == port) 
+      m_portCounts.erase (count);
+      if (port >= EPHEMERAL_FIRST)
         {
-          return true;
+          uint32_t bit = port - EPHEMERAL_FIRST;
+          m_ephemeralPorts[bit / 32] &= ~(1U << (bit % 32));
         }
     }
-  return false;
+  LocalCounts::iterator local = m_localCounts.find (FourTuple (endPoint->GetLocalAddress (), port, Ipv4Address::GetAny (), 0));
+  NS_ASSERT (local != m_localCounts.end ());
+  if (--local->second == 0)
+    {
+      m_localCounts.erase (local);
+    }
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::AddEndPoint (Ipv4EndPoint *endPoint)
+{
+  endPoint->m_demux = this;
+  Insert (endPoint);
+  m_nEndPoints++;
+  NS_LOG_DEBUG ("Now have >>" << m_nEndPoints << "<< endpoints.");
+  return endPoint;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_portCounts.find (port) != m_portCounts.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_localCounts.find (FourTuple (addr, port, Ipv4Address::GetAny (), 0)) != m_localCounts.end ();
 }
 
 Ipv4EndPoint *
@@ -82,10 +193,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return AddEndPoint (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -98,10 +206,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return AddEndPoint (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -121,10 +226,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return AddEndPoint (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -132,40 +234,48 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  const EndPoints *candidates;
+  if (peerPort != 0 && peerAddress != Ipv4Address::GetAny ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      candidates = FindConnected (localAddress, localPort, peerAddress, peerPort);
+    }
+  else
+    {
+      PortEndPoints::const_iterator bucket = m_unconnected.find (localPort);
+      candidates = bucket == m_unconnected.end () ? 0 : &bucket->second;
+    }
+  if (candidates != 0)
+    {
+      for (EndPoints::const_iterator i = candidates->begin (); i != candidates->end (); i++)
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if ((*i)->GetLocalPort () == localPort &&
+              (*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress) 
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return AddEndPoint (endPoint);
 }
 
 void 
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Remove (endPoint);
+  m_nEndPoints--;
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -177,14 +287,29 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION_NOARGS ();
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (PortEndPoints::iterator i = m_unconnected.begin (); i != m_unconnected.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-      ret.push_back (endP);
+      ret.insert (ret.end (), i->second.begin (), i->second.end ());
+    }
+  for (ConnectedEndPoints::iterator i = m_connected.begin (); i != m_connected.end (); i++)
+    {
+      ret.insert (ret.end (), i->second.begin (), i->second.end ());
     }
   return ret;
 }
 
+const Ipv4EndPointDemux::EndPoints *
+Ipv4EndPointDemux::FindConnected (Ipv4Address localAddress, uint16_t localPort,
+                                  Ipv4Address peerAddress, uint16_t peerPort) const
+{
+  ConnectedEndPoints::const_iterator bucket =
+    m_connected.find (FourTuple (localAddress, localPort, peerAddress, peerPort));
+  if (bucket == m_connected.end ())
+    {
+      return 0;
+    }
+  return &bucket->second;
+}
 
 /*
  * If we have an exact match, we return it.
@@ -197,114 +322,179 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
                            Ptr<Ipv4Interface> incomingInterface)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
+  EndPoints retval;
+  DoLookup (daddr, dport, saddr, sport, incomingInterface, &retval);
+  return retval;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::LookupBest (Ipv4Address daddr, uint16_t dport, 
+                               Ipv4Address saddr, uint16_t sport,
+                               Ptr<Ipv4Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return DoLookup (daddr, dport, saddr, sport, incomingInterface, 0);
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::DoLookup (Ipv4Address daddr, uint16_t dport, 
+                             Ipv4Address saddr, uint16_t sport,
+                             Ptr<Ipv4Interface> incomingInterface,
+                             EndPoints *matches)
+{
+  // Endpoints are ranked in four classes; the result is made of the
+  // endpoints of the most specific class that has any:
+  //  1: Matches exact on local port, wildcards on others
+  //  2: Matches exact on local port/adder, wildcards on others
+  //  3: Matches all but local address
+  //  4: Exact match on all 4
+  uint32_t bestClass = 0;
+  Ipv4EndPoint *best = 0;
 
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-      if (endP->GetLocalPort () != dport) 
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
-      if (endP->GetBoundNetDevice ())
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
+
+  // Any matching endpoint is either listed under the local port, or has
+  // its peer set to the packet source and its local address set to the
+  // destination, to the wildcard or, for broadcasts, to the address of
+  // the incoming interface.
+  const EndPoints *candidates[4];
+  uint32_t nCandidates = 0;
+  PortEndPoints::const_iterator port = m_unconnected.find (dport);
+  if (port != m_unconnected.end ())
+    {
+      candidates[nCandidates++] = &port->second;
+    }
+  if (sport != 0 && saddr != Ipv4Address::GetAny ())
+    {
+      Ipv4Address localAddresses[3] = { daddr, Ipv4Address::GetAny (), incomingInterfaceAddr };
+      uint32_t nLocalAddresses = (isBroadcast && incomingInterfaceAddr != daddr
+                                  && incomingInterfaceAddr != Ipv4Address::GetAny ()) ? 3 : 2;
+      for (uint32_t i = 0; i < nLocalAddresses; i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          if (i == 1 && daddr == Ipv4Address::GetAny ())
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
               continue;
             }
-        }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+          const EndPoints *connected = FindConnected (localAddresses[i], dport, saddr, sport);
+          if (connected != 0)
             {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
+              candidates[nCandidates++] = connected;
             }
         }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+    }
 
-      if (isBroadcast)
+  for (uint32_t c = 0; c < nCandidates; c++)
+    {
+      for (EndPoints::const_iterator i = candidates[c]->begin (); i != candidates[c]->end (); i++)
         {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
-        }
+          Ipv4EndPoint* endP = *i;
+          NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                     << " daddr=" << endP->GetLocalAddress ()
+                                                     << " sport=" << endP->GetPeerPort ()
+                                                     << " saddr=" << endP->GetPeerAddress ());
+          NS_ASSERT (endP->GetLocalPort () == dport);
+          if (endP->GetBoundNetDevice ())
+            {
+              if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+                {
+                  NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                     << " because endpoint is bound to specific device and"
+                                                     << endP->GetBoundNetDevice ()
+                                                     << " does not match packet device " << incomingInterface->GetDevice ());
+                  continue;
+                }
+            }
+          bool localAddressMatchesWildCard = 
+            endP->GetLocalAddress () == Ipv4Address::GetAny ();
+          bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
-        {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+          if (isBroadcast)
+            {
+              NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+            }
+
+          if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+            {
+              localAddressMatchesExact = (endP->GetLocalAddress () ==
+                                          incomingInterfaceAddr);
+            }
+          // if no match here, keep looking
+          if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+            continue; 
+          bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+          bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+          bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+          bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
+            Ipv4Address::GetAny ();
+          // If remote does not match either with exact or wildcard,
+          // skip this one
+          if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
+            continue;
+          if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+            continue;
+
+          // Now figure out the most specific class of this one
+          uint32_t endPointClass = 0;
+          if (localAddressMatchesExact &&
+              remotePeerMatchesExact &&
+              remoteAddressMatchesExact)
+            { // All 4 match
+              endPointClass = 4;
+            }
+          else if (localAddressMatchesWildCard &&
+                   remotePeerMatchesExact &&
+                   remoteAddressMatchesExact)
+            { // All but local address
+              endPointClass = 3;
+            }
+          else if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
+                   remotePeerMatchesWildCard &&
+                   remoteAddressMatchesWildCard)
+            { // Only local port and local address matches exactly
+              endPointClass = 2;
+            }
+          else if (localAddressMatchesWildCard &&
+                   remotePeerMatchesWildCard &&
+                   remoteAddressMatchesWildCard)
+            { // Only local port matches exactly
+              endPointClass = 1;
+            }
+          if (endPointClass == 0 || endPointClass < bestClass)
+            {
+              continue;
+            }
+          if (endPointClass > bestClass)
+            {
+              bestClass = endPointClass;
+              best = endP;
+              if (matches != 0)
+                {
+                  matches->clear ();
+                }
+            }
+          if (matches != 0)
+            {
+              matches->push_back (endP);
+            }
         }
     }
-
-  // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  return best;
 }
 
 Ipv4EndPoint *
@@ -315,34 +505,50 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  const EndPoints *exact = FindConnected (daddr, dport, saddr, sport);
+  if (exact != 0)
+    {
+      /* this is an exact match. */
+      return exact->front ();
+    }
+  const EndPoints *candidates[2] = { 0, 0 };
+  candidates[0] = FindConnected (Ipv4Address::GetAny (), dport, saddr, sport);
+  PortEndPoints::const_iterator port = m_unconnected.find (dport);
+  if (port != m_unconnected.end ())
+    {
+      candidates[1] = &port->second;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (uint32_t c = 0; c < 2; c++)
     {
-      if ((*i)->GetLocalPort () != dport) 
+      if (candidates[c] == 0)
         {
           continue;
         }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-      uint32_t tmp = 0;
-      if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+      for (EndPoints::const_iterator i = candidates[c]->begin (); i != candidates[c]->end (); i++)
         {
-          tmp++;
-        }
-      if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
-        {
-          tmp++;
-        }
-      if (tmp < genericity) 
-        {
-          generic = (*i);
-          genericity = tmp;
+          if ((*i)->GetLocalAddress () == daddr &&
+              (*i)->GetPeerPort () == sport &&
+              (*i)->GetPeerAddress () == saddr) 
+            {
+              /* this is an exact match. */
+              return *i;
+            }
+          uint32_t tmp = 0;
+          if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
+            {
+              tmp++;
+            }
+          if ((*i)->GetPeerAddress () == Ipv4Address::GetAny ()) 
+            {
+              tmp++;
+            }
+          if (tmp < genericity) 
+            {
+              generic = (*i);
+              genericity = tmp;
+            }
         }
     }
   return generic;
@@ -352,19 +558,35 @@ uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint16_t port = m_ephemeral;
-  do 
+  // Ports are tried in the order m_ephemeral + 1 to 65534, then
+  // 49152 to m_ephemeral; skip whole words of ports in use.
+  uint32_t start = m_ephemeral + 1 - EPHEMERAL_FIRST;
+  uint32_t end = 65535 - EPHEMERAL_FIRST;
+  for (uint32_t pass = 0; pass < 2; pass++)
     {
-      port++;
-      if (port == 65535) 
-        {
-          port = 49152;
-        }
-      if (!LookupPortLocal (port)) 
+      uint32_t bit = start;
+      while (bit < end)
         {
-          return port;
+          uint32_t word = m_ephemeralPorts[bit / 32] | ((1U << (bit % 32)) - 1);
+          if (word != 0xffffffff)
+            {
+              uint32_t free = bit - bit % 32;
+              while (word & 1)
+                {
+                  word >>= 1;
+                  free++;
+                }
+              if (free < end)
+                {
+                  return EPHEMERAL_FIRST + free;
+                }
+              break;
+            }
+          bit = bit - bit % 32 + 32;
         }
-    } while (port != m_ephemeral);
+      end = start;
+      start = 0;
+    }
   return 0;
 }
 
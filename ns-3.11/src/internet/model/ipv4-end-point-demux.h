@@ -23,7 +23,9 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -34,10 +36,17 @@ class Ipv4EndPoint;
  * \brief Demultiplexes packets to various transport layer endpoints
  *
  * This class serves as a lookup table to match partial or full information
- * about a four-tuple to an ns3::Ipv4EndPoint.  It internally contains a list
- * of endpoints, and has APIs to add and find endpoints in this demux.  This
- * code is shared in common to TCP and UDP protocols in ns3.  This demux
- * sits between ns3's layer four and the socket layer
+ * about a four-tuple to an ns3::Ipv4EndPoint.  It internally indexes the
+ * endpoints in hash tables, and has APIs to add and find endpoints in this
+ * demux.  This code is shared in common to TCP and UDP protocols in ns3.
+ * This demux sits between ns3's layer four and the socket layer
+ *
+ * Endpoints whose peer address and port are both set are indexed by their
+ * full four-tuple; the others (listening or unconnected sockets) are
+ * indexed by local port.  A lookup therefore probes a few hash buckets
+ * rather than scanning every endpoint of the node, which matters on nodes
+ * holding thousands of connections.  Endpoints notify the demux when
+ * their addresses change so that they are re-indexed.
  */
 
 class Ipv4EndPointDemux {
@@ -57,6 +66,21 @@ public:
                     uint16_t sport,
                     Ptr<Ipv4Interface> incomingInterface);
 
+  /**
+   * \brief Find the most specific endpoint matching a packet.
+   *
+   * This applies the rules of Lookup but returns only the first endpoint
+   * of the most specific class, without building a list; it suits
+   * protocols such as TCP which deliver a segment to a single endpoint.
+   *
+   * \return the endpoint, or zero if none matches
+   */
+  Ipv4EndPoint *LookupBest (Ipv4Address daddr, 
+                            uint16_t dport, 
+                            Ipv4Address saddr, 
+                            uint16_t sport,
+                            Ptr<Ipv4Interface> incomingInterface);
+
   Ipv4EndPoint *SimpleLookup (Ipv4Address daddr, 
                               uint16_t dport, 
                               Ipv4Address saddr, 
@@ -74,10 +98,56 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /// The key of an endpoint with both its local and peer ends set
+  struct FourTuple
+  {
+    FourTuple (Ipv4Address localAddress, uint16_t localPort,
+               Ipv4Address peerAddress, uint16_t peerPort);
+    bool operator == (const FourTuple &o) const;
+    uint32_t m_localAddress;
+    uint32_t m_peerAddress;
+    uint16_t m_localPort;
+    uint16_t m_peerPort;
+  };
+  struct FourTupleHash
+  {
+    size_t operator () (const FourTuple &x) const;
+  };
+  struct PortHash
+  {
+    size_t operator () (uint16_t x) const;
+  };
+  typedef sgi::hash_map<FourTuple, EndPoints, FourTupleHash> ConnectedEndPoints;
+  typedef sgi::hash_map<uint16_t, EndPoints, PortHash> PortEndPoints;
+  typedef sgi::hash_map<uint16_t, uint32_t, PortHash> PortCounts;
+  typedef sgi::hash_map<FourTuple, uint32_t, FourTupleHash> LocalCounts;
+
   uint16_t AllocateEphemeralPort (void);
+  Ipv4EndPoint *AddEndPoint (Ipv4EndPoint *endPoint);
+  void Insert (Ipv4EndPoint *endPoint);
+  void Remove (Ipv4EndPoint *endPoint);
+  Ipv4EndPoint *DoLookup (Ipv4Address daddr, uint16_t dport,
+                          Ipv4Address saddr, uint16_t sport,
+                          Ptr<Ipv4Interface> incomingInterface,
+                          EndPoints *matches);
+  const EndPoints *FindConnected (Ipv4Address localAddress, uint16_t localPort,
+                                  Ipv4Address peerAddress, uint16_t peerPort) const;
+  static bool IsConnected (Ipv4EndPoint *endPoint);
 
   uint16_t m_ephemeral;
-  EndPoints m_endPoints;
+  uint32_t m_nEndPoints;
+  /// Endpoints with their peer set, by four-tuple
+  ConnectedEndPoints m_connected;
+  /// Endpoints with a wildcard peer address or port, by local port
+  PortEndPoints m_unconnected;
+  /// Number of endpoints using each local port
+  PortCounts m_portCounts;
+  /// Number of endpoints using each local address and port
+  LocalCounts m_localCounts;
+  /// One bit per ephemeral port, set while the port is in use
+  std::vector<uint32_t> m_ephemeralPorts;
 };
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 
 #include "ipv4-end-point.h"
+#include "ipv4-end-point-demux.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -31,7 +32,8 @@ Ipv4EndPoint::Ipv4EndPoint (Ipv4Address address, uint16_t port)
   : m_localAddr (address), 
     m_localPort (port),
     m_peerAddr (Ipv4Address::GetAny ()),
-    m_peerPort (0)
+    m_peerPort (0),
+    m_demux (0)
 {
 }
 Ipv4EndPoint::~Ipv4EndPoint ()
@@ -51,7 +53,15 @@ Ipv4EndPoint::GetLocalAddress (void)
 void 
 Ipv4EndPoint::SetLocalAddress (Ipv4Address address)
 {
+  if (m_demux != 0)
+    {
+      m_demux->Remove (this);
+    }
   m_localAddr = address;
+  if (m_demux != 0)
+    {
+      m_demux->Insert (this);
+    }
 }
 
 uint16_t 
@@ -72,8 +82,16 @@ Ipv4EndPoint::GetPeerPort (void)
 void 
 Ipv4EndPoint::SetPeer (Ipv4Address address, uint16_t port)
 {
+  if (m_demux != 0)
+    {
+      m_demux->Remove (this);
+    }
   m_peerAddr = address;
   m_peerPort = port;
+  if (m_demux != 0)
+    {
+      m_demux->Insert (this);
+    }
 }
 
 void
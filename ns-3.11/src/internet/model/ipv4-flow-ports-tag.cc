@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ipv4-flow-ports-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4FlowPortsTag);
+
+Ipv4FlowPortsTag::Ipv4FlowPortsTag ()
+  : m_sourcePort (0),
+    m_destinationPort (0)
+{
+}
+
+Ipv4FlowPortsTag::Ipv4FlowPortsTag (uint16_t sourcePort, uint16_t destinationPort)
+  : m_sourcePort (sourcePort),
+    m_destinationPort (destinationPort)
+{
+}
+
+void
+Ipv4FlowPortsTag::SetSourcePort (uint16_t port)
+{
+  m_sourcePort = port;
+}
+
+uint16_t
+Ipv4FlowPortsTag::GetSourcePort (void) const
+{
+  return m_sourcePort;
+}
+
+void
+Ipv4FlowPortsTag::SetDestinationPort (uint16_t port)
+{
+  m_destinationPort = port;
+}
+
+uint16_t
+Ipv4FlowPortsTag::GetDestinationPort (void) const
+{
+  return m_destinationPort;
+}
+
+TypeId
+Ipv4FlowPortsTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4FlowPortsTag")
+    .SetParent<Tag> ()
+    .AddConstructor<Ipv4FlowPortsTag> ()
+  ;
+  return tid;
+}
+TypeId
+Ipv4FlowPortsTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+Ipv4FlowPortsTag::GetSerializedSize (void) const
+{
+  return 4;
+}
+void
+Ipv4FlowPortsTag::Serialize (TagBuffer i) const
+{
+  i.WriteU16 (m_sourcePort);
+  i.WriteU16 (m_destinationPort);
+}
+void
+Ipv4FlowPortsTag::Deserialize (TagBuffer i)
+{
+  m_sourcePort = i.ReadU16 ();
+  m_destinationPort = i.ReadU16 ();
+}
+void
+Ipv4FlowPortsTag::Print (std::ostream &os) const
+{
+  os << "ports=" << m_sourcePort << ">" << m_destinationPort;
+}
+
+} // namespace ns3
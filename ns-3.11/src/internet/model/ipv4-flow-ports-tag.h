@@ -0,0 +1,61 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_FLOW_PORTS_TAG_H
+#define IPV4_FLOW_PORTS_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \brief The ports of the flow of a packet, for Ipv4RoutingProtocol::RouteOutput
+ *
+ * A transport protocol routes a packet before or after adding its own
+ * header, so the routing protocol cannot tell from the packet where
+ * its ports are. TcpL4Protocol and UdpSocketImpl add this tag to the
+ * packet they route and remove it once the route is found. UdpL4Protocol
+ * adds it to the packets Ipv4L3Protocol routes, and Ipv4L3Protocol::Send
+ * removes it. This way, the ECMP modes of Ipv4GlobalRouting hash the
+ * ports of TCP and UDP flows at the sending host as well as at the
+ * routers, and never read the payload of other packets.
+ */
+class Ipv4FlowPortsTag : public Tag
+{
+public:
+  Ipv4FlowPortsTag ();
+  Ipv4FlowPortsTag (uint16_t sourcePort, uint16_t destinationPort);
+
+  void SetSourcePort (uint16_t port);
+  uint16_t GetSourcePort (void) const;
+  void SetDestinationPort (uint16_t port);
+  uint16_t GetDestinationPort (void) const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint16_t m_sourcePort;
+  uint16_t m_destinationPort;
+};
+
+} // namespace ns3
+
+#endif /* IPV4_FLOW_PORTS_TAG_H */
@@ -17,6 +17,7 @@
 //
 
 #include <vector>
+#include <map>
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
@@ -27,7 +28,11 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
 #include "ipv4-global-routing.h"
+#include "ipv4-flow-ports-tag.h"
 #include "global-route-manager.h"
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRouting");
@@ -51,13 +56,49 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_respondToInterfaceEvents),
                    MakeBooleanChecker ())
+    .AddAttribute ("UseCompiledFib",
+                   "Set to true to look up unicast routes in the compiled forwarding table; set to false to scan the route lists for every packet",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_useCompiledFib),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EcmpMode",
+                   "How packets are spread over equal-cost next hops.  When None, RandomEcmpRouting=true selects PerPacketRandom.",
+                   EnumValue (ECMP_NONE),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::SetEcmpMode,
+                                     &Ipv4GlobalRouting::GetEcmpMode),
+                   MakeEnumChecker (ECMP_NONE, "None",
+                                    ECMP_PER_PACKET_RANDOM, "PerPacketRandom",
+                                    ECMP_FLOW_HASH, "FlowHash",
+                                    ECMP_FLOWLET_HASH, "FlowletHash"))
+    .AddAttribute ("EcmpHashSeed",
+                   "Seed of the flow hash used by the FlowHash and FlowletHash modes; zero uses the id of the node, so that every switch hashes differently",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowletTimeout",
+                   "Inactivity gap after which a flow may be moved to another next hop in the FlowletHash mode",
+                   TimeValue (MicroSeconds (500)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_flowletTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("FlowletTableSize",
+                   "Number of flows tracked in the FlowletHash mode; flows hashing to the same slot share it",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_flowletTableSize),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_ecmpMode (ECMP_NONE),
+    m_ecmpHashSeed (0),
+    m_flowletTableSize (4096),
+    m_nodeId (0),
+    m_respondToInterfaceEvents (false),
+    m_useCompiledFib (true),
+    m_fibDirty (true),
+    m_fibRoot (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -65,6 +106,62 @@ Ipv4GlobalRouting::Ipv4GlobalRouting ()
 Ipv4GlobalRouting::~Ipv4GlobalRouting ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  SetEcmpMode (ECMP_NONE);
+  ClearFib ();
+}
+
+uint32_t Ipv4GlobalRouting::g_nFlowHashRouters = 0;
+
+bool
+Ipv4GlobalRouting::IsFlowHashEnabled (void)
+{
+  return g_nFlowHashRouters != 0;
+}
+
+static bool
+IsHashMode (Ipv4GlobalRouting::EcmpMode mode)
+{
+  return mode == Ipv4GlobalRouting::ECMP_FLOW_HASH
+         || mode == Ipv4GlobalRouting::ECMP_FLOWLET_HASH;
+}
+
+void
+Ipv4GlobalRouting::SetEcmpMode (EcmpMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  if (IsHashMode (m_ecmpMode))
+    {
+      g_nFlowHashRouters--;
+    }
+  m_ecmpMode = mode;
+  if (IsHashMode (m_ecmpMode))
+    {
+      g_nFlowHashRouters++;
+    }
+}
+
+Ipv4GlobalRouting::EcmpMode
+Ipv4GlobalRouting::GetEcmpMode (void) const
+{
+  return m_ecmpMode;
+}
+
+Ipv4GlobalRouting::FibNode::FibNode ()
+{
+  for (uint32_t i = 0; i < 256; i++)
+    {
+      m_group[i] = -1;
+      m_priority[i] = 0;
+      m_child[i] = 0;
+    }
+}
+
+Ipv4GlobalRouting::FibNode::~FibNode ()
+{
+  for (uint32_t i = 0; i < 256; i++)
+    {
+      delete m_child[i];
+    }
 }
 
 void 
@@ -76,6 +173,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_fibDirty = true;
 }
 
 void 
@@ -86,6 +184,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_fibDirty = true;
 }
 
 void 
@@ -101,6 +200,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibDirty = true;
 }
 
 void 
@@ -114,6 +214,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_fibDirty = true;
 }
 
 void 
@@ -129,13 +230,281 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_fibDirty = true;
+}
+
+
+// Mix one 32-bit word into a MurmurHash3 state
+static inline uint32_t
+HashMix (uint32_t h, uint32_t k)
+{
+  k *= 0xcc9e2d51;
+  k = (k << 15) | (k >> 17);
+  k *= 0x1b873593;
+  h ^= k;
+  h = (h << 13) | (h >> 19);
+  return h * 5 + 0xe6546b64;
+}
+
+// MurmurHash3 finalizer, so that every input bit affects the low bits
+static inline uint32_t
+HashFinal (uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p, bool hasL4Header)
+{
+  uint16_t sourcePort = 0;
+  uint16_t destinationPort = 0;
+  uint8_t protocol = header.GetProtocol ();
+  // TCP and UDP both start with the source and destination ports
+  if (hasL4Header && p != 0 && (protocol == 6 || protocol == 17)
+      && header.GetFragmentOffset () == 0 && p->GetSize () >= 4)
+    {
+      uint8_t ports[4];
+      p->CopyData (ports, 4);
+      sourcePort = (ports[0] << 8) | ports[1];
+      destinationPort = (ports[2] << 8) | ports[3];
+    }
+  else if (!hasL4Header && p != 0)
+    {
+      Ipv4FlowPortsTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          sourcePort = tag.GetSourcePort ();
+          destinationPort = tag.GetDestinationPort ();
+        }
+    }
+  uint32_t h = m_ecmpHashSeed != 0 ? m_ecmpHashSeed : m_nodeId;
+  h = HashMix (h, header.GetSource ().Get ());
+  h = HashMix (h, header.GetDestination ().Get ());
+  h = HashMix (h, protocol);
+  h = HashMix (h, (sourcePort << 16) | destinationPort);
+  return HashFinal (h ^ 13);
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectNextHop (uint32_t nNextHops, const Ipv4Header &header,
+                                  Ptr<const Packet> p, bool hasL4Header)
+{
+  EcmpMode mode = m_ecmpMode;
+  if (mode == ECMP_NONE && m_randomEcmpRouting)
+    {
+      mode = ECMP_PER_PACKET_RANDOM;
+    }
+  switch (mode)
+    {
+    case ECMP_PER_PACKET_RANDOM:
+      return m_rand.GetInteger (0, nNextHops - 1);
+    case ECMP_FLOW_HASH:
+      if (nNextHops == 1)
+        {
+          return 0;
+        }
+      return GetFlowHash (header, p, hasL4Header) % nNextHops;
+    case ECMP_FLOWLET_HASH:
+      {
+        if (nNextHops == 1)
+          {
+            return 0;
+          }
+        uint32_t flowHash = GetFlowHash (header, p, hasL4Header);
+        if (m_flowlets.size () != m_flowletTableSize)
+          {
+            Flowlet empty = { 0, 0, 0, Time (0) };
+            m_flowlets.assign (m_flowletTableSize, empty);
+          }
+        Flowlet &flowlet = m_flowlets[flowHash % m_flowletTableSize];
+        Time now = Simulator::Now ();
+        if (flowlet.m_flowHash != flowHash || flowlet.m_count == 0
+            || now - flowlet.m_lastSeen > m_flowletTimeout)
+          {
+            // a new flowlet: rehash the flow with the flowlet count so that
+            // the choice stays a deterministic function of the packet stream
+            uint32_t count = flowlet.m_flowHash == flowHash ? flowlet.m_count + 1 : 1;
+            flowlet.m_flowHash = flowHash;
+            flowlet.m_count = count;
+            flowlet.m_nextHop = HashFinal (HashMix (flowHash, count));
+            NS_LOG_LOGIC ("New flowlet " << count << " for flow hash " << flowHash);
+          }
+        flowlet.m_lastSeen = now;
+        return flowlet.m_nextHop % nNextHops;
+      }
+    case ECMP_NONE:
+    default:
+      return 0;
+    }
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::CreateRoute (const Ipv4RoutingTableEntry *route) const
+{
+  // create a Ipv4Route object from the selected routing table entry
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route->GetDest ());
+  // XXX handle multi-address case
+  rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+  rtentry->SetGateway (route->GetGateway ());
+  uint32_t interfaceIdx = route->GetInterface ();
+  rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+  return rtentry;
+}
+
+void
+Ipv4GlobalRouting::ClearFib (void)
+{
+  delete m_fibRoot;
+  m_fibRoot = 0;
+  m_fibGroups.clear ();
 }
 
+void
+Ipv4GlobalRouting::InsertFib (Ipv4Address network, uint8_t prefixLength,
+                              uint8_t priority, int32_t group)
+{
+  NS_LOG_FUNCTION (this << network << (uint32_t)prefixLength << (uint32_t)priority << group);
+  // A prefix is stored at the level holding its last significant bit,
+  // expanded over all the slots of that level it covers.
+  uint32_t level = prefixLength == 0 ? 0 : (prefixLength - 1) / 8;
+  uint32_t address = network.Get ();
+  FibNode *node = m_fibRoot;
+  for (uint32_t i = 0; i < level; i++)
+    {
+      uint8_t index = (address >> (24 - 8 * i)) & 0xff;
+      if (node->m_child[index] == 0)
+        {
+          node->m_child[index] = new FibNode ();
+        }
+      node = node->m_child[index];
+    }
+  uint32_t span = 1 << (8 * (level + 1) - prefixLength);
+  uint32_t first = ((address >> (24 - 8 * level)) & 0xff) & ~(span - 1);
+  for (uint32_t index = first; index < first + span; index++)
+    {
+      if (priority > node->m_priority[index])
+        {
+          node->m_priority[index] = priority;
+          node->m_group[index] = group;
+        }
+    }
+}
+
+void
+Ipv4GlobalRouting::CompileFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  ClearFib ();
+  m_fibDirty = false;
+  if (m_ipv4 == 0)
+    {
+      return;
+    }
+  m_fibRoot = new FibNode ();
+  // The priority of a prefix orders the route classes first, then the
+  // prefix lengths; zero marks an empty slot.
+  typedef std::map<std::pair<uint8_t, uint32_t>, int32_t> GroupIndex;
+  GroupIndex groups;
+  const std::list<Ipv4RoutingTableEntry *> *routeClasses[3] = { &m_ASexternalRoutes, &m_networkRoutes, &m_hostRoutes };
+  for (uint32_t routeClass = 0; routeClass < 3; routeClass++)
+    {
+      for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routeClasses[routeClass]->begin ();
+           i != routeClasses[routeClass]->end ();
+           i++)
+        {
+          Ipv4Mask mask = (*i)->IsHost () ? Ipv4Mask::GetOnes () : (*i)->GetDestNetworkMask ();
+          uint16_t prefixLength = mask.GetPrefixLength ();
+          if (prefixLength != 0 && mask.Get () != (0xffffffff << (32 - prefixLength)))
+            {
+              NS_LOG_LOGIC ("Non-contiguous mask " << mask << ", not using the compiled table");
+              ClearFib ();
+              return;
+            }
+          if (m_ipv4->GetNAddresses ((*i)->GetInterface ()) == 0)
+            {
+              NS_LOG_LOGIC ("No address on interface " << (*i)->GetInterface () << ", skipping " << **i);
+              continue;
+            }
+          Ipv4Address network = (*i)->IsHost () ? (*i)->GetDest () : (*i)->GetDestNetwork ();
+          uint8_t priority = ((routeClass + 1) << 6) | prefixLength;
+          std::pair<uint8_t, uint32_t> key (priority, network.CombineMask (mask).Get ());
+          GroupIndex::iterator found = groups.find (key);
+          int32_t group;
+          if (found == groups.end ())
+            {
+              group = m_fibGroups.size ();
+              m_fibGroups.push_back (NextHopGroup ());
+              groups[key] = group;
+              InsertFib (network, prefixLength, priority, group);
+            }
+          else
+            {
+              group = found->second;
+            }
+          // only the first matching external route is ever used
+          if (routeClasses[routeClass] == &m_ASexternalRoutes && !m_fibGroups[group].empty ())
+            {
+              continue;
+            }
+          m_fibGroups[group].push_back (CreateRoute (*i));
+        }
+    }
+  NS_LOG_LOGIC ("Compiled " << GetNRoutes () << " routes into " << m_fibGroups.size () << " next hop groups");
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p,
+                                 bool hasL4Header, Ptr<NetDevice> oif)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (!m_useCompiledFib || oif != 0)
+    {
+      return LookupRouteList (header, p, hasL4Header, oif);
+    }
+  if (m_fibDirty)
+    {
+      CompileFib ();
+    }
+  if (m_fibRoot == 0)
+    {
+      return LookupRouteList (header, p, hasL4Header, oif);
+    }
+  Ipv4Address dest = header.GetDestination ();
+  NS_LOG_LOGIC ("Looking for route for destination " << dest << " in compiled table");
+  uint32_t address = dest.Get ();
+  int32_t group = -1;
+  uint8_t bestPriority = 0;
+  const FibNode *node = m_fibRoot;
+  for (uint32_t level = 0; level < 4 && node != 0; level++)
+    {
+      uint8_t index = (address >> (24 - 8 * level)) & 0xff;
+      if (node->m_priority[index] > bestPriority)
+        {
+          bestPriority = node->m_priority[index];
+          group = node->m_group[index];
+        }
+      node = node->m_child[index];
+    }
+  if (group < 0)
+    {
+      return 0;
+    }
+  const NextHopGroup &nextHops = m_fibGroups[group];
+  return nextHops[SelectNextHop (nextHops.size (), header, p, hasL4Header)];
+}
 
 Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupRouteList (const Ipv4Header &header, Ptr<const Packet> p,
+                                    bool hasL4Header, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  Ipv4Address dest = header.GetDestination ();
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
@@ -165,6 +534,8 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
+      // only the routes to the longest matching prefix are equal-cost
+      uint16_t longest = 0;
       for (NetworkRoutesI j = m_networkRoutes.begin (); 
            j != m_networkRoutes.end (); 
            j++) 
@@ -181,6 +552,16 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
                       continue;
                     }
                 }
+              uint16_t prefixLength = mask.GetPrefixLength ();
+              if (allRoutes.size () > 0 && prefixLength < longest)
+                {
+                  continue;
+                }
+              if (prefixLength > longest)
+                {
+                  allRoutes.clear ();
+                  longest = prefixLength;
+                }
               allRoutes.push_back (*j);
               NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
@@ -188,6 +569,8 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
+      // the first external route to the longest matching prefix is used
+      uint16_t longest = 0;
       for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
            k != m_ASexternalRoutes.end ();
            k++)
@@ -205,34 +588,21 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
                       continue;
                     }
                 }
-              allRoutes.push_back (*k);
-              break;
+              uint16_t prefixLength = mask.GetPrefixLength ();
+              if (allRoutes.size () == 0 || prefixLength > longest)
+                {
+                  allRoutes.assign (1, *k);
+                  longest = prefixLength;
+                }
             }
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
-        {
-          selectIndex = m_rand.GetInteger (0, allRoutes.size ()-1);
-        }
-      else 
-        {
-          selectIndex = 0;
-        }
+      // pick up one of the routes according to the ECMP mode
+      uint32_t selectIndex = SelectNextHop (allRoutes.size (), header, p, hasL4Header);
       Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
-      // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
-      // XXX handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
-      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+      rtentry = CreateRoute (route);
       return rtentry;
     }
   else 
@@ -317,6 +687,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
               delete *i;
               m_hostRoutes.erase (i);
+              m_fibDirty = true;
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -334,6 +705,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
           delete *j;
           m_networkRoutes.erase (j);
+          m_fibDirty = true;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -350,6 +722,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
           delete *k;
           m_ASexternalRoutes.erase (k);
+          m_fibDirty = true;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -380,6 +753,7 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  ClearFib ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -448,7 +822,9 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  // A transport may route its packets with or without its header, so
+  // the ports of the flow come from the Ipv4FlowPortsTag of its packet
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, p, false, oif);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -526,7 +902,7 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header, p, true);
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -544,6 +920,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_fibDirty = true;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -556,6 +933,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_fibDirty = true;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -568,6 +946,7 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  m_fibDirty = true;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -580,6 +959,7 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  m_fibDirty = true;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -594,6 +974,11 @@ Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  Ptr<Node> node = m_ipv4->GetObject<Node> ();
+  if (node != 0)
+    {
+      m_nodeId = node->GetId ();
+    }
 }
 
 
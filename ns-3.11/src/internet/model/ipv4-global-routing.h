@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +29,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -63,6 +65,12 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * When several equal-cost routes lead to a destination, the EcmpMode
+ * attribute chooses among them: always the first one, a random one per
+ * packet, one picked by a seeded hash of the addresses, protocol and
+ * transport ports, or the same hash recomputed whenever a flow has been
+ * idle for longer than FlowletTimeout.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -70,6 +78,17 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
 {
 public:
   static TypeId GetTypeId (void);
+
+  /**
+   * \brief How packets are spread over equal-cost next hops.
+   */
+  enum EcmpMode
+  {
+    ECMP_NONE,               /**< Always use the first next hop */
+    ECMP_PER_PACKET_RANDOM,  /**< Pick a next hop at random for every packet */
+    ECMP_FLOW_HASH,          /**< Pick a next hop from a hash of the 5-tuple */
+    ECMP_FLOWLET_HASH        /**< Rehash a flow after an inactivity gap */
+  };
 /**
  * \brief Construct an empty Ipv4GlobalRouting routing protocol,
  *
@@ -81,6 +100,13 @@ public:
   Ipv4GlobalRouting ();
   virtual ~Ipv4GlobalRouting ();
 
+  /**
+   * \returns true if the EcmpMode of some Ipv4GlobalRouting hashes the
+   * ports of the flows.  Only then do TCP and UDP tag the packets they
+   * route with an Ipv4FlowPortsTag.
+   */
+  static bool IsFlowHashEnabled (void);
+
   // These methods inherited from base class
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
 
@@ -211,12 +237,59 @@ public:
  */
   void RemoveRoute (uint32_t i);
 
+/**
+ * \brief Compile the unicast routes into the forwarding table used on
+ * the lookup fast path.
+ *
+ * The compiled table is a multibit trie with an 8-bit stride, indexed by
+ * destination address.  Each matching slot refers to a precomputed group
+ * of equal-cost next hops, each held as an immutable Ipv4Route shared by
+ * every packet that takes it, so that a lookup neither walks the route
+ * lists nor allocates.  Both this table and the list-based lookup give
+ * host routes precedence over network routes, which take precedence over
+ * AS external routes.  Within each class the longest matching prefix
+ * wins: all the network routes to that prefix are equal-cost next hops,
+ * while only the first AS external route to it is used.
+ *
+ * GlobalRouteManager::InitializeRoutes calls this for every node once
+ * the SPF calculation is done.  Adding or removing a route, or changing
+ * an interface, marks the table stale and it is recompiled on the next
+ * lookup.  Routes with a non-contiguous network mask cannot be compiled;
+ * the node then falls back to the list-based lookup.
+ */
+  void CompileFib (void);
+
 protected:
   void DoDispose (void);
 
 private:
+  /// Last packet time and next hop of a flow, for flowlet switching
+  struct Flowlet
+  {
+    uint32_t m_flowHash;
+    uint32_t m_nextHop;
+    uint32_t m_count;
+    Time m_lastSeen;
+  };
+
   /// Set to true if packets are randomly routed among ECMP; set to false for using only one route consistently
   bool m_randomEcmpRouting;
+  void SetEcmpMode (EcmpMode mode);
+  EcmpMode GetEcmpMode (void) const;
+
+  /// How packets are spread over equal-cost next hops
+  EcmpMode m_ecmpMode;
+  /// Number of instances whose EcmpMode hashes the flows
+  static uint32_t g_nFlowHashRouters;
+  /// Seed mixed into the flow hash, or zero to use the node id
+  uint32_t m_ecmpHashSeed;
+  /// Inactivity gap after which a flow may move to another next hop
+  Time m_flowletTimeout;
+  /// Number of flows tracked for flowlet switching
+  uint32_t m_flowletTableSize;
+  std::vector<Flowlet> m_flowlets;
+  /// Id of the node, used as the default hash seed
+  uint32_t m_nodeId;
   /// Set to true if this interface should respond to interface events by globallly recomputing routes 
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
@@ -232,12 +305,44 @@ private:
   typedef std::list<Ipv4RoutingTableEntry *>::const_iterator ASExternalRoutesCI;
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  /// A set of equal-cost next hops for one destination prefix
+  typedef std::vector<Ptr<Ipv4Route> > NextHopGroup;
+
+  /**
+   * \brief One level of the compiled forwarding trie.
+   *
+   * Each level is indexed by one byte of the destination address.  A
+   * slot holds the next hop group of the best prefix expanded into it
+   * at this level (or -1) and a child for the next address byte.
+   */
+  struct FibNode
+  {
+    FibNode ();
+    ~FibNode ();
+    int32_t m_group[256];
+    uint8_t m_priority[256];
+    FibNode *m_child[256];
+  };
+
+  Ptr<Ipv4Route> LookupGlobal (const Ipv4Header &header, Ptr<const Packet> p, bool hasL4Header, Ptr<NetDevice> oif = 0);
+  Ptr<Ipv4Route> LookupRouteList (const Ipv4Header &header, Ptr<const Packet> p, bool hasL4Header, Ptr<NetDevice> oif);
+  uint32_t SelectNextHop (uint32_t nNextHops, const Ipv4Header &header, Ptr<const Packet> p, bool hasL4Header);
+  uint32_t GetFlowHash (const Ipv4Header &header, Ptr<const Packet> p, bool hasL4Header);
+  Ptr<Ipv4Route> CreateRoute (const Ipv4RoutingTableEntry *route) const;
+  void ClearFib (void);
+  void InsertFib (Ipv4Address network, uint8_t prefixLength, uint8_t priority, int32_t group);
 
   HostRoutes m_hostRoutes;
   NetworkRoutes m_networkRoutes;
   ASExternalRoutes m_ASexternalRoutes; // External routes imported
 
+  /// Set to true to look up unicast routes in the compiled forwarding table
+  bool m_useCompiledFib;
+  /// Set when the routes have changed since the table was last compiled
+  bool m_fibDirty;
+  FibNode *m_fibRoot;
+  std::vector<NextHopGroup> m_fibGroups;
+
   Ptr<Ipv4> m_ipv4;
 };
 
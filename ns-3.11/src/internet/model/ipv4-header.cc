@@ -21,6 +21,7 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/header.h"
+#include "ns3/checksum.h"
 #include "ipv4-header.h"
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4Header");
@@ -39,7 +40,8 @@ Ipv4Header::Ipv4Header ()
     m_flags (0),
     m_fragmentOffset (0),
     m_checksum (0),
-    m_goodChecksum (true)
+    m_goodChecksum (true),
+    m_checksumKnown (false)
 {
 }
 
@@ -53,6 +55,7 @@ void
 Ipv4Header::SetPayloadSize (uint16_t size)
 {
   m_payloadSize = size;
+  m_checksumKnown = false;
 }
 uint16_t
 Ipv4Header::GetPayloadSize (void) const
@@ -69,6 +72,7 @@ void
 Ipv4Header::SetIdentification (uint16_t identification)
 {
   m_identification = identification;
+  m_checksumKnown = false;
 }
 
 
@@ -76,6 +80,7 @@ Ipv4Header::SetIdentification (uint16_t identification)
 void 
 Ipv4Header::SetTos (uint8_t tos)
 {
+  UpdateChecksum (0x45 | (m_tos << 8), 0x45 | (tos << 8));
   m_tos = tos;
 }
 uint8_t 
@@ -83,15 +88,27 @@ Ipv4Header::GetTos (void) const
 {
   return m_tos;
 }
+void
+Ipv4Header::SetEcn (EcnType ecn)
+{
+  SetTos ((m_tos & 0xfc) | ecn);
+}
+Ipv4Header::EcnType
+Ipv4Header::GetEcn (void) const
+{
+  return EcnType (m_tos & 0x03);
+}
 void 
 Ipv4Header::SetMoreFragments (void)
 {
   m_flags |= MORE_FRAGMENTS;
+  m_checksumKnown = false;
 }
 void
 Ipv4Header::SetLastFragment (void)
 {
   m_flags &= ~MORE_FRAGMENTS;
+  m_checksumKnown = false;
 }
 bool 
 Ipv4Header::IsLastFragment (void) const
@@ -103,11 +120,13 @@ void
 Ipv4Header::SetDontFragment (void)
 {
   m_flags |= DONT_FRAGMENT;
+  m_checksumKnown = false;
 }
 void 
 Ipv4Header::SetMayFragment (void)
 {
   m_flags &= ~DONT_FRAGMENT;
+  m_checksumKnown = false;
 }
 bool 
 Ipv4Header::IsDontFragment (void) const
@@ -120,6 +139,7 @@ Ipv4Header::SetFragmentOffset (uint16_t offset)
 {
   NS_ASSERT (!(offset & (~0x3fff)));
   m_fragmentOffset = offset;
+  m_checksumKnown = false;
 }
 uint16_t 
 Ipv4Header::GetFragmentOffset (void) const
@@ -131,6 +151,7 @@ Ipv4Header::GetFragmentOffset (void) const
 void 
 Ipv4Header::SetTtl (uint8_t ttl)
 {
+  UpdateChecksum (m_ttl | (m_protocol << 8), ttl | (m_protocol << 8));
   m_ttl = ttl;
 }
 uint8_t 
@@ -147,6 +168,7 @@ Ipv4Header::GetProtocol (void) const
 void 
 Ipv4Header::SetProtocol (uint8_t protocol)
 {
+  UpdateChecksum (m_ttl | (m_protocol << 8), m_ttl | (protocol << 8));
   m_protocol = protocol;
 }
 
@@ -154,6 +176,7 @@ void
 Ipv4Header::SetSource (Ipv4Address source)
 {
   m_source = source;
+  m_checksumKnown = false;
 }
 Ipv4Address
 Ipv4Header::GetSource (void) const
@@ -165,6 +188,7 @@ void
 Ipv4Header::SetDestination (Ipv4Address dst)
 {
   m_destination = dst;
+  m_checksumKnown = false;
 }
 Ipv4Address
 Ipv4Header::GetDestination (void) const
@@ -179,6 +203,15 @@ Ipv4Header::IsChecksumOk (void) const
   return m_goodChecksum;
 }
 
+void
+Ipv4Header::UpdateChecksum (uint16_t oldWord, uint16_t newWord)
+{
+  if (m_checksumKnown)
+    {
+      m_checksum = ChecksumUpdate (m_checksum, oldWord, newWord);
+    }
+}
+
 TypeId 
 Ipv4Header::GetTypeId (void)
 {
@@ -268,7 +301,9 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
   if (m_calcChecksum) 
     {
       i = start;
-      uint16_t checksum = i.CalculateIpChecksum (20);
+      // A header forwarded or marked keeps the checksum it was received
+      // with, updated for the fields which changed
+      uint16_t checksum = m_checksumKnown ? m_checksum : i.CalculateIpChecksum (20);
       NS_LOG_LOGIC ("checksum=" <<checksum);
       i = start;
       i.Next (10);
@@ -316,6 +351,11 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
       NS_LOG_LOGIC ("checksum=" <<checksum);
 
       m_goodChecksum = (checksum == 0);
+      m_checksumKnown = m_goodChecksum && headerSize == 20;
+    }
+  else
+    {
+      m_checksumKnown = false;
     }
   return GetSerializedSize ();
 }
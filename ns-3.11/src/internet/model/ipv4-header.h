@@ -35,6 +35,16 @@ public:
    * \brief Construct a null IPv4 header
    */
   Ipv4Header ();
+  /**
+   * \brief The Explicit Congestion Notification codepoints (RFC 3168)
+   */
+  enum EcnType
+  {
+    ECN_NotECT = 0x00, //!< Not ECN-Capable Transport
+    ECN_ECT1 = 0x01,   //!< ECN-Capable Transport, ECT(1)
+    ECN_ECT0 = 0x02,   //!< ECN-Capable Transport, ECT(0)
+    ECN_CE = 0x03      //!< Congestion Experienced
+  };
   /**
    * \brief Enable checksum calculation for this header.
    */
@@ -53,6 +63,10 @@ public:
    * \param tos the 8 bits of Ipv4 TOS.
    */
   void SetTos (uint8_t tos);
+  /**
+   * \param ecn the ECN codepoint, in the two low bits of the TOS field
+   */
+  void SetEcn (EcnType ecn);
   /**
    * This packet is not the last packet of a fragmented ipv4 packet.
    */
@@ -101,6 +115,10 @@ public:
    * \returns the TOS field of this packet.
    */
   uint8_t GetTos (void) const;
+  /**
+   * \returns the ECN codepoint of this packet.
+   */
+  EcnType GetEcn (void) const;
   /**
    * \returns true if this is the last fragment of a packet, false otherwise.
    */
@@ -151,6 +169,13 @@ private:
     MORE_FRAGMENTS = (1<<1)
   };
 
+  /**
+   * Update the checksum of a header received, m_checksum, for the change
+   * of a 16 bit word of the header, both words read as by
+   * Buffer::Iterator::ReadU16.
+   */
+  void UpdateChecksum (uint16_t oldWord, uint16_t newWord);
+
   bool m_calcChecksum;
 
   uint16_t m_payloadSize;
@@ -164,6 +189,10 @@ private:
   Ipv4Address m_destination;
   uint16_t m_checksum;
   bool m_goodChecksum;
+  // m_checksum is the valid checksum of the fields: the header was
+  // received with a good checksum, and only fields whose change can be
+  // applied to the checksum incrementally were set since
+  bool m_checksumKnown;
 };
 
 } // namespace ns3
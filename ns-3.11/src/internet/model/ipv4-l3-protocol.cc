@@ -32,6 +32,7 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/checksum.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -40,6 +41,8 @@
 #include "icmpv4-l4-protocol.h"
 #include "ipv4-interface.h"
 #include "ipv4-raw-socket-impl.h"
+#include "ipv4-flow-ports-tag.h"
+#include "ipv4-global-routing.h"
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4L3Protocol");
 
@@ -59,6 +62,11 @@ Ipv4L3Protocol::GetTypeId (void)
                    UintegerValue (64),
                    MakeUintegerAccessor (&Ipv4L3Protocol::m_defaultTtl),
                    MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("FastForwarding",
+                   "Set to true to forward packets with the IPv4 header they were received with, updating its TTL and checksum in place, when no sink is connected to the UnicastForward trace source",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4L3Protocol::m_fastForwarding),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Tx", "Send ipv4 packet to outgoing interface.",
                      MakeTraceSourceAccessor (&Ipv4L3Protocol::m_txTrace))
     .AddTraceSource ("Rx", "Receive ipv4 packet from incoming interface.",
@@ -82,9 +90,15 @@ Ipv4L3Protocol::GetTypeId (void)
 }
 
 Ipv4L3Protocol::Ipv4L3Protocol()
-  : m_identification (0)
+  : m_identification (0),
+    m_fastStripped (0),
+    m_fastHeader (0)
 {
   NS_LOG_FUNCTION (this);
+  m_ucb = MakeCallback (&Ipv4L3Protocol::FastIpForward, this);
+  m_mcb = MakeCallback (&Ipv4L3Protocol::IpMulticastForward, this);
+  m_lcb = MakeCallback (&Ipv4L3Protocol::LocalDeliver, this);
+  m_ecb = MakeCallback (&Ipv4L3Protocol::RouteInputError, this);
 }
 
 Ipv4L3Protocol::~Ipv4L3Protocol ()
@@ -196,6 +210,8 @@ Ipv4L3Protocol::DoDispose (void)
       *i = 0;
     }
   m_interfaces.clear ();
+  m_deviceInterfaces.clear ();
+  m_fastPacket = 0;
   m_sockets.clear ();
   m_node = 0;
   m_routingProtocol = 0;
@@ -267,6 +283,19 @@ Ipv4L3Protocol::AddIpv4Interface (Ptr<Ipv4Interface>interface)
   NS_LOG_FUNCTION (this << interface);
   uint32_t index = m_interfaces.size ();
   m_interfaces.push_back (interface);
+  Ptr<NetDevice> device = interface->GetDevice ();
+  if (device != 0)
+    {
+      uint32_t ifIndex = device->GetIfIndex ();
+      if (ifIndex >= m_deviceInterfaces.size ())
+        {
+          m_deviceInterfaces.resize (ifIndex + 1, -1);
+        }
+      if (m_deviceInterfaces[ifIndex] < 0)
+        {
+          m_deviceInterfaces[ifIndex] = index;
+        }
+    }
   return index;
 }
 
@@ -333,6 +362,19 @@ int32_t
 Ipv4L3Protocol::GetInterfaceForDevice (
   Ptr<const NetDevice> device) const
 {
+  if (device != 0)
+    {
+      uint32_t ifIndex = device->GetIfIndex ();
+      if (ifIndex < m_deviceInterfaces.size ())
+        {
+          int32_t interface = m_deviceInterfaces[ifIndex];
+          if (interface >= 0 && m_interfaces[interface]->GetDevice () == device)
+            {
+              return interface;
+            }
+        }
+    }
+  // The device may not have been added to the node yet
   int32_t interface = 0;
   for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
        i != m_interfaces.end (); 
@@ -418,30 +460,23 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
   NS_LOG_LOGIC ("Packet from " << from << " received on node " << 
                 m_node->GetId ());
 
-  uint32_t interface = 0;
+  uint32_t interface = GetInterfaceForDevice (device);
   Ptr<Packet> packet = p->Copy ();
 
-  Ptr<Ipv4Interface> ipv4Interface;
-  for (Ipv4InterfaceList::const_iterator i = m_interfaces.begin (); 
-       i != m_interfaces.end (); 
-       i++, interface++)
+  Ptr<Ipv4Interface> ipv4Interface = GetInterface (interface);
+  if (ipv4Interface != 0)
     {
-      ipv4Interface = *i;
-      if (ipv4Interface->GetDevice () == device)
+      if (ipv4Interface->IsUp ())
         {
-          if (ipv4Interface->IsUp ())
-            {
-              m_rxTrace (packet, m_node->GetObject<Ipv4> (), interface);
-              break;
-            }
-          else
-            {
-              NS_LOG_LOGIC ("Dropping received packet -- interface is down");
-              Ipv4Header ipHeader;
-              packet->RemoveHeader (ipHeader);
-              m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
-              return;
-            }
+          m_rxTrace (packet, this, interface);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Dropping received packet -- interface is down");
+          Ipv4Header ipHeader;
+          packet->RemoveHeader (ipHeader);
+          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
+          return;
         }
     }
 
@@ -453,15 +488,17 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
   packet->RemoveHeader (ipHeader);
 
   // Trim any residual frame padding from underlying devices
+  bool padded = false;
   if (ipHeader.GetPayloadSize () < packet->GetSize ())
     {
       packet->RemoveAtEnd (packet->GetSize () - ipHeader.GetPayloadSize ());
+      padded = true;
     }
 
   if (!ipHeader.IsChecksumOk ()) 
     {
       NS_LOG_LOGIC ("Dropping received packet -- checksum not ok");
-      m_dropTrace (ipHeader, packet, DROP_BAD_CHECKSUM, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (ipHeader, packet, DROP_BAD_CHECKSUM, this, interface);
       return;
     }
 
@@ -472,19 +509,29 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       socket->ForwardUp (packet, ipHeader, ipv4Interface);
     }
 
+  //
+  // If nothing needs the header of the packet apart from the routing
+  // protocol, the packet received is kept at hand so that FastIpForward
+  // can send it out with its own header, should the routing protocol
+  // forward it right away.
+  //
+  if (m_fastForwarding && !padded && m_unicastForwardTrace.IsEmpty ())
+    {
+      m_fastPacket = p;
+      m_fastStripped = PeekPointer (packet);
+      m_fastHeader = &ipHeader;
+    }
+
   NS_ASSERT_MSG (m_routingProtocol != 0, "Need a routing protocol object to process packets");
-  if (!m_routingProtocol->RouteInput (packet, ipHeader, device,
-                                      MakeCallback (&Ipv4L3Protocol::IpForward, this),
-                                      MakeCallback (&Ipv4L3Protocol::IpMulticastForward, this),
-                                      MakeCallback (&Ipv4L3Protocol::LocalDeliver, this),
-                                      MakeCallback (&Ipv4L3Protocol::RouteInputError, this)
-                                      ))
+  bool routed = m_routingProtocol->RouteInput (packet, ipHeader, device, m_ucb, m_mcb, m_lcb, m_ecb);
+  m_fastPacket = 0;
+  m_fastStripped = 0;
+  m_fastHeader = 0;
+  if (!routed)
     {
       NS_LOG_WARN ("No route found for forwarding packet.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, interface);
     }
-
-
 }
 
 Ptr<Icmpv4L4Protocol> 
@@ -534,6 +581,16 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
     {
       ttl = tag.GetTtl ();
     }
+  uint8_t tos = 0;
+  SocketIpTosTag tosTag;
+  if (packet->RemovePacketTag (tosTag))
+    {
+      tos = tosTag.GetTos ();
+    }
+  // the ports of the flow, if the packet has to be routed here
+  Ipv4FlowPortsTag portsTag;
+  bool hasPorts = Ipv4GlobalRouting::IsFlowHashEnabled ()
+    && packet->RemovePacketTag (portsTag);
 
   // Handle a few cases:
   // 1) packet is destined to limited broadcast address
@@ -546,7 +603,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   if (destination.IsBroadcast () || destination.IsLocalMulticast ())
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 1:  limited broadcast");
-      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, mayFragment);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
       uint32_t ifaceIndex = 0;
       for (Ipv4InterfaceList::iterator ifaceIter = m_interfaces.begin ();
            ifaceIter != m_interfaces.end (); ifaceIter++, ifaceIndex++)
@@ -558,7 +615,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
 
           m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
           packetCopy->AddHeader (ipHeader);
-          m_txTrace (packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+          m_txTrace (packetCopy, this, ifaceIndex);
           outInterface->Send (packetCopy, destination);
         }
       return;
@@ -578,11 +635,11 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
               destination.CombineMask (ifAddr.GetMask ()) == ifAddr.GetLocal ().CombineMask (ifAddr.GetMask ())   )
             {
               NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 2:  subnet directed bcast to " << ifAddr.GetLocal ());
-              ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, mayFragment);
+              ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
               Ptr<Packet> packetCopy = packet->Copy ();
               m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
               packetCopy->AddHeader (ipHeader);
-              m_txTrace (packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+              m_txTrace (packetCopy, this, ifaceIndex);
               outInterface->Send (packetCopy, destination);
               return;
             }
@@ -594,7 +651,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   if (route && route->GetGateway () != Ipv4Address ())
     {
       NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 3:  passed in with route");
-      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, mayFragment);
+      ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
       int32_t interface = GetInterfaceForDevice (route->GetOutputDevice ());
       m_sendOutgoingTrace (ipHeader, packet, interface);
       SendRealOut (route, packet->Copy (), ipHeader);
@@ -613,11 +670,19 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   NS_LOG_LOGIC ("Ipv4L3Protocol::Send case 5:  passed in with no route " << destination);
   Socket::SocketErrno errno_; 
   Ptr<NetDevice> oif (0); // unused for now
-  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, mayFragment);
+  ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
   Ptr<Ipv4Route> newRoute;
   if (m_routingProtocol != 0)
     {
+      if (hasPorts)
+        {
+          packet->AddPacketTag (portsTag);
+        }
       newRoute = m_routingProtocol->RouteOutput (packet, ipHeader, oif, errno_);
+      if (hasPorts)
+        {
+          packet->RemovePacketTag (portsTag);
+        }
     }
   else
     {
@@ -632,7 +697,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   else
     {
       NS_LOG_WARN ("No route to host.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), 0);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, 0);
     }
 }
 
@@ -646,15 +711,17 @@ Ipv4L3Protocol::BuildHeader (
   uint8_t protocol,
   uint16_t payloadSize,
   uint8_t ttl,
+  uint8_t tos,
   bool mayFragment)
 {
-  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << mayFragment);
+  NS_LOG_FUNCTION (this << source << destination << (uint16_t)protocol << payloadSize << (uint16_t)ttl << (uint16_t)tos << mayFragment);
   Ipv4Header ipHeader;
   ipHeader.SetSource (source);
   ipHeader.SetDestination (destination);
   ipHeader.SetProtocol (protocol);
   ipHeader.SetPayloadSize (payloadSize);
   ipHeader.SetTtl (ttl);
+  ipHeader.SetTos (tos);
   if (mayFragment == true)
     {
       ipHeader.SetMayFragment ();
@@ -685,10 +752,19 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   if (route == 0)
     {
       NS_LOG_WARN ("No route to host.  Drop.");
-      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), 0);
+      m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, this, 0);
       return;
     }
   packet->AddHeader (ipHeader);
+  SendOut (route, packet, ipHeader.GetDestination ());
+}
+
+void
+Ipv4L3Protocol::SendOut (Ptr<Ipv4Route> route,
+                         Ptr<Packet> packet,
+                         Ipv4Address destination)
+{
+  NS_LOG_FUNCTION (this << route << packet << destination);
   Ptr<NetDevice> outDev = route->GetOutputDevice ();
   int32_t interface = GetInterfaceForDevice (outDev);
   NS_ASSERT (interface >= 0);
@@ -699,12 +775,12 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
                  "Packet size " << packet->GetSize () << " exceeds device MTU "
                                 << outInterface->GetDevice ()->GetMtu ()
                                 << " for IPv4; fragmentation not supported");
-  if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0"))) 
+  if (!route->GetGateway ().IsEqual (Ipv4Address::GetZero ())) 
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
+          m_txTrace (packet, this, interface);
           outInterface->Send (packet, route->GetGateway ());
         }
       else
@@ -712,23 +788,23 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
           NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << route->GetGateway ());
           Ipv4Header ipHeader;
           packet->RemoveHeader (ipHeader);
-          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
+          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
         }
     } 
   else 
     {
       if (outInterface->IsUp ())
         {
-          NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          m_txTrace (packet, m_node->GetObject<Ipv4> (), interface);
-          outInterface->Send (packet, ipHeader.GetDestination ());
+          NS_LOG_LOGIC ("Send to destination " << destination);
+          m_txTrace (packet, this, interface);
+          outInterface->Send (packet, destination);
         }
       else
         {
-          NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << ipHeader.GetDestination ());
+          NS_LOG_LOGIC ("Dropping -- outgoing interface is down: " << destination);
           Ipv4Header ipHeader;
           packet->RemoveHeader (ipHeader);
-          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, m_node->GetObject<Ipv4> (), interface);
+          m_dropTrace (ipHeader, packet, DROP_INTERFACE_DOWN, this, interface);
         }
     }
 }
@@ -754,7 +830,7 @@ Ipv4L3Protocol::IpMulticastForward (Ptr<Ipv4MulticastRoute> mrtentry, Ptr<const
       if (h.GetTtl () == 0)
         {
           NS_LOG_WARN ("TTL exceeded.  Drop.");
-          m_dropTrace (header, packet, DROP_TTL_EXPIRED, m_node->GetObject<Ipv4> (), interfaceId);
+          m_dropTrace (header, packet, DROP_TTL_EXPIRED, this, interfaceId);
           return;
         }
       NS_LOG_LOGIC ("Forward multicast via interface " << interfaceId);
@@ -790,13 +866,53 @@ Ipv4L3Protocol::IpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ip
           icmp->SendTimeExceededTtl (ipHeader, packet);
         }
       NS_LOG_WARN ("TTL exceeded.  Drop.");
-      m_dropTrace (header, packet, DROP_TTL_EXPIRED, m_node->GetObject<Ipv4> (), interface);
+      m_dropTrace (header, packet, DROP_TTL_EXPIRED, this, interface);
       return;
     }
   m_unicastForwardTrace (ipHeader, packet, interface);
   SendRealOut (rtentry, packet, ipHeader);
 }
 
+void
+Ipv4L3Protocol::FastIpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  NS_LOG_FUNCTION (this << rtentry << p << header);
+  //
+  // Only the packet being received, with its own header, can take the
+  // fast path: the routing protocol may also forward a packet it queued
+  // earlier.  A TTL which expires takes the slow path too, which reports
+  // it.
+  //
+  if (PeekPointer (p) != m_fastStripped || &header != m_fastHeader || header.GetTtl () <= 1)
+    {
+      IpForward (rtentry, p, header);
+      return;
+    }
+  NS_LOG_LOGIC ("Fast forwarding logic for node: " << m_node->GetId ());
+  Ptr<Packet> packet = m_fastPacket->Copy ();
+  DecrementTtl (packet);
+  SendOut (rtentry, packet, header.GetDestination ());
+}
+
+void
+Ipv4L3Protocol::DecrementTtl (Ptr<Packet> packet)
+{
+  Buffer::Iterator i = packet->BeginWrite ();
+  i.Next (8);
+  uint8_t ttl = i.ReadU8 ();
+  uint8_t protocol = i.ReadU8 ();
+  i.Prev (2);
+  i.WriteU8 (ttl - 1);
+  if (Node::ChecksumEnabled ())
+    {
+      // The TTL shares a 16 bit word with the protocol
+      i.Next (1);
+      uint16_t checksum = i.ReadNtohU16 ();
+      i.Prev (2);
+      i.WriteHtonU16 (ChecksumUpdate (checksum, (ttl << 8) | protocol, ((ttl - 1) << 8) | protocol));
+    }
+}
+
 void
 Ipv4L3Protocol::LocalDeliver (Ptr<const Packet> packet, Ipv4Header const&ip, uint32_t iif)
 {
@@ -1054,7 +1170,7 @@ Ipv4L3Protocol::RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeade
 {
   NS_LOG_FUNCTION (this << p << ipHeader << sockErrno);
   NS_LOG_LOGIC ("Route input failure-- dropping packet to " << ipHeader << " with errno " << sockErrno); 
-  m_dropTrace (ipHeader, p, DROP_ROUTE_ERROR, m_node->GetObject<Ipv4> (), 0);
+  m_dropTrace (ipHeader, p, DROP_ROUTE_ERROR, this, 0);
 }
 
 } //namespace ns3
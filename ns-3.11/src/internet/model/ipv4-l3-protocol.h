@@ -63,6 +63,15 @@ class Icmpv4L4Protocol;
  * and LocalDeliver trace sources are slightly higher-level and pass
  * around the Ipv4Header as an explicit parameter and not as part of
  * the packet.
+ *
+ * When the FastForwarding attribute is set and no sink is connected to
+ * the UnicastForward trace source, a packet forwarded by the node keeps
+ * the header it was received with: its TTL is decremented and its
+ * checksum updated in place, instead of the header being serialized
+ * again.  The routing protocol still sees the packet without its header.
+ * The bytes sent are the same, but the packet keeps the byte tags of
+ * the header received, which the sniffers and the receivers downstream
+ * can observe; the attribute is therefore off by default.
  */
 class Ipv4L3Protocol : public Ipv4
 {
@@ -224,6 +233,7 @@ private:
     uint8_t protocol,
     uint16_t payloadSize,
     uint8_t ttl,
+    uint8_t tos,
     bool mayFragment);
 
   void
@@ -231,6 +241,27 @@ private:
                Ptr<Packet> packet,
                Ipv4Header const &ipHeader);
 
+  /**
+   * Send a packet which carries its IPv4 header through the interface
+   * of a route.
+   */
+  void SendOut (Ptr<Ipv4Route> route, Ptr<Packet> packet, Ipv4Address destination);
+
+  /**
+   * Forward the packet being received through the fast path if
+   * possible, with IpForward otherwise.
+   */
+  void FastIpForward (Ptr<Ipv4Route> rtentry,
+                      Ptr<const Packet> p,
+                      const Ipv4Header &header);
+
+  /**
+   * Decrement the TTL of the IPv4 header at the start of a packet, and
+   * update its checksum incrementally (RFC 1624) when checksums are
+   * enabled.
+   */
+  static void DecrementTtl (Ptr<Packet> packet);
+
   void 
   IpForward (Ptr<Ipv4Route> rtentry, 
              Ptr<const Packet> p, 
@@ -261,6 +292,21 @@ private:
   uint16_t m_identification;
   Ptr<Node> m_node;
 
+  // Interface of each device of the node, by device index, -1 if none
+  std::vector<int32_t> m_deviceInterfaces;
+
+  bool m_fastForwarding;
+  // The packet being received, with its header, while the routing
+  // protocol may forward it through the fast path
+  Ptr<const Packet> m_fastPacket;
+  const Packet *m_fastStripped;
+  const Ipv4Header *m_fastHeader;
+
+  Ipv4RoutingProtocol::UnicastForwardCallback m_ucb;
+  Ipv4RoutingProtocol::MulticastForwardCallback m_mcb;
+  Ipv4RoutingProtocol::LocalDeliverCallback m_lcb;
+  Ipv4RoutingProtocol::ErrorCallback m_ecb;
+
   TracedCallback<const Ipv4Header &, Ptr<const Packet>, uint32_t> m_sendOutgoingTrace;
   TracedCallback<const Ipv4Header &, Ptr<const Packet>, uint32_t> m_unicastForwardTrace;
   TracedCallback<const Ipv4Header &, Ptr<const Packet>, uint32_t> m_localDeliverTrace;
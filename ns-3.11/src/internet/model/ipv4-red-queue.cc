@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/log.h"
+#include "ipv4-header.h"
+#include "ipv4-red-queue.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RedQueue");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv4RedQueue);
+
+TypeId
+Ipv4RedQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4RedQueue")
+    .SetParent<RedQueue> ()
+    .AddConstructor<Ipv4RedQueue> ()
+  ;
+  return tid;
+}
+
+Ipv4RedQueue::Ipv4RedQueue ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ipv4RedQueue::~Ipv4RedQueue ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+bool
+Ipv4RedQueue::Mark (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  // Find the IPv4 header: at the start of the packet, or behind a PPP
+  // header whose protocol field is 0x0021
+  uint8_t buf[2];
+  if (p->GetSize () < 2)
+    {
+      return false;
+    }
+  p->CopyData (buf, 2);
+  uint32_t offset;
+  if ((buf[0] >> 4) == 4)
+    {
+      offset = 0;
+    }
+  else if (buf[0] == 0x00 && buf[1] == 0x21)
+    {
+      offset = 2;
+    }
+  else
+    {
+      return false;
+    }
+  Ipv4Header header;
+  if (p->GetSize () < offset + header.GetSerializedSize ())
+    {
+      return false;
+    }
+
+  // The TOS byte is covered by the header checksum: keep it valid for
+  // the receivers that check it, by updating the checksum received if it
+  // is good, or computing it again otherwise
+  header.EnableChecksum ();
+  Ptr<Packet> datagram = p->CreateFragment (offset, p->GetSize () - offset);
+  datagram->RemoveHeader (header);
+  if (header.GetEcn () == Ipv4Header::ECN_NotECT)
+    {
+      return false;
+    }
+  header.SetEcn (Ipv4Header::ECN_CE);
+  datagram->AddHeader (header);
+
+  // Keep the uid and the tags of the original packet
+  Ptr<Packet> marked = p->CreateFragment (0, offset);
+  marked->AddAtEnd (datagram);
+  *p = *marked;
+  return true;
+}
+
+} // namespace ns3
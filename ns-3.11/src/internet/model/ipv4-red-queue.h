@@ -0,0 +1,53 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IPV4_RED_QUEUE_H
+#define IPV4_RED_QUEUE_H
+
+#include "ns3/red-queue.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4
+ * \brief A RED queue that marks ECN-capable IPv4 packets
+ *
+ * The packets signalled by the queue are marked with the Congestion
+ * Experienced codepoint when their IPv4 header carries ECT(0) or
+ * ECT(1), and dropped otherwise. The queue accepts packets that start
+ * with their IPv4 header, or with the PPP header of a
+ * PointToPointNetDevice, e.g.
+ *
+ * \code
+ *   p2p.SetQueue ("ns3::Ipv4RedQueue",
+ *                 "UseEcn", BooleanValue (true),
+ *                 "MinTh", DoubleValue (20), "MaxTh", DoubleValue (20),
+ *                 "QW", DoubleValue (1));
+ * \endcode
+ */
+class Ipv4RedQueue : public RedQueue
+{
+public:
+  static TypeId GetTypeId (void);
+  Ipv4RedQueue ();
+  virtual ~Ipv4RedQueue ();
+
+protected:
+  virtual bool Mark (Ptr<Packet> p);
+};
+
+} // namespace ns3
+
+#endif /* IPV4_RED_QUEUE_H */
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <algorithm>
+#include <cmath>
+#include "mp-tcp-congestion-control.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpCongestionControl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MpTcpCongestionControl);
+NS_OBJECT_ENSURE_REGISTERED (MpTcpLia);
+NS_OBJECT_ENSURE_REGISTERED (MpTcpOlia);
+
+/* Round trip time in seconds, with a floor to keep the ratios finite
+   before the first measurement */
+static double
+RttSeconds (const MpTcpSubflowState &s)
+{
+  return std::max (s.m_rtt.GetSeconds (), 1e-6);
+}
+
+TypeId
+MpTcpCongestionControl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpCongestionControl")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+MpTcpCongestionControl::~MpTcpCongestionControl ()
+{
+}
+
+TypeId
+MpTcpLia::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpLia")
+    .SetParent<MpTcpCongestionControl> ()
+    .AddConstructor<MpTcpLia> ()
+  ;
+  return tid;
+}
+
+MpTcpLia::MpTcpLia ()
+{
+}
+
+MpTcpLia::~MpTcpLia ()
+{
+}
+
+int32_t
+MpTcpLia::GetIncrease (uint32_t r, const std::vector<MpTcpSubflowState> &subflows)
+{
+  NS_LOG_FUNCTION (this << r);
+  NS_ASSERT (r < subflows.size ());
+  double total = 0;
+  double maxRatio = 0;
+  double sumRate = 0;
+  for (std::vector<MpTcpSubflowState>::const_iterator i = subflows.begin (); i != subflows.end (); ++i)
+    {
+      double rtt = RttSeconds (*i);
+      total += i->m_cWnd;
+      maxRatio = std::max (maxRatio, i->m_cWnd / (rtt * rtt));
+      sumRate += i->m_cWnd / rtt;
+    }
+  double mss = subflows[r].m_segmentSize;
+  double alpha = total * maxRatio / (sumRate * sumRate);
+  double coupled = alpha * mss * mss / total;
+  double uncoupled = mss * mss / subflows[r].m_cWnd;
+  double increase = std::max (1.0, std::min (coupled, uncoupled));
+  NS_LOG_LOGIC ("alpha " << alpha << " increase " << increase);
+  return static_cast<int32_t> (increase);
+}
+
+TypeId
+MpTcpOlia::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpOlia")
+    .SetParent<MpTcpCongestionControl> ()
+    .AddConstructor<MpTcpOlia> ()
+  ;
+  return tid;
+}
+
+MpTcpOlia::MpTcpOlia ()
+{
+}
+
+MpTcpOlia::~MpTcpOlia ()
+{
+}
+
+int32_t
+MpTcpOlia::GetIncrease (uint32_t r, const std::vector<MpTcpSubflowState> &subflows)
+{
+  NS_LOG_FUNCTION (this << r);
+  NS_ASSERT (r < subflows.size ());
+  uint32_t n = subflows.size ();
+  // Windows in segments; find the largest window and the best path quality
+  std::vector<double> w (n);
+  double sumRate = 0;
+  double maxW = 0;
+  double bestQuality = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double rtt = RttSeconds (subflows[i]);
+      double l = subflows[i].m_lossInterval;
+      w[i] = static_cast<double> (subflows[i].m_cWnd) / subflows[i].m_segmentSize;
+      sumRate += w[i] / rtt;
+      maxW = std::max (maxW, w[i]);
+      bestQuality = std::max (bestQuality, l * l / rtt);
+    }
+  // M: the paths with the largest window; B: the best paths. The
+  // collected paths are the best paths which do not have the largest window.
+  std::vector<bool> inM (n);
+  std::vector<bool> collected (n);
+  uint32_t nM = 0;
+  uint32_t nCollected = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      double l = subflows[i].m_lossInterval;
+      inM[i] = (w[i] == maxW);
+      collected[i] = !inM[i] && (l * l / RttSeconds (subflows[i]) == bestQuality);
+      nM += inM[i] ? 1 : 0;
+      nCollected += collected[i] ? 1 : 0;
+    }
+  double alpha = 0;
+  if (nCollected > 0)
+    {
+      if (collected[r])
+        {
+          alpha = 1.0 / (n * nCollected);
+        }
+      else if (inM[r])
+        {
+          alpha = -1.0 / (n * nM);
+        }
+    }
+  double rtt = RttSeconds (subflows[r]);
+  double increase = (w[r] / (rtt * rtt)) / (sumRate * sumRate) + alpha / w[r];
+  NS_LOG_LOGIC ("alpha " << alpha << " increase " << increase << " segments");
+  return static_cast<int32_t> (std::floor (increase * subflows[r].m_segmentSize + 0.5));
+}
+
+} // namespace ns3
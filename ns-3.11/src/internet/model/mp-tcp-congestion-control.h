@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MP_TCP_CONGESTION_CONTROL_H
+#define MP_TCP_CONGESTION_CONTROL_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief The congestion state of one subflow of a Multipath TCP connection
+ */
+struct MpTcpSubflowState
+{
+  uint32_t m_cWnd;         //< Congestion window (bytes)
+  uint32_t m_segmentSize;  //< Segment size (bytes)
+  Time m_rtt;              //< Smoothed round trip time
+  uint32_t m_lossInterval; //< Bytes acknowledged between the last two losses
+};
+
+/**
+ * \ingroup tcp
+ * \brief Coupled congestion control of the subflows of a Multipath TCP connection
+ *
+ * The subflows run slow start and loss recovery as NewReno does; only
+ * the congestion avoidance increase is coupled, so that a connection
+ * takes no more capacity than a single TCP flow on its best path, and
+ * moves its traffic away from the more congested paths.
+ */
+class MpTcpCongestionControl : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual ~MpTcpCongestionControl ();
+
+  /**
+   * \param r the index of the subflow which received a new ACK
+   * \param subflows the state of the established subflows of the connection
+   * \returns the change of the congestion window of subflow r, in bytes,
+   *          for one acknowledged segment in congestion avoidance
+   */
+  virtual int32_t GetIncrease (uint32_t r, const std::vector<MpTcpSubflowState> &subflows) = 0;
+};
+
+/**
+ * \ingroup tcp
+ * \brief The Linked Increases Algorithm (RFC 6356)
+ *
+ * The window of subflow r grows by min (alpha*mss^2/total, mss^2/w_r)
+ * per acknowledged segment, where total is the sum of the windows of
+ * the subflows and alpha = total * max (w_p/rtt_p^2) / (sum w_p/rtt_p)^2.
+ * On a single path this is the increase of NewReno.
+ */
+class MpTcpLia : public MpTcpCongestionControl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpLia ();
+  virtual ~MpTcpLia ();
+
+  virtual int32_t GetIncrease (uint32_t r, const std::vector<MpTcpSubflowState> &subflows);
+};
+
+/**
+ * \ingroup tcp
+ * \brief The Opportunistic Linked Increases Algorithm (Khalili et al., 2012)
+ *
+ * In segments, the window of subflow r grows by
+ * (w_r/rtt_r^2) / (sum w_p/rtt_p)^2 + alpha_r/w_r per acknowledged
+ * segment. The alpha terms move window from the subflows with the
+ * largest windows to the best paths (those with the largest
+ * l_p^2/rtt_p, l_p being the bytes acknowledged between losses) which
+ * do not have a largest window yet, and are zero once the best paths
+ * have the largest windows. Unlike LIA, OLIA is Pareto-optimal.
+ */
+class MpTcpOlia : public MpTcpCongestionControl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpOlia ();
+  virtual ~MpTcpOlia ();
+
+  virtual int32_t GetIncrease (uint32_t r, const std::vector<MpTcpSubflowState> &subflows);
+};
+
+} // namespace ns3
+
+#endif /* MP_TCP_CONGESTION_CONTROL_H */
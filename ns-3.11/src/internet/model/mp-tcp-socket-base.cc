@@ -0,0 +1,920 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include <algorithm>
+#include "mp-tcp-socket-base.h"
+#include "mp-tcp-subflow.h"
+#include "tcp-l4-protocol.h"
+#include "tcp-header.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-factory.h"
+#include "ns3/inet-socket-address.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpSocketBase");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MpTcpSocketBase);
+
+TypeId
+MpTcpSocketBase::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpSocketBase")
+    .SetParent<TcpSocket> ()
+    .AddConstructor<MpTcpSocketBase> ()
+    .AddAttribute ("Subflows",
+                   "Number of subflows opened by a connecting socket",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&MpTcpSocketBase::m_maxSubflows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("CongestionControl",
+                   "The type of the coupled congestion control of the subflows",
+                   TypeIdValue (MpTcpLia::GetTypeId ()),
+                   MakeTypeIdAccessor (&MpTcpSocketBase::m_ccTypeId),
+                   MakeTypeIdChecker ())
+  ;
+  return tid;
+}
+
+MpTcpSocketBase::MpTcpSocketBase (void)
+  : m_node (0),
+    m_tcp (0),
+    m_bound (false),
+    m_maxSubflows (2),
+    m_remoteKey (0),
+    m_mpCapable (false),
+    m_cc (0),
+    m_nextTxSequence (0),
+    m_state (CLOSED),
+    m_errno (ERROR_NOTERROR),
+    m_closeOnEmpty (false),
+    m_subflowsClosing (false),
+    m_closeNotified (false),
+    m_shutdownSend (false),
+    m_shutdownRecv (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpTcpSocketBase::MpTcpSocketBase (const MpTcpSocketBase& sock)
+  : TcpSocket (sock),
+    m_node (sock.m_node),
+    m_tcp (sock.m_tcp),
+    m_bound (false),
+    m_maxSubflows (sock.m_maxSubflows),
+    m_remoteKey (0),
+    m_mpCapable (false),
+    m_ccTypeId (sock.m_ccTypeId),
+    m_cc (0),
+    m_txBuffer (sock.m_txBuffer),
+    m_rxBuffer (sock.m_rxBuffer),
+    m_nextTxSequence (sock.m_nextTxSequence),
+    m_state (sock.m_state),
+    m_errno (sock.m_errno),
+    m_closeOnEmpty (false),
+    m_subflowsClosing (false),
+    m_closeNotified (false),
+    m_shutdownSend (false),
+    m_shutdownRecv (false),
+    m_sndBufSize (sock.m_sndBufSize),
+    m_rcvBufSize (sock.m_rcvBufSize),
+    m_segmentSize (sock.m_segmentSize),
+    m_ssThresh (sock.m_ssThresh),
+    m_initialCwnd (sock.m_initialCwnd),
+    m_cnTimeout (sock.m_cnTimeout),
+    m_cnCount (sock.m_cnCount),
+    m_delAckTimeout (sock.m_delAckTimeout),
+    m_delAckMaxCount (sock.m_delAckMaxCount),
+    m_persistTimeout (sock.m_persistTimeout)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+  // Reset all callbacks to null
+  Callback<void, Ptr< Socket > > vPS = MakeNullCallback<void, Ptr<Socket> > ();
+  Callback<void, Ptr<Socket>, uint32_t> vPSUI = MakeNullCallback<void, Ptr<Socket>, uint32_t> ();
+  SetConnectCallback (vPS, vPS);
+  SetDataSentCallback (vPSUI);
+  SetSendCallback (vPSUI);
+  SetRecvCallback (vPS);
+}
+
+MpTcpSocketBase::~MpTcpSocketBase (void)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MpTcpSocketBase::DoDispose (void)
+{
+  m_subflows.clear ();
+  m_listener = 0;
+  m_accepted.clear ();
+  m_cc = 0;
+  m_tcp = 0;
+  m_node = 0;
+  TcpSocket::DoDispose ();
+}
+
+void
+MpTcpSocketBase::SetNode (Ptr<Node> node)
+{
+  m_node = node;
+}
+
+void
+MpTcpSocketBase::SetTcp (Ptr<TcpL4Protocol> tcp)
+{
+  m_tcp = tcp;
+}
+
+enum Socket::SocketErrno
+MpTcpSocketBase::GetErrno (void) const
+{
+  return m_errno;
+}
+
+enum Socket::SocketType
+MpTcpSocketBase::GetSocketType (void) const
+{
+  return NS3_SOCK_STREAM;
+}
+
+Ptr<Node>
+MpTcpSocketBase::GetNode (void) const
+{
+  return m_node;
+}
+
+/** The subflows are bound when the socket connects or listens */
+int
+MpTcpSocketBase::Bind (void)
+{
+  NS_LOG_FUNCTION (this);
+  return Bind (InetSocketAddress (Ipv4Address::GetAny (), 0));
+}
+
+int
+MpTcpSocketBase::Bind (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+  if (!InetSocketAddress::IsMatchingType (address) || m_state != CLOSED)
+    {
+      m_errno = ERROR_INVAL;
+      return -1;
+    }
+  m_localAddress = address;
+  m_bound = true;
+  return 0;
+}
+
+/** Open the first subflow with MP_CAPABLE. The other subflows are opened
+    once it is established. */
+int
+MpTcpSocketBase::Connect (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+  if (m_state != CLOSED || !InetSocketAddress::IsMatchingType (address))
+    {
+      m_errno = ERROR_INVAL;
+      return -1;
+    }
+  m_peerAddress = address;
+  Ptr<MpTcpSubflow> subflow = CreateSubflow ();
+  if (m_bound && subflow->Bind (m_localAddress) == -1)
+    {
+      m_errno = subflow->GetErrno ();
+      return -1;
+    }
+  subflow->SetCapable ();
+  subflow->SetConnectCallback (MakeCallback (&MpTcpSocketBase::SubflowConnected, this),
+                               MakeCallback (&MpTcpSocketBase::SubflowConnectionFailed, this));
+  AddSubflow (subflow);
+  m_state = SYN_SENT;
+  if (subflow->Connect (address) == -1)
+    {
+      m_errno = subflow->GetErrno ();
+      m_state = CLOSED;
+      m_subflows.clear ();
+      return -1;
+    }
+  return 0;
+}
+
+int
+MpTcpSocketBase::Listen (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state != CLOSED)
+    {
+      m_errno = ERROR_INVAL;
+      return -1;
+    }
+  m_listener = CreateSubflow ();
+  if ((m_bound ? m_listener->Bind (m_localAddress) : m_listener->Bind ()) == -1)
+    {
+      m_errno = m_listener->GetErrno ();
+      m_listener = 0;
+      return -1;
+    }
+  m_listener->SetAcceptCallback (MakeCallback (&MpTcpSocketBase::SubflowConnectionRequest, this),
+                                 MakeCallback (&MpTcpSocketBase::SubflowAccepted, this));
+  if (m_listener->Listen () == -1)
+    {
+      m_errno = m_listener->GetErrno ();
+      m_listener = 0;
+      return -1;
+    }
+  m_state = LISTEN;
+  return 0;
+}
+
+/** Close the subflows once all the data is pushed into them */
+int
+MpTcpSocketBase::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  switch (m_state)
+    {
+    case LISTEN:
+      m_listener->Close ();
+      m_listener = 0;
+      m_accepted.clear ();
+      m_state = CLOSED;
+      return 0;
+    case CLOSED:
+    case SYN_SENT:
+      CloseSubflows ();
+      m_state = CLOSED;
+      return 0;
+    case ESTABLISHED:
+      m_state = FIN_WAIT_1;
+      break;
+    case CLOSE_WAIT:
+      m_state = LAST_ACK;
+      break;
+    default:
+      return 0;
+    }
+  if (m_rxBuffer.Size () != 0)
+    {
+      NS_LOG_WARN ("Closing MpTcpSocketBase " << this << " with unread data");
+    }
+  m_closeOnEmpty = true;
+  SendPendingData ();
+  return 0;
+}
+
+int
+MpTcpSocketBase::ShutdownSend (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_shutdownSend = true;
+  return 0;
+}
+
+int
+MpTcpSocketBase::ShutdownRecv (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_shutdownRecv = true;
+  return 0;
+}
+
+int
+MpTcpSocketBase::Send (Ptr<Packet> p, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this << p);
+  NS_ABORT_MSG_IF (flags, "use of flags is not supported in MpTcpSocketBase::Send()");
+  if (m_state != ESTABLISHED && m_state != SYN_SENT && m_state != CLOSE_WAIT)
+    { // Connection not established yet, or closed
+      m_errno = ERROR_NOTCONN;
+      return -1;
+    }
+  if (!m_txBuffer.Add (p))
+    { // TxBuffer overflow, send failed
+      m_errno = ERROR_MSGSIZE;
+      return -1;
+    }
+  SendPendingData ();
+  return p->GetSize ();
+}
+
+int
+MpTcpSocketBase::SendTo (Ptr<Packet> p, uint32_t flags, const Address &address)
+{
+  return Send (p, flags);
+}
+
+Ptr<Packet>
+MpTcpSocketBase::Recv (uint32_t maxSize, uint32_t flags)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (flags, "use of flags is not supported in MpTcpSocketBase::Recv()");
+  if (m_rxBuffer.Size () == 0 && (m_state == CLOSE_WAIT || m_state == LAST_ACK))
+    {
+      return Create<Packet> (); // Send EOF on connection close
+    }
+  Ptr<Packet> outPacket = m_rxBuffer.Extract (maxSize);
+  if (outPacket != 0 && outPacket->GetSize () != 0)
+    {
+      SocketAddressTag tag;
+      tag.SetAddress (m_peerAddress);
+      outPacket->AddPacketTag (tag);
+      // Room was made: move more data up from the subflows, but not from
+      // within the call of the application
+      if (!m_pullEvent.IsRunning ())
+        {
+          m_pullEvent = Simulator::ScheduleNow (&MpTcpSocketBase::PullData, this);
+        }
+    }
+  return outPacket;
+}
+
+Ptr<Packet>
+MpTcpSocketBase::RecvFrom (uint32_t maxSize, uint32_t flags, Address &fromAddress)
+{
+  NS_LOG_FUNCTION (this << maxSize << flags);
+  Ptr<Packet> packet = Recv (maxSize, flags);
+  // Null packet means no data to read, and an empty packet indicates EOF
+  if (packet != 0 && packet->GetSize () != 0)
+    {
+      fromAddress = m_peerAddress;
+    }
+  else
+    {
+      fromAddress = InetSocketAddress (Ipv4Address::GetZero (), 0);
+    }
+  return packet;
+}
+
+uint32_t
+MpTcpSocketBase::GetTxAvailable (void) const
+{
+  return m_txBuffer.Available ();
+}
+
+uint32_t
+MpTcpSocketBase::GetRxAvailable (void) const
+{
+  return m_rxBuffer.Available ();
+}
+
+int
+MpTcpSocketBase::GetSockName (Address &address) const
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_subflows.empty ())
+    {
+      return m_subflows.front ()->GetSockName (address);
+    }
+  if (m_listener != 0)
+    {
+      return m_listener->GetSockName (address);
+    }
+  address = InetSocketAddress (Ipv4Address::GetZero (), 0);
+  return 0;
+}
+
+bool
+MpTcpSocketBase::SetAllowBroadcast (bool allowBroadcast)
+{
+  return (!allowBroadcast);
+}
+
+bool
+MpTcpSocketBase::GetAllowBroadcast () const
+{
+  return false;
+}
+
+SequenceNumber32
+MpTcpSocketBase::GetDataAck (void) const
+{
+  return m_rxBuffer.NextRxSequence ();
+}
+
+/** Release the data acknowledged at the data level */
+void
+MpTcpSocketBase::ReceivedDataAck (SequenceNumber32 ack)
+{
+  NS_LOG_FUNCTION (this << ack);
+  if (ack <= m_txBuffer.HeadSequence () || ack > m_nextTxSequence)
+    {
+      return;
+    }
+  m_txBuffer.DiscardUpTo (ack);
+  if (GetTxAvailable () > 0)
+    {
+      NotifySend (GetTxAvailable ());
+    }
+}
+
+int32_t
+MpTcpSocketBase::GetIncrease (Ptr<MpTcpSubflow> subflow)
+{
+  if (m_cc == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_ccTypeId);
+      m_cc = factory.Create<MpTcpCongestionControl> ();
+    }
+  std::vector<MpTcpSubflowState> states;
+  uint32_t r = 0;
+  for (std::vector<Ptr<MpTcpSubflow> >::const_iterator i = m_subflows.begin (); i != m_subflows.end (); ++i)
+    {
+      if (*i == subflow)
+        {
+          r = states.size ();
+        }
+      else if (!(*i)->IsConnected ())
+        {
+          continue;
+        }
+      MpTcpSubflowState state;
+      state.m_cWnd = (*i)->GetCongestionWindow ();
+      state.m_segmentSize = (*i)->GetSegmentSize ();
+      state.m_rtt = (*i)->GetRoundTripTime ();
+      state.m_lossInterval = (*i)->GetLossInterval ();
+      states.push_back (state);
+    }
+  return m_cc->GetIncrease (r, states);
+}
+
+uint32_t
+MpTcpSocketBase::GetSubflowCount (void) const
+{
+  return m_subflows.size ();
+}
+
+uint32_t
+MpTcpSocketBase::KeyToToken (uint64_t key)
+{
+  // RFC 6824 truncates the SHA-1 of the key; a multiplicative hash is
+  // as good at telling apart the few keys of a simulation
+  return static_cast<uint32_t> (key >> 32) * 2654435761U + static_cast<uint32_t> (key);
+}
+
+Ptr<MpTcpSubflow>
+MpTcpSocketBase::CreateSubflow (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<MpTcpSubflow> subflow = DynamicCast<MpTcpSubflow> (m_tcp->CreateSocket (MpTcpSubflow::GetTypeId ()));
+  // Hand the TcpSocket attributes of this socket down to the subflow
+  TypeId tid = TcpSocket::GetTypeId ();
+  for (uint32_t i = 0; i < tid.GetAttributeN (); ++i)
+    {
+      Ptr<AttributeValue> value = tid.GetAttributeChecker (i)->Create ();
+      GetAttribute (tid.GetAttributeName (i), *value);
+      subflow->SetAttribute (tid.GetAttributeName (i), *value);
+    }
+  return subflow;
+}
+
+void
+MpTcpSocketBase::AddSubflow (Ptr<MpTcpSubflow> subflow)
+{
+  NS_LOG_FUNCTION (this << subflow);
+  subflow->SetMeta (this);
+  subflow->SetSendCallback (MakeCallback (&MpTcpSocketBase::SubflowSend, this));
+  subflow->SetRecvCallback (MakeCallback (&MpTcpSocketBase::SubflowRecv, this));
+  subflow->SetCloseCallbacks (MakeCallback (&MpTcpSocketBase::SubflowClosed, this),
+                              MakeCallback (&MpTcpSocketBase::SubflowClosed, this));
+  m_subflows.push_back (subflow);
+}
+
+/** Open the MP_JOIN subflows, each from its own local port */
+void
+MpTcpSocketBase::OpenJoinSubflows (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t token = KeyToToken (m_remoteKey);
+  Ipv4Address local = Ipv4Address::GetAny ();
+  if (m_bound)
+    {
+      local = InetSocketAddress::ConvertFrom (m_localAddress).GetIpv4 ();
+    }
+  for (uint32_t i = 1; i < m_maxSubflows; ++i)
+    {
+      Ptr<MpTcpSubflow> subflow = CreateSubflow ();
+      if (subflow->Bind (InetSocketAddress (local, 0)) == -1)
+        {
+          NS_LOG_WARN ("No port left for subflow " << i);
+          return;
+        }
+      subflow->SetJoin (token);
+      subflow->SetConnectCallback (MakeCallback (&MpTcpSocketBase::SubflowConnected, this),
+                                   MakeCallback (&MpTcpSocketBase::SubflowConnectionFailed, this));
+      AddSubflow (subflow);
+      subflow->Connect (m_peerAddress);
+    }
+}
+
+/** Push the unsent data into the subflows, one segment at a time */
+void
+MpTcpSocketBase::SendPendingData (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state != ESTABLISHED && m_state != CLOSE_WAIT && m_state != FIN_WAIT_1 && m_state != LAST_ACK)
+    {
+      return;
+    }
+  bool released = false;
+  while (m_txBuffer.SizeFromSequence (m_nextTxSequence) > 0)
+    {
+      uint32_t size = std::min (m_segmentSize, m_txBuffer.SizeFromSequence (m_nextTxSequence));
+      Ptr<MpTcpSubflow> subflow = PickSubflow (size);
+      if (subflow == 0)
+        {
+          break;
+        }
+      Ptr<Packet> p = m_txBuffer.CopyFromSequence (size, m_nextTxSequence);
+      if (subflow->SendMapping (p, m_nextTxSequence) < 0)
+        {
+          break;
+        }
+      NS_LOG_LOGIC ("Data " << m_nextTxSequence << "+" << size << " on subflow " << subflow);
+      m_nextTxSequence += size;
+      Simulator::ScheduleNow (&MpTcpSocketBase::NotifyDataSent, this, size);
+      if (!m_mpCapable)
+        { // Regular TCP: no data acknowledgement will come
+          m_txBuffer.DiscardUpTo (m_nextTxSequence);
+          released = true;
+        }
+    }
+  if (m_closeOnEmpty && m_txBuffer.SizeFromSequence (m_nextTxSequence) == 0)
+    {
+      CloseSubflows ();
+    }
+  else if (released && GetTxAvailable () > 0)
+    { // Not from within Send (): the application may still be writing
+      Simulator::ScheduleNow (&MpTcpSocketBase::NotifySend, this, GetTxAvailable ());
+    }
+}
+
+Ptr<MpTcpSubflow>
+MpTcpSocketBase::PickSubflow (uint32_t size)
+{
+  Ptr<MpTcpSubflow> best = 0;
+  Time bestRtt;
+  for (std::vector<Ptr<MpTcpSubflow> >::const_iterator i = m_subflows.begin (); i != m_subflows.end (); ++i)
+    {
+      if (!(*i)->IsConnected () || (*i)->GetFreeWindow () < size)
+        {
+          continue;
+        }
+      Time rtt = (*i)->GetRoundTripTime ();
+      if (best == 0 || rtt < bestRtt)
+        {
+          best = *i;
+          bestRtt = rtt;
+        }
+      if (!m_mpCapable)
+        { // Only the first subflow carries data
+          break;
+        }
+    }
+  return best;
+}
+
+/** Move the data received by the subflows into the data-level buffer */
+void
+MpTcpSocketBase::PullData (void)
+{
+  NS_LOG_FUNCTION (this);
+  SequenceNumber32 expectedSeq = m_rxBuffer.NextRxSequence ();
+  for (std::vector<Ptr<MpTcpSubflow> >::const_iterator i = m_subflows.begin (); i != m_subflows.end (); ++i)
+    {
+      PullSubflow (*i);
+    }
+  if (expectedSeq < m_rxBuffer.NextRxSequence () && !m_shutdownRecv)
+    {
+      NotifyDataRecv ();
+    }
+  CheckPeerClose ();
+}
+
+void
+MpTcpSocketBase::PullSubflow (Ptr<MpTcpSubflow> subflow)
+{
+  SequenceNumber32 dataSeq;
+  uint32_t length;
+  while (subflow->PeekMapping (dataSeq, length))
+    {
+      SequenceNumber32 maxSeq = m_rxBuffer.MaxRxSequence ();
+      if (dataSeq >= maxSeq)
+        { // The data-level buffer is full: leave it in the subflow
+          break;
+        }
+      length = std::min (length, static_cast<uint32_t> (maxSeq - dataSeq));
+      Ptr<Packet> p = subflow->ExtractMapped (length);
+      TcpHeader header;
+      header.SetSequenceNumber (dataSeq);
+      m_rxBuffer.Add (p, header);
+    }
+}
+
+/** The peer closed the connection once every subflow is closed and read */
+void
+MpTcpSocketBase::CheckPeerClose (void)
+{
+  if ((m_state != ESTABLISHED && m_state != FIN_WAIT_1) || m_subflows.empty ())
+    {
+      return;
+    }
+  for (std::vector<Ptr<MpTcpSubflow> >::const_iterator i = m_subflows.begin (); i != m_subflows.end (); ++i)
+    {
+      if (!(*i)->PeerClosed () || (*i)->GetRxAvailable () > 0)
+        {
+          return;
+        }
+    }
+  if (m_state == ESTABLISHED)
+    {
+      NS_LOG_INFO ("ESTABLISHED -> CLOSE_WAIT");
+      m_state = CLOSE_WAIT;
+    }
+  else
+    {
+      NS_LOG_INFO ("FIN_WAIT_1 -> CLOSED");
+      m_state = CLOSED;
+    }
+  if (!m_closeNotified)
+    {
+      NotifyNormalClose ();
+      m_closeNotified = true;
+    }
+  if (m_shutdownSend && m_state == CLOSE_WAIT)
+    {
+      Close ();
+    }
+}
+
+void
+MpTcpSocketBase::CloseSubflows (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_subflowsClosing)
+    {
+      return;
+    }
+  m_subflowsClosing = true;
+  // Closing a subflow may call back into this socket
+  std::vector<Ptr<MpTcpSubflow> > subflows = m_subflows;
+  for (std::vector<Ptr<MpTcpSubflow> >::iterator i = subflows.begin (); i != subflows.end (); ++i)
+    {
+      (*i)->Close ();
+    }
+}
+
+void
+MpTcpSocketBase::SubflowConnected (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Ptr<MpTcpSubflow> subflow = DynamicCast<MpTcpSubflow> (socket);
+  if (m_state == SYN_SENT)
+    { // The first subflow: MPTCP is negotiated, or not
+      NS_LOG_INFO ("SYN_SENT -> ESTABLISHED");
+      m_state = ESTABLISHED;
+      m_mpCapable = subflow->IsMpCapable ();
+      if (m_mpCapable)
+        {
+          m_remoteKey = subflow->GetRemoteKey ();
+          OpenJoinSubflows ();
+        }
+      else
+        {
+          NS_LOG_INFO ("Peer is not MPTCP capable, fall back to TCP");
+        }
+      NotifyConnectionSucceeded ();
+      if (GetTxAvailable () > 0)
+        {
+          NotifySend (GetTxAvailable ());
+        }
+    }
+  else if (!subflow->IsMpCapable () || m_subflowsClosing)
+    { // The join was refused, or came too late
+      subflow->Close ();
+      return;
+    }
+  SendPendingData ();
+}
+
+void
+MpTcpSocketBase::SubflowConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  if (m_state == SYN_SENT)
+    {
+      m_state = CLOSED;
+      NotifyConnectionFailed ();
+    }
+}
+
+bool
+MpTcpSocketBase::SubflowConnectionRequest (Ptr<Socket> socket, const Address &from)
+{
+  // The listener has read the options of the SYN: only new connections
+  // are for the application to accept
+  Ptr<MpTcpSubflow> listener = DynamicCast<MpTcpSubflow> (socket);
+  return listener->IsJoin () || NotifyConnectionRequest (from);
+}
+
+void
+MpTcpSocketBase::SubflowAccepted (Ptr<Socket> socket, const Address &from)
+{
+  NS_LOG_FUNCTION (this << socket << from);
+  Ptr<MpTcpSubflow> subflow = DynamicCast<MpTcpSubflow> (socket);
+  if (subflow->IsJoin ())
+    {
+      std::map<uint32_t, Ptr<MpTcpSocketBase> >::iterator i = m_accepted.find (subflow->GetJoinToken ());
+      if (i == m_accepted.end () || i->second->m_subflowsClosing)
+        {
+          NS_LOG_LOGIC ("MP_JOIN with unknown token " << subflow->GetJoinToken ());
+          subflow->Close ();
+          return;
+        }
+      i->second->AddSubflow (subflow);
+      i->second->PullData ();
+      i->second->SendPendingData ();
+      return;
+    }
+  // A new connection: fork this socket
+  Ptr<MpTcpSocketBase> connection = CopyObject<MpTcpSocketBase> (this);
+  connection->m_state = ESTABLISHED;
+  connection->m_mpCapable = subflow->IsMpCapable ();
+  connection->m_remoteKey = subflow->GetRemoteKey ();
+  connection->m_peerAddress = from;
+  connection->AddSubflow (subflow);
+  if (connection->m_mpCapable)
+    {
+      m_accepted[KeyToToken (subflow->GetLocalKey ())] = connection;
+    }
+  NotifyNewConnectionCreated (connection, from);
+  // Data may have come with the end of the handshake
+  connection->PullData ();
+}
+
+void
+MpTcpSocketBase::SubflowSend (Ptr<Socket> socket, uint32_t available)
+{
+  SendPendingData ();
+}
+
+void
+MpTcpSocketBase::SubflowRecv (Ptr<Socket> socket)
+{
+  PullData ();
+}
+
+void
+MpTcpSocketBase::SubflowClosed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  PullData ();
+}
+
+void
+MpTcpSocketBase::SetSndBufSize (uint32_t size)
+{
+  m_sndBufSize = size;
+  m_txBuffer.SetMaxBufferSize (size);
+}
+
+uint32_t
+MpTcpSocketBase::GetSndBufSize (void) const
+{
+  return m_sndBufSize;
+}
+
+void
+MpTcpSocketBase::SetRcvBufSize (uint32_t size)
+{
+  m_rcvBufSize = size;
+  m_rxBuffer.SetMaxBufferSize (size);
+}
+
+uint32_t
+MpTcpSocketBase::GetRcvBufSize (void) const
+{
+  return m_rcvBufSize;
+}
+
+void
+MpTcpSocketBase::SetSegSize (uint32_t size)
+{
+  NS_ABORT_MSG_UNLESS (m_state == CLOSED, "MpTcpSocketBase::SetSegSize() cannot change segment size after connection started.");
+  m_segmentSize = size;
+}
+
+uint32_t
+MpTcpSocketBase::GetSegSize (void) const
+{
+  return m_segmentSize;
+}
+
+void
+MpTcpSocketBase::SetSSThresh (uint32_t threshold)
+{
+  m_ssThresh = threshold;
+}
+
+uint32_t
+MpTcpSocketBase::GetSSThresh (void) const
+{
+  return m_ssThresh;
+}
+
+void
+MpTcpSocketBase::SetInitialCwnd (uint32_t cwnd)
+{
+  m_initialCwnd = cwnd;
+}
+
+uint32_t
+MpTcpSocketBase::GetInitialCwnd (void) const
+{
+  return m_initialCwnd;
+}
+
+void
+MpTcpSocketBase::SetConnTimeout (Time timeout)
+{
+  m_cnTimeout = timeout;
+}
+
+Time
+MpTcpSocketBase::GetConnTimeout (void) const
+{
+  return m_cnTimeout;
+}
+
+void
+MpTcpSocketBase::SetConnCount (uint32_t count)
+{
+  m_cnCount = count;
+}
+
+uint32_t
+MpTcpSocketBase::GetConnCount (void) const
+{
+  return m_cnCount;
+}
+
+void
+MpTcpSocketBase::SetDelAckTimeout (Time timeout)
+{
+  m_delAckTimeout = timeout;
+}
+
+Time
+MpTcpSocketBase::GetDelAckTimeout (void) const
+{
+  return m_delAckTimeout;
+}
+
+void
+MpTcpSocketBase::SetDelAckMaxCount (uint32_t count)
+{
+  m_delAckMaxCount = count;
+}
+
+uint32_t
+MpTcpSocketBase::GetDelAckMaxCount (void) const
+{
+  return m_delAckMaxCount;
+}
+
+void
+MpTcpSocketBase::SetPersistTimeout (Time timeout)
+{
+  m_persistTimeout = timeout;
+}
+
+Time
+MpTcpSocketBase::GetPersistTimeout (void) const
+{
+  return m_persistTimeout;
+}
+
+} // namespace ns3
@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MP_TCP_SOCKET_BASE_H
+#define MP_TCP_SOCKET_BASE_H
+
+#include <map>
+#include <vector>
+#include "ns3/tcp-socket.h"
+#include "ns3/event-id.h"
+#include "tcp-tx-buffer.h"
+#include "tcp-rx-buffer.h"
+#include "mp-tcp-congestion-control.h"
+
+namespace ns3 {
+
+class Node;
+class TcpL4Protocol;
+class MpTcpSubflow;
+
+/**
+ * \ingroup tcp
+ * \brief A Multipath TCP connection (RFC 6824)
+ *
+ * The socket offers the usual stream socket API, and spreads the data
+ * of the application over several MpTcpSubflow connections. The
+ * connecting side opens the first subflow with MP_CAPABLE and, once it
+ * is established, the other subflows with MP_JOIN; each of them is
+ * bound to its own local port, so that the ECMP routing of the network
+ * can hash them onto different paths. The data is scheduled onto the
+ * established subflow with the smallest round trip time which has
+ * room in its congestion window, and reassembled in data sequence
+ * order at the receiver. The congestion avoidance of the subflows is
+ * coupled by a MpTcpCongestionControl.
+ *
+ * If the peer does not answer MP_CAPABLE, the connection falls back to
+ * regular TCP over its first subflow.
+ *
+ * The model keeps the subflows open for the life of the connection: a
+ * lost subflow is not detected, and its data is not reinjected onto
+ * the other subflows. The connection is closed by closing every
+ * subflow once all the data is pushed into them, instead of with a
+ * DATA_FIN.
+ */
+class MpTcpSocketBase : public TcpSocket
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpSocketBase (void);
+  MpTcpSocketBase (const MpTcpSocketBase& sock);
+  virtual ~MpTcpSocketBase (void);
+
+  void SetNode (Ptr<Node> node);
+  void SetTcp (Ptr<TcpL4Protocol> tcp);
+
+  // Necessary implementations of null functions from ns3::Socket
+  virtual enum SocketErrno GetErrno (void) const;
+  virtual enum SocketType GetSocketType (void) const;
+  virtual Ptr<Node> GetNode (void) const;
+  virtual int Bind (void);
+  virtual int Bind (const Address &address);
+  virtual int Connect (const Address &address);
+  virtual int Listen (void);
+  virtual int Close (void);
+  virtual int ShutdownSend (void);
+  virtual int ShutdownRecv (void);
+  virtual int Send (Ptr<Packet> p, uint32_t flags);
+  virtual int SendTo (Ptr<Packet> p, uint32_t flags, const Address &toAddress);
+  virtual Ptr<Packet> Recv (uint32_t maxSize, uint32_t flags);
+  virtual Ptr<Packet> RecvFrom (uint32_t maxSize, uint32_t flags, Address &fromAddress);
+  virtual uint32_t GetTxAvailable (void) const;
+  virtual uint32_t GetRxAvailable (void) const;
+  virtual int GetSockName (Address &address) const;
+  virtual bool SetAllowBroadcast (bool allowBroadcast);
+  virtual bool GetAllowBroadcast () const;
+
+  // Called by the subflows
+  SequenceNumber32 GetDataAck (void) const;  // Next data sequence number expected
+  void ReceivedDataAck (SequenceNumber32 ack);
+  int32_t GetIncrease (Ptr<MpTcpSubflow> subflow); // Coupled congestion avoidance increase
+
+  /**
+   * \returns the number of subflows of the connection
+   */
+  uint32_t GetSubflowCount (void) const;
+  /**
+   * \param key a key of MP_CAPABLE
+   * \returns the token which identifies the connection of the key
+   */
+  static uint32_t KeyToToken (uint64_t key);
+
+protected:
+  // Implementing ns3::TcpSocket -- Attribute get/set
+  virtual void     SetSndBufSize (uint32_t size);
+  virtual uint32_t GetSndBufSize (void) const;
+  virtual void     SetRcvBufSize (uint32_t size);
+  virtual uint32_t GetRcvBufSize (void) const;
+  virtual void     SetSegSize (uint32_t size);
+  virtual uint32_t GetSegSize (void) const;
+  virtual void     SetSSThresh (uint32_t threshold);
+  virtual uint32_t GetSSThresh (void) const;
+  virtual void     SetInitialCwnd (uint32_t cwnd);
+  virtual uint32_t GetInitialCwnd (void) const;
+  virtual void     SetConnTimeout (Time timeout);
+  virtual Time     GetConnTimeout (void) const;
+  virtual void     SetConnCount (uint32_t count);
+  virtual uint32_t GetConnCount (void) const;
+  virtual void     SetDelAckTimeout (Time timeout);
+  virtual Time     GetDelAckTimeout (void) const;
+  virtual void     SetDelAckMaxCount (uint32_t count);
+  virtual uint32_t GetDelAckMaxCount (void) const;
+  virtual void     SetPersistTimeout (Time timeout);
+  virtual Time     GetPersistTimeout (void) const;
+
+  virtual void DoDispose (void);
+
+private:
+  Ptr<MpTcpSubflow> CreateSubflow (void); // A subflow with the attributes of this socket
+  void AddSubflow (Ptr<MpTcpSubflow> subflow);
+  void OpenJoinSubflows (void);
+  void SendPendingData (void);  // Push data into the subflows as their windows allow
+  Ptr<MpTcpSubflow> PickSubflow (uint32_t size); // Lowest RTT subflow with room for size bytes
+  void PullData (void);         // Move the mapped data of the subflows into m_rxBuffer
+  void PullSubflow (Ptr<MpTcpSubflow> subflow);
+  void CheckPeerClose (void);
+  void CloseSubflows (void);
+
+  // Subflow callbacks
+  void SubflowConnected (Ptr<Socket> socket);
+  void SubflowConnectionFailed (Ptr<Socket> socket);
+  bool SubflowConnectionRequest (Ptr<Socket> socket, const Address &from);
+  void SubflowAccepted (Ptr<Socket> socket, const Address &from);
+  void SubflowSend (Ptr<Socket> socket, uint32_t available);
+  void SubflowRecv (Ptr<Socket> socket);
+  void SubflowClosed (Ptr<Socket> socket);
+
+  // Connections to other layers of TCP/IP
+  Ptr<Node> m_node;
+  Ptr<TcpL4Protocol> m_tcp;
+  Address m_localAddress;
+  bool m_bound;
+  Address m_peerAddress;
+
+  // Subflows
+  uint32_t m_maxSubflows;
+  std::vector<Ptr<MpTcpSubflow> > m_subflows;
+  Ptr<MpTcpSubflow> m_listener;
+  std::map<uint32_t, Ptr<MpTcpSocketBase> > m_accepted; //< Connections accepted by a listener, by token
+  uint64_t m_remoteKey;
+  bool m_mpCapable;
+
+  // Congestion control
+  TypeId m_ccTypeId;
+  Ptr<MpTcpCongestionControl> m_cc;
+
+  // Data-level buffers
+  TcpTxBuffer m_txBuffer;
+  TcpRxBuffer m_rxBuffer;
+  SequenceNumber32 m_nextTxSequence; //< Next data sequence number to push into a subflow
+  EventId m_pullEvent;
+
+  // State
+  TcpStates_t m_state;
+  enum SocketErrno m_errno;
+  bool m_closeOnEmpty;
+  bool m_subflowsClosing;
+  bool m_closeNotified;
+  bool m_shutdownSend;
+  bool m_shutdownRecv;
+
+  // Attributes handed to the subflows
+  uint32_t m_sndBufSize;
+  uint32_t m_rcvBufSize;
+  uint32_t m_segmentSize;
+  uint32_t m_ssThresh;
+  uint32_t m_initialCwnd;
+  Time m_cnTimeout;
+  uint32_t m_cnCount;
+  Time m_delAckTimeout;
+  uint32_t m_delAckMaxCount;
+  Time m_persistTimeout;
+};
+
+} // namespace ns3
+
+#endif /* MP_TCP_SOCKET_BASE_H */
@@ -0,0 +1,465 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include <algorithm>
+#include "mp-tcp-subflow.h"
+#include "mp-tcp-socket-base.h"
+#include "tcp-option-mptcp.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpSubflow");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MpTcpSubflow);
+
+TypeId
+MpTcpSubflow::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpSubflow")
+    .SetParent<TcpNewReno> ()
+    .AddConstructor<MpTcpSubflow> ()
+  ;
+  return tid;
+}
+
+MpTcpSubflow::MpTcpSubflow (void)
+  : m_meta (0),
+    m_mpCapable (false),
+    m_isJoin (false),
+    m_localKey (0),
+    m_remoteKey (0),
+    m_joinToken (0),
+    m_bytesSinceLoss (0),
+    m_lastLossInterval (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MpTcpSubflow::MpTcpSubflow (const MpTcpSubflow& sock)
+  : TcpNewReno (sock),
+    m_meta (0),
+    m_mpCapable (sock.m_mpCapable),
+    m_isJoin (sock.m_isJoin),
+    m_localKey (0),
+    m_remoteKey (sock.m_remoteKey),
+    m_joinToken (sock.m_joinToken),
+    m_rxReadSequence (sock.m_rxReadSequence),
+    m_rxInitialSequence (sock.m_rxInitialSequence),
+    m_bytesSinceLoss (0),
+    m_lastLossInterval (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+}
+
+MpTcpSubflow::~MpTcpSubflow (void)
+{
+}
+
+void
+MpTcpSubflow::DoDispose (void)
+{
+  m_meta = 0;
+  TcpNewReno::DoDispose ();
+}
+
+void
+MpTcpSubflow::SetMeta (Ptr<MpTcpSocketBase> meta)
+{
+  m_meta = meta;
+}
+
+void
+MpTcpSubflow::SetCapable (void)
+{
+  m_mpCapable = true;
+  GenerateKey ();
+}
+
+void
+MpTcpSubflow::SetJoin (uint32_t token)
+{
+  m_mpCapable = true;
+  m_isJoin = true;
+  m_joinToken = token;
+}
+
+bool
+MpTcpSubflow::IsMpCapable (void) const
+{
+  return m_mpCapable;
+}
+
+bool
+MpTcpSubflow::IsJoin (void) const
+{
+  return m_isJoin;
+}
+
+uint64_t
+MpTcpSubflow::GetLocalKey (void) const
+{
+  return m_localKey;
+}
+
+uint64_t
+MpTcpSubflow::GetRemoteKey (void) const
+{
+  return m_remoteKey;
+}
+
+uint32_t
+MpTcpSubflow::GetJoinToken (void) const
+{
+  return m_joinToken;
+}
+
+bool
+MpTcpSubflow::IsConnected (void) const
+{
+  return m_state == ESTABLISHED || m_state == CLOSE_WAIT;
+}
+
+TcpStates_t
+MpTcpSubflow::GetState (void) const
+{
+  return m_state;
+}
+
+bool
+MpTcpSubflow::PeerClosed (void)
+{
+  return m_rxBuffer.Finished () || m_state == CLOSED;
+}
+
+uint32_t
+MpTcpSubflow::GetCongestionWindow (void) const
+{
+  return m_cWnd;
+}
+
+uint32_t
+MpTcpSubflow::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+Time
+MpTcpSubflow::GetRoundTripTime (void) const
+{
+  return m_rtt != 0 ? m_rtt->GetEstimate () : Seconds (0);
+}
+
+uint32_t
+MpTcpSubflow::GetLossInterval (void) const
+{
+  return std::max (m_bytesSinceLoss, m_lastLossInterval);
+}
+
+uint32_t
+MpTcpSubflow::GetFreeWindow (void)
+{
+  uint32_t window = AvailableWindow ();
+  uint32_t unsent = m_txBuffer.SizeFromSequence (m_nextTxSequence);
+  return window > unsent ? window - unsent : 0;
+}
+
+int
+MpTcpSubflow::SendMapping (Ptr<Packet> p, SequenceNumber32 dataSeq)
+{
+  NS_LOG_FUNCTION (this << p << dataSeq);
+  Mapping mapping;
+  mapping.m_subflowSeq = m_txBuffer.TailSequence ();
+  mapping.m_dataSeq = dataSeq;
+  mapping.m_length = p->GetSize ();
+  m_txMappings.push_back (mapping);
+  int sent = Send (p, 0);
+  if (sent < 0)
+    {
+      m_txMappings.pop_back ();
+    }
+  return sent;
+}
+
+bool
+MpTcpSubflow::PeekMapping (SequenceNumber32 &dataSeq, uint32_t &length)
+{
+  uint32_t available = m_rxBuffer.Available ();
+  if (available == 0)
+    {
+      return false;
+    }
+  if (!m_mpCapable)
+    { // Fallback to regular TCP: the data sequence is the subflow sequence
+      dataSeq = SequenceNumber32 (0) + (m_rxReadSequence - m_rxInitialSequence);
+      length = available;
+      return true;
+    }
+  std::map<SequenceNumber32, Mapping>::const_iterator i = m_rxMappings.upper_bound (m_rxReadSequence);
+  if (i == m_rxMappings.begin ())
+    {
+      return false;
+    }
+  --i;
+  SequenceNumber32 end = i->first + SequenceNumber32 (i->second.m_length);
+  if (m_rxReadSequence >= end)
+    {
+      NS_LOG_WARN ("No mapping for subflow sequence " << m_rxReadSequence);
+      return false;
+    }
+  dataSeq = i->second.m_dataSeq + (m_rxReadSequence - i->first);
+  length = std::min (available, static_cast<uint32_t> (end - m_rxReadSequence));
+  return true;
+}
+
+Ptr<Packet>
+MpTcpSubflow::ExtractMapped (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  Ptr<Packet> p = m_rxBuffer.Extract (size);
+  if (p == 0)
+    {
+      return 0;
+    }
+  m_rxReadSequence += p->GetSize ();
+  // Drop the mappings of the data read
+  while (!m_rxMappings.empty ())
+    {
+      std::map<SequenceNumber32, Mapping>::iterator i = m_rxMappings.begin ();
+      if (i->first + SequenceNumber32 (i->second.m_length) > m_rxReadSequence)
+        {
+          break;
+        }
+      m_rxMappings.erase (i);
+    }
+  return p;
+}
+
+Ptr<TcpSocketBase>
+MpTcpSubflow::Fork (void)
+{
+  return CopyObject<MpTcpSubflow> (this);
+}
+
+void
+MpTcpSubflow::NewAck (SequenceNumber32 const& seq)
+{
+  NS_LOG_FUNCTION (this << seq);
+  if (seq > m_txBuffer.HeadSequence ())
+    {
+      m_bytesSinceLoss += seq - m_txBuffer.HeadSequence ();
+    }
+  while (!m_txMappings.empty ()
+         && m_txMappings.front ().m_subflowSeq + SequenceNumber32 (m_txMappings.front ().m_length) <= seq)
+    {
+      m_txMappings.pop_front ();
+    }
+  TcpNewReno::NewAck (seq);
+}
+
+void
+MpTcpSubflow::DupAck (const TcpHeader& t, uint32_t count)
+{
+  if (count == 3 && !m_inFastRec)
+    {
+      RecordLoss ();
+    }
+  TcpNewReno::DupAck (t, count);
+}
+
+void
+MpTcpSubflow::Retransmit (void)
+{
+  if (m_state != CLOSED && m_state != TIME_WAIT && m_txBuffer.HeadSequence () < m_nextTxSequence)
+    {
+      RecordLoss ();
+    }
+  TcpNewReno::Retransmit ();
+}
+
+void
+MpTcpSubflow::RecordLoss (void)
+{
+  m_lastLossInterval = m_bytesSinceLoss;
+  m_bytesSinceLoss = 0;
+}
+
+void
+MpTcpSubflow::CongestionAvoidance (void)
+{
+  if (!m_mpCapable || m_meta == 0)
+    {
+      TcpNewReno::CongestionAvoidance ();
+      return;
+    }
+  int64_t cWnd = static_cast<int64_t> (m_cWnd.Get ()) + m_meta->GetIncrease (this);
+  m_cWnd = static_cast<uint32_t> (std::max (cWnd, static_cast<int64_t> (m_segmentSize)));
+  NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+}
+
+void
+MpTcpSubflow::GenerateKey (void)
+{
+  // The node id keeps the keys of the nodes apart, the counter those of
+  // the connections of a node
+  static uint32_t counter = 0;
+  m_localKey = (static_cast<uint64_t> (m_node->GetId ()) << 32) | ++counter;
+}
+
+/** The MPTCP option goes first, so that the other options get what is left */
+void
+MpTcpSubflow::AddOptions (TcpHeader& tcpHeader)
+{
+  AddMpTcpOption (tcpHeader);
+  TcpNewReno::AddOptions (tcpHeader);
+}
+
+void
+MpTcpSubflow::AddMpTcpOption (TcpHeader& tcpHeader)
+{
+  TcpOptionMpTcp option;
+  if (tcpHeader.GetFlags () & TcpHeader::SYN)
+    {
+      if (m_isJoin)
+        {
+          option.SetJoin (m_joinToken, 0, 0);
+        }
+      else if (m_mpCapable)
+        {
+          if (m_localKey == 0)
+            { // SYN+ACK of a forked subflow
+              GenerateKey ();
+            }
+          option.SetCapable (m_localKey);
+        }
+      else
+        {
+          return;
+        }
+      tcpHeader.AppendOption (option);
+      return;
+    }
+  if (!m_mpCapable || m_meta == 0)
+    {
+      return;
+    }
+  option.SetDataAck (m_meta->GetDataAck ());
+  // Map the data of the segment, if any; the newest mappings are the likeliest
+  SequenceNumber32 seq = tcpHeader.GetSequenceNumber ();
+  for (std::deque<Mapping>::reverse_iterator i = m_txMappings.rbegin (); i != m_txMappings.rend (); ++i)
+    {
+      if (i->m_subflowSeq <= seq)
+        {
+          if (seq < i->m_subflowSeq + SequenceNumber32 (i->m_length))
+            {
+              option.SetMapping (i->m_dataSeq, i->m_subflowSeq, i->m_length);
+            }
+          break;
+        }
+    }
+  tcpHeader.AppendOption (option);
+}
+
+void
+MpTcpSubflow::ReadOptions (const TcpHeader& tcpHeader)
+{
+  TcpNewReno::ReadOptions (tcpHeader);
+  uint8_t flags = tcpHeader.GetFlags ();
+  TcpOptionMpTcp option;
+  bool hasOption = tcpHeader.GetOption (option);
+  if (flags & TcpHeader::SYN)
+    {
+      if (m_state != LISTEN && m_state != SYN_SENT && m_state != SYN_RCVD)
+        { // Duplicated SYN or SYN+ACK
+          return;
+        }
+      m_rxInitialSequence = tcpHeader.GetSequenceNumber () + SequenceNumber32 (1);
+      m_rxReadSequence = m_rxInitialSequence;
+      if ((flags & TcpHeader::ACK) == 0)
+        { // A new connection request: the peer decides what the subflow is
+          m_isJoin = false;
+          m_mpCapable = false;
+          m_remoteKey = 0;
+          m_joinToken = 0;
+          m_rxMappings.clear ();
+        }
+      else if (!hasOption)
+        { // The peer does not speak MPTCP
+          m_mpCapable = false;
+        }
+      if (hasOption && option.GetSubType () == TcpOptionMpTcp::MP_CAPABLE)
+        {
+          m_mpCapable = true;
+          m_remoteKey = option.GetKey ();
+        }
+      else if (hasOption && option.GetSubType () == TcpOptionMpTcp::MP_JOIN)
+        {
+          m_mpCapable = true;
+          m_isJoin = true;
+          m_joinToken = option.GetToken ();
+        }
+      return;
+    }
+  if (!hasOption || !m_mpCapable || option.GetSubType () != TcpOptionMpTcp::DSS)
+    {
+      return;
+    }
+  if (option.HasMapping () && option.GetSubflowSequence () >= m_rxReadSequence)
+    {
+      Mapping mapping;
+      mapping.m_subflowSeq = option.GetSubflowSequence ();
+      mapping.m_dataSeq = option.GetDataSequence ();
+      mapping.m_length = option.GetDataLength ();
+      m_rxMappings[mapping.m_subflowSeq] = mapping;
+    }
+  if (option.HasDataAck () && m_meta != 0)
+    {
+      m_meta->ReceivedDataAck (option.GetDataAck ());
+    }
+}
+
+uint32_t
+MpTcpSubflow::SegmentSizeAt (SequenceNumber32 seq)
+{
+  for (std::deque<Mapping>::reverse_iterator i = m_txMappings.rbegin (); i != m_txMappings.rend (); ++i)
+    {
+      if (i->m_subflowSeq <= seq)
+        {
+          SequenceNumber32 end = i->m_subflowSeq + SequenceNumber32 (i->m_length);
+          if (seq < end)
+            {
+              return std::min (m_segmentSize, static_cast<uint32_t> (end - seq));
+            }
+          break;
+        }
+    }
+  return m_segmentSize;
+}
+
+bool
+MpTcpSubflow::SharedOptions (void) const
+{
+  return false;
+}
+
+} // namespace ns3
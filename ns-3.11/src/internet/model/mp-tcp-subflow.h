@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MP_TCP_SUBFLOW_H
+#define MP_TCP_SUBFLOW_H
+
+#include <deque>
+#include <map>
+#include "tcp-newreno.h"
+
+namespace ns3 {
+
+class MpTcpSocketBase;
+
+/**
+ * \ingroup tcp
+ * \brief One subflow of a Multipath TCP connection
+ *
+ * A subflow is a NewReno connection whose segments carry the MPTCP
+ * options: MP_CAPABLE or MP_JOIN in the handshake, then a DSS option
+ * with the data acknowledgement of the connection and the mapping of
+ * the segment onto the data sequence space. The subflow is driven by
+ * its MpTcpSocketBase, which pushes mapped data into it and pulls the
+ * mapped data it received; its congestion avoidance increase is the
+ * one computed by the coupled congestion control of the connection.
+ */
+class MpTcpSubflow : public TcpNewReno
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MpTcpSubflow (void);
+  MpTcpSubflow (const MpTcpSubflow& sock);
+  virtual ~MpTcpSubflow (void);
+
+  void SetMeta (Ptr<MpTcpSocketBase> meta);
+  void SetCapable (void);                // Send MP_CAPABLE in the SYN
+  void SetJoin (uint32_t token);         // Send MP_JOIN in the SYN
+
+  bool IsMpCapable (void) const;         // MPTCP negotiated
+  bool IsJoin (void) const;              // Opened by an MP_JOIN
+  uint64_t GetLocalKey (void) const;
+  uint64_t GetRemoteKey (void) const;
+  uint32_t GetJoinToken (void) const;
+
+  bool IsConnected (void) const;
+  TcpStates_t GetState (void) const;
+  bool PeerClosed (void);                // All the data of the peer is received
+  uint32_t GetCongestionWindow (void) const;
+  uint32_t GetSegmentSize (void) const;
+  Time GetRoundTripTime (void) const;
+  uint32_t GetLossInterval (void) const;
+  uint32_t GetFreeWindow (void);         // Bytes the subflow could send at once
+
+  /**
+   * \param p the data to send
+   * \param dataSeq the data sequence number of its first byte
+   * \returns the number of bytes queued, or -1 on error
+   */
+  int SendMapping (Ptr<Packet> p, SequenceNumber32 dataSeq);
+  /**
+   * \param dataSeq the data sequence number of the next byte to read
+   * \param length the number of bytes readable under the same mapping
+   * \returns true if there is mapped data to read
+   */
+  bool PeekMapping (SequenceNumber32 &dataSeq, uint32_t &length);
+  /**
+   * \param size the number of bytes to read
+   * \returns the data read
+   */
+  Ptr<Packet> ExtractMapped (uint32_t size);
+
+protected:
+  virtual Ptr<TcpSocketBase> Fork (void); // Call CopyObject<MpTcpSubflow> to clone me
+  virtual void NewAck (SequenceNumber32 const& seq); // Prune the acknowledged mappings
+  virtual void DupAck (const TcpHeader& t, uint32_t count); // Record a loss
+  virtual void Retransmit (void); // Record a loss
+  virtual void CongestionAvoidance (void); // Coupled increase
+  virtual void AddOptions (TcpHeader& tcpHeader);
+  virtual void ReadOptions (const TcpHeader& tcpHeader);
+  virtual uint32_t SegmentSizeAt (SequenceNumber32 seq);
+  virtual bool SharedOptions (void) const; // No: each segment carries its own mapping
+  virtual void DoDispose (void);
+
+private:
+  struct Mapping
+  {
+    SequenceNumber32 m_subflowSeq;
+    SequenceNumber32 m_dataSeq;
+    uint32_t m_length;
+  };
+
+  void RecordLoss (void);
+  void GenerateKey (void);
+  void AddMpTcpOption (TcpHeader& tcpHeader);
+
+  Ptr<MpTcpSocketBase> m_meta;
+  bool m_mpCapable;                 //< MP_CAPABLE sent or received
+  bool m_isJoin;                    //< MP_JOIN sent or received
+  uint64_t m_localKey;
+  uint64_t m_remoteKey;
+  uint32_t m_joinToken;
+  std::deque<Mapping> m_txMappings; //< Mappings of the unacknowledged data
+  std::map<SequenceNumber32, Mapping> m_rxMappings; //< Mappings of the unread data, by subflow sequence
+  SequenceNumber32 m_rxReadSequence; //< Subflow sequence of the next byte to read
+  SequenceNumber32 m_rxInitialSequence; //< Subflow sequence of the first data byte
+  uint32_t m_bytesSinceLoss;
+  uint32_t m_lastLossInterval;
+};
+
+} // namespace ns3
+
+#endif /* MP_TCP_SUBFLOW_H */
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#define NS_LOG_APPEND_CONTEXT \
+  if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
+
+#include "tcp-dctcp.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+
+NS_LOG_COMPONENT_DEFINE ("TcpDctcp");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (TcpDctcp);
+
+TypeId
+TcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpDctcp")
+    .SetParent<TcpNewReno> ()
+    .AddConstructor<TcpDctcp> ()
+    .AddAttribute ("G",
+                   "Weight of the fraction of bytes marked in the last window, "
+                   "in the moving average alpha",
+                   DoubleValue (1.0 / 16),
+                   MakeDoubleAccessor (&TcpDctcp::m_g),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("AlphaOnInit",
+                   "Value of alpha when the connection starts",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&TcpDctcp::m_alphaOnInit),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddTraceSource ("Alpha",
+                     "Estimated fraction of the bytes marked by the network",
+                     MakeTraceSourceAccessor (&TcpDctcp::m_alpha))
+  ;
+  return tid;
+}
+
+TcpDctcp::TcpDctcp (void)
+  : m_ackedBytes (0),
+    m_markedBytes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::TcpDctcp (const TcpDctcp& sock)
+  : TcpNewReno (sock),
+    m_g (sock.m_g),
+    m_alphaOnInit (sock.m_alphaOnInit),
+    m_alpha (sock.m_alpha),
+    m_ackedBytes (0),
+    m_markedBytes (0),
+    m_alphaWindowEnd (sock.m_alphaWindowEnd)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_LOGIC ("Invoked the copy constructor");
+}
+
+TcpDctcp::~TcpDctcp (void)
+{
+}
+
+/** We initialize alpha from this function, after attributes initialized */
+int
+TcpDctcp::Listen (void)
+{
+  NS_LOG_FUNCTION (this);
+  InitializeDctcp ();
+  return TcpNewReno::Listen ();
+}
+
+/** We initialize alpha from this function, after attributes initialized */
+int
+TcpDctcp::Connect (const Address & address)
+{
+  NS_LOG_FUNCTION (this << address);
+  InitializeDctcp ();
+  return TcpNewReno::Connect (address);
+}
+
+Ptr<TcpSocketBase>
+TcpDctcp::Fork (void)
+{
+  return CopyObject<TcpDctcp> (this);
+}
+
+/** Echo the CE codepoint of every segment (RFC 8257 sec.3.2). If it changed,
+    acknowledge at once the segments whose ACK was delayed, with the
+    previous ECE state, before the new segment is processed. */
+void
+TcpDctcp::ReceivedEcn (const TcpHeader& t, bool ce)
+{
+  if (ce != m_ecnEcho && m_delAckCount > 0)
+    {
+      NS_LOG_LOGIC (this << " CE state changed, send the delayed ACK now");
+      SendEmptyPacket (TcpHeader::ACK);
+    }
+  m_ecnEcho = ce;
+}
+
+/** Count the bytes acknowledged with and without ECE, update alpha once per
+    window of data, and reduce cwnd in proportion to alpha at most once per
+    window (RFC 8257 sec.3.3) */
+void
+TcpDctcp::ReceivedEcnEcho (const TcpHeader& t)
+{
+  bool ece = t.GetFlags () & TcpHeader::ECE;
+  SequenceNumber32 ack = t.GetAckNumber ();
+  if (ack > m_txBuffer.HeadSequence ())
+    {
+      uint32_t acked = ack - m_txBuffer.HeadSequence ();
+      m_ackedBytes += acked;
+      if (ece)
+        {
+          m_markedBytes += acked;
+        }
+    }
+  if (ack > m_alphaWindowEnd)
+    {
+      if (m_ackedBytes > 0)
+        {
+          double fraction = static_cast<double> (m_markedBytes) / m_ackedBytes;
+          m_alpha = (1 - m_g) * m_alpha.Get () + m_g * fraction;
+          NS_LOG_LOGIC (this << " fraction marked " << fraction << ", alpha " << m_alpha);
+        }
+      m_ackedBytes = 0;
+      m_markedBytes = 0;
+      m_alphaWindowEnd = m_nextTxSequence;
+    }
+
+  if (!ece || m_inFastRec || ack <= m_ecnRecover)
+    {
+      return;
+    }
+  uint32_t cwnd = static_cast<uint32_t> (m_cWnd.Get () * (1 - m_alpha.Get () / 2));
+  m_ssThresh = std::max (2 * m_segmentSize, cwnd);
+  m_cWnd = m_ssThresh;
+  m_ecnRecover = m_highTxMark;
+  m_ecnCwr = true;
+  NS_LOG_INFO ("ECN-Echo with alpha " << m_alpha << ". Reset cwnd to " << m_cWnd);
+}
+
+void
+TcpDctcp::InitializeDctcp (void)
+{
+  m_ecnEnabled = true;
+  m_alpha = m_alphaOnInit;
+}
+
+} // namespace ns3
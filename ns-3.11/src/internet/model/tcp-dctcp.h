@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_DCTCP_H
+#define TCP_DCTCP_H
+
+#include "tcp-newreno.h"
+#include "ns3/traced-value.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup socket
+ * \ingroup tcp
+ *
+ * \brief An implementation of Data Center TCP (RFC 8257)
+ *
+ * The receiver echoes the Congestion Experienced mark of every segment
+ * rather than latching ECE until CWR: when the mark changes while an
+ * ACK is delayed, the segments received so far are acknowledged at once
+ * with the previous state. The sender estimates the fraction alpha of
+ * its bytes which were marked, as a moving average over windows of data
+ * with weight G, and reduces cwnd by alpha/2 once per window in which
+ * marks were echoed. Losses are handled as in TcpNewReno.
+ *
+ * ECN is always offered to the peer, whatever the Ecn attribute says.
+ * The queues of the network should mark packets as soon as their
+ * instantaneous length exceeds a threshold, e.g. an Ipv4RedQueue with
+ * MinTh equal to MaxTh and QW set to 1.
+ */
+class TcpDctcp : public TcpNewReno
+{
+public:
+  static TypeId GetTypeId (void);
+  /**
+   * Create an unbound tcp socket.
+   */
+  TcpDctcp (void);
+  TcpDctcp (const TcpDctcp& sock);
+  virtual ~TcpDctcp (void);
+
+  // From TcpSocketBase
+  virtual int Connect (const Address &address);
+  virtual int Listen (void);
+
+protected:
+  virtual Ptr<TcpSocketBase> Fork (void); // Call CopyObject<TcpDctcp> to clone me
+  virtual void ReceivedEcn (const TcpHeader& t, bool ce); // Echo the CE mark of every segment
+  virtual void ReceivedEcnEcho (const TcpHeader& t); // Update alpha, cut cwnd by alpha/2 upon ECE
+
+private:
+  void InitializeDctcp (void);          // Enable ECN and set alpha when connection starts
+
+  double                 m_g;            //< Weight of the last window in alpha
+  double                 m_alphaOnInit;  //< Initial value of alpha
+  TracedValue<double>    m_alpha;        //< Estimated fraction of the bytes marked
+  uint32_t               m_ackedBytes;   //< Bytes acknowledged in the current window
+  uint32_t               m_markedBytes;  //< Bytes acknowledged with ECE in the current window
+  SequenceNumber32       m_alphaWindowEnd; //< End of the window over which alpha is updated
+};
+
+} // namespace ns3
+
+#endif /* TCP_DCTCP_H */
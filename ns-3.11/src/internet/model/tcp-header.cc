@@ -20,9 +20,10 @@
 
 #include <stdint.h>
 #include <iostream>
+#include <algorithm>
 #include "tcp-header.h"
 #include "ns3/buffer.h"
-#include "ns3/address-utils.h"
+#include "ns3/checksum.h"
 
 namespace ns3 {
 
@@ -38,7 +39,8 @@ TcpHeader::TcpHeader ()
     m_windowSize (0xffff),
     m_urgentPointer (0),
     m_calcChecksum (false),
-    m_goodChecksum (true)
+    m_goodChecksum (true),
+    m_optionsLength (0)
 {
 }
 
@@ -118,6 +120,74 @@ uint16_t TcpHeader::GetUrgentPointer () const
   return m_urgentPointer;
 }
 
+bool
+TcpHeader::AppendOption (const TcpOption &option)
+{
+  uint32_t size = option.GetSerializedSize ();
+  if (m_optionsLength + size > MAX_OPTIONS_LENGTH)
+    {
+      return false;
+    }
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  option.Serialize (buffer.Begin ());
+  buffer.CopyData (m_options + m_optionsLength, size);
+  m_optionsLength += size;
+  m_length = 5 + (m_optionsLength + 3) / 4;
+  return true;
+}
+
+int32_t
+TcpHeader::FindOption (uint8_t kind) const
+{
+  uint32_t i = 0;
+  while (i < m_optionsLength)
+    {
+      uint8_t current = m_options[i];
+      if (current == TcpOption::END)
+        {
+          break;
+        }
+      if (current == TcpOption::NOP)
+        {
+          i++;
+          continue;
+        }
+      if (i + 1 >= m_optionsLength || m_options[i + 1] < 2)
+        {
+          break; // malformed
+        }
+      if (current == kind)
+        {
+          return i;
+        }
+      i += m_options[i + 1];
+    }
+  return -1;
+}
+
+bool
+TcpHeader::GetOption (TcpOption &option) const
+{
+  int32_t offset = FindOption (option.GetKind ());
+  if (offset < 0)
+    {
+      return false;
+    }
+  uint32_t size = std::min<uint32_t> (m_options[offset + 1], m_optionsLength - offset);
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  buffer.Begin ().Write (m_options + offset, size);
+  option.Deserialize (buffer.Begin ());
+  return true;
+}
+
+bool
+TcpHeader::HasOption (uint8_t kind) const
+{
+  return FindOption (kind) >= 0;
+}
+
 void 
 TcpHeader::InitializeChecksum (Ipv4Address source, 
                                Ipv4Address destination,
@@ -131,20 +201,17 @@ TcpHeader::InitializeChecksum (Ipv4Address source,
 uint16_t
 TcpHeader::CalculateHeaderChecksum (uint16_t size) const
 {
-  Buffer buf = Buffer (12);
-  buf.AddAtStart (12);
-  Buffer::Iterator it = buf.Begin ();
+  uint8_t buf[12];
 
-  WriteTo (it, m_source);
-  WriteTo (it, m_destination);
-  it.WriteU8 (0); /* protocol */
-  it.WriteU8 (m_protocol); /* protocol */
-  it.WriteU8 (size >> 8); /* length */
-  it.WriteU8 (size & 0xff); /* length */
+  m_source.Serialize (buf);
+  m_destination.Serialize (buf + 4);
+  buf[8] = 0; /* protocol */
+  buf[9] = m_protocol; /* protocol */
+  buf[10] = size >> 8; /* length */
+  buf[11] = size & 0xff; /* length */
 
-  it = buf.Begin ();
   /* we don't CompleteChecksum ( ~ ) now */
-  return ~(it.CalculateIpChecksum (12));
+  return OnesComplementSum (buf, 12);
 }
 
 bool
@@ -197,6 +264,14 @@ void TcpHeader::Print (std::ostream &os)  const
         {
           os<<" URG ";
         }
+      if((m_flags & ECE) != 0)
+        {
+          os<<" ECE ";
+        }
+      if((m_flags & CWR) != 0)
+        {
+          os<<" CWR ";
+        }
       os<<"]";
     }
   os<<" Seq="<<m_sequenceNumber<<" Ack="<<m_ackNumber<<" Win="<<m_windowSize;
@@ -216,6 +291,14 @@ void TcpHeader::Serialize (Buffer::Iterator start)  const
   i.WriteHtonU16 (m_windowSize);
   i.WriteHtonU16 (0);
   i.WriteHtonU16 (m_urgentPointer);
+  if (m_optionsLength > 0)
+    {
+      i.Write (m_options, m_optionsLength);
+      for (uint32_t padding = m_optionsLength; padding < 4 * m_length - 20u; ++padding)
+        {
+          i.WriteU8 (TcpOption::END);
+        }
+    }
 
   if(m_calcChecksum)
     {
@@ -236,11 +319,32 @@ uint32_t TcpHeader::Deserialize (Buffer::Iterator start)
   m_sequenceNumber = i.ReadNtohU32 ();
   m_ackNumber = i.ReadNtohU32 ();
   uint16_t field = i.ReadNtohU16 ();
-  m_flags = field & 0x3F;
+  m_flags = field & 0xFF;
   m_length = field>>12;
   m_windowSize = i.ReadNtohU16 ();
   i.Next (2);
   m_urgentPointer = i.ReadNtohU16 ();
+  m_optionsLength = 0;
+  if (m_length > 5)
+    {
+      uint32_t size = std::min<uint32_t> (4 * m_length - 20, MAX_OPTIONS_LENGTH);
+      i.Read (m_options, size);
+      // Drop the padding, so that options can still be appended
+      while (m_optionsLength < size && m_options[m_optionsLength] != TcpOption::END)
+        {
+          if (m_options[m_optionsLength] == TcpOption::NOP)
+            {
+              m_optionsLength++;
+              continue;
+            }
+          if (m_optionsLength + 1u >= size || m_options[m_optionsLength + 1] < 2
+              || m_optionsLength + m_options[m_optionsLength + 1] > size)
+            {
+              break; // malformed
+            }
+          m_optionsLength += m_options[m_optionsLength + 1];
+        }
+    }
 
   if(m_calcChecksum)
     {
@@ -27,6 +27,7 @@
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/sequence-number.h"
+#include "tcp-option.h"
 
 namespace ns3 {
 
@@ -118,6 +119,28 @@ public:
    */
   uint16_t GetUrgentPointer () const;
 
+  /**
+   * \param option the option to append
+   * \returns false if the option does not fit in the header
+   *
+   * Append an option to the options of this header, and update the
+   * length of the header accordingly.
+   */
+  bool AppendOption (const TcpOption &option);
+  /**
+   * \param option the option to fill
+   * \returns true if this header carries an option of the kind of option
+   *
+   * Deserialize the first option of the kind of option carried by this
+   * header into option.
+   */
+  bool GetOption (TcpOption &option) const;
+  /**
+   * \param kind an option kind
+   * \returns true if this header carries an option of this kind
+   */
+  bool HasOption (uint8_t kind) const;
+
   /**
    * \param source the ip source to use in the underlying
    *        ip packet.
@@ -134,7 +157,7 @@ public:
                            uint8_t protocol);
 
   typedef enum { NONE = 0, FIN = 1, SYN = 2, RST = 4, PSH = 8, ACK = 16, 
-                 URG = 32} Flags_t;
+                 URG = 32, ECE = 64, CWR = 128} Flags_t;
 
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
@@ -151,6 +174,10 @@ public:
 
 private:
   uint16_t CalculateHeaderChecksum (uint16_t size) const;
+  int32_t FindOption (uint8_t kind) const;
+
+  static const uint8_t MAX_OPTIONS_LENGTH = 40;
+
   uint16_t m_sourcePort;
   uint16_t m_destinationPort;
   SequenceNumber32 m_sequenceNumber;
@@ -167,6 +194,10 @@ private:
   uint16_t m_initialChecksum;
   bool m_calcChecksum;
   bool m_goodChecksum;
+
+  // options, as serialized, without the padding
+  uint8_t m_optionsLength;
+  uint8_t m_options[MAX_OPTIONS_LENGTH];
 };
 
 }; // namespace ns3
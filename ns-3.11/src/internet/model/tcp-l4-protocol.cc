@@ -34,10 +34,14 @@
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-l3-protocol.h"
+#include "ipv4-flow-ports-tag.h"
+#include "ipv4-global-routing.h"
 #include "tcp-socket-factory-impl.h"
+#include "mp-tcp-socket-factory-impl.h"
 #include "tcp-newreno.h"
 #include "rtt-estimator.h"
 
+#include <limits>
 #include <vector>
 #include <sstream>
 #include <iomanip>
@@ -120,6 +124,9 @@ TcpL4Protocol::NotifyNewAggregate ()
               Ptr<TcpSocketFactoryImpl> tcpFactory = CreateObject<TcpSocketFactoryImpl> ();
               tcpFactory->SetTcp (this);
               node->AggregateObject (tcpFactory);
+              Ptr<MpTcpSocketFactoryImpl> mpTcpFactory = CreateObject<MpTcpSocketFactoryImpl> ();
+              mpTcpFactory->SetTcp (this);
+              node->AggregateObject (mpTcpFactory);
               this->SetDownTarget (MakeCallback (&Ipv4::Send, ipv4));
             }
         }
@@ -167,10 +174,27 @@ TcpL4Protocol::CreateSocket (TypeId socketTypeId)
   socket->SetNode (m_node);
   socket->SetTcp (this);
   socket->SetRtt (rtt);
+  socket->m_socketIndex = m_sockets.size ();
   m_sockets.push_back (socket);
   return socket;
 }
 
+void
+TcpL4Protocol::RemoveSocket (Ptr<TcpSocketBase> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  // Sockets forked by a listening socket are not in the list
+  uint32_t index = socket->m_socketIndex;
+  if (index >= m_sockets.size () || m_sockets[index] != socket)
+    {
+      return;
+    }
+  m_sockets[index] = m_sockets.back ();
+  m_sockets[index]->m_socketIndex = index;
+  m_sockets.pop_back ();
+  socket->m_socketIndex = std::numeric_limits<uint32_t>::max ();
+}
+
 Ptr<Socket>
 TcpL4Protocol::CreateSocket (void)
 {
@@ -250,10 +274,10 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
     }
 
   NS_LOG_LOGIC ("TcpL4Protocol "<<this<<" received a packet");
-  Ipv4EndPointDemux::EndPoints endPoints =
-    m_endPoints->Lookup (ipHeader.GetDestination (), tcpHeader.GetDestinationPort (),
-                         ipHeader.GetSource (), tcpHeader.GetSourcePort (),incomingInterface);
-  if (endPoints.empty ())
+  Ipv4EndPoint *endPoint =
+    m_endPoints->LookupBest (ipHeader.GetDestination (), tcpHeader.GetDestinationPort (),
+                             ipHeader.GetSource (), tcpHeader.GetSourcePort (), incomingInterface);
+  if (endPoint == 0)
     {
       NS_LOG_LOGIC ("  No endpoints matched on TcpL4Protocol "<<this);
       std::ostringstream oss;
@@ -291,10 +315,9 @@ TcpL4Protocol::Receive (Ptr<Packet> packet,
           return Ipv4L4Protocol::RX_ENDPOINT_CLOSED;
         }
     }
-  NS_ASSERT_MSG (endPoints.size () == 1, "Demux returned more than one endpoint");
   NS_LOG_LOGIC ("TcpL4Protocol "<<this<<" forwarding up to endpoint/socket");
-  (*endPoints.begin ())->ForwardUp (packet, ipHeader, tcpHeader.GetSourcePort (), 
-                                    incomingInterface);
+  endPoint->ForwardUp (packet, ipHeader, tcpHeader.GetSourcePort (), 
+                       incomingInterface);
   return Ipv4L4Protocol::RX_OK;
 }
 
@@ -331,7 +354,17 @@ TcpL4Protocol::Send (Ptr<Packet> packet,
       Ptr<NetDevice> oif (0); //specify non-zero if bound to a source address
       if (ipv4->GetRoutingProtocol () != 0)
         {
-          route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+          if (Ipv4GlobalRouting::IsFlowHashEnabled ())
+            {
+              Ipv4FlowPortsTag portsTag (sport, dport);
+              packet->AddPacketTag (portsTag);
+              route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+              packet->RemovePacketTag (portsTag);
+            }
+          else
+            {
+              route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+            }
         }
       else
         {
@@ -355,7 +388,6 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
   // XXX outgoingHeader cannot be logged
 
   TcpHeader outgoingHeader = outgoing;
-  outgoingHeader.SetLength (5); //header length in units of 32bit words
   /* outgoingHeader.SetUrgentPointer (0); //XXX */
   if(Node::ChecksumEnabled ())
     {
@@ -376,7 +408,17 @@ TcpL4Protocol::SendPacket (Ptr<Packet> packet, const TcpHeader &outgoing,
       Ptr<Ipv4Route> route;
       if (ipv4->GetRoutingProtocol () != 0)
         {
-          route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+          if (Ipv4GlobalRouting::IsFlowHashEnabled ())
+            {
+              Ipv4FlowPortsTag portsTag (outgoing.GetSourcePort (), outgoing.GetDestinationPort ());
+              packet->AddPacketTag (portsTag);
+              route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+              packet->RemovePacketTag (portsTag);
+            }
+          else
+            {
+              route = ipv4->GetRoutingProtocol ()->RouteOutput (packet, header, oif, errno_);
+            }
         }
       else
         {
@@ -123,6 +123,13 @@ private:
   friend class TcpSocketBase;
   void SendPacket (Ptr<Packet>, const TcpHeader &,
                    Ipv4Address, Ipv4Address, Ptr<NetDevice> oif = 0);
+  /**
+   * \brief Remove a socket from the list of sockets, once it is closed
+   *
+   * The last socket of the list takes the place of the removed one, so
+   * that the removal takes a constant time.
+   */
+  void RemoveSocket (Ptr<TcpSocketBase> socket);
   TcpL4Protocol (const TcpL4Protocol &o);
   TcpL4Protocol &operator = (const TcpL4Protocol &o);
 
@@ -34,6 +34,10 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (TcpNewReno);
 
+// Number of duplicate ACKs, or of segments SACKed above a hole, after
+// which a segment is deemed lost (DupThresh of RFC 6675)
+static const uint32_t DUP_THRESH = 3;
+
 TypeId
 TcpNewReno::GetTypeId (void)
 {
@@ -57,7 +61,9 @@ TcpNewReno::TcpNewReno (const TcpNewReno& sock)
     m_cWnd (sock.m_cWnd),
     m_ssThresh (sock.m_ssThresh),
     m_initialCWnd (sock.m_initialCWnd),
-    m_inFastRec (false)
+    m_inFastRec (false),
+    m_sackHighRxt (sock.m_sackHighRxt),
+    m_ecnRecover (sock.m_ecnRecover)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -93,6 +99,29 @@ TcpNewReno::Window (void)
   return std::min (m_rWnd.Get (), m_cWnd.Get ());
 }
 
+/** In SACK recovery, the congestion window limits the pipe rather than the
+    unacknowledged data, and holes are repaired before new data is sent */
+uint32_t
+TcpNewReno::AvailableWindow (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_inFastRec || !m_sackPermitted)
+    {
+      return TcpSocketBase::AvailableWindow ();
+    }
+  SequenceNumber32 hole;
+  uint32_t length;
+  if (NextSackHole (m_sackHighRxt, hole, length) && IsLost (hole))
+    {
+      return 0;
+    }
+  uint32_t pipe = Pipe ();
+  uint32_t unack = UnAckDataCount ();
+  uint32_t cwndLeft = (m_cWnd.Get () > pipe) ? m_cWnd.Get () - pipe : 0;
+  uint32_t rwndLeft = (m_rWnd.Get () > unack) ? m_rWnd.Get () - unack : 0;
+  return std::min (cwndLeft, rwndLeft);
+}
+
 Ptr<TcpSocketBase>
 TcpNewReno::Fork (void)
 {
@@ -109,7 +138,13 @@ TcpNewReno::NewAck (const SequenceNumber32& seq)
                 " ssthresh " << m_ssThresh);
 
   // Check for exit condition of fast recovery
-  if (m_inFastRec && seq < m_recover)
+  if (m_inFastRec && seq < m_recover && m_sackPermitted)
+    { // Partial ACK in SACK recovery: the scoreboard tells what to send next
+      TcpSocketBase::NewAck (seq);
+      SackRecovery ();
+      return;
+    }
+  else if (m_inFastRec && seq < m_recover)
     { // Partial ACK, partial window deflation (RFC2582 sec.3 bullet #5 paragraph 3)
       m_cWnd += m_segmentSize;  // increase cwnd
       NS_LOG_INFO ("Partial ACK in fast recovery: cwnd set to " << m_cWnd);
@@ -131,23 +166,47 @@ TcpNewReno::NewAck (const SequenceNumber32& seq)
       NS_LOG_INFO ("In SlowStart, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
     }
   else
-    { // Congestion avoidance mode, increase by (segSize*segSize)/cwnd. (RFC2581, sec.3.1)
-      // To increase cwnd for one segSize per RTT, it should be (ackBytes*segSize)/cwnd
-      double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_cWnd.Get ();
-      adder = std::max (1.0, adder);
-      m_cWnd += static_cast<uint32_t> (adder);
-      NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+    {
+      CongestionAvoidance ();
     }
 
   // Complete newAck processing
   TcpSocketBase::NewAck (seq);
 }
 
+/** Congestion avoidance mode, increase by (segSize*segSize)/cwnd. (RFC2581, sec.3.1) */
+void
+TcpNewReno::CongestionAvoidance (void)
+{
+  // To increase cwnd for one segSize per RTT, it should be (ackBytes*segSize)/cwnd
+  double adder = static_cast<double> (m_segmentSize * m_segmentSize) / m_cWnd.Get ();
+  adder = std::max (1.0, adder);
+  m_cWnd += static_cast<uint32_t> (adder);
+  NS_LOG_INFO ("In CongAvoid, updated to cwnd " << m_cWnd << " ssthresh " << m_ssThresh);
+}
+
 /** Cut cwnd and enter fast recovery mode upon triple dupack */
 void
 TcpNewReno::DupAck (const TcpHeader& t, uint32_t count)
 {
-  if (count == 3 && !m_inFastRec)
+  if (count == DUP_THRESH && !m_inFastRec && m_sackPermitted)
+    { // Enter SACK recovery (RFC 6675 sec.5): retransmit the first segment
+      // unconditionally, then let the pipe go down to the halved window
+      m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+      m_cWnd = m_ssThresh;
+      m_recover = m_highTxMark;
+      m_inFastRec = true;
+      NS_LOG_INFO ("Triple dupack. Enter SACK recovery mode. Reset cwnd to " << m_cWnd <<
+                   ", ssthresh to " << m_ssThresh << " at fast recovery seqnum " << m_recover);
+      SequenceNumber32 head = m_txBuffer.HeadSequence ();
+      m_sackHighRxt = head + SequenceNumber32 (SendDataPacket (head, SegmentSizeAt (head), m_connected));
+      SackRecovery ();
+    }
+  else if (m_inFastRec && m_sackPermitted)
+    { // No window inflation: the SACK blocks of the dupack shrank the pipe
+      SackRecovery ();
+    }
+  else if (count == DUP_THRESH && !m_inFastRec)
     { // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
       m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
       m_cWnd = m_ssThresh + 3 * m_segmentSize;
@@ -165,6 +224,22 @@ TcpNewReno::DupAck (const TcpHeader& t, uint32_t count)
     };
 }
 
+/** ECN-Echo received: respond as to a loss, but at most once per window of
+    data and not while recovering from a loss (RFC 3168 sec.6.1.2) */
+void
+TcpNewReno::ReceivedEcnEcho (const TcpHeader& t)
+{
+  if (!(t.GetFlags () & TcpHeader::ECE) || m_inFastRec || t.GetAckNumber () <= m_ecnRecover)
+    {
+      return;
+    }
+  m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+  m_cWnd = m_ssThresh;
+  m_ecnRecover = m_highTxMark;
+  m_ecnCwr = true;
+  NS_LOG_INFO ("ECN-Echo. Reset cwnd to " << m_cWnd << ", ssthresh to " << m_ssThresh);
+}
+
 /** Retransmit timeout */
 void
 TcpNewReno::Retransmit (void)
@@ -190,6 +265,81 @@ TcpNewReno::Retransmit (void)
   DoRetransmit ();                          // Retransmit the packet
 }
 
+/** A hole is deemed lost once DupThresh segments were SACKed above it
+    (RFC 6675 sec.4 IsLost), so that a segment which is merely reordered is
+    not resent. A SACKed range counts as the segments of at most SMSS bytes
+    it holds, which also covers the rule of (DupThresh - 1) * SMSS bytes. */
+bool
+TcpNewReno::IsLost (SequenceNumber32 seq) const
+{
+  uint32_t segments = 0;
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_reverse_iterator i = m_sackBoard.rbegin ();
+       i != m_sackBoard.rend () && i->first > seq; ++i)
+    {
+      uint32_t length = i->second - i->first;
+      segments += (length + m_segmentSize - 1) / m_segmentSize;
+      if (segments >= DUP_THRESH)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/** Bytes sent and neither acknowledged, SACKed nor deemed lost, plus the
+    bytes retransmitted below HighRxt (RFC 6675 sec.4 SetPipe) */
+uint32_t
+TcpNewReno::Pipe (void)
+{
+  uint32_t pipe = 0;
+  SequenceNumber32 seq = m_txBuffer.HeadSequence ();
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sackBoard.begin ();
+  while (seq < m_highTxMark.Get ())
+    {
+      SequenceNumber32 end = (i == m_sackBoard.end ()) ? m_highTxMark.Get () : i->first;
+      if (seq < end)
+        { // A hole, or the data sent above the last SACKed range
+          if (!IsLost (seq))
+            {
+              pipe += end - seq;
+            }
+          if (seq < m_sackHighRxt)
+            {
+              pipe += std::min (end, m_sackHighRxt) - seq;
+            }
+        }
+      if (i == m_sackBoard.end ())
+        {
+          break;
+        }
+      seq = std::max (seq, i->second);
+      ++i;
+    }
+  return pipe;
+}
+
+/** Retransmit the lost holes of the scoreboard in sequence order while the
+    pipe is below cwnd, then send new data (RFC 6675 sec.5 NextSeg rules 1
+    and 2); a hole which is not deemed lost is left to the receiver */
+void
+TcpNewReno::SackRecovery (void)
+{
+  NS_LOG_FUNCTION (this);
+  SequenceNumber32 hole;
+  uint32_t length;
+  while (NextSackHole (m_sackHighRxt, hole, length) && IsLost (hole))
+    {
+      uint32_t size = std::min (length, SegmentSizeAt (hole));
+      if (m_cWnd.Get () < Pipe () + size)
+        {
+          return;
+        }
+      NS_LOG_LOGIC ("SACK recovery retransmits " << hole << "+" << size);
+      m_sackHighRxt = hole + SequenceNumber32 (SendDataPacket (hole, size, m_connected));
+    }
+  SendPendingData (m_connected);
+}
+
 void
 TcpNewReno::SetSegSize (uint32_t size)
 {
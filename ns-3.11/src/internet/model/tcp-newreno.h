@@ -32,6 +32,12 @@ namespace ns3 {
  * \brief An implementation of a stream socket using TCP.
  *
  * This class contains the NewReno implementation of TCP, as of RFC2582.
+ * When SACK is agreed on with the peer, fast recovery follows the
+ * scoreboard instead (RFC 6675): the window is not inflated, the holes
+ * below the SACKed data are retransmitted first, and new data is sent
+ * only once no hole is left, as far as the congestion window allows.
+ * When ECN is agreed on, an ECN-Echo halves the window as a loss would,
+ * at most once per window of data, without retransmitting anything.
  */
 class TcpNewReno : public TcpSocketBase
 {
@@ -50,10 +56,13 @@ public:
 
 protected:
   virtual uint32_t Window (void); // Return the max possible number of unacked bytes
+  virtual uint32_t AvailableWindow (void); // Window left for new data, from the pipe in SACK recovery
   virtual Ptr<TcpSocketBase> Fork (void); // Call CopyObject<TcpNewReno> to clone me
   virtual void NewAck (SequenceNumber32 const& seq); // Inc cwnd and call NewAck() of parent
   virtual void DupAck (const TcpHeader& t, uint32_t count);  // Halving cwnd and reset nextTxSequence
   virtual void Retransmit (void); // Exit fast recovery upon retransmit timeout
+  virtual void CongestionAvoidance (void); // Inc cwnd in congestion avoidance, per new ACK
+  virtual void ReceivedEcnEcho (const TcpHeader& t); // Halving cwnd upon ECE, once per window
 
   // Implementing ns3::TcpSocket -- Attribute get/set
   virtual void     SetSegSize (uint32_t size);
@@ -62,7 +71,11 @@ protected:
   virtual void     SetInitialCwnd (uint32_t cwnd);
   virtual uint32_t GetInitialCwnd (void) const;
 private:
+  friend class TcpSackScoreboardTestCase;
   void InitializeCwnd (void);            // set m_cWnd when connection starts
+  bool IsLost (SequenceNumber32 seq) const; // Whether enough data was SACKed above seq to deem it lost
+  uint32_t Pipe (void);                  // Estimate of the bytes in flight during SACK recovery
+  void SackRecovery (void);              // Send what the scoreboard and cwnd allow in SACK recovery
 
 protected:
   TracedValue<uint32_t>  m_cWnd;         //< Congestion window
@@ -70,6 +83,8 @@ protected:
   uint32_t               m_initialCWnd;  //< Initial cWnd value
   SequenceNumber32       m_recover;      //< Previous highest Tx seqnum for fast recovery
   bool                   m_inFastRec;    //< currently in fast recovery
+  SequenceNumber32       m_sackHighRxt;  //< Highest seqnum retransmitted in SACK recovery (HighRxt)
+  SequenceNumber32       m_ecnRecover;   //< Highest Tx seqnum when cwnd was last reduced upon ECE
 };
 
 } // namespace ns3
@@ -0,0 +1,262 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tcp-option-mptcp.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+TcpOptionMpTcp::TcpOptionMpTcp ()
+  : m_subType (DSS),
+    m_dssFlags (0),
+    m_key (0),
+    m_token (0),
+    m_addressId (0),
+    m_nonce (0),
+    m_dataAck (0),
+    m_dataSeq (0),
+    m_subflowSeq (0),
+    m_dataLength (0)
+{
+}
+
+TcpOptionMpTcp::~TcpOptionMpTcp ()
+{
+}
+
+void
+TcpOptionMpTcp::SetCapable (uint64_t key)
+{
+  m_subType = MP_CAPABLE;
+  m_key = key;
+}
+
+void
+TcpOptionMpTcp::SetJoin (uint32_t token, uint8_t addressId, uint32_t nonce)
+{
+  m_subType = MP_JOIN;
+  m_token = token;
+  m_addressId = addressId;
+  m_nonce = nonce;
+}
+
+void
+TcpOptionMpTcp::SetDataAck (SequenceNumber32 ack)
+{
+  m_subType = DSS;
+  m_dssFlags |= DSS_DATA_ACK;
+  m_dataAck = ack;
+}
+
+void
+TcpOptionMpTcp::SetMapping (SequenceNumber32 dataSeq, SequenceNumber32 subflowSeq, uint16_t length)
+{
+  m_subType = DSS;
+  m_dssFlags |= DSS_MAPPING;
+  m_dataSeq = dataSeq;
+  m_subflowSeq = subflowSeq;
+  m_dataLength = length;
+}
+
+enum TcpOptionMpTcp::SubType
+TcpOptionMpTcp::GetSubType (void) const
+{
+  return m_subType;
+}
+
+uint64_t
+TcpOptionMpTcp::GetKey (void) const
+{
+  return m_key;
+}
+
+uint32_t
+TcpOptionMpTcp::GetToken (void) const
+{
+  return m_token;
+}
+
+uint8_t
+TcpOptionMpTcp::GetAddressId (void) const
+{
+  return m_addressId;
+}
+
+uint32_t
+TcpOptionMpTcp::GetNonce (void) const
+{
+  return m_nonce;
+}
+
+bool
+TcpOptionMpTcp::HasDataAck (void) const
+{
+  return m_subType == DSS && (m_dssFlags & DSS_DATA_ACK);
+}
+
+SequenceNumber32
+TcpOptionMpTcp::GetDataAck (void) const
+{
+  return m_dataAck;
+}
+
+bool
+TcpOptionMpTcp::HasMapping (void) const
+{
+  return m_subType == DSS && (m_dssFlags & DSS_MAPPING);
+}
+
+SequenceNumber32
+TcpOptionMpTcp::GetDataSequence (void) const
+{
+  return m_dataSeq;
+}
+
+SequenceNumber32
+TcpOptionMpTcp::GetSubflowSequence (void) const
+{
+  return m_subflowSeq;
+}
+
+uint16_t
+TcpOptionMpTcp::GetDataLength (void) const
+{
+  return m_dataLength;
+}
+
+uint8_t
+TcpOptionMpTcp::GetKind (void) const
+{
+  return MPTCP;
+}
+
+uint32_t
+TcpOptionMpTcp::GetSerializedSize (void) const
+{
+  switch (m_subType)
+    {
+    case MP_CAPABLE:
+    case MP_JOIN:
+      return 12;
+    case DSS:
+    default:
+      return 4 + ((m_dssFlags & DSS_DATA_ACK) ? 4 : 0) + ((m_dssFlags & DSS_MAPPING) ? 10 : 0);
+    }
+}
+
+void
+TcpOptionMpTcp::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (GetKind ());
+  i.WriteU8 (GetSerializedSize ());
+  switch (m_subType)
+    {
+    case MP_CAPABLE:
+      i.WriteU8 (MP_CAPABLE << 4); // version 0
+      i.WriteU8 (0x01);            // no checksum, HMAC-SHA1
+      i.WriteHtonU64 (m_key);
+      break;
+    case MP_JOIN:
+      i.WriteU8 (MP_JOIN << 4);
+      i.WriteU8 (m_addressId);
+      i.WriteHtonU32 (m_token);
+      i.WriteHtonU32 (m_nonce);
+      break;
+    case DSS:
+      i.WriteU8 (DSS << 4);
+      i.WriteU8 (m_dssFlags);
+      if (m_dssFlags & DSS_DATA_ACK)
+        {
+          i.WriteHtonU32 (m_dataAck.GetValue ());
+        }
+      if (m_dssFlags & DSS_MAPPING)
+        {
+          i.WriteHtonU32 (m_dataSeq.GetValue ());
+          i.WriteHtonU32 (m_subflowSeq.GetValue ());
+          i.WriteHtonU16 (m_dataLength);
+        }
+      break;
+    }
+}
+
+uint32_t
+TcpOptionMpTcp::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t kind = i.ReadU8 ();
+  NS_ASSERT (kind == MPTCP);
+  (void) kind;
+  uint8_t length = i.ReadU8 ();
+  m_subType = static_cast<enum SubType> (i.ReadU8 () >> 4);
+  switch (m_subType)
+    {
+    case MP_CAPABLE:
+      i.ReadU8 ();
+      m_key = i.ReadNtohU64 ();
+      break;
+    case MP_JOIN:
+      m_addressId = i.ReadU8 ();
+      m_token = i.ReadNtohU32 ();
+      m_nonce = i.ReadNtohU32 ();
+      break;
+    case DSS:
+      m_dssFlags = i.ReadU8 ();
+      if (m_dssFlags & DSS_DATA_ACK)
+        {
+          m_dataAck = SequenceNumber32 (i.ReadNtohU32 ());
+        }
+      if (m_dssFlags & DSS_MAPPING)
+        {
+          m_dataSeq = SequenceNumber32 (i.ReadNtohU32 ());
+          m_subflowSeq = SequenceNumber32 (i.ReadNtohU32 ());
+          m_dataLength = i.ReadNtohU16 ();
+        }
+      break;
+    default:
+      break;
+    }
+  return length;
+}
+
+void
+TcpOptionMpTcp::Print (std::ostream &os) const
+{
+  switch (m_subType)
+    {
+    case MP_CAPABLE:
+      os << "MP_CAPABLE key=" << m_key;
+      break;
+    case MP_JOIN:
+      os << "MP_JOIN token=" << m_token << " id=" << (uint32_t) m_addressId;
+      break;
+    case DSS:
+      os << "DSS";
+      if (m_dssFlags & DSS_DATA_ACK)
+        {
+          os << " ack=" << m_dataAck;
+        }
+      if (m_dssFlags & DSS_MAPPING)
+        {
+          os << " map=" << m_dataSeq << "/" << m_subflowSeq << "+" << m_dataLength;
+        }
+      break;
+    default:
+      os << "MPTCP subtype " << (uint32_t) m_subType;
+      break;
+    }
+}
+
+} // namespace ns3
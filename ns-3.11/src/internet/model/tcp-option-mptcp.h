@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TCP_OPTION_MPTCP_H
+#define TCP_OPTION_MPTCP_H
+
+#include "tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief The Multipath TCP option (RFC 6824)
+ *
+ * Three subtypes are supported: MP_CAPABLE, which carries the key of
+ * the sender in the SYN and SYN+ACK of the first subflow; MP_JOIN,
+ * which carries the token of the connection in the SYN of the other
+ * subflows; and DSS, which carries the data-level acknowledgement and
+ * the mapping of the subflow sequence numbers of a segment onto the
+ * data sequence numbers of the connection. Checksums are not
+ * negotiated, so the DSS option carries none, and the subflow sequence
+ * numbers are relative to an initial sequence number of zero.
+ */
+class TcpOptionMpTcp : public TcpOption
+{
+public:
+  enum SubType
+  {
+    MP_CAPABLE = 0,
+    MP_JOIN = 1,
+    DSS = 2
+  };
+
+  TcpOptionMpTcp ();
+  virtual ~TcpOptionMpTcp ();
+
+  /**
+   * \param key the key of the sender
+   *
+   * Make this option an MP_CAPABLE option.
+   */
+  void SetCapable (uint64_t key);
+  /**
+   * \param token the token of the connection the subflow joins
+   * \param addressId the identifier of the source address
+   * \param nonce a random number of the sender
+   *
+   * Make this option an MP_JOIN option.
+   */
+  void SetJoin (uint32_t token, uint8_t addressId, uint32_t nonce);
+  /**
+   * \param ack the next data sequence number expected by the sender
+   *
+   * Make this option a DSS option, and add a data acknowledgement to it.
+   */
+  void SetDataAck (SequenceNumber32 ack);
+  /**
+   * \param dataSeq the data sequence number of the first byte mapped
+   * \param subflowSeq the subflow sequence number of the first byte mapped
+   * \param length the number of bytes mapped
+   *
+   * Make this option a DSS option, and add a mapping to it.
+   */
+  void SetMapping (SequenceNumber32 dataSeq, SequenceNumber32 subflowSeq, uint16_t length);
+
+  enum SubType GetSubType (void) const;
+  uint64_t GetKey (void) const;
+  uint32_t GetToken (void) const;
+  uint8_t GetAddressId (void) const;
+  uint32_t GetNonce (void) const;
+  bool HasDataAck (void) const;
+  SequenceNumber32 GetDataAck (void) const;
+  bool HasMapping (void) const;
+  SequenceNumber32 GetDataSequence (void) const;
+  SequenceNumber32 GetSubflowSequence (void) const;
+  uint16_t GetDataLength (void) const;
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  enum
+  {
+    DSS_DATA_ACK = 0x01,
+    DSS_MAPPING = 0x04
+  };
+
+  enum SubType m_subType;
+  uint8_t m_dssFlags;
+  uint64_t m_key;
+  uint32_t m_token;
+  uint8_t m_addressId;
+  uint32_t m_nonce;
+  SequenceNumber32 m_dataAck;
+  SequenceNumber32 m_dataSeq;
+  SequenceNumber32 m_subflowSeq;
+  uint16_t m_dataLength;
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_MPTCP_H */
@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tcp-option-sack.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+TcpOptionSackPermitted::TcpOptionSackPermitted ()
+{
+}
+
+TcpOptionSackPermitted::~TcpOptionSackPermitted ()
+{
+}
+
+uint8_t
+TcpOptionSackPermitted::GetKind (void) const
+{
+  return SACK_PERMITTED;
+}
+
+uint32_t
+TcpOptionSackPermitted::GetSerializedSize (void) const
+{
+  return 2;
+}
+
+void
+TcpOptionSackPermitted::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (GetKind ());
+  i.WriteU8 (GetSerializedSize ());
+}
+
+uint32_t
+TcpOptionSackPermitted::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t kind = i.ReadU8 ();
+  NS_ASSERT (kind == SACK_PERMITTED);
+  (void) kind;
+  return i.ReadU8 ();
+}
+
+void
+TcpOptionSackPermitted::Print (std::ostream &os) const
+{
+  os << "SACK_PERMITTED";
+}
+
+TcpOptionSack::TcpOptionSack ()
+{
+}
+
+TcpOptionSack::~TcpOptionSack ()
+{
+}
+
+void
+TcpOptionSack::AddSackBlock (SackBlock block)
+{
+  m_sackList.push_back (block);
+}
+
+const TcpOptionSack::SackList &
+TcpOptionSack::GetSackList (void) const
+{
+  return m_sackList;
+}
+
+uint32_t
+TcpOptionSack::GetNumSackBlocks (void) const
+{
+  return m_sackList.size ();
+}
+
+void
+TcpOptionSack::ClearSackList (void)
+{
+  m_sackList.clear ();
+}
+
+uint8_t
+TcpOptionSack::GetKind (void) const
+{
+  return SACK;
+}
+
+uint32_t
+TcpOptionSack::GetSerializedSize (void) const
+{
+  return 2 + 8 * m_sackList.size ();
+}
+
+void
+TcpOptionSack::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (GetKind ());
+  i.WriteU8 (GetSerializedSize ());
+  for (SackList::const_iterator it = m_sackList.begin (); it != m_sackList.end (); ++it)
+    {
+      i.WriteHtonU32 (it->first.GetValue ());
+      i.WriteHtonU32 (it->second.GetValue ());
+    }
+}
+
+uint32_t
+TcpOptionSack::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t kind = i.ReadU8 ();
+  NS_ASSERT (kind == SACK);
+  (void) kind;
+  uint8_t length = i.ReadU8 ();
+  m_sackList.clear ();
+  for (uint32_t n = 0; n < (length - 2u) / 8; ++n)
+    {
+      SequenceNumber32 first = SequenceNumber32 (i.ReadNtohU32 ());
+      SequenceNumber32 second = SequenceNumber32 (i.ReadNtohU32 ());
+      m_sackList.push_back (SackBlock (first, second));
+    }
+  return length;
+}
+
+void
+TcpOptionSack::Print (std::ostream &os) const
+{
+  os << "SACK";
+  for (SackList::const_iterator it = m_sackList.begin (); it != m_sackList.end (); ++it)
+    {
+      os << " [" << it->first << ";" << it->second << ")";
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include <vector>
+#include <utility>
+#include "tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief The SACK-permitted option (RFC 2018), sent in a SYN or SYN+ACK
+ */
+class TcpOptionSackPermitted : public TcpOption
+{
+public:
+  TcpOptionSackPermitted ();
+  virtual ~TcpOptionSackPermitted ();
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+};
+
+/**
+ * \ingroup tcp
+ * \brief The SACK option (RFC 2018)
+ *
+ * Each block is the range [first, second) of sequence numbers of a
+ * block of data received out of order. At most four blocks fit in the
+ * option space of a header, three if timestamps are in use too.
+ */
+class TcpOptionSack : public TcpOption
+{
+public:
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  typedef std::vector<SackBlock> SackList;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  /**
+   * \param block the block to append to the option
+   */
+  void AddSackBlock (SackBlock block);
+  /**
+   * \returns the blocks carried by the option, in their order of appearance
+   */
+  const SackList & GetSackList (void) const;
+  /**
+   * \returns the number of blocks carried by the option
+   */
+  uint32_t GetNumSackBlocks (void) const;
+  /**
+   * Remove all the blocks of the option
+   */
+  void ClearSackList (void);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  SackList m_sackList;
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
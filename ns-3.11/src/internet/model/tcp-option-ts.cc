@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "tcp-option-ts.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+TcpOptionTimestamp::TcpOptionTimestamp ()
+  : m_timestamp (0),
+    m_echo (0)
+{
+}
+
+TcpOptionTimestamp::~TcpOptionTimestamp ()
+{
+}
+
+void
+TcpOptionTimestamp::SetTimestamp (uint32_t value, uint32_t echo)
+{
+  m_timestamp = value;
+  m_echo = echo;
+}
+
+uint32_t
+TcpOptionTimestamp::GetTimestamp (void) const
+{
+  return m_timestamp;
+}
+
+uint32_t
+TcpOptionTimestamp::GetEcho (void) const
+{
+  return m_echo;
+}
+
+uint8_t
+TcpOptionTimestamp::GetKind (void) const
+{
+  return TIMESTAMP;
+}
+
+uint32_t
+TcpOptionTimestamp::GetSerializedSize (void) const
+{
+  return 10;
+}
+
+void
+TcpOptionTimestamp::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (GetKind ());
+  i.WriteU8 (GetSerializedSize ());
+  i.WriteHtonU32 (m_timestamp);
+  i.WriteHtonU32 (m_echo);
+}
+
+uint32_t
+TcpOptionTimestamp::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t kind = i.ReadU8 ();
+  NS_ASSERT (kind == TIMESTAMP);
+  (void) kind;
+  uint8_t length = i.ReadU8 ();
+  m_timestamp = i.ReadNtohU32 ();
+  m_echo = i.ReadNtohU32 ();
+  return length;
+}
+
+void
+TcpOptionTimestamp::Print (std::ostream &os) const
+{
+  os << "TS val=" << m_timestamp << " ecr=" << m_echo;
+}
+
+} // namespace ns3
@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TCP_OPTION_TS_H
+#define TCP_OPTION_TS_H
+
+#include "tcp-option.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief The timestamp option (RFC 7323)
+ *
+ * TcpSocketBase fills the timestamp value with a clock that ticks every
+ * microsecond, so that round trips of data center networks can be
+ * measured, and echoes the most recent timestamp value of the peer.
+ */
+class TcpOptionTimestamp : public TcpOption
+{
+public:
+  TcpOptionTimestamp ();
+  virtual ~TcpOptionTimestamp ();
+
+  /**
+   * \param value the clock of the sender (TSval)
+   * \param echo the timestamp value echoed to the peer (TSecr)
+   */
+  void SetTimestamp (uint32_t value, uint32_t echo);
+  uint32_t GetTimestamp (void) const;
+  uint32_t GetEcho (void) const;
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  uint32_t m_timestamp;
+  uint32_t m_echo;
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_TS_H */
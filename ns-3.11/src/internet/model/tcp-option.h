@@ -0,0 +1,79 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TCP_OPTION_H
+#define TCP_OPTION_H
+
+#include <stdint.h>
+#include <ostream>
+#include "ns3/buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief Base class of the options carried by a TcpHeader
+ *
+ * An option is a plain value: TcpHeader::AppendOption serializes it
+ * into the option bytes of the header, and TcpHeader::GetOption
+ * deserializes the first option of the same kind found in a header.
+ * The serialized form includes the kind and length octets, except
+ * for the single-octet END and NOP options which are handled by the
+ * header itself.
+ */
+class TcpOption
+{
+public:
+  /**
+   * The option kinds, as assigned by IANA
+   */
+  enum Kind
+  {
+    END = 0,
+    NOP = 1,
+    SACK_PERMITTED = 4,
+    SACK = 5,
+    TIMESTAMP = 8,
+    MPTCP = 30
+  };
+
+  virtual ~TcpOption ();
+
+  /**
+   * \returns the kind of the option
+   */
+  virtual uint8_t GetKind (void) const = 0;
+  /**
+   * \returns the number of bytes of the option, kind and length included
+   */
+  virtual uint32_t GetSerializedSize (void) const = 0;
+  /**
+   * \param start the position at which the option is written
+   */
+  virtual void Serialize (Buffer::Iterator start) const = 0;
+  /**
+   * \param start the position of the kind octet of the option
+   * \returns the number of bytes read
+   */
+  virtual uint32_t Deserialize (Buffer::Iterator start) = 0;
+  /**
+   * \param os output stream
+   */
+  virtual void Print (std::ostream &os) const = 0;
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_H */
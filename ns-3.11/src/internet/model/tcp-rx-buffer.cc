@@ -18,6 +18,8 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+#include <string.h>
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -48,7 +50,8 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_mode (PACKET_MAP), m_ringHead (0)
 {
 }
 
@@ -106,17 +109,44 @@ TcpRxBuffer::IncNextRxSequence ()
 SequenceNumber32
 TcpRxBuffer::MaxRxSequence (void) const
 {
+  SequenceNumber32 firstSeq;
   if (m_gotFin)
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (HeadOfData (firstSeq))
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return firstSeq + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
 
+// Find the sequence number of the first byte buffered, if any
+bool
+TcpRxBuffer::HeadOfData (SequenceNumber32 &seq) const
+{
+  if (m_mode == BYTE_RING)
+    {
+      if (m_availBytes)
+        {
+          seq = m_headSeq;
+          return true;
+        }
+      if (m_blocks.size ())
+        {
+          seq = m_blocks.front ().first;
+          return true;
+        }
+      return false;
+    }
+  if (m_data.size ())
+    {
+      seq = m_data.begin ()->first;
+      return true;
+    }
+  return false;
+}
+
 void
 TcpRxBuffer::SetFinSequence (const SequenceNumber32& s)
 {
@@ -146,12 +176,27 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  SequenceNumber32 firstSeq;
+  if (HeadOfData (firstSeq))
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = firstSeq + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
+  if (m_mode == BYTE_RING)
+    {
+      if (!AddToRing (p, headSeq, tailSeq, tcph.GetSequenceNumber ()))
+        {
+          return false;
+        }
+      NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq
+                                                << " blocks=" << m_blocks.size ());
+      if (m_gotFin && m_nextRxSeq == m_finSeq)
+        { // Account for the FIN packet
+          ++m_nextRxSeq;
+        }
+      return true;
+    }
   // Remove overlapped bytes from packet
   BufIterator i = m_data.begin ();
   while (i != m_data.end () && i->first <= tailSeq)
@@ -192,6 +237,7 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   // Insert packet into buffer
   NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
   m_data [ headSeq ] = p;
+  m_lastSeq = headSeq;
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
@@ -224,6 +270,10 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
+  if (m_mode == BYTE_RING)
+    {
+      return ExtractFromRing (extractSize);
+    }
   NS_ASSERT (m_data.size ()); // At least we have something to extract
   Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
   BufIterator i;
@@ -261,4 +311,205 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   return outPkt;
 }
 
+TcpRxBuffer::SackList
+TcpRxBuffer::GetSackList (void) const
+{
+  SackList blocks;
+  if (m_mode == BYTE_RING)
+    {
+      blocks = m_blocks;
+    }
+  else
+    {
+      std::map<SequenceNumber32, Ptr<Packet> >::const_iterator i = m_data.upper_bound (m_nextRxSeq);
+      for (; i != m_data.end (); ++i)
+        {
+          SequenceNumber32 tail = i->first + SequenceNumber32 (i->second->GetSize ());
+          if (blocks.size () && blocks.back ().second == i->first)
+            {
+              blocks.back ().second = tail;
+            }
+          else
+            {
+              blocks.push_back (SackBlock (i->first, tail));
+            }
+        }
+    }
+  // Report first the block holding the most recently received segment
+  for (SackList::iterator i = blocks.begin (); i != blocks.end (); ++i)
+    {
+      if (i->first <= m_lastSeq && m_lastSeq < i->second)
+        {
+          SackBlock last = *i;
+          blocks.erase (i);
+          blocks.insert (blocks.begin (), last);
+          break;
+        }
+    }
+  return blocks;
+}
+
+void
+TcpRxBuffer::SetStorageMode (StorageMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  NS_ASSERT_MSG (m_size == 0, "Cannot change the storage of a non-empty buffer");
+  m_mode = mode;
+  m_data.clear ();
+  m_blocks.clear ();
+  m_ring.clear ();
+  m_ringHead = 0;
+}
+
+TcpRxBuffer::StorageMode
+TcpRxBuffer::GetStorageMode (void) const
+{
+  return m_mode;
+}
+
+void
+TcpRxBuffer::GrowRing (uint32_t needed)
+{
+  NS_LOG_FUNCTION (this << needed);
+  // Bytes from the first unread one to the end of the last out of order block
+  uint32_t span = m_availBytes;
+  if (m_blocks.size ())
+    {
+      span = m_blocks.back ().second - m_headSeq;
+    }
+  uint32_t capacity = std::max<uint32_t> (m_ring.size (), 2048);
+  while (capacity < needed)
+    {
+      capacity *= 2;
+    }
+  std::vector<uint8_t> ring (capacity);
+  uint32_t first = std::min<uint32_t> (span, m_ring.size () - m_ringHead);
+  if (first > 0)
+    {
+      memcpy (&ring[0], &m_ring[m_ringHead], first);
+    }
+  if (span > first)
+    {
+      memcpy (&ring[first], &m_ring[0], span - first);
+    }
+  m_ring.swap (ring);
+  m_ringHead = 0;
+  NS_LOG_LOGIC ("Ring capacity is now " << capacity);
+}
+
+bool
+TcpRxBuffer::AddToRing (Ptr<Packet> p, SequenceNumber32 headSeq, SequenceNumber32 tailSeq,
+                        const SequenceNumber32& pktSeq)
+{
+  if (headSeq >= tailSeq)
+    {
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false;
+    }
+  // Count the bytes not buffered yet
+  uint32_t newBytes = tailSeq - headSeq;
+  for (SackList::const_iterator i = m_blocks.begin (); i != m_blocks.end () && i->first < tailSeq; ++i)
+    {
+      SequenceNumber32 overlapHead = std::max (i->first, headSeq);
+      SequenceNumber32 overlapTail = std::min (i->second, tailSeq);
+      if (overlapHead < overlapTail)
+        {
+          newBytes -= overlapTail - overlapHead;
+        }
+    }
+  if (newBytes == 0)
+    {
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false;
+    }
+
+  // Copy the data in place, overwriting identical bytes received before
+  if (m_size == 0)
+    {
+      m_headSeq = m_nextRxSeq;
+      m_ringHead = 0;
+    }
+  uint32_t end = tailSeq - m_headSeq;
+  if (end > m_ring.size ())
+    {
+      GrowRing (end);
+    }
+  uint32_t start = headSeq - pktSeq;
+  uint32_t length = tailSeq - headSeq;
+  uint32_t pos = (m_ringHead + (headSeq - m_headSeq)) % m_ring.size ();
+  uint32_t first = std::min<uint32_t> (length, m_ring.size () - pos);
+  if (start == 0 && first == length)
+    {
+      p->CopyData (&m_ring[pos], length);
+    }
+  else
+    {
+      m_scratch.resize (p->GetSize ());
+      p->CopyData (&m_scratch[0], p->GetSize ());
+      memcpy (&m_ring[pos], &m_scratch[start], first);
+      if (length > first)
+        {
+          memcpy (&m_ring[0], &m_scratch[start + first], length - first);
+        }
+    }
+  NS_LOG_LOGIC ("Buffered data of seqno=" << headSeq << " len=" << length);
+
+  // Merge the new range with the blocks it overlaps or touches
+  SackList::iterator i = m_blocks.begin ();
+  while (i != m_blocks.end () && i->second < headSeq)
+    {
+      ++i;
+    }
+  SackBlock block (headSeq, tailSeq);
+  SackList::iterator j = i;
+  while (j != m_blocks.end () && j->first <= tailSeq)
+    {
+      block.first = std::min (block.first, j->first);
+      block.second = std::max (block.second, j->second);
+      ++j;
+    }
+  i = m_blocks.erase (i, j);
+  m_blocks.insert (i, block);
+  m_size += newBytes;
+  m_lastSeq = headSeq;
+
+  // Hand the block at the head over to the application
+  if (m_blocks.front ().first == m_nextRxSeq)
+    {
+      m_availBytes += m_blocks.front ().second - m_blocks.front ().first;
+      m_nextRxSeq = m_blocks.front ().second;
+      m_blocks.erase (m_blocks.begin ());
+    }
+  return true;
+}
+
+Ptr<Packet>
+TcpRxBuffer::ExtractFromRing (uint32_t extractSize)
+{
+  Ptr<Packet> outPkt;
+  uint32_t first = m_ring.size () - m_ringHead;
+  if (extractSize <= first)
+    {
+      outPkt = Create<Packet> (&m_ring[m_ringHead], extractSize);
+    }
+  else
+    {
+      m_scratch.resize (extractSize);
+      memcpy (&m_scratch[0], &m_ring[m_ringHead], first);
+      memcpy (&m_scratch[first], &m_ring[0], extractSize - first);
+      outPkt = Create<Packet> (&m_scratch[0], extractSize);
+    }
+  m_ringHead = (m_ringHead + extractSize) % m_ring.size ();
+  m_headSeq += extractSize;
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+  if (m_size == 0)
+    {
+      m_ringHead = 0;
+    }
+  NS_LOG_LOGIC ("Extracted " << extractSize << " bytes, bufsize=" << m_size
+                             << ", num blocks in buffer=" << m_blocks.size ());
+  return outPkt;
+}
+
 } //namepsace ns3
@@ -22,6 +22,8 @@
 #define __TCP_RX_BUFFER_H__
 
 #include <map>
+#include <vector>
+#include <utility>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,11 +38,37 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * Two storage schemes are available. The default one keeps each received
+ * segment as a packet in a map indexed by sequence number, trims overlapping
+ * segments by fragmenting them and concatenates the segments on every read.
+ * The byte ring scheme copies the received bytes into a circular byte store
+ * and only records the received ranges, merging contiguous and overlapping
+ * ones as they arrive, so the bookkeeping grows with the number of holes
+ * rather than with the number of segments. Packet metadata and tags of the
+ * received segments are not carried over to the application in this scheme.
  */
 class TcpRxBuffer : public Object
 {
 public:
   static TypeId GetTypeId (void);
+
+  /**
+   * \brief Storage schemes of the buffered data
+   */
+  enum StorageMode
+  {
+    PACKET_MAP,  /**< map of the received segments */
+    BYTE_RING    /**< circular store of the received bytes */
+  };
+
+  /**
+   * \brief A block of contiguous data received out of order,
+   *        as the range [first, second)
+   */
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  typedef std::vector<SackBlock> SackList;
+
   TcpRxBuffer (uint32_t n = 0);
   virtual ~TcpRxBuffer ();
 
@@ -72,6 +100,32 @@ public:
    * The extracted data is going to be forwarded to the application.
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /**
+   * Returns the blocks of data buffered beyond the next expected sequence
+   * number, ordered as RFC 2018 wants them in a SACK option: the block
+   * holding the most recently received segment first, then the others in
+   * sequence order.
+   */
+  SackList GetSackList (void) const;
+
+  /**
+   * Select the storage scheme. The buffer must be empty.
+   *
+   * \param mode The storage scheme to use for subsequent data
+   */
+  void SetStorageMode (StorageMode mode);
+
+  /**
+   * Returns the storage scheme in use
+   */
+  StorageMode GetStorageMode (void) const;
+private:
+  bool AddToRing (Ptr<Packet> p, SequenceNumber32 headSeq, SequenceNumber32 tailSeq,
+                  const SequenceNumber32& pktSeq);
+  Ptr<Packet> ExtractFromRing (uint32_t extractSize);
+  void GrowRing (uint32_t needed);
+  bool HeadOfData (SequenceNumber32 &seq) const;
 public:
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //< Seqnum of the first missing byte in data (RCV.NXT)
@@ -82,6 +136,13 @@ public:
   uint32_t m_availBytes;                     //< Number of bytes available to read, i.e. contiguous block at head
   std::map<SequenceNumber32, Ptr<Packet> > m_data;
   //< Corresponding data (may be null)
+  StorageMode m_mode;                        //< Storage scheme in use
+  std::vector<uint8_t> m_ring;               //< Circular byte store (BYTE_RING mode)
+  uint32_t m_ringHead;                       //< Offset of m_headSeq in m_ring
+  SequenceNumber32 m_headSeq;                //< Seqnum of the first unread byte (BYTE_RING mode)
+  SackList m_blocks;                         //< Out of order ranges in sequence order (BYTE_RING mode)
+  SequenceNumber32 m_lastSeq;                //< Seqnum of the last buffered segment
+  std::vector<uint8_t> m_scratch;            //< Staging area for data crossing the end of m_ring
 };
 
 } //namepsace ns3
@@ -33,14 +33,20 @@
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/trace-source-accessor.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
 #include "tcp-header.h"
+#include "tcp-option-sack.h"
+#include "tcp-option-ts.h"
 #include "rtt-estimator.h"
 
 #include <algorithm>
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
@@ -58,6 +64,77 @@ TcpSocketBase::GetTypeId (void)
 //                   EnumValue (CLOSED),
 //                   MakeEnumAccessor (&TcpSocketBase::m_state),
 //                   MakeEnumChecker (CLOSED, "Closed"))
+    .AddAttribute ("TxBufferStorage",
+                   "Storage scheme of the transmission buffer: a list of the "
+                   "application packets, or a circular store of their bytes",
+                   EnumValue (TcpTxBuffer::PACKET_LIST),
+                   MakeEnumAccessor (&TcpSocketBase::SetTxBufferStorage,
+                                     &TcpSocketBase::GetTxBufferStorage),
+                   MakeEnumChecker (TcpTxBuffer::PACKET_LIST, "PacketList",
+                                    TcpTxBuffer::BYTE_RING, "ByteRing"))
+    .AddAttribute ("RxBufferStorage",
+                   "Storage scheme of the reordering buffer: a map of the "
+                   "received segments, or a circular store of their bytes",
+                   EnumValue (TcpRxBuffer::PACKET_MAP),
+                   MakeEnumAccessor (&TcpSocketBase::SetRxBufferStorage,
+                                     &TcpSocketBase::GetRxBufferStorage),
+                   MakeEnumChecker (TcpRxBuffer::PACKET_MAP, "PacketMap",
+                                    TcpRxBuffer::BYTE_RING, "ByteRing"))
+    .AddAttribute ("Sack",
+                   "Offer selective acknowledgements (RFC 2018) to the peer",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Timestamp",
+                   "Offer the timestamp option (RFC 7323) to the peer, and "
+                   "measure the round trip time from the timestamps echoed",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Ecn",
+                   "Offer explicit congestion notification (RFC 3168) to the "
+                   "peer, and send the data segments as ECN-capable",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_ecnEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("BatchSend",
+                   "Send the segments the window allows in one pass, sharing "
+                   "one header template, and notify the application of the "
+                   "data sent once per pass instead of once per segment",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_batchSend),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Pacing",
+                   "Space the data segments at the pacing rate instead of "
+                   "sending the available window back to back",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FixedPacingRate",
+                   "Pacing rate to use; if zero, the rate is PacingGain times "
+                   "the window over the smoothed RTT",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&TcpSocketBase::m_fixedPacingRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("TimeWaitTimeout",
+                   "Time spent in TIME_WAIT, twice the maximum segment "
+                   "lifetime, before the socket closes and is reclaimed; "
+                   "if zero, the socket stays in TIME_WAIT",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&TcpSocketBase::m_timeWaitTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacingGain",
+                   "Ratio of the computed pacing rate to the window over the "
+                   "smoothed RTT, above 1 to let the window grow",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&TcpSocketBase::m_pacingGain),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PacingMaxBurst",
+                   "Most segments sent back to back each time the pacing "
+                   "timer expires, as the pacing credit allows",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&TcpSocketBase::m_pacingMaxBurst),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto))
@@ -76,6 +153,9 @@ TcpSocketBase::GetTypeId (void)
     .AddTraceSource ("RWND",
                      "Remote side's flow control window",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rWnd))
+    .AddTraceSource ("PacingRate",
+                     "Rate at which the data segments are paced, zero if not paced",
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_pacingRate))
   ;
   return tid;
 }
@@ -86,6 +166,7 @@ TcpSocketBase::TcpSocketBase (void)
     m_endPoint (0),
     m_node (0),
     m_tcp (0),
+    m_socketIndex (std::numeric_limits<uint32_t>::max ()),
     m_rtt (0),
     m_nextTxSequence (0),       // Change this for non-zero initial sequence number
     m_highTxMark (0),
@@ -99,7 +180,23 @@ TcpSocketBase::TcpSocketBase (void)
     m_shutdownRecv (false),
     m_connected (false),
     m_segmentSize (0),          // For attribute initialization consistency (quiet valgrind)
-    m_rWnd (0)
+    m_rWnd (0),
+    m_sackEnabled (false),
+    m_timestampEnabled (false),
+    m_sackPermitted (false),
+    m_timestampPermitted (false),
+    m_tsRecent (0),
+    m_lastAckSent (0),
+    m_sackedBytes (0),
+    m_ecnEnabled (false),
+    m_ecnPermitted (false),
+    m_ecnEcho (false),
+    m_ecnCwr (false),
+    m_batchSend (false),
+    m_pacing (false),
+    m_pacingGain (2.0),
+    m_pacingMaxBurst (2),
+    m_pacingRate (DataRate (0))
 {
   NS_LOG_FUNCTION (this);
 }
@@ -113,9 +210,11 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_delAckTimeout (sock.m_delAckTimeout),
     m_persistTimeout (sock.m_persistTimeout),
     m_cnTimeout (sock.m_cnTimeout),
+    m_timeWaitTimeout (sock.m_timeWaitTimeout),
     m_endPoint (0),
     m_node (sock.m_node),
     m_tcp (sock.m_tcp),
+    m_socketIndex (std::numeric_limits<uint32_t>::max ()),
     m_rtt (0),
     m_nextTxSequence (sock.m_nextTxSequence),
     m_highTxMark (sock.m_highTxMark),
@@ -129,7 +228,24 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_shutdownRecv (sock.m_shutdownRecv),
     m_connected (sock.m_connected),
     m_segmentSize (sock.m_segmentSize),
-    m_rWnd (sock.m_rWnd)
+    m_rWnd (sock.m_rWnd),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_timestampEnabled (sock.m_timestampEnabled),
+    m_sackPermitted (sock.m_sackPermitted),
+    m_timestampPermitted (sock.m_timestampPermitted),
+    m_tsRecent (sock.m_tsRecent),
+    m_lastAckSent (sock.m_lastAckSent),
+    m_sackedBytes (0),
+    m_ecnEnabled (sock.m_ecnEnabled),
+    m_ecnPermitted (sock.m_ecnPermitted),
+    m_ecnEcho (false),
+    m_ecnCwr (false),
+    m_batchSend (sock.m_batchSend),
+    m_pacing (sock.m_pacing),
+    m_fixedPacingRate (sock.m_fixedPacingRate),
+    m_pacingGain (sock.m_pacingGain),
+    m_pacingMaxBurst (sock.m_pacingMaxBurst),
+    m_pacingRate (DataRate (0))
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -606,6 +722,7 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   // Peel off TCP header and do validity checking
   TcpHeader tcpHeader;
   packet->RemoveHeader (tcpHeader);
+  ReadOptions (tcpHeader);
   if (tcpHeader.GetFlags () & TcpHeader::ACK)
     { 
       EstimateRtt (tcpHeader);
@@ -629,6 +746,18 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
       return;
     }
 
+  if (m_ecnPermitted && !(tcpHeader.GetFlags () & TcpHeader::SYN))
+    {
+      ReceivedEcn (tcpHeader, header.GetEcn () == Ipv4Header::ECN_CE);
+      if (tcpHeader.GetFlags () & TcpHeader::ACK)
+        {
+          ReceivedEcnEcho (tcpHeader);
+        }
+    }
+  // The ECN flags were handled above and in ReadOptions (), the state
+  // machine does not look at them
+  tcpHeader.SetFlags (tcpHeader.GetFlags () & ~(TcpHeader::ECE | TcpHeader::CWR));
+
   // TCP state machine code in different process functions
   // C.f.: tcp_rcv_state_process() in tcp_input.c in Linux kernel
   switch (m_state)
@@ -723,6 +852,10 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
+  if (m_sackPermitted && (tcpHeader.GetFlags () & TcpHeader::ACK))
+    {
+      UpdateSackScoreboard (tcpHeader);
+    }
   // Received ACK. Compare the ACK number against highest unacked seqno
   if (0 == (tcpHeader.GetFlags () & TcpHeader::ACK))
     { // Ignore if no ACK flag
@@ -948,24 +1081,34 @@ TcpSocketBase::ProcessWait (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           if (m_txBuffer.Size () == 0 &&
               tcpHeader.GetAckNumber () == m_highTxMark + SequenceNumber32 (1))
             { // This ACK corresponds to the FIN sent
-              NS_LOG_INFO ("CLOSING -> TIME_WAIT");
-              m_state = TIME_WAIT;
-              CancelAllTimers ();
+              TimeWait ();
             }
         }
       else if (m_state == FIN_WAIT_2)
         {
-          NS_LOG_INFO ("FIN_WAIT_2 -> TIME_WAIT");
-          m_state = TIME_WAIT;
-          CancelAllTimers ();
-          // TODO: In TIME_WAIT, we supposed to move to CLOSED after 2*MSL time
-          // but this move is not yet implemeneted. Is this necessary?
+          TimeWait ();
         };
       SendEmptyPacket (TcpHeader::ACK);
       if (!m_shutdownRecv) NotifyDataRecv ();
     }
 }
 
+/** Move to TIME_WAIT, where the socket absorbs the segments of the
+    connection still in flight, then to CLOSED after the TIME_WAIT timeout.
+    Without a timeout, as by default, the socket stays in TIME_WAIT: the
+    simulations which do not reclaim their sockets run as they always have */
+void
+TcpSocketBase::TimeWait (void)
+{
+  NS_LOG_INFO (TcpStateName[m_state] << " -> TIME_WAIT");
+  m_state = TIME_WAIT;
+  CancelAllTimers ();
+  if (!m_timeWaitTimeout.IsZero ())
+    {
+      m_timeWaitEvent = Simulator::Schedule (m_timeWaitTimeout, &TcpSocketBase::CloseAndNotify, this);
+    }
+}
+
 /** Received a packet upon CLOSING */
 void
 TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
@@ -979,11 +1122,7 @@ TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
     {
       if (tcpHeader.GetSequenceNumber () == m_rxBuffer.NextRxSequence ())
         { // This ACK corresponds to the FIN sent
-          NS_LOG_INFO ("CLOSING -> TIME_WAIT");
-          m_state = TIME_WAIT;
-          CancelAllTimers ();
-          // TODO: In TIME_WAIT, we supposed to move to CLOSED after 2*MSL time
-          // but this move is not yet implemeneted. Is this necessary?
+          TimeWait ();
         }
     }
   else
@@ -1156,6 +1295,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
   header.SetSourcePort (m_endPoint->GetLocalPort ());
   header.SetDestinationPort (m_endPoint->GetPeerPort ());
   header.SetWindowSize (AdvertisedWindowSize ());
+  AddOptions (header);
   m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress (), m_boundnetdevice);
   m_rto = m_rtt->RetransmitTimeout ();
   bool hasSyn = flags & TcpHeader::SYN;
@@ -1197,6 +1337,10 @@ TcpSocketBase::DeallocateEndPoint (void)
 {
   if (m_endPoint != 0)
     {
+      // The list of sockets of the protocol and the end point may hold the
+      // last references to this socket: release them once the current event
+      // has completed
+      Simulator::ScheduleNow (&TcpL4Protocol::RemoveSocket, m_tcp, Ptr<TcpSocketBase> (this));
       m_endPoint->SetDestroyCallback (MakeNullCallback<void> ());
       m_tcp->DeAllocate (m_endPoint);
       m_endPoint = 0;
@@ -1265,7 +1409,13 @@ TcpSocketBase::ConnectionSucceeded ()
 }
 
 // Send as much pending data as possible according to the Tx window. Note that
-// this function did not implement the PSH flag
+// this function did not implement the PSH flag. In batch mode, the segments
+// of a pass share the header built for the first one when the options allow
+// it, and the application is notified once of the bytes sent. With pacing,
+// every segment sent pushes m_pacingNext back by its time at the pacing rate;
+// a pass starts only once m_pacingNext is due and sends at most
+// m_pacingMaxBurst segments before it leaves the rest to the pacing timer.
+// Retransmissions are not held back, but they push m_pacingNext back too.
 bool
 TcpSocketBase::SendPendingData (bool withAck)
 {
@@ -1276,7 +1426,22 @@ TcpSocketBase::SendPendingData (bool withAck)
       NS_LOG_INFO ("TcpSocketBase::SendPendingData: No endpoint; m_shutdownSend=" << m_shutdownSend);
       return false; // Is this the right way to handle this condition?
     }
+  if (m_pacing && m_pacingEvent.IsRunning ())
+    {
+      NS_LOG_LOGIC ("Paced: wait for the pacing timer");
+      return false;
+    }
+  if (m_pacing && m_pacingNext > Simulator::Now ())
+    {
+      NS_LOG_LOGIC ("Paced: no credit before " << m_pacingNext.GetSeconds ());
+      m_pacingEvent = Simulator::Schedule (m_pacingNext - Simulator::Now (),
+                                           &TcpSocketBase::PacingTimeout, this);
+      return false;
+    }
   uint32_t nPacketsSent = 0;
+  uint32_t nBytesSent = 0;
+  bool shareHeader = m_batchSend && SharedOptions ();
+  TcpHeader batchHeader;
   while (m_txBuffer.SizeFromSequence (m_nextTxSequence))
     {
       uint32_t w = AvailableWindow (); // Get available window size
@@ -1295,66 +1460,189 @@ TcpSocketBase::SendPendingData (bool withAck)
           return false;
         }
       // Stop sending if we need to wait for a larger Tx window
-      if (w < m_segmentSize && m_txBuffer.SizeFromSequence (m_nextTxSequence) > w)
+      uint32_t segmentSize = SegmentSizeAt (m_nextTxSequence);
+      if (w < segmentSize && m_txBuffer.SizeFromSequence (m_nextTxSequence) > w)
         {
           break; // No more
         }
-      uint32_t s = std::min (w, m_segmentSize);  // Send no more than window
-      Ptr<Packet> p = m_txBuffer.CopyFromSequence (s, m_nextTxSequence);
-      NS_LOG_LOGIC ("TcpSocketBase " << this << " SendPendingData" <<
-                    " txseq " << m_nextTxSequence <<
-                    " s " << s << " datasize " << p->GetSize ());
-      uint8_t flags = 0;
-      uint32_t sz = p->GetSize (); // Size of packet
-      uint32_t remainingData = m_txBuffer.SizeFromSequence (m_nextTxSequence + SequenceNumber32 (sz));
-      if (m_closeOnEmpty && (remainingData == 0))
+      uint32_t s = std::min (w, segmentSize);  // Send no more than window
+      uint32_t sz;
+      if (shareHeader)
         {
-          flags = TcpHeader::FIN;
-          if (m_state == ESTABLISHED)
-            { // On active close: I am the first one to send FIN
-              NS_LOG_INFO ("ESTABLISHED -> FIN_WAIT_1");
-              m_state = FIN_WAIT_1;
-            }
-          else
-            { // On passive close: Peer sent me FIN already
-              NS_LOG_INFO ("CLOSE_WAIT -> LAST_ACK");
-              m_state = LAST_ACK;
+          if (nPacketsSent == 0)
+            {
+              BuildDataHeader (batchHeader, m_nextTxSequence, withAck ? TcpHeader::ACK : 0);
             }
+          sz = SendDataPacket (m_nextTxSequence, s, withAck, &batchHeader);
         }
-      if (withAck)
+      else
         {
-          flags |= TcpHeader::ACK;
+          sz = SendDataPacket (m_nextTxSequence, s, withAck);
         }
-      TcpHeader header;
-      header.SetFlags (flags);
-      header.SetSequenceNumber (m_nextTxSequence);
-      header.SetAckNumber (m_rxBuffer.NextRxSequence ());
-      header.SetSourcePort (m_endPoint->GetLocalPort ());
-      header.SetDestinationPort (m_endPoint->GetPeerPort ());
-      header.SetWindowSize (AdvertisedWindowSize ());
-      if (m_retxEvent.IsExpired () )
-        { // Schedule retransmit
-          m_rto = m_rtt->RetransmitTimeout ();
-          NS_LOG_LOGIC (this << " SendPendingData Schedule ReTxTimeout at time " <<
-                        Simulator::Now ().GetSeconds () << " to expire at time " <<
-                        (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-          m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      if (!m_batchSend)
+        { // Notify the application of the data being sent
+          Simulator::ScheduleNow (&TcpSocketBase::NotifyDataSent, this, sz);
         }
-      NS_LOG_LOGIC ("Send packet via TcpL4Protocol with flags 0x" << std::hex << static_cast<uint32_t> (flags) << std::dec);
-      m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), m_boundnetdevice);
-      m_rtt->SentSeq (m_nextTxSequence, sz);       // notify the RTT
-      // Notify the application of the data being sent
-      Simulator::ScheduleNow (&TcpSocketBase::NotifyDataSent, this, sz);
       nPacketsSent++;                             // Count sent this loop
+      nBytesSent += sz;
       m_nextTxSequence += sz;                     // Advance next tx sequence
       // Update highTxMark
       m_highTxMark = std::max (m_nextTxSequence, m_highTxMark);
+      if (m_pacing && nPacketsSent >= m_pacingMaxBurst && m_pacingNext > Simulator::Now ())
+        { // Burst sent: the rest waits until the credit is due
+          NS_LOG_LOGIC ("Paced: next segment at " << m_pacingNext.GetSeconds ());
+          m_pacingEvent = Simulator::Schedule (m_pacingNext - Simulator::Now (),
+                                               &TcpSocketBase::PacingTimeout, this);
+          break;
+        }
+    }
+  if (m_batchSend && nBytesSent > 0)
+    {
+      Simulator::ScheduleNow (&TcpSocketBase::NotifyDataSent, this, nBytesSent);
     }
   NS_LOG_LOGIC ("SendPendingData sent " << nPacketsSent << " packets");
   return (nPacketsSent > 0);
 }
 
+// The rate of the pacing timer: the fixed rate if set, otherwise the window
+// sent over a smoothed RTT, scaled by the gain. No pacing without an RTT.
+void
+TcpSocketBase::UpdatePacingRate (void)
+{
+  DataRate rate = m_fixedPacingRate;
+  if (rate.GetBitRate () == 0 && m_rtt->nSamples > 0)
+    {
+      double srtt = m_rtt->GetEstimate ().GetSeconds ();
+      if (srtt > 0)
+        {
+          rate = DataRate (static_cast<uint64_t> (m_pacingGain * Window () * 8 / srtt));
+        }
+    }
+  m_pacingRate = rate;
+}
+
+// Charge a segment sent, new data or retransmission, to the pacing credit:
+// the next new segment is due after its time at the pacing rate
+void
+TcpSocketBase::ChargePacing (uint32_t size)
+{
+  UpdatePacingRate ();
+  if (m_pacingRate.Get ().GetBitRate () > 0)
+    {
+      m_pacingNext = std::max (m_pacingNext, Simulator::Now ())
+        + Seconds (m_pacingRate.Get ().CalculateTxTime (size));
+    }
+}
+
+// The pacing timer expired: send the segments the credit allows
+void
+TcpSocketBase::PacingTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  SendPendingData (m_connected);
+}
+
+// Fill the header of a data segment, options included
+void
+TcpSocketBase::BuildDataHeader (TcpHeader& header, SequenceNumber32 seq, uint8_t flags)
+{
+  header.SetFlags (flags);
+  header.SetSequenceNumber (seq);
+  header.SetAckNumber (m_rxBuffer.NextRxSequence ());
+  header.SetSourcePort (m_endPoint->GetLocalPort ());
+  header.SetDestinationPort (m_endPoint->GetPeerPort ());
+  header.SetWindowSize (AdvertisedWindowSize ());
+  AddOptions (header);
+}
+
+// The options of the data segments sent in one pass are the same, unless a
+// subclass adds options that depend on the sequence number
+bool
+TcpSocketBase::SharedOptions (void) const
+{
+  return true;
+}
+
+// Send a segment of at most maxSize bytes of the Tx buffer, starting at seq.
+// Used for new data as well as for the retransmissions of SACK recovery.
+// The header is built here, or copied from batchHeader if given: only the
+// sequence number and the FIN and CWR flags are then set for this segment.
+uint32_t
+TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck,
+                               const TcpHeader* batchHeader)
+{
+  NS_LOG_FUNCTION (this << seq << maxSize << withAck);
+  Ptr<Packet> p = m_txBuffer.CopyFromSequence (maxSize, seq);
+  NS_LOG_LOGIC ("TcpSocketBase " << this << " SendDataPacket" <<
+                " txseq " << seq <<
+                " s " << maxSize << " datasize " << p->GetSize ());
+  uint8_t flags = 0;
+  uint32_t sz = p->GetSize (); // Size of packet
+  uint32_t remainingData = m_txBuffer.SizeFromSequence (seq + SequenceNumber32 (sz));
+  if (m_closeOnEmpty && (remainingData == 0))
+    {
+      flags = TcpHeader::FIN;
+      if (m_state == ESTABLISHED)
+        { // On active close: I am the first one to send FIN
+          NS_LOG_INFO ("ESTABLISHED -> FIN_WAIT_1");
+          m_state = FIN_WAIT_1;
+        }
+      else
+        { // On passive close: Peer sent me FIN already
+          NS_LOG_INFO ("CLOSE_WAIT -> LAST_ACK");
+          m_state = LAST_ACK;
+        }
+    }
+  if (withAck)
+    {
+      flags |= TcpHeader::ACK;
+    }
+  // New data is ECN-capable, retransmissions are not (RFC 3168 sec.6.1.5)
+  bool ecnCapable = m_ecnPermitted && seq >= m_highTxMark.Get ();
+  if (ecnCapable)
+    {
+      SocketIpTosTag tosTag;
+      tosTag.SetTos (Ipv4Header::ECN_ECT0);
+      p->AddPacketTag (tosTag);
+      if (m_ecnCwr)
+        { // First new data after the window was reduced
+          flags |= TcpHeader::CWR;
+          m_ecnCwr = false;
+        }
+    }
+  TcpHeader header;
+  if (batchHeader != 0)
+    {
+      header = *batchHeader;
+      header.SetFlags (header.GetFlags () | flags);
+      header.SetSequenceNumber (seq);
+    }
+  else
+    {
+      BuildDataHeader (header, seq, flags);
+    }
+  if (m_retxEvent.IsExpired () )
+    { // Schedule retransmit
+      m_rto = m_rtt->RetransmitTimeout ();
+      NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
+                    Simulator::Now ().GetSeconds () << " to expire at time " <<
+                    (Simulator::Now () + m_rto.Get ()).GetSeconds () );
+      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+    }
+  if (m_pacing)
+    {
+      ChargePacing (sz);
+    }
+  NS_LOG_LOGIC ("Send packet via TcpL4Protocol with flags 0x" << std::hex << static_cast<uint32_t> (flags) << std::dec);
+  m_tcp->SendPacket (p, header, m_endPoint->GetLocalAddress (),
+                     m_endPoint->GetPeerAddress (), m_boundnetdevice);
+  if (!m_timestampPermitted)
+    { // Timestamps measure the RTT of every segment without keeping a history
+      m_rtt->SentSeq (seq, sz);
+    }
+  return sz;
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount ()
 {
@@ -1450,11 +1738,28 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
 void
 TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
 {
-  // Use m_rtt for the estimation. Note, RTT of duplicated acknowledgement
-  // (which should be ignored) is handled by m_rtt. Once timestamp option
-  // is implemented, this function would be more elaborated.
-  m_rtt->AckSeq (tcpHeader.GetAckNumber () );
-};
+  if (!m_timestampPermitted)
+    { // Use m_rtt for the estimation. Note, RTT of duplicated acknowledgement
+      // (which should be ignored) is handled by m_rtt.
+      Time m = m_rtt->AckSeq (tcpHeader.GetAckNumber ());
+      if (!m.IsZero ())
+        {
+          m_lastRtt = m;
+        }
+      return;
+    }
+  // RTTM (RFC 7323 sec.4): an ACK of new data echoes the clock of the segment
+  // it acknowledges, retransmitted or not, so every such ACK is a sample
+  TcpOptionTimestamp ts;
+  if (tcpHeader.GetAckNumber () > m_txBuffer.HeadSequence ()
+      && tcpHeader.GetOption (ts) && ts.GetEcho () != 0)
+    {
+      Time m = MicroSeconds (TimestampNow () - ts.GetEcho ());
+      m_rtt->Measurement (m);
+      m_rtt->ResetMultiplier ();
+      m_lastRtt = m;
+    }
+}
 
 // Called by the ReceivedAck() when new ACK received and by ProcessSynRcvd()
 // when the three-way handshake completed. This cancels retransmission timer
@@ -1521,6 +1826,9 @@ TcpSocketBase::ReTxTimeout ()
   // If all data are received, just return
   if (m_state <= ESTABLISHED && m_txBuffer.HeadSequence () >= m_nextTxSequence) return;
 
+  // The receiver may have dropped the data it SACKed (RFC 2018 sec.8)
+  m_sackBoard.clear ();
+  m_sackedBytes = 0;
   Retransmit ();
 }
 
@@ -1554,7 +1862,7 @@ void
 TcpSocketBase::PersistTimeout ()
 {
   NS_LOG_LOGIC ("PersistTimeout expired at " << Simulator::Now ().GetSeconds ());
-  m_persistTimeout = std::min (Seconds (60), Time (2 * m_persistTimeout)); // max persist timeout = 60s
+  m_persistTimeout = std::min (Seconds (60), Time (int64x64_t (2) * m_persistTimeout)); // max persist timeout = 60s
   Ptr<Packet> p = m_txBuffer.CopyFromSequence (1, m_nextTxSequence);
   TcpHeader tcpHeader;
   tcpHeader.SetSequenceNumber (m_nextTxSequence);
@@ -1562,6 +1870,7 @@ TcpSocketBase::PersistTimeout ()
   tcpHeader.SetSourcePort (m_endPoint->GetLocalPort ());
   tcpHeader.SetDestinationPort (m_endPoint->GetPeerPort ());
   tcpHeader.SetWindowSize (AdvertisedWindowSize ());
+  AddOptions (tcpHeader);
 
   m_tcp->SendPacket (p, tcpHeader, m_endPoint->GetLocalAddress (),
                      m_endPoint->GetPeerAddress (), m_boundnetdevice);
@@ -1608,7 +1917,8 @@ TcpSocketBase::DoRetransmit ()
       return;
     }
   // Retransmit a data packet: Extract data
-  Ptr<Packet> p = m_txBuffer.CopyFromSequence (m_segmentSize, m_txBuffer.HeadSequence ());
+  Ptr<Packet> p = m_txBuffer.CopyFromSequence (SegmentSizeAt (m_txBuffer.HeadSequence ()),
+                                               m_txBuffer.HeadSequence ());
   // Close-on-Empty check
   if (m_closeOnEmpty && m_txBuffer.Size () == p->GetSize ())
     {
@@ -1624,7 +1934,14 @@ TcpSocketBase::DoRetransmit ()
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
       m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
-  m_rtt->SentSeq (m_txBuffer.HeadSequence (), p->GetSize ());
+  if (!m_timestampPermitted)
+    {
+      m_rtt->SentSeq (m_txBuffer.HeadSequence (), p->GetSize ());
+    }
+  if (m_pacing)
+    { // Sent at once, but later new data waits for it
+      ChargePacing (p->GetSize ());
+    }
   // And send the packet
   TcpHeader tcpHeader;
   tcpHeader.SetSequenceNumber (m_txBuffer.HeadSequence ());
@@ -1633,11 +1950,223 @@ TcpSocketBase::DoRetransmit ()
   tcpHeader.SetDestinationPort (m_endPoint->GetPeerPort ());
   tcpHeader.SetFlags (flags);
   tcpHeader.SetWindowSize (AdvertisedWindowSize ());
+  AddOptions (tcpHeader);
 
   m_tcp->SendPacket (p, tcpHeader, m_endPoint->GetLocalAddress (),
                      m_endPoint->GetPeerAddress (), m_boundnetdevice);
 }
 
+/** Add the options of an outgoing segment: the SACK-permitted and timestamp
+    options are offered in a SYN and accepted in a SYN+ACK, then the timestamp
+    and SACK options are sent once agreed on. */
+void
+TcpSocketBase::AddOptions (TcpHeader& tcpHeader)
+{
+  uint8_t flags = tcpHeader.GetFlags ();
+  if (flags & TcpHeader::SYN)
+    {
+      bool isAck = flags & TcpHeader::ACK;
+      if (isAck ? m_ecnPermitted : m_ecnEnabled)
+        { // ECN-setup SYN or SYN+ACK (RFC 3168 sec.6.1.1)
+          tcpHeader.SetFlags (flags | (isAck ? TcpHeader::ECE : TcpHeader::ECE | TcpHeader::CWR));
+        }
+      if (isAck ? m_sackPermitted : m_sackEnabled)
+        {
+          tcpHeader.AppendOption (TcpOptionSackPermitted ());
+        }
+      if (isAck ? m_timestampPermitted : m_timestampEnabled)
+        {
+          TcpOptionTimestamp ts;
+          ts.SetTimestamp (TimestampNow (), isAck ? m_tsRecent : 0);
+          tcpHeader.AppendOption (ts);
+        }
+      return;
+    }
+  if (flags & TcpHeader::ACK)
+    {
+      m_lastAckSent = tcpHeader.GetAckNumber ();
+      if (m_ecnEcho)
+        {
+          tcpHeader.SetFlags (tcpHeader.GetFlags () | TcpHeader::ECE);
+        }
+    }
+  if (m_timestampPermitted)
+    {
+      TcpOptionTimestamp ts;
+      ts.SetTimestamp (TimestampNow (), m_tsRecent);
+      tcpHeader.AppendOption (ts);
+    }
+  if (m_sackPermitted && (flags & TcpHeader::ACK))
+    {
+      TcpRxBuffer::SackList blocks = m_rxBuffer.GetSackList ();
+      // Report as many blocks as the option space left allows
+      for (uint32_t n = std::min<uint32_t> (blocks.size (), 4); n > 0; --n)
+        {
+          TcpOptionSack sack;
+          for (uint32_t i = 0; i < n; ++i)
+            {
+              sack.AddSackBlock (blocks[i]);
+            }
+          if (tcpHeader.AppendOption (sack))
+            {
+              break;
+            }
+        }
+    }
+}
+
+/** Read the options of an incoming segment, before it is processed */
+void
+TcpSocketBase::ReadOptions (const TcpHeader& tcpHeader)
+{
+  uint8_t flags = tcpHeader.GetFlags ();
+  TcpOptionTimestamp ts;
+  bool hasTimestamp = tcpHeader.GetOption (ts);
+  if (flags & TcpHeader::SYN)
+    {
+      if (m_state != LISTEN && m_state != SYN_SENT && m_state != SYN_RCVD)
+        { // Duplicated SYN or SYN+ACK
+          return;
+        }
+      // An option is used only if both ends offered it. A listening socket
+      // keeps the outcome for the socket it forks.
+      m_sackPermitted = m_sackEnabled && tcpHeader.HasOption (TcpOption::SACK_PERMITTED);
+      m_timestampPermitted = m_timestampEnabled && hasTimestamp;
+      m_tsRecent = m_timestampPermitted ? ts.GetTimestamp () : 0;
+      // ECE and CWR in a SYN, ECE alone in a SYN+ACK
+      bool ece = flags & TcpHeader::ECE;
+      bool cwr = flags & TcpHeader::CWR;
+      m_ecnPermitted = m_ecnEnabled && ece && ((flags & TcpHeader::ACK) ? !cwr : cwr);
+      m_ecnEcho = false;
+      return;
+    }
+  if (m_timestampPermitted && hasTimestamp && tcpHeader.GetSequenceNumber () <= m_lastAckSent)
+    { // Echo the clock of the oldest segment not yet acknowledged (RFC 7323 sec.4.3)
+      m_tsRecent = ts.GetTimestamp ();
+    }
+}
+
+/** Called for every segment received once ECN is agreed on, with whether
+    it was marked Congestion Experienced. The receiver sets ECE on its ACKs
+    from a CE mark until the sender confirms with CWR (RFC 3168 sec.6.1.3). */
+void
+TcpSocketBase::ReceivedEcn (const TcpHeader& tcpHeader, bool ce)
+{
+  if (tcpHeader.GetFlags () & TcpHeader::CWR)
+    {
+      m_ecnEcho = false;
+    }
+  if (ce)
+    {
+      NS_LOG_LOGIC (this << " received CE on seq " << tcpHeader.GetSequenceNumber ());
+      m_ecnEcho = true;
+    }
+}
+
+/** Called for every ACK received once ECN is agreed on, before it is
+    processed. The reaction to ECE belongs to the congestion control, which
+    sets m_ecnCwr once it reduced its window. */
+void
+TcpSocketBase::ReceivedEcnEcho (const TcpHeader& tcpHeader)
+{
+}
+
+/** Size of the largest segment which may start at the given sequence
+    number. Subclasses which map the sequence space onto another one use
+    it to keep segments from spanning two mappings. */
+uint32_t
+TcpSocketBase::SegmentSizeAt (SequenceNumber32 seq)
+{
+  return m_segmentSize;
+}
+
+/** Merge the SACK blocks of an ACK into the scoreboard, and forget the
+    ranges below its cumulative ACK */
+void
+TcpSocketBase::UpdateSackScoreboard (const TcpHeader& tcpHeader)
+{
+  SequenceNumber32 ack = tcpHeader.GetAckNumber ();
+  while (!m_sackBoard.empty () && m_sackBoard.begin ()->first < ack)
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sackBoard.begin ();
+      SequenceNumber32 end = i->second;
+      m_sackedBytes -= end - i->first;
+      m_sackBoard.erase (i);
+      if (end > ack)
+        {
+          m_sackBoard[ack] = end;
+          m_sackedBytes += end - ack;
+          break;
+        }
+    }
+  TcpOptionSack sack;
+  if (!tcpHeader.GetOption (sack))
+    {
+      return;
+    }
+  const TcpOptionSack::SackList& blocks = sack.GetSackList ();
+  for (TcpOptionSack::SackList::const_iterator b = blocks.begin (); b != blocks.end (); ++b)
+    {
+      SequenceNumber32 first = std::max (b->first, ack);
+      SequenceNumber32 second = std::min (b->second, m_highTxMark.Get ());
+      if (second <= first)
+        { // Nothing new, or a bogus block
+          continue;
+        }
+      // Absorb the ranges the block overlaps or touches
+      std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_sackBoard.upper_bound (first);
+      if (i != m_sackBoard.begin ())
+        {
+          --i;
+          if (i->second < first)
+            {
+              ++i;
+            }
+        }
+      while (i != m_sackBoard.end () && i->first <= second)
+        {
+          first = std::min (first, i->first);
+          second = std::max (second, i->second);
+          m_sackedBytes -= i->second - i->first;
+          m_sackBoard.erase (i++);
+        }
+      m_sackBoard[first] = second;
+      m_sackedBytes += second - first;
+    }
+}
+
+uint32_t
+TcpSocketBase::SackedBytes (void) const
+{
+  return m_sackedBytes;
+}
+
+/** Find the first range of data from seq onwards which was not SACKed
+    although data above it was. Returns false if there is none. */
+bool
+TcpSocketBase::NextSackHole (SequenceNumber32 from, SequenceNumber32& hole, uint32_t& length) const
+{
+  hole = std::max (from, m_txBuffer.HeadSequence ());
+  for (std::map<SequenceNumber32, SequenceNumber32>::const_iterator i = m_sackBoard.begin ();
+       i != m_sackBoard.end (); ++i)
+    {
+      if (hole < i->first)
+        {
+          length = i->first - hole;
+          return true;
+        }
+      hole = std::max (hole, i->second);
+    }
+  return false;
+}
+
+/** The timestamp clock ticks every microsecond and wraps around */
+uint32_t
+TcpSocketBase::TimestampNow (void) const
+{
+  return static_cast<uint32_t> (Simulator::Now ().GetMicroSeconds ());
+}
+
 void
 TcpSocketBase::CancelAllTimers ()
 {
@@ -1645,6 +2174,8 @@ TcpSocketBase::CancelAllTimers ()
   m_persistEvent.Cancel ();
   m_delAckEvent.Cancel ();
   m_lastAckEvent.Cancel ();
+  m_pacingEvent.Cancel ();
+  m_timeWaitEvent.Cancel ();
 }
 
 /** Below are the attribute get/set functions */
@@ -1661,6 +2192,32 @@ TcpSocketBase::GetSndBufSize (void) const
   return m_txBuffer.MaxBufferSize ();
 }
 
+void
+TcpSocketBase::SetTxBufferStorage (TcpTxBuffer::StorageMode mode)
+{
+  NS_ABORT_MSG_UNLESS (m_txBuffer.Size () == 0, "Cannot change buffer storage with data in the buffer.");
+  m_txBuffer.SetStorageMode (mode);
+}
+
+TcpTxBuffer::StorageMode
+TcpSocketBase::GetTxBufferStorage (void) const
+{
+  return m_txBuffer.GetStorageMode ();
+}
+
+void
+TcpSocketBase::SetRxBufferStorage (TcpRxBuffer::StorageMode mode)
+{
+  NS_ABORT_MSG_UNLESS (m_rxBuffer.Size () == 0, "Cannot change buffer storage with data in the buffer.");
+  m_rxBuffer.SetStorageMode (mode);
+}
+
+TcpRxBuffer::StorageMode
+TcpSocketBase::GetRxBufferStorage (void) const
+{
+  return m_rxBuffer.GetStorageMode ();
+}
+
 void
 TcpSocketBase::SetRcvBufSize (uint32_t size)
 {
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <queue>
+#include <map>
 #include "ns3/callback.h"
 #include "ns3/traced-value.h"
 #include "ns3/tcp-socket.h"
@@ -30,6 +31,7 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -119,6 +121,10 @@ protected:
   virtual Time     GetPersistTimeout (void) const;
   virtual bool     SetAllowBroadcast (bool allowBroadcast);
   virtual bool     GetAllowBroadcast () const;
+  void             SetTxBufferStorage (TcpTxBuffer::StorageMode mode);
+  TcpTxBuffer::StorageMode GetTxBufferStorage (void) const;
+  void             SetRxBufferStorage (TcpRxBuffer::StorageMode mode);
+  TcpRxBuffer::StorageMode GetRxBufferStorage (void) const;
 
   // Helper functions: Connection set up
   int SetupCallback (void);        // Common part of the two Bind(), i.e. set callback and remembering local addr:port
@@ -130,6 +136,12 @@ protected:
   // Helper functions: Transfer operation
   void ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> incomingInterface); //Get a pkt from L3
   bool SendPendingData (bool withAck = false); // Send as much as the window allows
+  uint32_t SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool withAck,
+                           const TcpHeader* batchHeader = 0); // Send one data segment, return its size
+  void BuildDataHeader (TcpHeader& header, SequenceNumber32 seq, uint8_t flags); // Fill the header of a data segment
+  void UpdatePacingRate (void); // Compute the pacing rate from the window and the RTT
+  void ChargePacing (uint32_t size); // Delay the next paced segment by the time of one sent
+  void PacingTimeout (void); // Send the paced segments now due
   void SendEmptyPacket (uint8_t flags); // Send a empty packet that carries a flag, e.g. ACK
   void SendRST (void); // Send reset and tear down this socket
   bool OutOfRange (SequenceNumber32 s) const; // Check if a sequence number is within rx window
@@ -141,6 +153,7 @@ protected:
   void DeallocateEndPoint (void); // Deallocate m_endPoint
   void PeerClose (Ptr<Packet>, const TcpHeader&); // Received a FIN from peer, notify rx buffer
   void DoPeerClose (void); // FIN is in sequence, notify app and respond with a FIN
+  void TimeWait (void); // Move to TIME_WAIT, and to CLOSED once the TIME_WAIT timeout, if any, expires
   void CancelAllTimers (void); // Cancel all timer when endpoint is deleted
 
   // State transition functions
@@ -173,12 +186,32 @@ protected:
   virtual void PersistTimeout (void); // Send 1 byte probe to get an updated window size
   virtual void DoRetransmit (void); // Retransmit the oldest packet
 
+  // Options and segmentation
+  virtual void AddOptions (TcpHeader& tcpHeader); // Add the options and ECN flags of an outgoing segment
+  virtual void ReadOptions (const TcpHeader& tcpHeader); // Read the options of an incoming segment
+  virtual uint32_t SegmentSizeAt (SequenceNumber32 seq); // Largest segment allowed to start at seq
+  virtual bool SharedOptions (void) const; // Whether a batch of data segments can share their options
+
+  // SACK scoreboard of the sender
+  void UpdateSackScoreboard (const TcpHeader& tcpHeader); // Record the SACK blocks of an incoming ACK
+  uint32_t SackedBytes (void) const; // Number of bytes above the cumulative ACK reported by SACK
+  bool NextSackHole (SequenceNumber32 from, SequenceNumber32& hole, uint32_t& length) const; // First range not SACKed below a SACKed one
+  uint32_t TimestampNow (void) const; // Clock of the timestamp option
+
+  // Explicit congestion notification
+  virtual void ReceivedEcn (const TcpHeader& tcpHeader, bool ce); // Update the ECN-Echo state from an incoming segment
+  virtual void ReceivedEcnEcho (const TcpHeader& tcpHeader); // React to the ECN-Echo flag of an incoming ACK
+
 protected:
+  friend class TcpL4Protocol;
+
   // Counters and events
   EventId           m_retxEvent;       //< Retransmission event
   EventId           m_lastAckEvent;    //< Last ACK timeout event
   EventId           m_delAckEvent;     //< Delayed ACK timeout event
   EventId           m_persistEvent;    //< Persist event: Send 1 byte to probe for a non-zero Rx window
+  EventId           m_pacingEvent;     //< Pacing timer: no data segment is sent while it runs
+  EventId           m_timeWaitEvent;   //< TIME_WAIT timeout event
   uint32_t          m_dupAckCount;     //< Dupack counter
   uint32_t          m_delAckCount;     //< Delayed ACK counter
   uint32_t          m_delAckMaxCount;  //< Number of packet to fire an ACK before delay timeout
@@ -188,11 +221,13 @@ protected:
   Time              m_delAckTimeout;   //< Time to delay an ACK
   Time              m_persistTimeout;  //< Time between sending 1-byte probes
   Time              m_cnTimeout;       //< Timeout for connection retry
+  Time              m_timeWaitTimeout; //< Time spent in TIME_WAIT (2*MSL)
 
   // Connections to other layers of TCP/IP
   Ipv4EndPoint*       m_endPoint;
   Ptr<Node>           m_node;
   Ptr<TcpL4Protocol>  m_tcp;
+  uint32_t            m_socketIndex;   //< Index in the socket list of m_tcp
 
   // Round trip time estimation
   Ptr<RttEstimator> m_rtt;
@@ -215,6 +250,32 @@ protected:
   // Window management
   uint32_t              m_segmentSize; //< Segment size
   TracedValue<uint32_t> m_rWnd;        //< Flow control window at remote side
+
+  // Options
+  bool             m_sackEnabled;        //< SACK is offered to the peer
+  bool             m_timestampEnabled;   //< Timestamps are offered to the peer
+  bool             m_sackPermitted;      //< Both ends agreed on SACK
+  bool             m_timestampPermitted; //< Both ends agreed on timestamps
+  uint32_t         m_tsRecent;           //< Timestamp value to echo to the peer (TS.Recent)
+  SequenceNumber32 m_lastAckSent;        //< ACK number of the last segment sent (Last.ACK.sent)
+  std::map<SequenceNumber32, SequenceNumber32> m_sackBoard; //< SACKed ranges [first, second) above the cumulative ACK
+  uint32_t         m_sackedBytes;        //< Number of bytes in m_sackBoard
+
+  // Explicit congestion notification
+  bool             m_ecnEnabled;         //< ECN is offered to the peer
+  bool             m_ecnPermitted;       //< Both ends agreed on ECN
+  bool             m_ecnEcho;            //< Set ECE on the outgoing ACKs
+  bool             m_ecnCwr;             //< Set CWR on the next new data segment
+
+  bool             m_batchSend;          //< Send a window of segments per pass, with one notification
+
+  // Pacing
+  bool                  m_pacing;          //< Space the data segments at m_pacingRate
+  DataRate              m_fixedPacingRate; //< Pacing rate set by the user, zero to compute it
+  double                m_pacingGain;      //< Ratio of the computed rate to the window over the RTT
+  uint32_t              m_pacingMaxBurst;  //< Most segments sent back to back per pacing timeout
+  Time                  m_pacingNext;      //< Time the pacing credit allows the next new segment
+  TracedValue<DataRate> m_pacingRate;      //< Current pacing rate
 };
 
 } // namespace ns3
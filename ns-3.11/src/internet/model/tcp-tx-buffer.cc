@@ -51,7 +51,8 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0),
+    m_mode (PACKET_LIST), m_ringHead (0)
 {
 }
 
@@ -105,7 +106,14 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          if (m_mode == BYTE_RING)
+            {
+              AddToRing (p);
+            }
+          else
+            {
+              m_data.push_back (p);
+            }
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -136,6 +144,10 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     {
       return Create<Packet> (); // Empty packet returned
     }
+  if (m_mode == BYTE_RING && m_size > 0)
+    {
+      return CopyFromRing (seq - m_firstByteSeq.Get (), s);
+    }
   if (m_data.size () == 0)
     { // No actual data, just return dummy-data packet of correct size
       return Create<Packet> (s);
@@ -211,6 +223,23 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
+  if (m_mode == BYTE_RING)
+    { // Advance the ring head, the bytes behind it are simply forgotten
+      uint32_t offset = std::min<uint32_t> (m_size, seq - m_firstByteSeq.Get ());
+      if (offset > 0)
+        {
+          m_ringHead = (m_ringHead + offset) % m_ring.size ();
+          m_size -= offset;
+        }
+      if (m_size == 0)
+        {
+          m_ringHead = 0;
+        }
+      m_firstByteSeq = seq;
+      NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " ringHead=" << m_ringHead);
+      return;
+    }
+
   // Scan the buffer and discard packets
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
   uint32_t pktSize;
@@ -247,4 +276,85 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+void
+TcpTxBuffer::SetStorageMode (StorageMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  NS_ASSERT_MSG (m_size == 0, "Cannot change the storage of a non-empty buffer");
+  m_mode = mode;
+  m_data.clear ();
+  m_ring.clear ();
+  m_ringHead = 0;
+}
+
+TcpTxBuffer::StorageMode
+TcpTxBuffer::GetStorageMode (void) const
+{
+  return m_mode;
+}
+
+void
+TcpTxBuffer::GrowRing (uint32_t needed)
+{
+  NS_LOG_FUNCTION (this << needed);
+  // Double the capacity so that a buffer filled by small writes is
+  // relinearized only a logarithmic number of times
+  uint32_t capacity = std::max<uint32_t> (m_ring.size (), 2048);
+  while (capacity < needed)
+    {
+      capacity *= 2;
+    }
+  std::vector<uint8_t> ring (capacity);
+  uint32_t first = std::min<uint32_t> (m_size, m_ring.size () - m_ringHead);
+  if (first > 0)
+    {
+      memcpy (&ring[0], &m_ring[m_ringHead], first);
+    }
+  if (m_size > first)
+    {
+      memcpy (&ring[first], &m_ring[0], m_size - first);
+    }
+  m_ring.swap (ring);
+  m_ringHead = 0;
+  NS_LOG_LOGIC ("Ring capacity is now " << capacity);
+}
+
+void
+TcpTxBuffer::AddToRing (Ptr<Packet> p)
+{
+  uint32_t n = p->GetSize ();
+  if (m_size + n > m_ring.size ())
+    {
+      GrowRing (m_size + n);
+    }
+  uint32_t tail = (m_ringHead + m_size) % m_ring.size ();
+  uint32_t first = m_ring.size () - tail;
+  if (n <= first)
+    {
+      p->CopyData (&m_ring[tail], n);
+      return;
+    }
+  // The data wraps around the end of the ring
+  m_scratch.resize (n);
+  p->CopyData (&m_scratch[0], n);
+  memcpy (&m_ring[tail], &m_scratch[0], first);
+  memcpy (&m_ring[0], &m_scratch[first], n - first);
+}
+
+Ptr<Packet>
+TcpTxBuffer::CopyFromRing (uint32_t offset, uint32_t numBytes)
+{
+  NS_ASSERT_MSG (offset + numBytes <= m_size, "Requested data is not in the buffer");
+  uint32_t start = (m_ringHead + offset) % m_ring.size ();
+  uint32_t first = m_ring.size () - start;
+  if (numBytes <= first)
+    {
+      return Create<Packet> (&m_ring[start], numBytes);
+    }
+  m_scratch.resize (numBytes);
+  memcpy (&m_scratch[0], &m_ring[start], first);
+  memcpy (&m_scratch[first], &m_ring[0], numBytes - first);
+  return Create<Packet> (&m_scratch[0], numBytes);
+}
+
 } // namepsace ns3
@@ -22,6 +22,7 @@
 #define __TCP_TX_BUFFER_H__
 
 #include <list>
+#include <vector>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,11 +37,30 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * Two storage schemes are available. The default one keeps the packets handed
+ * over by the application in a list, and builds each segment by fragmenting
+ * and concatenating them, so that the packet metadata and byte tags of the
+ * application data travel along with the segments. The byte ring scheme
+ * copies the application data into a contiguous circular byte store; a
+ * segment is then located in constant time and handed out as a single packet
+ * created from the stored bytes, at the price of losing the metadata and
+ * byte tags of the original packets.
  */
 class TcpTxBuffer : public Object
 {
 public:
   static TypeId GetTypeId (void);
+
+  /**
+   * \brief Storage schemes of the buffered data
+   */
+  enum StorageMode
+  {
+    PACKET_LIST,  /**< list of the application packets */
+    BYTE_RING     /**< circular store of the application bytes */
+  };
+
   TcpTxBuffer (uint32_t n = 0);
   virtual ~TcpTxBuffer (void);
 
@@ -107,13 +127,33 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * Select the storage scheme. The buffer must be empty.
+   *
+   * \param mode The storage scheme to use for subsequent data
+   */
+  void SetStorageMode (StorageMode mode);
+
+  /**
+   * Returns the storage scheme in use
+   */
+  StorageMode GetStorageMode (void) const;
+
 private:
   typedef std::list<Ptr<Packet> >::iterator BufIterator;
 
+  void AddToRing (Ptr<Packet> p);
+  Ptr<Packet> CopyFromRing (uint32_t offset, uint32_t numBytes);
+  void GrowRing (uint32_t needed);
+
   TracedValue<SequenceNumber32> m_firstByteSeq; //< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //< Number of data bytes
   uint32_t m_maxBuffer;                         //< Max number of data bytes in buffer (SND.WND)
   std::list<Ptr<Packet> > m_data;               //< Corresponding data (may be null)
+  StorageMode m_mode;                           //< Storage scheme in use
+  std::vector<uint8_t> m_ring;                  //< Circular byte store (BYTE_RING mode)
+  uint32_t m_ringHead;                          //< Offset of m_firstByteSeq in m_ring
+  std::vector<uint8_t> m_scratch;               //< Staging area for data crossing the end of m_ring
 };
 
 } // namepsace ns3
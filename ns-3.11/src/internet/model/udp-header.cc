@@ -19,7 +19,7 @@
  */
 
 #include "udp-header.h"
-#include "ns3/address-utils.h"
+#include "ns3/checksum.h"
 
 namespace ns3 {
 
@@ -82,20 +82,17 @@ UdpHeader::InitializeChecksum (Ipv4Address source,
 uint16_t
 UdpHeader::CalculateHeaderChecksum (uint16_t size) const
 {
-  Buffer buf = Buffer (12);
-  buf.AddAtStart (12);
-  Buffer::Iterator it = buf.Begin ();
+  uint8_t buf[12];
 
-  WriteTo (it, m_source);
-  WriteTo (it, m_destination);
-  it.WriteU8 (0); /* protocol */
-  it.WriteU8 (m_protocol); /* protocol */
-  it.WriteU8 (size >> 8); /* length */
-  it.WriteU8 (size & 0xff); /* length */
+  m_source.Serialize (buf);
+  m_destination.Serialize (buf + 4);
+  buf[8] = 0; /* protocol */
+  buf[9] = m_protocol; /* protocol */
+  buf[10] = size >> 8; /* length */
+  buf[11] = size & 0xff; /* length */
 
-  it = buf.Begin ();
   /* we don't CompleteChecksum ( ~ ) now */
-  return ~(it.CalculateIpChecksum (12));
+  return OnesComplementSum (buf, 12);
 }
 
 bool
@@ -32,6 +32,8 @@
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ipv4-l3-protocol.h"
+#include "ipv4-flow-ports-tag.h"
+#include "ipv4-global-routing.h"
 #include "udp-socket-impl.h"
 
 NS_LOG_COMPONENT_DEFINE ("UdpL4Protocol");
@@ -272,6 +274,11 @@ UdpL4Protocol::Send (Ptr<Packet> packet,
   udpHeader.SetSourcePort (sport);
 
   packet->AddHeader (udpHeader);
+  if (Ipv4GlobalRouting::IsFlowHashEnabled ())
+    {
+      // Ipv4L3Protocol routes the packet
+      packet->AddPacketTag (Ipv4FlowPortsTag (sport, dport));
+    }
 
   m_downTarget (packet, saddr, daddr, PROT_NUMBER, 0);
 }
@@ -295,6 +302,11 @@ UdpL4Protocol::Send (Ptr<Packet> packet,
   udpHeader.SetSourcePort (sport);
 
   packet->AddHeader (udpHeader);
+  if (route == 0 && Ipv4GlobalRouting::IsFlowHashEnabled ())
+    {
+      // Ipv4L3Protocol routes the packet
+      packet->AddPacketTag (Ipv4FlowPortsTag (sport, dport));
+    }
 
   m_downTarget (packet, saddr, daddr, PROT_NUMBER, route);
 }
@@ -28,6 +28,8 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/ipv4-packet-info-tag.h"
+#include "ipv4-flow-ports-tag.h"
+#include "ipv4-global-routing.h"
 #include "udp-socket-impl.h"
 #include "udp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -440,7 +442,19 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port)
       Ptr<Ipv4Route> route;
       Ptr<NetDevice> oif = m_boundnetdevice; //specify non-zero if bound to a specific device
       // TBD-- we could cache the route and just check its validity
-      route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_); 
+      if (Ipv4GlobalRouting::IsFlowHashEnabled ())
+        {
+          // The packet has no UDP header yet: tell the routing protocol
+          // the ports of its flow.
+          Ipv4FlowPortsTag portsTag (m_endPoint->GetLocalPort (), port);
+          p->AddPacketTag (portsTag);
+          route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_);
+          p->RemovePacketTag (portsTag);
+        }
+      else
+        {
+          route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_);
+        }
       if (route != 0)
         {
           NS_LOG_LOGIC ("Route exists");
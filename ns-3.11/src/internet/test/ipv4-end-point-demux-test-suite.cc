@@ -0,0 +1,138 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/loopback-net-device.h"
+#include "ns3/node.h"
+
+namespace ns3 {
+
+class Ipv4EndPointDemuxLookupTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxLookupTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxLookupTestCase::Ipv4EndPointDemuxLookupTestCase ()
+  : TestCase ("Check that the most specific endpoint is found")
+{
+}
+
+void
+Ipv4EndPointDemuxLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  Ptr<LoopbackNetDevice> device = CreateObject<LoopbackNetDevice> ();
+  node->AddDevice (device);
+  interface->SetDevice (device);
+  interface->SetNode (node);
+  interface->AddAddress (Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+
+  Ipv4EndPointDemux demux;
+  Ipv4Address local ("10.0.0.1");
+  Ipv4EndPoint *listener = demux.Allocate (80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listening endpoint not allocated");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (80), 0, "Duplicate port should not be allocated");
+  Ipv4EndPoint *bound = demux.Allocate (local, 80);
+  NS_TEST_ASSERT_MSG_NE (bound, 0, "Bound endpoint not allocated");
+
+  // a thousand accepted connections on the listening port
+  for (uint16_t peerPort = 1000; peerPort < 2000; peerPort++)
+    {
+      NS_TEST_ASSERT_MSG_NE (demux.Allocate (local, 80, "10.0.0.2", peerPort), 0, "Connection not allocated");
+    }
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80, "10.0.0.2", 1500), 0, "Duplicate connection should not be allocated");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 1002, "Wrong number of endpoints");
+
+  Ipv4EndPoint *found = demux.LookupBest (local, 80, "10.0.0.2", 1500, interface);
+  NS_TEST_ASSERT_MSG_NE (found, 0, "Connection not found");
+  NS_TEST_ASSERT_MSG_EQ (found->GetPeerPort (), 1500, "Wrong connection found");
+  NS_TEST_ASSERT_MSG_EQ (found->GetLocalAddress (), local, "Wrong connection found");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 80, "10.0.0.2", 1500, interface).size (), 1, "One exact match expected");
+
+  // an unknown peer falls back on the bound endpoint, then the wildcard one
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, "10.0.0.3", 1500, interface), bound, "Bound endpoint expected");
+  demux.DeAllocate (bound);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, "10.0.0.3", 1500, interface), listener, "Listening endpoint expected");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 81, "10.0.0.3", 1500, interface), 0, "No endpoint expected");
+
+  // an endpoint connected after allocation is found by its four-tuple
+  Ipv4EndPoint *client = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_EQ (client->GetLocalPort (), 49153, "First ephemeral port expected");
+  client->SetPeer ("10.0.0.9", 5000);
+  client->SetLocalAddress (local);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 49153, "10.0.0.9", 5000, interface), client, "Connected client not found");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 49153, "10.0.0.8", 5000, interface), 0, "Other peer should not match");
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, 49153, "10.0.0.9", 5000), client, "SimpleLookup should find the client");
+  Simulator::Destroy ();
+}
+
+class Ipv4EndPointDemuxEphemeralTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxEphemeralTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxEphemeralTestCase::Ipv4EndPointDemuxEphemeralTestCase ()
+  : TestCase ("Check the ephemeral port allocation order")
+{
+}
+
+void
+Ipv4EndPointDemuxEphemeralTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  std::vector<Ipv4EndPoint *> endPoints;
+  // Ports 49153 to 65534 are handed out in order, then 49152
+  for (uint32_t port = 49153; port <= 65534; port++)
+    {
+      Ipv4EndPoint *endPoint = demux.Allocate ();
+      NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Port " << port << " not allocated");
+      NS_TEST_ASSERT_MSG_EQ (endPoint->GetLocalPort (), port, "Unexpected port");
+      endPoints.push_back (endPoint);
+    }
+  Ipv4EndPoint *last = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_EQ (last->GetLocalPort (), 49152, "Port 49152 expected last");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (), 0, "All ephemeral ports should be in use");
+
+  // The lowest released port is reused first
+  demux.DeAllocate (endPoints[1000]);
+  demux.DeAllocate (endPoints[100]);
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49253, "Lowest free port expected");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 50153, "Next free port expected");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (50153), true, "Port should be in use");
+}
+
+static class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ()
+    : TestSuite ("ipv4-end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxLookupTestCase ());
+    AddTestCase (new Ipv4EndPointDemuxEphemeralTestCase ());
+  }
+} g_ipv4EndPointDemuxTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,401 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/random-variable.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4.h"
+#include "ns3/tcp-header.h"
+#include "ns3/udp-header.h"
+#include "ns3/ipv4-flow-ports-tag.h"
+#include "ns3/packet.h"
+#include <set>
+
+namespace ns3 {
+
+/**
+ * Build a node with an IPv4 stack and three interfaces, 192.168.{1,2,3}.1
+ */
+static Ptr<Ipv4>
+CreateIpv4Node (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ((192 << 24) | (168 << 16) | (i << 8) | 1),
+                                                         Ipv4Mask ("255.255.255.0")));
+      ipv4->SetUp (interface);
+    }
+  return ipv4;
+}
+
+static Ptr<Ipv4Route>
+Lookup (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  return routing->RouteOutput (0, header, 0, sockerr);
+}
+
+class Ipv4GlobalRoutingFibPrecedenceTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFibPrecedenceTestCase (bool useCompiledFib);
+  virtual void DoRun (void);
+private:
+  bool m_useCompiledFib;
+};
+
+Ipv4GlobalRoutingFibPrecedenceTestCase::Ipv4GlobalRoutingFibPrecedenceTestCase (bool useCompiledFib)
+  : TestCase (useCompiledFib ? "Check route class precedence and longest prefix match in the compiled table"
+              : "Check route class precedence and longest prefix match in the route lists"),
+    m_useCompiledFib (useCompiledFib)
+{
+}
+
+void
+Ipv4GlobalRoutingFibPrecedenceTestCase::DoRun (void)
+{
+  Ptr<Ipv4> ipv4 = CreateIpv4Node ();
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetAttribute ("UseCompiledFib", BooleanValue (m_useCompiledFib));
+  routing->SetIpv4 (ipv4);
+
+  routing->AddASExternalRouteTo ("0.0.0.0", "0.0.0.0", "192.168.1.2", 1);
+  routing->AddASExternalRouteTo ("10.1.1.0", "255.255.255.0", "192.168.3.2", 3);
+  routing->AddASExternalRouteTo ("172.16.0.0", "255.255.0.0", "192.168.2.2", 2);
+  routing->AddASExternalRouteTo ("172.16.0.0", "255.255.0.0", "192.168.3.2", 3);
+  routing->AddNetworkRouteTo ("10.0.0.0", "255.0.0.0", "192.168.3.2", 3);
+  routing->AddNetworkRouteTo ("10.1.0.0", "255.255.0.0", "192.168.2.2", 2);
+  routing->AddNetworkRouteTo ("10.1.1.0", "255.255.255.0", "192.168.1.2", 1);
+  routing->AddNetworkRouteTo ("10.1.1.0", "255.255.255.0", "192.168.3.2", 3);
+  routing->AddNetworkRouteTo ("10.1.1.128", "255.255.255.128", "192.168.2.2", 2);
+  routing->AddHostRouteTo ("10.1.1.5", "192.168.2.2", 2);
+  routing->CompileFib ();
+
+  Ptr<Ipv4Route> route = Lookup (routing, "10.1.1.5");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.2.2"), "Host route should win");
+  route = Lookup (routing, "10.1.1.7");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.1.2"), "First equal-cost /24 route should be used");
+  NS_TEST_ASSERT_MSG_EQ (route->GetSource (), Ipv4Address ("192.168.1.1"), "Source should be the interface address");
+  route = Lookup (routing, "10.1.1.200");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.2.2"), "/25 should win over /24");
+  route = Lookup (routing, "10.1.2.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.2.2"), "/16 should win over /8");
+  route = Lookup (routing, "10.200.0.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.3.2"), "/8 should match");
+  route = Lookup (routing, "11.0.0.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.1.2"), "External default route should match");
+  route = Lookup (routing, "172.16.0.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.2.2"), "First external /16 should win over the default");
+
+  if (m_useCompiledFib)
+    {
+      // The routes are shared by every lookup that takes them
+      NS_TEST_ASSERT_MSG_EQ (PeekPointer (Lookup (routing, "10.1.1.7")), PeekPointer (Lookup (routing, "10.1.1.9")),
+                             "Lookups for one prefix should return the same route");
+    }
+
+  // A route added after compilation is seen by the next lookup
+  routing->AddHostRouteTo ("10.200.0.1", "192.168.1.2", 1);
+  route = Lookup (routing, "10.200.0.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("192.168.1.2"), "New host route should be used");
+
+  // Removing every route leaves nothing to match
+  while (routing->GetNRoutes () > 0)
+    {
+      routing->RemoveRoute (0);
+    }
+  NS_TEST_ASSERT_MSG_EQ (Lookup (routing, "10.1.1.5"), 0, "No route should be found");
+
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingFibEquivalenceTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFibEquivalenceTestCase ();
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingFibEquivalenceTestCase::Ipv4GlobalRoutingFibEquivalenceTestCase ()
+  : TestCase ("Check that the compiled table matches the route list lookup")
+{
+}
+
+void
+Ipv4GlobalRoutingFibEquivalenceTestCase::DoRun (void)
+{
+  Ptr<Ipv4> ipv4 = CreateIpv4Node ();
+  Ptr<Ipv4GlobalRouting> compiled = CreateObject<Ipv4GlobalRouting> ();
+  compiled->SetIpv4 (ipv4);
+  Ptr<Ipv4GlobalRouting> list = CreateObject<Ipv4GlobalRouting> ();
+  list->SetAttribute ("UseCompiledFib", BooleanValue (false));
+  list->SetIpv4 (ipv4);
+
+  // A fat-tree like table: a /24 per edge switch with two equal-cost
+  // uplinks, plus host routes for the directly attached servers.
+  Ptr<Ipv4GlobalRouting> routings[2] = { compiled, list };
+  for (uint32_t r = 0; r < 2; r++)
+    {
+      for (uint32_t pod = 0; pod < 16; pod++)
+        {
+          for (uint32_t edge = 0; edge < 32; edge++)
+            {
+              Ipv4Address network ((10 << 24) | (pod << 16) | (edge << 8));
+              routings[r]->AddNetworkRouteTo (network, "255.255.255.0", "192.168.1.2", 1);
+              routings[r]->AddNetworkRouteTo (network, "255.255.255.0", "192.168.2.2", 2);
+            }
+        }
+      for (uint32_t host = 2; host < 10; host++)
+        {
+          routings[r]->AddHostRouteTo (Ipv4Address ((10 << 24) | (3 << 16) | (7 << 8) | host), 3);
+        }
+    }
+  compiled->CompileFib ();
+
+  UniformVariable rand;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      Ipv4Address dest ((10 << 24) | rand.GetInteger (0, 20) << 16 | rand.GetInteger (0, 40) << 8 | rand.GetInteger (0, 15));
+      Ptr<Ipv4Route> expected = Lookup (list, dest);
+      Ptr<Ipv4Route> found = Lookup (compiled, dest);
+      if (expected == 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found, 0, "No route expected for " << dest);
+          continue;
+        }
+      NS_TEST_ASSERT_MSG_NE (found, 0, "Route expected for " << dest);
+      NS_TEST_ASSERT_MSG_EQ (found->GetGateway (), expected->GetGateway (), "Gateway mismatch for " << dest);
+      NS_TEST_ASSERT_MSG_EQ (found->GetSource (), expected->GetSource (), "Source mismatch for " << dest);
+      NS_TEST_ASSERT_MSG_EQ (found->GetOutputDevice (), expected->GetOutputDevice (), "Device mismatch for " << dest);
+    }
+
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpTestCase ();
+  virtual void DoRun (void);
+private:
+  Ptr<Ipv4GlobalRouting> CreateRouting (Ptr<Ipv4> ipv4, Ipv4GlobalRouting::EcmpMode mode, uint32_t seed);
+  Ipv4Address LookupFlow (Ptr<Ipv4GlobalRouting> routing, uint16_t sourcePort);
+  Ipv4Address ForwardFlow (Ptr<Ipv4GlobalRouting> routing, Ptr<NetDevice> idev, uint16_t sourcePort);
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+  void CheckFlowlet (Ptr<Ipv4GlobalRouting> routing, bool newFlowlet);
+  std::set<Ipv4Address> m_flowletGateways;
+  Ipv4Address m_lastGateway;
+  Ipv4Address m_forwardGateway;
+};
+
+Ipv4GlobalRoutingEcmpTestCase::Ipv4GlobalRoutingEcmpTestCase ()
+  : TestCase ("Check the flow hash and flowlet ECMP modes")
+{
+}
+
+Ptr<Ipv4GlobalRouting>
+Ipv4GlobalRoutingEcmpTestCase::CreateRouting (Ptr<Ipv4> ipv4, Ipv4GlobalRouting::EcmpMode mode, uint32_t seed)
+{
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetAttribute ("EcmpMode", EnumValue (mode));
+  routing->SetAttribute ("EcmpHashSeed", UintegerValue (seed));
+  routing->SetIpv4 (ipv4);
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      routing->AddNetworkRouteTo ("10.1.0.0", "255.255.0.0", Ipv4Address ((192 << 24) | (168 << 16) | (i << 8) | 2), i);
+    }
+  return routing;
+}
+
+Ipv4Address
+Ipv4GlobalRoutingEcmpTestCase::LookupFlow (Ptr<Ipv4GlobalRouting> routing, uint16_t sourcePort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  TcpHeader tcpHeader;
+  tcpHeader.SetSourcePort (sourcePort);
+  tcpHeader.SetDestinationPort (80);
+  p->AddHeader (tcpHeader);
+  // as TcpL4Protocol does, tell the routing the ports of the flow
+  p->AddPacketTag (Ipv4FlowPortsTag (sourcePort, 80));
+  Ipv4Header header;
+  header.SetDestination ("10.1.2.3");
+  header.SetProtocol (6);
+  Socket::SocketErrno sockerr;
+  return routing->RouteOutput (p, header, 0, sockerr)->GetGateway ();
+}
+
+Ipv4Address
+Ipv4GlobalRoutingEcmpTestCase::ForwardFlow (Ptr<Ipv4GlobalRouting> routing, Ptr<NetDevice> idev, uint16_t sourcePort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (sourcePort);
+  udpHeader.SetDestinationPort (80);
+  p->AddHeader (udpHeader);
+  Ipv4Header header;
+  header.SetSource ("10.2.0.1");
+  header.SetDestination ("10.1.2.3");
+  header.SetProtocol (17);
+  m_forwardGateway = Ipv4Address ();
+  routing->RouteInput (p, header, idev,
+                       MakeCallback (&Ipv4GlobalRoutingEcmpTestCase::Forward, this),
+                       MakeNullCallback<void, Ptr<Ipv4MulticastRoute>, Ptr<const Packet>, const Ipv4Header &> (),
+                       MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header &, uint32_t> (),
+                       MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno> ());
+  return m_forwardGateway;
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::Forward (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  m_forwardGateway = route->GetGateway ();
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::CheckFlowlet (Ptr<Ipv4GlobalRouting> routing, bool newFlowlet)
+{
+  Ipv4Address gateway = LookupFlow (routing, 5000);
+  if (!newFlowlet)
+    {
+      NS_TEST_EXPECT_MSG_EQ (gateway, m_lastGateway, "Flowlet moved within the inactivity gap");
+    }
+  m_lastGateway = gateway;
+  m_flowletGateways.insert (gateway);
+}
+
+void
+Ipv4GlobalRoutingEcmpTestCase::DoRun (void)
+{
+  Ptr<Ipv4> ipv4 = CreateIpv4Node ();
+
+  // The transports tag their packets with the ports only for a hashing mode
+  Ptr<Ipv4GlobalRouting> random = CreateRouting (ipv4, Ipv4GlobalRouting::ECMP_PER_PACKET_RANDOM, 1);
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRouting::IsFlowHashEnabled (), false, "No router hashes the flows");
+  random->SetAttribute ("EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_FLOW_HASH));
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRouting::IsFlowHashEnabled (), true, "A router hashes the flows");
+  random->SetAttribute ("EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_NONE));
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRouting::IsFlowHashEnabled (), false, "No router hashes the flows any more");
+
+  // A flow always takes the same next hop, and flows spread over all of them
+  Ptr<Ipv4GlobalRouting> hash = CreateRouting (ipv4, Ipv4GlobalRouting::ECMP_FLOW_HASH, 1);
+  std::set<Ipv4Address> gateways;
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      Ipv4Address gateway = LookupFlow (hash, port);
+      gateways.insert (gateway);
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (LookupFlow (hash, port), gateway, "Flow " << port << " changed next hop");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (gateways.size (), 3, "64 flows should use all three next hops");
+
+  // Another seed maps the flows differently
+  Ptr<Ipv4GlobalRouting> reseeded = CreateRouting (ipv4, Ipv4GlobalRouting::ECMP_FLOW_HASH, 2);
+  uint32_t moved = 0;
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      if (LookupFlow (hash, port) != LookupFlow (reseeded, port))
+        {
+          moved++;
+        }
+    }
+  NS_TEST_ASSERT_MSG_GT (moved, 0, "Changing the seed should move some flows");
+
+  // A UDP packet routed without its header and tagged with its ports by
+  // the sending host takes the same next hop as the same packet
+  // forwarded by a router which reads its UDP header.
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      Ptr<Packet> p = Create<Packet> (100);
+      p->AddPacketTag (Ipv4FlowPortsTag (port, 80));
+      Ipv4Header header;
+      header.SetSource ("10.2.0.1");
+      header.SetDestination ("10.1.2.3");
+      header.SetProtocol (17);
+      Socket::SocketErrno sockerr;
+      Ipv4Address gateway = hash->RouteOutput (p, header, 0, sockerr)->GetGateway ();
+      NS_TEST_ASSERT_MSG_EQ (ForwardFlow (hash, ipv4->GetNetDevice (1), port), gateway,
+                             "UDP flow " << port << " hashed differently when forwarded");
+    }
+
+  // Without the tag, RouteOutput does not read the payload, even if the
+  // protocol is TCP: a raw socket chooses what it sends.
+  std::set<Ipv4Address> rawGateways;
+  for (uint32_t i = 0; i < 64; i++)
+    {
+      uint8_t payload[4] = { uint8_t (i), uint8_t (i * 7), uint8_t (i * 13), uint8_t (i * 29) };
+      Ptr<Packet> p = Create<Packet> (payload, sizeof (payload));
+      Ipv4Header header;
+      header.SetDestination ("10.1.2.3");
+      header.SetProtocol (6);
+      Socket::SocketErrno sockerr;
+      rawGateways.insert (hash->RouteOutput (p, header, 0, sockerr)->GetGateway ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (rawGateways.size (), 1, "The payload of a packet without ports should not be hashed");
+
+  // A flowlet keeps its next hop while packets are closer than the
+  // inactivity gap; bursts separated by more than the gap are rehashed.
+  Ptr<Ipv4GlobalRouting> flowlet = CreateRouting (ipv4, Ipv4GlobalRouting::ECMP_FLOWLET_HASH, 1);
+  flowlet->SetAttribute ("FlowletTimeout", TimeValue (MicroSeconds (100)));
+  for (uint32_t burst = 0; burst < 32; burst++)
+    {
+      for (uint32_t packet = 0; packet < 10; packet++)
+        {
+          Simulator::Schedule (MicroSeconds (burst * 1000 + packet * 10),
+                               &Ipv4GlobalRoutingEcmpTestCase::CheckFlowlet, this, flowlet, packet == 0);
+        }
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_flowletGateways.size (), 3, "Flowlets should use all three next hops");
+
+  Simulator::Destroy ();
+}
+
+static class Ipv4GlobalRoutingTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingTestSuite ()
+    : TestSuite ("ipv4-global-routing", UNIT)
+  {
+    AddTestCase (new Ipv4GlobalRoutingFibPrecedenceTestCase (true));
+    AddTestCase (new Ipv4GlobalRoutingFibPrecedenceTestCase (false));
+    AddTestCase (new Ipv4GlobalRoutingFibEquivalenceTestCase ());
+    AddTestCase (new Ipv4GlobalRoutingEcmpTestCase ());
+  }
+} g_ipv4GlobalRoutingTestSuite;
+
+} // namespace ns3
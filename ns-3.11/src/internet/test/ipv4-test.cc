@@ -29,6 +29,20 @@
 #include "ns3/arp-l3-protocol.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/loopback-net-device.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/boolean.h"
+#include "ns3/global-value.h"
+#include "ns3/flow-id-tag.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -97,6 +111,182 @@ Ipv4L3ProtocolTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Forward UDP packets through a router, with and without its fast
+ * forwarding path: the packets must arrive the same, with a decremented
+ * TTL and a valid checksum, and the packets of the sender must not be
+ * touched by the router.  The sender tags the bytes of its IP header:
+ * only the fast path, which sends out the bytes received, keeps the tag
+ * on the header, and a sink on the UnicastForward trace must disable it.
+ */
+class Ipv4FastForwardingTestCase : public TestCase
+{
+public:
+  Ipv4FastForwardingTestCase ();
+private:
+  virtual void DoRun (void);
+  void Forward (bool fastForwarding, bool traceForward);
+  void SendPacket (Ptr<Socket> socket);
+  void SourceTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void SinkRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void RouterForward (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+  static uint32_t CountTaggedHeaders (const std::vector<Ptr<const Packet> > &packets);
+
+  std::vector<Ptr<const Packet> > m_sent;
+  std::vector<Ptr<const Packet> > m_received;
+  uint32_t m_forwarded;
+};
+
+Ipv4FastForwardingTestCase::Ipv4FastForwardingTestCase ()
+  : TestCase ("Verify the IPv4 fast forwarding path")
+{
+}
+
+void
+Ipv4FastForwardingTestCase::SendPacket (Ptr<Socket> socket)
+{
+  socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (Ipv4Address ("10.1.2.2"), 9));
+}
+
+void
+Ipv4FastForwardingTestCase::SourceTx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  packet->AddByteTag (FlowIdTag (1));
+  m_sent.push_back (packet->Copy ());
+}
+
+void
+Ipv4FastForwardingTestCase::SinkRx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_received.push_back (packet->Copy ());
+}
+
+void
+Ipv4FastForwardingTestCase::RouterForward (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  m_forwarded++;
+}
+
+uint32_t
+Ipv4FastForwardingTestCase::CountTaggedHeaders (const std::vector<Ptr<const Packet> > &packets)
+{
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < packets.size (); ++i)
+    {
+      ByteTagIterator j = packets[i]->GetByteTagIterator ();
+      while (j.HasNext ())
+        {
+          ByteTagIterator::Item item = j.Next ();
+          if (item.GetTypeId () == FlowIdTag::GetTypeId () && item.GetStart () == 0)
+            {
+              count++;
+            }
+        }
+    }
+  return count;
+}
+
+void
+Ipv4FastForwardingTestCase::Forward (bool fastForwarding, bool traceForward)
+{
+  m_sent.clear ();
+  m_received.clear ();
+  m_forwarded = 0;
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->SetAttribute ("FastForwarding", BooleanValue (fastForwarding));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      for (uint32_t j = i; j < i + 2; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (channel);
+          nodes.Get (j)->AddDevice (device);
+          devices.Add (device);
+        }
+      address.Assign (devices);
+      address.NewNetwork ();
+    }
+
+  Ipv4StaticRoutingHelper routing;
+  routing.GetStaticRouting (nodes.Get (0)->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("10.1.1.2"), 1);
+  routing.GetStaticRouting (nodes.Get (2)->GetObject<Ipv4> ())->SetDefaultRoute (Ipv4Address ("10.1.2.1"), 1);
+
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&Ipv4FastForwardingTestCase::SourceTx, this));
+  nodes.Get (2)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&Ipv4FastForwardingTestCase::SinkRx, this));
+  if (traceForward)
+    {
+      nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+        "UnicastForward", MakeCallback (&Ipv4FastForwardingTestCase::RouterForward, this));
+    }
+
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (2), UdpSocketFactory::GetTypeId ());
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      Simulator::Schedule (Seconds (1 + i), &Ipv4FastForwardingTestCase::SendPacket, this, source);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+Ipv4FastForwardingTestCase::DoRun (void)
+{
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (true));
+
+  Forward (false, false);
+  std::vector<Ptr<const Packet> > expected = m_received;
+  NS_TEST_ASSERT_MSG_EQ (expected.size (), 3, "The packets should be forwarded");
+  NS_TEST_ASSERT_MSG_EQ (CountTaggedHeaders (m_sent), 3, "The headers sent should be tagged");
+  NS_TEST_ASSERT_MSG_EQ (CountTaggedHeaders (expected), 0, "The slow path should write a new header");
+
+  Forward (true, true);
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), 3, "The packets should be forwarded");
+  NS_TEST_ASSERT_MSG_EQ (m_forwarded, 3, "The UnicastForward trace should see the packets");
+  NS_TEST_ASSERT_MSG_EQ (CountTaggedHeaders (m_received), 0, "A UnicastForward sink should disable the fast path");
+
+  Forward (true, false);
+  NS_TEST_ASSERT_MSG_EQ (m_received.size (), expected.size (), "The packets should be forwarded");
+  NS_TEST_ASSERT_MSG_EQ (CountTaggedHeaders (m_received), 3, "The fast path should send out the header received");
+  for (uint32_t i = 0; i < m_received.size () && i < expected.size (); ++i)
+    {
+      uint32_t size = m_received[i]->GetSize ();
+      NS_TEST_ASSERT_MSG_EQ (size, expected[i]->GetSize (), "The packets should have the same size");
+      std::vector<uint8_t> received (size);
+      std::vector<uint8_t> reference (size);
+      m_received[i]->CopyData (&received[0], size);
+      expected[i]->CopyData (&reference[0], size);
+      NS_TEST_ASSERT_MSG_EQ ((received == reference), true, "The packets should have the same bytes");
+
+      Ipv4Header header;
+      header.EnableChecksum ();
+      m_received[i]->PeekHeader (header);
+      NS_TEST_ASSERT_MSG_EQ (header.IsChecksumOk (), true, "The checksum should be updated");
+      NS_TEST_ASSERT_MSG_EQ (uint32_t (header.GetTtl ()), 63, "The TTL should be decremented");
+    }
+  for (uint32_t i = 0; i < m_sent.size (); ++i)
+    {
+      Ipv4Header header;
+      m_sent[i]->PeekHeader (header);
+      NS_TEST_ASSERT_MSG_EQ (uint32_t (header.GetTtl ()), 64, "The packets sent should not change");
+    }
+
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (false));
+}
+
 static class IPv4L3ProtocolTestSuite : public TestSuite
 {
 public:
@@ -104,6 +294,7 @@ public:
     TestSuite ("ipv4-protocol", UNIT)
   {
     AddTestCase (new Ipv4L3ProtocolTestCase ());
+    AddTestCase (new Ipv4FastForwardingTestCase ());
   }
 } g_ipv4protocolTestSuite;
 
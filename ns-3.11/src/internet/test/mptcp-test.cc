@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/mp-tcp-socket-factory.h"
+#include "ns3/mp-tcp-congestion-control.h"
+#include "ns3/tcp-option-mptcp.h"
+#include "ns3/tcp-header.h"
+#include "ns3/object-vector.h"
+#include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/packet.h"
+#include <string.h>
+
+namespace ns3 {
+
+class MpTcpOptionTestCase : public TestCase
+{
+public:
+  MpTcpOptionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpOptionTestCase::MpTcpOptionTestCase ()
+  : TestCase ("Serialize and deserialize the MPTCP options of a TCP header")
+{
+}
+
+void
+MpTcpOptionTestCase::DoRun (void)
+{
+  TcpOptionMpTcp dss;
+  dss.SetDataAck (SequenceNumber32 (1000));
+  dss.SetMapping (SequenceNumber32 (5000), SequenceNumber32 (1), 536);
+
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (1));
+  header.SetFlags (TcpHeader::ACK);
+  NS_TEST_ASSERT_MSG_EQ (header.AppendOption (dss), true, "DSS fits in the header");
+  NS_TEST_ASSERT_MSG_EQ (header.GetLength (), 5 + 5, "18 bytes of DSS take 5 words");
+
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100 + 40, "Header with its padded options");
+  TcpHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "The whole header is removed");
+  NS_TEST_ASSERT_MSG_EQ (received.HasOption (TcpOption::MPTCP), true, "The option is found");
+
+  TcpOptionMpTcp option;
+  NS_TEST_ASSERT_MSG_EQ (received.GetOption (option), true, "The option is read");
+  NS_TEST_EXPECT_MSG_EQ (option.GetSubType (), TcpOptionMpTcp::DSS, "DSS subtype");
+  NS_TEST_EXPECT_MSG_EQ (option.HasDataAck (), true, "Data ack present");
+  NS_TEST_EXPECT_MSG_EQ (option.GetDataAck (), SequenceNumber32 (1000), "Data ack");
+  NS_TEST_EXPECT_MSG_EQ (option.HasMapping (), true, "Mapping present");
+  NS_TEST_EXPECT_MSG_EQ (option.GetDataSequence (), SequenceNumber32 (5000), "Data sequence");
+  NS_TEST_EXPECT_MSG_EQ (option.GetSubflowSequence (), SequenceNumber32 (1), "Subflow sequence");
+  NS_TEST_EXPECT_MSG_EQ (option.GetDataLength (), 536, "Data length");
+
+  TcpOptionMpTcp capable;
+  capable.SetCapable (0x0123456789abcdefULL);
+  TcpHeader syn;
+  syn.SetFlags (TcpHeader::SYN);
+  syn.AppendOption (capable);
+  Buffer buffer;
+  buffer.AddAtStart (syn.GetSerializedSize ());
+  syn.Serialize (buffer.Begin ());
+  TcpHeader synReceived;
+  synReceived.Deserialize (buffer.Begin ());
+  NS_TEST_ASSERT_MSG_EQ (synReceived.GetOption (option), true, "MP_CAPABLE is read");
+  NS_TEST_EXPECT_MSG_EQ (option.GetSubType (), TcpOptionMpTcp::MP_CAPABLE, "MP_CAPABLE subtype");
+  NS_TEST_EXPECT_MSG_EQ (option.GetKey (), 0x0123456789abcdefULL, "Key");
+}
+
+class MpTcpCoupledIncreaseTestCase : public TestCase
+{
+public:
+  MpTcpCoupledIncreaseTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpCoupledIncreaseTestCase::MpTcpCoupledIncreaseTestCase ()
+  : TestCase ("Coupled congestion avoidance increase of LIA and OLIA")
+{
+}
+
+void
+MpTcpCoupledIncreaseTestCase::DoRun (void)
+{
+  Ptr<MpTcpCongestionControl> lia = CreateObject<MpTcpLia> ();
+  Ptr<MpTcpCongestionControl> olia = CreateObject<MpTcpOlia> ();
+  MpTcpSubflowState path;
+  path.m_cWnd = 10 * 1000;
+  path.m_segmentSize = 1000;
+  path.m_rtt = MilliSeconds (20);
+  path.m_lossInterval = 50000;
+
+  // On a single path, both are NewReno: mss^2/cwnd per segment
+  std::vector<MpTcpSubflowState> single (1, path);
+  NS_TEST_EXPECT_MSG_EQ (lia->GetIncrease (0, single), 100, "LIA on one path");
+  NS_TEST_EXPECT_MSG_EQ (olia->GetIncrease (0, single), 100, "OLIA on one path");
+
+  // Two identical paths take no more than one NewReno flow altogether
+  std::vector<MpTcpSubflowState> two (2, path);
+  NS_TEST_EXPECT_MSG_EQ (lia->GetIncrease (0, two), 25, "LIA on two identical paths");
+  NS_TEST_EXPECT_MSG_EQ (olia->GetIncrease (0, two), 25, "OLIA on two identical paths");
+
+  // OLIA moves window from the largest window to the better path
+  two[1].m_cWnd = 5 * 1000;
+  two[1].m_lossInterval = 100000;
+  NS_TEST_EXPECT_MSG_LT (olia->GetIncrease (0, two), 0, "OLIA shrinks the largest window");
+  NS_TEST_EXPECT_MSG_LT (lia->GetIncrease (1, two), olia->GetIncrease (1, two),
+                         "OLIA grows the best path faster than LIA");
+}
+
+class MpTcpTransferTestCase : public TestCase
+{
+public:
+  MpTcpTransferTestCase (bool mpTcpServer, std::string congestionControl);
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  uint32_t CountSockets (Ptr<Node> node);
+
+  bool m_mpTcpServer;
+  std::string m_congestionControl;
+  uint32_t m_totalBytes;
+  uint32_t m_sourceTxBytes;
+  uint32_t m_serverRxBytes;
+  uint32_t m_sourceSubflows;
+  uint8_t *m_sourceTxPayload;
+  uint8_t *m_serverRxPayload;
+};
+
+MpTcpTransferTestCase::MpTcpTransferTestCase (bool mpTcpServer, std::string congestionControl)
+  : TestCase (std::string ("Bulk transfer over two paths to a") + (mpTcpServer ? "n MPTCP" : " TCP")
+              + " server with " + congestionControl),
+    m_mpTcpServer (mpTcpServer),
+    m_congestionControl (congestionControl),
+    m_totalBytes (200000)
+{
+}
+
+uint32_t
+MpTcpTransferTestCase::CountSockets (Ptr<Node> node)
+{
+  ObjectVectorValue sockets;
+  node->GetObject<TcpL4Protocol> ()->GetAttribute ("SocketList", sockets);
+  return sockets.GetN ();
+}
+
+void
+MpTcpTransferTestCase::DoRun (void)
+{
+  m_sourceTxBytes = 0;
+  m_serverRxBytes = 0;
+  m_sourceSubflows = 0;
+  m_sourceTxPayload = new uint8_t [m_totalBytes];
+  m_serverRxPayload = new uint8_t [m_totalBytes];
+  for (uint32_t i = 0; i < m_totalBytes; ++i)
+    {
+      m_sourceTxPayload[i] = static_cast<uint8_t> (i * 7 + i / 256);
+    }
+  memset (m_serverRxPayload, 0, m_totalBytes);
+
+  // A diamond: the client reaches the server through either router, and
+  // the subflows are hashed onto the two paths
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_FLOW_HASH));
+  NodeContainer nodes;
+  nodes.Create (4);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  uint32_t links[4][2] = { { 0, 1 }, { 0, 2 }, { 1, 3 }, { 2, 3 } };
+  Ipv4AddressHelper address ("10.1.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices;
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (channel);
+          nodes.Get (links[i][j])->AddDevice (device);
+          devices.Add (device);
+        }
+      address.Assign (devices);
+      address.NewNetwork ();
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  Ptr<Socket> server = m_mpTcpServer ?
+    nodes.Get (3)->GetObject<MpTcpSocketFactory> ()->CreateSocket () :
+    nodes.Get (3)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&MpTcpTransferTestCase::ServerHandleConnectionCreated, this));
+
+  Ptr<Socket> source = nodes.Get (0)->GetObject<MpTcpSocketFactory> ()->CreateSocket ();
+  source->SetAttribute ("CongestionControl", TypeIdValue (TypeId::LookupByName (m_congestionControl)));
+  source->SetSendCallback (MakeCallback (&MpTcpTransferTestCase::SourceHandleSend, this));
+  source->Connect (InetSocketAddress (Ipv4Address ("10.1.3.2"), 50000));
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_sourceTxBytes, m_totalBytes, "Source sent all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_serverRxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (memcmp (m_sourceTxPayload, m_serverRxPayload, m_totalBytes), 0,
+                         "Server received the data in order");
+  // A TCP server refuses MPTCP: the client does not open a second subflow.
+  // The subflows are counted when the client closes, as the closed sockets
+  // are reclaimed once they leave TIME_WAIT, if it has a timeout.
+  NS_TEST_EXPECT_MSG_EQ (m_sourceSubflows, (m_mpTcpServer ? 2 : 1), "Subflows of the client");
+}
+
+void
+MpTcpTransferTestCase::DoTeardown (void)
+{
+  delete [] m_sourceTxPayload;
+  delete [] m_serverRxPayload;
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::EcmpMode", EnumValue (Ipv4GlobalRouting::ECMP_NONE));
+}
+
+void
+MpTcpTransferTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () > 0 && m_sourceTxBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_totalBytes - m_sourceTxBytes, sock->GetTxAvailable ());
+      toSend = std::min (toSend, 1000u);
+      Ptr<Packet> p = Create<Packet> (&m_sourceTxPayload[m_sourceTxBytes], toSend);
+      int sent = sock->Send (p);
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_sourceTxBytes += sent;
+    }
+  if (m_sourceTxBytes == m_totalBytes)
+    {
+      m_sourceSubflows = std::max (m_sourceSubflows, CountSockets (sock->GetNode ()));
+      sock->Close ();
+    }
+}
+
+void
+MpTcpTransferTestCase::ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&MpTcpTransferTestCase::ServerHandleRecv, this));
+}
+
+void
+MpTcpTransferTestCase::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      Ptr<Packet> p = sock->Recv (std::min (sock->GetRxAvailable (), 1500u), 0);
+      NS_TEST_ASSERT_MSG_EQ ((m_serverRxBytes + p->GetSize () <= m_totalBytes), true,
+                             "Server received too many bytes");
+      p->CopyData (&m_serverRxPayload[m_serverRxBytes], p->GetSize ());
+      m_serverRxBytes += p->GetSize ();
+    }
+  if (m_serverRxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+static class MpTcpTestSuite : public TestSuite
+{
+public:
+  MpTcpTestSuite ()
+    : TestSuite ("mptcp", UNIT)
+  {
+    AddTestCase (new MpTcpOptionTestCase);
+    AddTestCase (new MpTcpCoupledIncreaseTestCase);
+    AddTestCase (new MpTcpTransferTestCase (true, "ns3::MpTcpLia"));
+    AddTestCase (new MpTcpTransferTestCase (true, "ns3::MpTcpOlia"));
+    AddTestCase (new MpTcpTransferTestCase (false, "ns3::MpTcpLia"));
+  }
+} g_mpTcpTestSuite;
+
+} // namespace ns3
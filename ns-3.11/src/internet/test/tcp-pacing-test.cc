@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-header.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/packet.h"
+#include <algorithm>
+#include <sstream>
+
+namespace ns3 {
+
+/**
+ * A bulk transfer over a link without delay nor queue: without pacing, the
+ * sender sends its window back to back; with pacing, the data segments leave
+ * in bursts of at most PacingMaxBurst segments, each burst spaced from the
+ * previous one by the transmission time of its segments at the pacing rate.
+ */
+class TcpPacingTestCase : public TestCase
+{
+public:
+  TcpPacingTestCase (bool pacing, DataRate fixedRate, uint32_t maxBurst);
+private:
+  virtual void DoRun (void);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  void SourceIpv4Tx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void PacingRateChange (DataRate oldValue, DataRate newValue);
+
+  static std::string Name (bool pacing, DataRate fixedRate, uint32_t maxBurst);
+
+  bool m_pacing;
+  DataRate m_fixedRate;
+  uint32_t m_maxBurst;
+  uint32_t m_totalBytes;
+  uint32_t m_sourceTxBytes;
+  uint32_t m_serverRxBytes;
+  Time m_lastDataTx;
+  uint32_t m_burstSegments;
+  Time m_burstEnd;
+  uint32_t m_backToBack;
+  uint32_t m_tooLarge;
+  uint32_t m_tooEarly;
+  DataRate m_lastRate;
+};
+
+std::string
+TcpPacingTestCase::Name (bool pacing, DataRate fixedRate, uint32_t maxBurst)
+{
+  std::ostringstream oss;
+  oss << "Spacing of the data segments with pacing=" << pacing;
+  if (pacing)
+    {
+      oss << " rate=";
+      if (fixedRate.GetBitRate () > 0)
+        {
+          oss << fixedRate;
+        }
+      else
+        {
+          oss << "computed";
+        }
+      oss << " burst=" << maxBurst;
+    }
+  return oss.str ();
+}
+
+TcpPacingTestCase::TcpPacingTestCase (bool pacing, DataRate fixedRate, uint32_t maxBurst)
+  : TestCase (Name (pacing, fixedRate, maxBurst)),
+    m_pacing (pacing),
+    m_fixedRate (fixedRate),
+    m_maxBurst (maxBurst),
+    m_totalBytes (100000)
+{
+}
+
+void
+TcpPacingTestCase::DoRun (void)
+{
+  m_sourceTxBytes = 0;
+  m_serverRxBytes = 0;
+  m_lastDataTx = Seconds (-1);
+  m_burstSegments = 0;
+  m_burstEnd = Seconds (0);
+  m_backToBack = 0;
+  m_tooLarge = 0;
+  m_tooEarly = 0;
+  m_lastRate = DataRate (0);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices);
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&TcpPacingTestCase::SourceIpv4Tx, this));
+
+  // The link has no delay: the server delays its ACKs to give the
+  // connection a round trip time to compute the pacing rate from
+  Ptr<Socket> server = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  server->SetAttribute ("DelAckCount", UintegerValue (100));
+  server->SetAttribute ("DelAckTimeout", TimeValue (MilliSeconds (10)));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpPacingTestCase::ServerHandleConnectionCreated, this));
+
+  Ptr<Socket> source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  source->SetAttribute ("SegmentSize", UintegerValue (1000));
+  source->SetAttribute ("Pacing", BooleanValue (m_pacing));
+  source->SetAttribute ("FixedPacingRate", DataRateValue (m_fixedRate));
+  source->SetAttribute ("PacingMaxBurst", UintegerValue (m_maxBurst));
+  source->TraceConnectWithoutContext ("PacingRate", MakeCallback (&TcpPacingTestCase::PacingRateChange, this));
+  source->SetSendCallback (MakeCallback (&TcpPacingTestCase::SourceHandleSend, this));
+  source->Connect (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000));
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_sourceTxBytes, m_totalBytes, "Source sent all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_serverRxBytes, m_totalBytes, "Server received all bytes");
+  if (!m_pacing)
+    {
+      NS_TEST_EXPECT_MSG_LT (0, m_backToBack, "Segments are sent back to back");
+      NS_TEST_EXPECT_MSG_EQ (m_lastRate.GetBitRate (), 0, "No pacing rate");
+    }
+  else if (m_fixedRate.GetBitRate () > 0)
+    {
+      if (m_maxBurst == 1)
+        {
+          NS_TEST_EXPECT_MSG_EQ (m_backToBack, 0, "No segments back to back");
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_LT (0, m_backToBack, "Several segments sent per pacing timeout");
+        }
+      NS_TEST_EXPECT_MSG_EQ (m_tooLarge, 0, "No burst larger than PacingMaxBurst");
+      NS_TEST_EXPECT_MSG_EQ (m_tooEarly, 0, "Bursts spaced at the pacing rate");
+      NS_TEST_EXPECT_MSG_EQ (m_lastRate.GetBitRate (), m_fixedRate.GetBitRate (), "Fixed pacing rate");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_LT (0, m_lastRate.GetBitRate (), "Rate computed from the window and the RTT");
+      NS_TEST_EXPECT_MSG_EQ (m_tooLarge, 0, "No burst larger than PacingMaxBurst");
+      NS_TEST_EXPECT_MSG_EQ (m_tooEarly, 0, "Bursts spaced at the pacing rate");
+    }
+
+  Simulator::Destroy ();
+}
+
+void
+TcpPacingTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () > 0 && m_sourceTxBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_totalBytes - m_sourceTxBytes, sock->GetTxAvailable ());
+      int sent = sock->Send (Create<Packet> (toSend));
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_sourceTxBytes += sent;
+    }
+  if (m_sourceTxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+TcpPacingTestCase::ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&TcpPacingTestCase::ServerHandleRecv, this));
+}
+
+void
+TcpPacingTestCase::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      m_serverRxBytes += sock->Recv (sock->GetRxAvailable (), 0)->GetSize ();
+    }
+  if (m_serverRxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+TcpPacingTestCase::SourceIpv4Tx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if (p->GetSize () == 0)
+    {
+      return;
+    }
+  // A burst is the segments sent at the same time; m_burstEnd is when the
+  // segments paced so far allow the next burst
+  Time now = Simulator::Now ();
+  if (now == m_lastDataTx)
+    {
+      m_backToBack++;
+      if (++m_burstSegments > m_maxBurst && m_lastRate.GetBitRate () > 0)
+        {
+          m_tooLarge++;
+        }
+    }
+  else
+    {
+      if (m_lastRate.GetBitRate () > 0 && now < m_burstEnd - NanoSeconds (1))
+        {
+          m_tooEarly++;
+        }
+      m_burstSegments = 1;
+      m_burstEnd = std::max (m_burstEnd, now);
+    }
+  if (m_lastRate.GetBitRate () > 0)
+    {
+      m_burstEnd += Seconds (m_lastRate.CalculateTxTime (p->GetSize ()));
+    }
+  m_lastDataTx = now;
+}
+
+void
+TcpPacingTestCase::PacingRateChange (DataRate oldValue, DataRate newValue)
+{
+  m_lastRate = newValue;
+}
+
+static class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite ()
+    : TestSuite ("tcp-pacing", UNIT)
+  {
+    AddTestCase (new TcpPacingTestCase (false, DataRate (0), 2));
+    AddTestCase (new TcpPacingTestCase (true, DataRate ("10Mbps"), 1));
+    AddTestCase (new TcpPacingTestCase (true, DataRate ("10Mbps"), 4));
+    AddTestCase (new TcpPacingTestCase (true, DataRate (0), 2));
+  }
+} g_tcpPacingTestSuite;
+
+} // namespace ns3
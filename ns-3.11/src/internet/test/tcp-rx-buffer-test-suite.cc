@@ -0,0 +1,116 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-rx-buffer.h"
+
+#include <string.h>
+
+namespace ns3 {
+
+class TcpRxBufferReorderTestCase : public TestCase
+{
+public:
+  TcpRxBufferReorderTestCase (TcpRxBuffer::StorageMode mode, std::string name);
+  virtual void DoRun (void);
+private:
+  bool AddSegment (uint32_t offset, uint32_t length);
+  TcpRxBuffer m_buffer;
+  uint8_t m_data[1000];
+};
+
+TcpRxBufferReorderTestCase::TcpRxBufferReorderTestCase (TcpRxBuffer::StorageMode mode, std::string name)
+  : TestCase ("Check the reassembly of reordered segments with the " + name + " storage"),
+    m_buffer (1000)
+{
+  m_buffer.SetStorageMode (mode);
+  m_buffer.SetMaxBufferSize (1000);
+  for (uint32_t i = 0; i < sizeof (m_data); i++)
+    {
+      m_data[i] = i % 251;
+    }
+}
+
+bool
+TcpRxBufferReorderTestCase::AddSegment (uint32_t offset, uint32_t length)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (1000 + offset));
+  return m_buffer.Add (Create<Packet> (&m_data[offset], length), header);
+}
+
+void
+TcpRxBufferReorderTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (300, 100), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (100, 100), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (500, 100), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (200, 100), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (150, 100), false, "Duplicate should not be buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.Size (), 400, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.Available (), 0, "Nothing should be readable");
+
+  TcpRxBuffer::SackList blocks = m_buffer.GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (blocks.size (), 2, "Two blocks expected");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].first, SequenceNumber32 (1100), "Most recent block first");
+  NS_TEST_ASSERT_MSG_EQ (blocks[0].second, SequenceNumber32 (1400), "Blocks should be merged");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].first, SequenceNumber32 (1500), "Wrong second block");
+  NS_TEST_ASSERT_MSG_EQ (blocks[1].second, SequenceNumber32 (1600), "Wrong second block");
+
+  // A segment overlapping both ends of a hole only fills the hole
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (350, 200), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.Size (), 500, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (0, 120), true, "Segment should be buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.NextRxSequence (), SequenceNumber32 (1600), "Wrong next sequence");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.Available (), 600, "All data should be readable");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.GetSackList ().size (), 0, "No block expected");
+
+  uint8_t out[600];
+  Ptr<Packet> p = m_buffer.Extract (250);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 250, "Wrong extracted size");
+  p->CopyData (out, 250);
+  p = m_buffer.Extract (1000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 350, "Wrong extracted size");
+  p->CopyData (out + 250, 350);
+  NS_TEST_ASSERT_MSG_EQ (memcmp (out, m_data, 600), 0, "Wrong data extracted");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer.Size (), 0, "Buffer should be empty");
+
+  // The window follows the data, so reuse the storage several times
+  for (uint32_t offset = 600; offset < 1000; offset += 100)
+    {
+      NS_TEST_ASSERT_MSG_EQ (AddSegment (offset + 50, 50), true, "Segment should be buffered");
+      NS_TEST_ASSERT_MSG_EQ (AddSegment (offset, 50), true, "Segment should be buffered");
+      p = m_buffer.Extract (100);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Wrong extracted size");
+      p->CopyData (out, 100);
+      NS_TEST_ASSERT_MSG_EQ (memcmp (out, &m_data[offset], 100), 0, "Wrong data extracted");
+    }
+}
+
+static class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite ()
+    : TestSuite ("tcp-rx-buffer", UNIT)
+  {
+    AddTestCase (new TcpRxBufferReorderTestCase (TcpRxBuffer::PACKET_MAP, "PacketMap"));
+    AddTestCase (new TcpRxBufferReorderTestCase (TcpRxBuffer::BYTE_RING, "ByteRing"));
+  }
+} g_tcpRxBufferTestSuite;
+
+} // namespace ns3
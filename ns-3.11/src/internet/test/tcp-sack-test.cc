@@ -0,0 +1,381 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
+#include "ns3/tcp-option-ts.h"
+#include "../model/tcp-newreno.h"
+#include "ns3/boolean.h"
+#include "ns3/packet.h"
+#include <set>
+#include <string.h>
+
+namespace ns3 {
+
+class TcpSackOptionTestCase : public TestCase
+{
+public:
+  TcpSackOptionTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+TcpSackOptionTestCase::TcpSackOptionTestCase ()
+  : TestCase ("Serialize and deserialize the SACK and timestamp options of a TCP header")
+{
+}
+
+void
+TcpSackOptionTestCase::DoRun (void)
+{
+  TcpOptionTimestamp ts;
+  ts.SetTimestamp (123456, 654321);
+  TcpOptionSack sack;
+  sack.AddSackBlock (TcpOptionSack::SackBlock (SequenceNumber32 (3000), SequenceNumber32 (4000)));
+  sack.AddSackBlock (TcpOptionSack::SackBlock (SequenceNumber32 (1000), SequenceNumber32 (2000)));
+  sack.AddSackBlock (TcpOptionSack::SackBlock (SequenceNumber32 (5000), SequenceNumber32 (5536)));
+
+  TcpHeader header;
+  header.SetFlags (TcpHeader::ACK);
+  NS_TEST_ASSERT_MSG_EQ (header.AppendOption (ts), true, "Timestamp fits in the header");
+  NS_TEST_ASSERT_MSG_EQ (header.AppendOption (sack), true, "Three SACK blocks fit with a timestamp");
+  NS_TEST_EXPECT_MSG_EQ (header.AppendOption (ts), false, "The option space is exhausted");
+
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100 + 20 + 36, "Header with its padded options");
+  TcpHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "The whole header is removed");
+
+  TcpOptionTimestamp receivedTs;
+  NS_TEST_ASSERT_MSG_EQ (received.GetOption (receivedTs), true, "The timestamp is read");
+  NS_TEST_EXPECT_MSG_EQ (receivedTs.GetTimestamp (), 123456, "Timestamp value");
+  NS_TEST_EXPECT_MSG_EQ (receivedTs.GetEcho (), 654321, "Timestamp echo");
+  TcpOptionSack receivedSack;
+  NS_TEST_ASSERT_MSG_EQ (received.GetOption (receivedSack), true, "The SACK option is read");
+  NS_TEST_ASSERT_MSG_EQ (receivedSack.GetNumSackBlocks (), 3, "Number of blocks");
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (receivedSack.GetSackList ()[i].first, sack.GetSackList ()[i].first, "Left edge");
+      NS_TEST_EXPECT_MSG_EQ (receivedSack.GetSackList ()[i].second, sack.GetSackList ()[i].second, "Right edge");
+    }
+  NS_TEST_EXPECT_MSG_EQ (received.HasOption (TcpOption::SACK_PERMITTED), false, "No SACK-permitted");
+}
+
+/**
+ * The scoreboard of a sender with ten segments in flight: a hole is only
+ * deemed lost, and left out of the pipe, once three segments were SACKed
+ * above it, so that a reordered segment is not resent.
+ */
+class TcpSackScoreboardTestCase : public TestCase
+{
+public:
+  TcpSackScoreboardTestCase ();
+private:
+  virtual void DoRun (void);
+  void Sack (Ptr<TcpNewReno> socket, uint32_t first, uint32_t second);
+};
+
+TcpSackScoreboardTestCase::TcpSackScoreboardTestCase ()
+  : TestCase ("Deem the holes of the SACK scoreboard lost as in RFC 6675")
+{
+}
+
+void
+TcpSackScoreboardTestCase::Sack (Ptr<TcpNewReno> socket, uint32_t first, uint32_t second)
+{
+  TcpOptionSack sack;
+  sack.AddSackBlock (TcpOptionSack::SackBlock (SequenceNumber32 (first), SequenceNumber32 (second)));
+  TcpHeader header;
+  header.SetFlags (TcpHeader::ACK);
+  header.SetAckNumber (SequenceNumber32 (0));
+  header.AppendOption (sack);
+  socket->UpdateSackScoreboard (header);
+}
+
+void
+TcpSackScoreboardTestCase::DoRun (void)
+{
+  Ptr<TcpNewReno> socket = CreateObject<TcpNewReno> ();
+  socket->m_segmentSize = 1000;
+  socket->m_highTxMark = SequenceNumber32 (10000);
+
+  // One segment SACKed above the first one: it may just be late
+  Sack (socket, 1000, 2000);
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (0)), false, "One segment SACKed above");
+  NS_TEST_EXPECT_MSG_EQ (socket->Pipe (), 9000, "The first segment is still in flight");
+
+  // Three segments SACKed above the first one, two above the third one
+  Sack (socket, 3000, 4000);
+  Sack (socket, 5000, 6000);
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (0)), true, "Three segments SACKed above");
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (2000)), false, "Two segments SACKed above");
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (4000)), false, "One segment SACKed above");
+  NS_TEST_EXPECT_MSG_EQ (socket->Pipe (), 6000, "The lost segment left the pipe");
+
+  // Its retransmission is in flight again
+  socket->m_sackHighRxt = SequenceNumber32 (1000);
+  NS_TEST_EXPECT_MSG_EQ (socket->Pipe (), 7000, "The retransmission is in the pipe");
+
+  // Small segments count as segments too
+  Sack (socket, 6200, 6300);
+  Sack (socket, 6500, 6600);
+  Sack (socket, 6800, 6900);
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (6000)), true, "Three small segments SACKed above");
+  NS_TEST_EXPECT_MSG_EQ (socket->IsLost (SequenceNumber32 (6300)), false, "Two small segments SACKed above");
+}
+
+/**
+ * A bulk transfer with several losses in one window: with SACK, the sender
+ * retransmits exactly the lost segments, and never goes back N after a
+ * timeout.
+ */
+class TcpSackRecoveryTestCase : public TestCase
+{
+public:
+  TcpSackRecoveryTestCase (bool sack, bool timestamp);
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  void ServerIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void SourceIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  bool m_sack;
+  bool m_timestamp;
+  uint32_t m_totalBytes;
+  uint32_t m_sourceTxBytes;
+  uint32_t m_serverRxBytes;
+  uint8_t *m_sourceTxPayload;
+  uint8_t *m_serverRxPayload;
+  std::set<uint32_t> m_segmentsSeen;
+  uint32_t m_dataSegments;
+  uint32_t m_duplicateSegments;
+  uint32_t m_segmentsWithoutTimestamp;
+  uint32_t m_acksWithSack;
+};
+
+TcpSackRecoveryTestCase::TcpSackRecoveryTestCase (bool sack, bool timestamp)
+  : TestCase (std::string ("Recovery from several losses in a window with sack=")
+              + (sack ? "1" : "0") + " timestamp=" + (timestamp ? "1" : "0")),
+    m_sack (sack),
+    m_timestamp (timestamp),
+    m_totalBytes (100000)
+{
+}
+
+void
+TcpSackRecoveryTestCase::DoRun (void)
+{
+  m_sourceTxBytes = 0;
+  m_serverRxBytes = 0;
+  m_dataSegments = 0;
+  m_duplicateSegments = 0;
+  m_segmentsWithoutTimestamp = 0;
+  m_acksWithSack = 0;
+  m_segmentsSeen.clear ();
+  m_sourceTxPayload = new uint8_t [m_totalBytes];
+  m_serverRxPayload = new uint8_t [m_totalBytes];
+  for (uint32_t i = 0; i < m_totalBytes; ++i)
+    {
+      m_sourceTxPayload[i] = static_cast<uint8_t> (i * 13 + i / 256);
+    }
+  memset (m_serverRxPayload, 0, m_totalBytes);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  // Drop three segments of the same window on their way to the server
+  std::list<uint32_t> drops;
+  drops.push_back (40);
+  drops.push_back (42);
+  drops.push_back (45);
+  Ptr<ReceiveListErrorModel> em = CreateObject<ReceiveListErrorModel> ();
+  em->SetList (drops);
+  DynamicCast<SimpleNetDevice> (devices.Get (1))->SetReceiveErrorModel (em);
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&TcpSackRecoveryTestCase::ServerIpv4Rx, this));
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&TcpSackRecoveryTestCase::SourceIpv4Rx, this));
+
+  Ptr<Socket> server = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  server->SetAttribute ("Sack", BooleanValue (m_sack));
+  server->SetAttribute ("Timestamp", BooleanValue (m_timestamp));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpSackRecoveryTestCase::ServerHandleConnectionCreated, this));
+
+  Ptr<Socket> source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  source->SetAttribute ("Sack", BooleanValue (m_sack));
+  source->SetAttribute ("Timestamp", BooleanValue (m_timestamp));
+  source->SetSendCallback (MakeCallback (&TcpSackRecoveryTestCase::SourceHandleSend, this));
+  source->Connect (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000));
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_sourceTxBytes, m_totalBytes, "Source sent all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_serverRxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (memcmp (m_sourceTxPayload, m_serverRxPayload, m_totalBytes), 0,
+                         "Server received the data in order");
+  if (m_sack)
+    { // Every retransmission repaired a loss
+      NS_TEST_EXPECT_MSG_EQ ((m_acksWithSack > 0), true, "The server sent SACK blocks");
+      NS_TEST_EXPECT_MSG_EQ (m_duplicateSegments, 0, "No segment was received twice");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_acksWithSack, 0, "SACK was not negotiated");
+    }
+  if (m_timestamp)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_segmentsWithoutTimestamp, 0, "Every segment carried a timestamp");
+    }
+}
+
+void
+TcpSackRecoveryTestCase::DoTeardown (void)
+{
+  delete [] m_sourceTxPayload;
+  delete [] m_serverRxPayload;
+  Simulator::Destroy ();
+}
+
+void
+TcpSackRecoveryTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () > 0 && m_sourceTxBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_totalBytes - m_sourceTxBytes, sock->GetTxAvailable ());
+      toSend = std::min (toSend, 1000u);
+      Ptr<Packet> p = Create<Packet> (&m_sourceTxPayload[m_sourceTxBytes], toSend);
+      int sent = sock->Send (p);
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_sourceTxBytes += sent;
+    }
+  if (m_sourceTxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+TcpSackRecoveryTestCase::ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&TcpSackRecoveryTestCase::ServerHandleRecv, this));
+}
+
+void
+TcpSackRecoveryTestCase::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      Ptr<Packet> p = sock->Recv (std::min (sock->GetRxAvailable (), 1500u), 0);
+      NS_TEST_ASSERT_MSG_EQ ((m_serverRxBytes + p->GetSize () <= m_totalBytes), true,
+                             "Server received too many bytes");
+      p->CopyData (&m_serverRxPayload[m_serverRxBytes], p->GetSize ());
+      m_serverRxBytes += p->GetSize ();
+    }
+  if (m_serverRxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+TcpSackRecoveryTestCase::ServerIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if ((tcpHeader.GetFlags () & TcpHeader::SYN) == 0 && !tcpHeader.HasOption (TcpOption::TIMESTAMP))
+    {
+      m_segmentsWithoutTimestamp++;
+    }
+  if (p->GetSize () == 0)
+    {
+      return;
+    }
+  m_dataSegments++;
+  if (!m_segmentsSeen.insert (tcpHeader.GetSequenceNumber ().GetValue ()).second)
+    {
+      m_duplicateSegments++;
+    }
+}
+
+void
+TcpSackRecoveryTestCase::SourceIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if (tcpHeader.HasOption (TcpOption::SACK))
+    {
+      m_acksWithSack++;
+    }
+}
+
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ()
+    : TestSuite ("tcp-sack", UNIT)
+  {
+    AddTestCase (new TcpSackOptionTestCase);
+    AddTestCase (new TcpSackScoreboardTestCase);
+    AddTestCase (new TcpSackRecoveryTestCase (false, false));
+    AddTestCase (new TcpSackRecoveryTestCase (true, false));
+    AddTestCase (new TcpSackRecoveryTestCase (true, true));
+  }
+} g_tcpSackTestSuite;
+
+} // namespace ns3
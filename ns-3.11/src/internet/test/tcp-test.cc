@@ -33,6 +33,8 @@
 #include "ns3/node.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
 #include "ns3/log.h"
 
 #include "ns3/ipv4-end-point.h"
@@ -55,7 +57,9 @@ public:
                uint32_t sourceWriteSize,
                uint32_t sourceReadSize,
                uint32_t serverWriteSize,
-               uint32_t serverReadSize);
+               uint32_t serverReadSize,
+               std::string bufferStorage = "Default",
+               bool batchSend = false);
 private:
   virtual void DoRun (void);
   virtual void DoTeardown (void);
@@ -68,16 +72,21 @@ private:
   void ServerHandleSend (Ptr<Socket> sock, uint32_t available);
   void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
   void SourceHandleRecv (Ptr<Socket> sock);
+  void SourceHandleDataSent (Ptr<Socket> sock, uint32_t size);
 
   uint32_t m_totalBytes;
   uint32_t m_sourceWriteSize;
   uint32_t m_sourceReadSize;
   uint32_t m_serverWriteSize;
   uint32_t m_serverReadSize;
+  std::string m_bufferStorage;
+  bool m_batchSend;
   uint32_t m_currentSourceTxBytes;
   uint32_t m_currentSourceRxBytes;
   uint32_t m_currentServerRxBytes;
   uint32_t m_currentServerTxBytes;
+  uint32_t m_sourceDataSentBytes;
+  uint32_t m_sourceDataSentCalls;
   uint8_t *m_sourceTxPayload;
   uint8_t *m_sourceRxPayload;
   uint8_t* m_serverRxPayload;
@@ -87,12 +96,18 @@ static std::string Name (std::string str, uint32_t totalStreamSize,
                          uint32_t sourceWriteSize,
                          uint32_t serverReadSize,
                          uint32_t serverWriteSize,
-                         uint32_t sourceReadSize)
+                         uint32_t sourceReadSize,
+                         std::string bufferStorage,
+                         bool batchSend)
 {
   std::ostringstream oss;
   oss << str << " total=" << totalStreamSize << " sourceWrite=" << sourceWriteSize 
       << " sourceRead=" << sourceReadSize << " serverRead=" << serverReadSize
-      << " serverWrite=" << serverWriteSize;
+      << " serverWrite=" << serverWriteSize << " buffers=" << bufferStorage;
+  if (batchSend)
+    {
+      oss << " batch";
+    }
   return oss.str ();
 }
 
@@ -109,18 +124,24 @@ TcpTestCase::TcpTestCase (uint32_t totalStreamSize,
                           uint32_t sourceWriteSize,
                           uint32_t sourceReadSize,
                           uint32_t serverWriteSize,
-                          uint32_t serverReadSize)
+                          uint32_t serverReadSize,
+                          std::string bufferStorage,
+                          bool batchSend)
   : TestCase (Name ("Send string data from client to server and back", 
                     totalStreamSize, 
                     sourceWriteSize,
                     serverReadSize,
                     serverWriteSize,
-                    sourceReadSize)),
+                    sourceReadSize,
+                    bufferStorage,
+                    batchSend)),
     m_totalBytes (totalStreamSize),
     m_sourceWriteSize (sourceWriteSize),
     m_sourceReadSize (sourceReadSize),
     m_serverWriteSize (serverWriteSize),
-    m_serverReadSize (serverReadSize)
+    m_serverReadSize (serverReadSize),
+    m_bufferStorage (bufferStorage),
+    m_batchSend (batchSend)
 {
 }
 
@@ -131,6 +152,8 @@ TcpTestCase::DoRun (void)
   m_currentSourceRxBytes = 0;
   m_currentServerRxBytes = 0;
   m_currentServerTxBytes = 0;
+  m_sourceDataSentBytes = 0;
+  m_sourceDataSentCalls = 0;
   m_sourceTxPayload = new uint8_t [m_totalBytes];
   m_sourceRxPayload = new uint8_t [m_totalBytes];
   m_serverRxPayload = new uint8_t [m_totalBytes];
@@ -153,6 +176,12 @@ TcpTestCase::DoRun (void)
                          "Server received expected data buffers");
   NS_TEST_EXPECT_MSG_EQ (memcmp (m_sourceTxPayload, m_sourceRxPayload, m_totalBytes), 0, 
                          "Source received back expected data buffers");
+  NS_TEST_EXPECT_MSG_EQ (m_sourceDataSentBytes, m_totalBytes, "Source notified of all bytes sent");
+  if (m_batchSend)
+    {
+      uint32_t segments = (m_totalBytes + 535) / 536;
+      NS_TEST_EXPECT_MSG_LT (m_sourceDataSentCalls, segments, "One notification per batch");
+    }
 }
 void
 TcpTestCase::DoTeardown (void)
@@ -226,6 +255,13 @@ TcpTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
     }
 }
 
+void
+TcpTestCase::SourceHandleDataSent (Ptr<Socket> sock, uint32_t size)
+{
+  m_sourceDataSentBytes += size;
+  m_sourceDataSentCalls++;
+}
+
 void
 TcpTestCase::SourceHandleRecv (Ptr<Socket> sock)
 {
@@ -310,6 +346,18 @@ TcpTestCase::SetupDefaultSim (void)
 
   Ptr<Socket> server = sockFactory0->CreateSocket ();
   Ptr<Socket> source = sockFactory1->CreateSocket ();
+  if (m_bufferStorage != "Default")
+    { // Accepted sockets inherit the setting of the listening socket
+      server->SetAttribute ("TxBufferStorage", StringValue (m_bufferStorage));
+      source->SetAttribute ("TxBufferStorage", StringValue (m_bufferStorage));
+      server->SetAttribute ("RxBufferStorage", StringValue (m_bufferStorage));
+      source->SetAttribute ("RxBufferStorage", StringValue (m_bufferStorage));
+    }
+  if (m_batchSend)
+    {
+      server->SetAttribute ("BatchSend", BooleanValue (true));
+      source->SetAttribute ("BatchSend", BooleanValue (true));
+    }
 
   uint16_t port = 50000;
   InetSocketAddress serverlocaladdr (Ipv4Address::GetAny (), port);
@@ -322,6 +370,7 @@ TcpTestCase::SetupDefaultSim (void)
 
   source->SetRecvCallback (MakeCallback (&TcpTestCase::SourceHandleRecv, this));
   source->SetSendCallback (MakeCallback (&TcpTestCase::SourceHandleSend, this));
+  source->SetDataSentCallback (MakeCallback (&TcpTestCase::SourceHandleDataSent, this));
 
   source->Connect (serverremoteaddr);
 }
@@ -339,6 +388,11 @@ public:
     AddTestCase (new TcpTestCase (13, 200, 200, 200, 200));
     AddTestCase (new TcpTestCase (13, 1, 1, 1, 1));
     AddTestCase (new TcpTestCase (100000, 100, 50, 100, 20));
+    AddTestCase (new TcpTestCase (13, 1, 1, 1, 1, "ByteRing"));
+    AddTestCase (new TcpTestCase (100000, 100, 50, 100, 20, "ByteRing"));
+    AddTestCase (new TcpTestCase (100000, 1000, 1500, 7000, 100, "ByteRing"));
+    AddTestCase (new TcpTestCase (100000, 100, 50, 100, 20, "Default", true));
+    AddTestCase (new TcpTestCase (100000, 1000, 1500, 7000, 100, "ByteRing", true));
   }
 
 } g_tcpTestSuite;
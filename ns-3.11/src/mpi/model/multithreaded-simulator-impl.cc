@@ -0,0 +1,781 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/global-value.h"
+#include "ns3/ptr.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <map>
+#include <sched.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+// timestamp of an empty event list
+static const uint64_t NO_EVENT = ~(uint64_t)0;
+
+__thread struct MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "Maximum number of threads running the logical processes; "
+                   "zero uses one thread per online processor",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+bool
+MultithreadedSimulatorImpl::IsEnabled (void)
+{
+  StringValue type;
+  GlobalValue::GetValueByName ("SimulatorImplementationType", type);
+  return type.Get () == GetTypeId ().GetName ();
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  m_stop = false;
+  m_stopTs = NO_EVENT;
+  m_stopUid = 0;
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_global.m_uid = 4;
+  // before ::Run is entered, the m_currentUid will be zero
+  m_global.m_currentUid = 0;
+  m_global.m_currentTs = 0;
+  m_global.m_currentContext = 0xffffffff;
+  m_global.m_unscheduledEvents = 0;
+  m_global.m_windowEnd = 0;
+  m_global.m_events = 0;
+  m_uidStride = 1;
+  m_lookAhead = 0;
+  m_maxThreads = 0;
+  m_nThreads = 1;
+  m_nPartitions = 0;
+  m_running = false;
+  m_globalNext = NO_EVENT;
+  m_nextWorker = 0;
+  m_barrierCount = 0;
+  m_barrierGeneration = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  while (!m_global.m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_global.m_events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_global.m_events = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_ASSERT (!m_running);
+  m_schedulerFactory = schedulerFactory;
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+
+  if (m_global.m_events != 0)
+    {
+      while (!m_global.m_events->IsEmpty ())
+        {
+          Scheduler::Event next = m_global.m_events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+    }
+  m_global.m_events = scheduler;
+}
+
+struct MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  if (m_current == 0)
+    {
+      // the main program, outside of the events
+      return const_cast<struct Partition *> (&m_global);
+    }
+  return m_current;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionIndex (uint32_t context) const
+{
+  if (context < m_partitionOf.size ())
+    {
+      return m_partitionOf[context];
+    }
+  return m_nPartitions;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::NextTs (const struct Partition *partition) const
+{
+  if (partition->m_events->IsEmpty ())
+    {
+      return NO_EVENT;
+    }
+  return partition->m_events->PeekNext ().key.m_ts;
+}
+
+void
+MultithreadedSimulatorImpl::Setup (void)
+{
+  // one logical process per system id
+  std::map<uint32_t, uint32_t> partitionOfSystem;
+  m_partitionOf.clear ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      uint32_t systemId = (*i)->GetSystemId ();
+      std::map<uint32_t, uint32_t>::iterator found = partitionOfSystem.find (systemId);
+      if (found == partitionOfSystem.end ())
+        {
+          uint32_t index = partitionOfSystem.size ();
+          found = partitionOfSystem.insert (std::make_pair (systemId, index)).first;
+        }
+      m_partitionOf.push_back (found->second);
+    }
+  m_nPartitions = partitionOfSystem.size ();
+
+  // the uids of the partitions are interleaved to stay unique
+  m_uidStride = m_nPartitions + 1;
+  m_partitions.clear ();
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      struct Partition *partition = new struct Partition ();
+      partition->m_events = m_schedulerFactory.Create<Scheduler> ();
+      partition->m_uid = m_global.m_uid + i;
+      partition->m_currentUid = m_global.m_currentUid;
+      partition->m_currentTs = m_global.m_currentTs;
+      partition->m_currentContext = 0xffffffff;
+      partition->m_unscheduledEvents = 0;
+      partition->m_windowEnd = 0;
+      partition->m_outbox.resize (m_nPartitions + 1);
+      m_partitions.push_back (partition);
+    }
+  m_global.m_uid += m_nPartitions;
+  m_global.m_outbox.resize (m_nPartitions + 1);
+  m_partitions.push_back (&m_global);
+
+  CalculateLookAhead ();
+
+  m_nThreads = 1;
+#ifdef NS3_MULTITHREADED
+  uint32_t maxThreads = m_maxThreads;
+  if (maxThreads == 0)
+    {
+      maxThreads = std::max (sysconf (_SC_NPROCESSORS_ONLN), 1L);
+    }
+  m_nThreads = std::max (std::min (maxThreads, m_nPartitions), 1U);
+#endif
+  m_workerNext.assign (m_nThreads, NO_EVENT);
+
+  // hand the events of the nodes over to their partitions
+  std::vector<Scheduler::Event> global;
+  while (!m_global.m_events->IsEmpty ())
+    {
+      Scheduler::Event ev = m_global.m_events->RemoveNext ();
+      uint32_t index = GetPartitionIndex (ev.key.m_context);
+      if (index == m_nPartitions)
+        {
+          global.push_back (ev);
+          continue;
+        }
+      m_partitions[index]->m_events->Insert (ev);
+      m_partitions[index]->m_unscheduledEvents++;
+      m_global.m_unscheduledEvents--;
+    }
+  for (std::vector<Scheduler::Event>::const_iterator i = global.begin (); i != global.end (); ++i)
+    {
+      m_global.m_events->Insert (*i);
+    }
+  m_running = true;
+
+  NS_LOG_LOGIC (m_nPartitions << " partitions, " << m_nThreads << " threads, lookahead " << m_lookAhead);
+}
+
+void
+MultithreadedSimulatorImpl::Teardown (void)
+{
+  m_running = false;
+  uint64_t currentTs = m_global.m_currentTs;
+  uint32_t currentUid = m_global.m_currentUid;
+  uint32_t uid = m_global.m_uid;
+  for (uint32_t i = 0; i < m_nPartitions; ++i)
+    {
+      struct Partition *partition = m_partitions[i];
+      while (!partition->m_events->IsEmpty ())
+        {
+          m_global.m_events->Insert (partition->m_events->RemoveNext ());
+        }
+      m_global.m_unscheduledEvents += partition->m_unscheduledEvents;
+      if (partition->m_currentTs > currentTs)
+        {
+          currentTs = partition->m_currentTs;
+          currentUid = partition->m_currentUid;
+        }
+      uid = std::max (uid, partition->m_uid);
+      delete partition;
+    }
+  if (m_stopTs != NO_EVENT)
+    {
+      // the events left in the partitions are not earlier than the stop
+      currentTs = m_stopTs;
+      currentUid = m_stopUid;
+    }
+  m_partitions.clear ();
+  m_partitionOf.clear ();
+  m_global.m_outbox.clear ();
+  m_global.m_currentTs = currentTs;
+  m_global.m_currentUid = currentUid;
+  m_global.m_currentContext = 0xffffffff;
+  m_global.m_uid = uid;
+  m_global.m_windowEnd = 0;
+  m_uidStride = 1;
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookAhead (void)
+{
+  m_lookAhead = NO_EVENT;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      uint32_t local = m_partitionOf[node->GetId ()];
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (j);
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              Ptr<Node> remoteNode = channel->GetDevice (k)->GetNode ();
+              if (m_partitionOf[remoteNode->GetId ()] == local)
+                {
+                  continue;
+                }
+              // only point-to-point links can join two partitions: their
+              // delay is the lookahead, and the remote channel does not
+              // share its packets between the partitions.
+              TypeId remoteChannel;
+              if (!TypeId::LookupByNameFailSafe ("ns3::PointToPointRemoteChannel", &remoteChannel)
+                  || (channel->GetInstanceTypeId () != remoteChannel
+                      && !channel->GetInstanceTypeId ().IsChildOf (remoteChannel)))
+                {
+                  NS_FATAL_ERROR ("Nodes " << node->GetId () << " and " << remoteNode->GetId () <<
+                                  " are in different partitions but not linked by a PointToPointRemoteChannel;"
+                                  " select the simulator with SimulatorImplementationType before building the topology");
+                }
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (!delay.Get ().IsStrictlyPositive ())
+                {
+                  NS_FATAL_ERROR ("Zero delay link between nodes " << node->GetId () << " and " <<
+                                  remoteNode->GetId () << " of different partitions");
+                }
+              m_lookAhead = std::min (m_lookAhead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+            }
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  uint32_t generation = m_barrierGeneration;
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_nThreads)
+    {
+      m_barrierCount = 0;
+      __sync_synchronize ();
+      m_barrierGeneration = generation + 1;
+    }
+  else
+    {
+      uint32_t spins = 0;
+      while (m_barrierGeneration == generation)
+        {
+          if (++spins > 1000)
+            {
+              sched_yield ();
+            }
+        }
+    }
+  __sync_synchronize ();
+}
+
+void
+MultithreadedSimulatorImpl::Merge (uint32_t index)
+{
+  struct Partition *partition = m_partitions[index];
+  for (uint32_t i = 0; i <= m_nPartitions; ++i)
+    {
+      std::vector<Scheduler::Event> &outbox = m_partitions[i]->m_outbox[index];
+      for (std::vector<Scheduler::Event>::const_iterator j = outbox.begin (); j != outbox.end (); ++j)
+        {
+          partition->m_events->Insert (*j);
+        }
+      partition->m_unscheduledEvents += outbox.size ();
+      outbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (struct Partition *partition)
+{
+  Scheduler::Event next = partition->m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition->m_currentTs);
+  partition->m_unscheduledEvents--;
+
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition->m_currentTs = next.key.m_ts;
+  partition->m_currentContext = next.key.m_context;
+  partition->m_currentUid = next.key.m_uid;
+  m_current = partition;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Work (void)
+{
+  DoRun (__sync_add_and_fetch (&m_nextWorker, 1));
+}
+
+void
+MultithreadedSimulatorImpl::DoRun (uint32_t worker)
+{
+  while (true)
+    {
+      // take in the events sent to our partitions by the last window
+      uint64_t next = NO_EVENT;
+      for (uint32_t i = worker; i < m_nPartitions; i += m_nThreads)
+        {
+          Merge (i);
+          next = std::min (next, NextTs (m_partitions[i]));
+        }
+      if (worker == 0)
+        {
+          Merge (m_nPartitions);
+          m_globalNext = NextTs (&m_global);
+        }
+      m_workerNext[worker] = next;
+      bool stop = m_stop;
+      Barrier ();
+
+      uint64_t smallest = m_globalNext;
+      for (uint32_t i = 0; i < m_nThreads; ++i)
+        {
+          smallest = std::min (smallest, m_workerNext[i]);
+        }
+      if (stop || smallest == NO_EVENT)
+        {
+          break;
+        }
+
+      if (m_globalNext == smallest)
+        {
+          // the global events may touch any node: run them alone
+          if (worker == 0)
+            {
+              while (!m_stop && NextTs (&m_global) == smallest)
+                {
+                  ProcessOneEvent (&m_global);
+                }
+            }
+          Barrier ();
+          continue;
+        }
+
+      // no partition can receive an event for a time earlier than
+      // smallest + lookahead from another partition
+      uint64_t end = NO_EVENT;
+      if (m_lookAhead < NO_EVENT - smallest)
+        {
+          end = smallest + m_lookAhead;
+        }
+      end = std::min (end, m_globalNext);
+      for (uint32_t i = worker; i < m_nPartitions; i += m_nThreads)
+        {
+          struct Partition *partition = m_partitions[i];
+          partition->m_windowEnd = end;
+          // a Stop from any partition clamps the window to its time
+          while (NextTs (partition) < std::min (end, static_cast<uint64_t> (m_stopTs)))
+            {
+              ProcessOneEvent (partition);
+            }
+        }
+      Barrier ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  m_stop = false;
+  m_stopTs = NO_EVENT;
+  Setup ();
+
+  std::vector<Ptr<SystemThread> > threads;
+  m_nextWorker = 0;
+  for (uint32_t i = 1; i < m_nThreads; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Work, this));
+      thread->Start ();
+      threads.push_back (thread);
+    }
+  DoRun (0);
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_current = 0;
+
+  Teardown ();
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!m_global.m_events->IsEmpty () || m_global.m_unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::RunOneEvent (void)
+{
+  ProcessOneEvent (&m_global);
+  m_current = 0;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  return m_global.m_events->IsEmpty () || m_stop;
+}
+
+Time
+MultithreadedSimulatorImpl::Next (void) const
+{
+  NS_ASSERT (!m_global.m_events->IsEmpty ());
+  return TimeStep (NextTs (&m_global));
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  struct Partition *partition = GetCurrent ();
+  CriticalSection cs (m_stopMutex);
+  if (m_running && partition->m_currentTs < m_stopTs)
+    {
+      m_stopTs = partition->m_currentTs;
+      m_stopUid = partition->m_currentUid;
+    }
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  Simulator::Schedule (time, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  struct Partition *partition = GetCurrent ();
+  Time tAbsolute = time + TimeStep (partition->m_currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->m_currentTs));
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = static_cast<uint64_t> (tAbsolute.GetTimeStep ());
+  ev.key.m_context = partition->m_currentContext;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid += m_uidStride;
+  partition->m_unscheduledEvents++;
+  partition->m_events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  struct Partition *partition = GetCurrent ();
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = partition->m_currentTs + time.GetTimeStep ();
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid += m_uidStride;
+
+  if (!m_running)
+    {
+      partition->m_unscheduledEvents++;
+      partition->m_events->Insert (ev);
+      return;
+    }
+  uint32_t index = GetPartitionIndex (context);
+  struct Partition *destination = m_partitions[index];
+  if (destination == partition || partition == &m_global)
+    {
+      // the global events run while the other threads wait
+      destination->m_unscheduledEvents++;
+      destination->m_events->Insert (ev);
+      return;
+    }
+  if (ev.key.m_ts < partition->m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " scheduled " << time.GetTimeStep () <<
+                      " time steps ahead, within the lookahead of " << m_lookAhead);
+    }
+  partition->m_outbox[index].push_back (ev);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  struct Partition *partition = GetCurrent ();
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = partition->m_currentTs;
+  ev.key.m_context = partition->m_currentContext;
+  ev.key.m_uid = partition->m_uid;
+  partition->m_uid += m_uidStride;
+  partition->m_unscheduledEvents++;
+  partition->m_events->Insert (ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->m_currentTs, 0xffffffff, 2);
+  CriticalSection cs (m_destroyMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  return TimeStep (GetCurrent ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  struct Partition *partition = &m_global;
+  if (m_running)
+    {
+      partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+      if (partition != GetCurrent () && GetCurrent () != &m_global)
+        {
+          NS_FATAL_ERROR ("Can't remove an event of another partition");
+        }
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0
+          || ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const struct Partition *partition = &m_global;
+  if (m_running)
+    {
+      partition = m_partitions[GetPartitionIndex (ev.GetContext ())];
+    }
+  if (ev.PeekEventImpl () == 0
+      || ev.GetTs () < partition->m_currentTs
+      || (ev.GetTs () == partition->m_currentTs
+          && ev.GetUid () <= partition->m_currentUid)
+      || ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  // XXX: I am fairly certain other compilers use other non-standard
+  // post-fixes to indicate 64 bit constants.
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->m_currentContext;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  if (m_lookAhead == NO_EVENT)
+    {
+      return GetMaximumSimulationTime ();
+    }
+  return TimeStep (m_lookAhead);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_nPartitions;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetThreadCount (void) const
+{
+  return m_nThreads;
+}
+
+} // namespace ns3
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-mutex.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator for shared-memory machines
+ *
+ * The nodes are split into logical processes according to their
+ * system id, as with the DistributedSimulatorImpl, but all logical
+ * processes live in this process and are run by a pool of threads.
+ * Each logical process has its own event list, which holds the events
+ * of its nodes' contexts; events which do not belong to a node (the
+ * events scheduled from the main program, for example) are run by the
+ * main thread while the other threads wait.
+ *
+ * The logical processes are synchronized by windows: the lookahead is
+ * the smallest delay of the point-to-point channels which connect two
+ * logical processes, so that all the events of the next lookahead
+ * worth of simulation time can be run in parallel. The events a window
+ * sends to another logical process are handed over at the end of the
+ * window. When an event calls Stop, the partitions stop before the time
+ * of that event and the simulation time is that time: only a partition
+ * run earlier in the same window by the same thread, or concurrently by
+ * another thread, may already have run events up to the end of the
+ * window. Links between logical processes must use a
+ * PointToPointRemoteChannel (the PointToPointHelper does so for nodes
+ * with different system ids), which gives the receiver its own copy of
+ * each packet.
+ *
+ * This simulator must be selected with the SimulatorImplementationType
+ * global value before the topology is built.
+ *
+ * A model run by this simulator may only touch the objects of the
+ * nodes of its own logical process. Several threads are only used
+ * when ns-3 is configured with --enable-multithreaded-simulator, which
+ * makes the reference counts atomic; otherwise, all the logical
+ * processes are run in turn by the main thread.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * \returns true if the SimulatorImplementationType global value
+   *          selects this simulator
+   *
+   * The topology helpers use remote channels between the system ids
+   * only if so; unlike Simulator::GetImplementation, this does not
+   * create the simulator.
+   */
+  static bool IsEnabled (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual Time Next (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual void RunOneEvent (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the lookahead used by the last run
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \returns the number of logical processes of the last run
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \returns the number of threads used by the last run
+   */
+  uint32_t GetThreadCount (void) const;
+
+private:
+  struct Partition
+  {
+    Ptr<Scheduler> m_events;
+    uint32_t m_uid;
+    uint32_t m_currentUid;
+    uint64_t m_currentTs;
+    uint32_t m_currentContext;
+    // number of events that have been inserted but not yet scheduled,
+    // not counting the "destroy" events; this is used for validation
+    int m_unscheduledEvents;
+    // end of the window being run
+    uint64_t m_windowEnd;
+    // events sent to the other partitions, indexed by destination
+    std::vector<std::vector<Scheduler::Event> > m_outbox;
+  };
+
+  virtual void DoDispose (void);
+  void Setup (void);
+  void Teardown (void);
+  void CalculateLookAhead (void);
+  void Work (void);
+  void DoRun (uint32_t worker);
+  void Barrier (void);
+  void Merge (uint32_t index);
+  void ProcessOneEvent (struct Partition *partition);
+  struct Partition *GetCurrent (void) const;
+  uint32_t GetPartitionIndex (uint32_t context) const;
+  uint64_t NextTs (const struct Partition *partition) const;
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyMutex;
+  ObjectFactory m_schedulerFactory;
+  // events which belong to no partition, and all the events outside of Run
+  struct Partition m_global;
+  // the partitions of the nodes, followed by m_global
+  std::vector<struct Partition *> m_partitions;
+  // partition index of each node, indexed by node id
+  std::vector<uint32_t> m_partitionOf;
+  uint32_t m_uidStride;
+  uint64_t m_lookAhead;
+  uint32_t m_maxThreads;
+  uint32_t m_nThreads;
+  uint32_t m_nPartitions;
+  // true while the events are held by the partitions
+  bool m_running;
+  volatile bool m_stop;
+  // time and uid of the earliest event which called Stop during Run;
+  // the partitions do not run the events from that time on
+  volatile uint64_t m_stopTs;
+  uint32_t m_stopUid;
+  SystemMutex m_stopMutex;
+  std::vector<uint64_t> m_workerNext;
+  uint64_t m_globalNext;
+  volatile uint32_t m_nextWorker;
+  volatile uint32_t m_barrierCount;
+  volatile uint32_t m_barrierGeneration;
+
+  static __thread struct Partition *m_current;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
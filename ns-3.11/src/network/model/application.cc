@@ -54,6 +54,8 @@ Application::GetTypeId (void)
 
 // \brief Application Constructor
 Application::Application()
+  : m_running (false),
+    m_index (0)
 {
 }
 
@@ -86,10 +88,10 @@ Application::DoDispose (void)
 void
 Application::DoStart (void)
 {
-  m_startEvent = Simulator::Schedule (m_startTime, &Application::StartApplication, this);
+  m_startEvent = Simulator::Schedule (m_startTime, &Application::DoStartApplication, this);
   if (m_stopTime != TimeStep (0))
     {
-      m_stopEvent = Simulator::Schedule (m_stopTime, &Application::StopApplication, this);
+      m_stopEvent = Simulator::Schedule (m_stopTime, &Application::DoStopApplication, this);
     }
   Object::DoStart ();
 }
@@ -105,6 +107,23 @@ Application::SetNode (Ptr<Node> node)
   m_node = node;
 }
 
+void
+Application::DoStartApplication (void)
+{
+  m_running = true;
+  StartApplication ();
+}
+
+void
+Application::DoStopApplication (void)
+{
+  if (m_running)
+    {
+      m_running = false;
+      StopApplication ();
+    }
+}
+
 // Protected methods
 // StartApp and StopApp will likely be overridden by application subclasses
 void Application::StartApplication ()
@@ -119,6 +119,13 @@ private:
    * subclasses.
    */
   virtual void StopApplication (void);
+
+  friend class Node;
+  void DoStartApplication (void);
+  void DoStopApplication (void);
+
+  bool m_running;       // Started and not stopped yet
+  uint32_t m_index;     // Index within the list of the node
 protected:
   virtual void DoDispose (void);
   virtual void DoStart (void);
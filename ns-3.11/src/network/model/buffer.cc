@@ -18,7 +18,10 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "buffer.h"
+#include "checksum.h"
+#include "packet-pool.h"
 #include "ns3/assert.h"
+#include "ns3/core-config.h"
 #include "ns3/log.h"
 
 NS_LOG_COMPONENT_DEFINE ("Buffer");
@@ -45,113 +48,42 @@ static struct Zeroes
 
 namespace ns3 {
 
+// Each thread of the multithreaded simulator keeps its own heuristic.
+// Without thread-local storage, the heuristic is only safe when the
+// simulator cannot be driven by several threads; otherwise new buffers
+// always start at zero.
+#if defined (HAVE_TLS)
+#define BUFFER_HEURISTIC_ENABLED 1
+#define BUFFER_HEURISTIC_STORAGE static __thread
+#elif !defined (HAVE_PTHREAD_H)
+#define BUFFER_HEURISTIC_ENABLED 1
+#define BUFFER_HEURISTIC_STORAGE static
+#endif
 
-uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
+#ifdef BUFFER_HEURISTIC_ENABLED
+/**
+ * location in a newly-allocated buffer where you should start
+ * writing data. i.e., m_start should be initialized to this
+ * value. Each thread keeps its own value.
  */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
-
-void
-Buffer::Recycle (struct Buffer::Data *data)
-{
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
-}
+BUFFER_HEURISTIC_STORAGE uint32_t g_recommendedStart = 0;
+#define BUFFER_HEURISTIC_UPDATE(maxZeroAreaStart) \
+  g_recommendedStart = std::max (g_recommendedStart, maxZeroAreaStart)
+#else
+static const uint32_t g_recommendedStart = 0;
+#define BUFFER_HEURISTIC_UPDATE(maxZeroAreaStart)
+#endif
 
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
-{
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
-}
-#else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_ASSERT (data->m_count == 0);
-  Deallocate (data);
+  PacketPool::Deallocate (PacketPool::BUFFER_DATA, data,
+                          data->m_size - 1 + sizeof (struct Buffer::Data));
 }
 
-Buffer::Data *
-Buffer::Create (uint32_t size)
-{
-  return Allocate (size);
-}
-#endif /* BUFFER_FREE_LIST */
-
 struct Buffer::Data *
-Buffer::Allocate (uint32_t reqSize)
+Buffer::Create (uint32_t reqSize)
 {
   if (reqSize == 0) 
     {
@@ -159,21 +91,13 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
-  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  struct Buffer::Data *data = static_cast<struct Buffer::Data *> (PacketPool::Allocate (PacketPool::BUFFER_DATA, size));
+  // the rest of the block is free room for the buffer to grow into
+  data->m_size = PacketPool::GetBlockSize (size) + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
 
-void
-Buffer::Deallocate (struct Buffer::Data *data)
-{
-  NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
-}
-
 Buffer::Buffer ()
 {
   NS_LOG_FUNCTION (this);
@@ -259,7 +183,7 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  BUFFER_HEURISTIC_UPDATE (m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -273,7 +197,7 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  BUFFER_HEURISTIC_UPDATE (m_maxZeroAreaStart);
   m_data->m_count--;
   if (m_data->m_count == 0) 
     {
@@ -557,6 +481,28 @@ Buffer::CreateFullCopy (void) const
   return *this;
 }
 
+Buffer::Iterator
+Buffer::BeginWrite (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  if (m_data->m_count > 1)
+    {
+      /* The copy keeps the offsets of the data, so that the space
+       * in front of it is still available to AddAtStart.
+       */
+      struct Buffer::Data *newData = Buffer::Create (GetInternalEnd ());
+      memcpy (newData->m_data + m_start, m_data->m_data + m_start, GetInternalSize ());
+      m_data->m_count--;
+      m_data = newData;
+      m_data->m_dirtyStart = m_start;
+      m_data->m_dirtyEnd = m_end;
+      LOG_INTERNAL_STATE ("begin write, ");
+    }
+  NS_ASSERT (CheckInternalState ());
+  return Buffer::Iterator (this);
+}
+
 uint32_t 
 Buffer::GetSerializedSize (void) const
 {
@@ -1123,14 +1069,43 @@ Buffer::Iterator::CalculateIpChecksum (uint16_t size)
 uint16_t
 Buffer::Iterator::CalculateIpChecksum (uint16_t size, uint32_t initialChecksum)
 {
-  /* see RFC 1071 to understand this code. */
+  /* see RFC 1071 to understand this code. The bytes are summed a
+   * contiguous run at a time: the bytes in front of the zero area, which
+   * adds nothing, and the bytes behind it. A run which starts at an odd
+   * offset from the start of the checksum is summed as if it started at
+   * an even one, which swaps the bytes of its sum.
+   */
+  NS_ASSERT_MSG (m_current >= m_dataStart &&
+                 m_current + size <= m_dataEnd,
+                 GetReadErrorMessage ());
   uint32_t sum = initialChecksum;
+  uint32_t end = m_current + size;
+  bool odd = false;
 
-  for (int j = 0; j < size/2; j++)
-    sum += ReadU16 ();
-
-  if (size & 1)
-    sum += ReadU8 ();
+  if (m_current < m_zeroStart)
+    {
+      uint32_t n = std::min (end, m_zeroStart) - m_current;
+      sum += OnesComplementSum (m_data + m_current, n);
+      odd = n & 1;
+      m_current += n;
+    }
+  if (m_current < end && m_current < m_zeroEnd)
+    {
+      uint32_t n = std::min (end, m_zeroEnd) - m_current;
+      odd ^= n & 1;
+      m_current += n;
+    }
+  if (m_current < end)
+    {
+      uint32_t n = end - m_current;
+      uint16_t runSum = OnesComplementSum (m_data + m_current - (m_zeroEnd - m_zeroStart), n);
+      if (odd)
+        {
+          runSum = (runSum << 8) | (runSum >> 8);
+        }
+      sum += runSum;
+      m_current = end;
+    }
 
   while (sum >> 16)
     sum = (sum & 0xffff) + (sum >> 16);
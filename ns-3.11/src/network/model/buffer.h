@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define noBUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -478,6 +476,16 @@ private:
    * end of this Buffer.
    */
   inline Buffer::Iterator End (void) const;
+  /**
+   * \return an Iterator which points to the start of this Buffer,
+   * through which the bytes of the buffer can be overwritten in place.
+   *
+   * If the data of this Buffer is shared with copies of it, the data
+   * is copied first, so that the bytes written are not seen by the
+   * copies. Any call to this method invalidates any Iterator pointing
+   * to this Buffer.
+   */
+  Buffer::Iterator BeginWrite (void);
 
   Buffer CreateFullCopy (void) const;
 
@@ -572,8 +580,6 @@ private:
   uint32_t GetInternalEnd (void) const;
   static void Recycle (struct Buffer::Data *data);
   static struct Buffer::Data *Create (uint32_t size);
-  static struct Buffer::Data *Allocate (uint32_t reqSize);
-  static void Deallocate (struct Buffer::Data *data);
 
   struct Data *m_data;
 
@@ -587,12 +593,6 @@ private:
    * m_zeroAreaStart.
    */
   uint32_t m_maxZeroAreaStart;
-  /**
-   * location in a newly-allocated buffer where you should start
-   * writing data. i.e., m_start should be initialized to this 
-   * value.
-   */
-  static uint32_t g_recommendedStart;
 
   /* offset to the start of the virtual zero area from the start 
    * of m_data->m_data
@@ -610,17 +610,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize;
-  static FreeList *g_freeList;
-  static struct LocalStaticDestructor g_localStaticDestructor;
-#endif
 };
 
 } // namespace ns3
@@ -19,12 +19,17 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
 #include <vector>
 #include <string.h>
 
 NS_LOG_COMPONENT_DEFINE ("ByteTagList");
 
+// the free list is shared by all threads: the multithreaded simulator
+// goes straight to the heap instead.
+#ifndef NS3_MULTITHREADED
 #define USE_FREE_LIST 1
+#endif
 #define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
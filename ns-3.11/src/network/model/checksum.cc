@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "checksum.h"
+#include "ns3/assert.h"
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__SSE2__)
+#define CHECKSUM_HAVE_SSE2 1
+#include <emmintrin.h>
+#if defined (__clang__) || (defined (__GNUC__) && __GNUC__ >= 5)
+// The AVX2 kernel is compiled for AVX2 alone and run only if the
+// processor supports it
+#define CHECKSUM_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace ns3 {
+
+/*
+ * The kernels sum the bytes as little-endian 32 bit words or 16 bit lanes
+ * into a wider accumulator: as 2^16 = 1 modulo 2^16 - 1, folding the
+ * accumulator to 16 bits with end-around carries gives the one's
+ * complement sum of the 16 bit words.  The words are read in the order
+ * of Buffer::Iterator::ReadU16, that is little-endian, whatever the host.
+ */
+
+static uint64_t
+SumScalar (uint8_t const *data, uint32_t size)
+{
+  uint64_t sum = 0;
+  uint32_t i = 0;
+  for (; i + 4 <= size; i += 4)
+    {
+      sum += uint32_t (data[i])
+        | (uint32_t (data[i + 1]) << 8)
+        | (uint32_t (data[i + 2]) << 16)
+        | (uint32_t (data[i + 3]) << 24);
+    }
+  for (; i + 2 <= size; i += 2)
+    {
+      sum += uint32_t (data[i]) | (uint32_t (data[i + 1]) << 8);
+    }
+  if (i < size)
+    {
+      sum += data[i];
+    }
+  return sum;
+}
+
+#ifdef CHECKSUM_HAVE_SSE2
+static uint64_t
+SumSse2 (uint8_t const *data, uint32_t size)
+{
+  uint64_t sum = 0;
+  __m128i zero = _mm_setzero_si128 ();
+  while (size >= 16)
+    {
+      // Each 32 bit lane gains at most 2 * 0xffff per block: flush the
+      // lanes before they can overflow
+      uint32_t blocks = size / 16;
+      if (blocks > 16384)
+        {
+          blocks = 16384;
+        }
+      __m128i acc = zero;
+      for (uint32_t i = 0; i < blocks; i++)
+        {
+          __m128i v = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (data));
+          acc = _mm_add_epi32 (acc, _mm_unpacklo_epi16 (v, zero));
+          acc = _mm_add_epi32 (acc, _mm_unpackhi_epi16 (v, zero));
+          data += 16;
+        }
+      uint32_t lanes[4];
+      _mm_storeu_si128 (reinterpret_cast<__m128i *> (lanes), acc);
+      sum += uint64_t (lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+      size -= blocks * 16;
+    }
+  return sum + SumScalar (data, size);
+}
+#endif /* CHECKSUM_HAVE_SSE2 */
+
+#ifdef CHECKSUM_HAVE_AVX2
+__attribute__ ((target ("avx2")))
+static uint64_t
+SumAvx2 (uint8_t const *data, uint32_t size)
+{
+  uint64_t sum = 0;
+  __m256i zero = _mm256_setzero_si256 ();
+  while (size >= 32)
+    {
+      uint32_t blocks = size / 32;
+      if (blocks > 16384)
+        {
+          blocks = 16384;
+        }
+      __m256i acc = zero;
+      for (uint32_t i = 0; i < blocks; i++)
+        {
+          __m256i v = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (data));
+          acc = _mm256_add_epi32 (acc, _mm256_unpacklo_epi16 (v, zero));
+          acc = _mm256_add_epi32 (acc, _mm256_unpackhi_epi16 (v, zero));
+          data += 32;
+        }
+      uint32_t lanes[8];
+      _mm256_storeu_si256 (reinterpret_cast<__m256i *> (lanes), acc);
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          sum += lanes[i];
+        }
+      size -= blocks * 32;
+    }
+  return sum + SumScalar (data, size);
+}
+#endif /* CHECKSUM_HAVE_AVX2 */
+
+typedef uint64_t (*SumFunction)(uint8_t const *, uint32_t);
+
+static SumFunction
+GetSumFunction (ChecksumKernel kernel)
+{
+  switch (kernel)
+    {
+#ifdef CHECKSUM_HAVE_SSE2
+    case CHECKSUM_SSE2:
+      return &SumSse2;
+#endif
+#ifdef CHECKSUM_HAVE_AVX2
+    case CHECKSUM_AVX2:
+      return &SumAvx2;
+#endif
+    default:
+      return &SumScalar;
+    }
+}
+
+static ChecksumKernel
+GetFastestKernel (void)
+{
+  if (IsChecksumKernelSupported (CHECKSUM_AVX2))
+    {
+      return CHECKSUM_AVX2;
+    }
+  if (IsChecksumKernelSupported (CHECKSUM_SSE2))
+    {
+      return CHECKSUM_SSE2;
+    }
+  return CHECKSUM_SCALAR;
+}
+
+static uint16_t
+Fold (uint64_t sum)
+{
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
+bool
+IsChecksumKernelSupported (ChecksumKernel kernel)
+{
+  switch (kernel)
+    {
+    case CHECKSUM_SCALAR:
+      return true;
+    case CHECKSUM_SSE2:
+#ifdef CHECKSUM_HAVE_SSE2
+      return true;
+#else
+      return false;
+#endif
+    case CHECKSUM_AVX2:
+#ifdef CHECKSUM_HAVE_AVX2
+      __builtin_cpu_init ();
+      return __builtin_cpu_supports ("avx2");
+#else
+      return false;
+#endif
+    }
+  return false;
+}
+
+uint16_t
+OnesComplementSum (uint8_t const *data, uint32_t size)
+{
+  static SumFunction sum = GetSumFunction (GetFastestKernel ());
+  // Headers are summed far more often than payloads: leave them to the
+  // scalar kernel, which has no setup
+  if (size < 64)
+    {
+      return Fold (SumScalar (data, size));
+    }
+  return Fold (sum (data, size));
+}
+
+uint16_t
+OnesComplementSum (uint8_t const *data, uint32_t size, ChecksumKernel kernel)
+{
+  NS_ASSERT (IsChecksumKernelSupported (kernel));
+  return Fold (GetSumFunction (kernel) (data, size));
+}
+
+} // namespace ns3
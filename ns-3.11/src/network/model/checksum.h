@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief The implementations of OnesComplementSum
+ *
+ * The vector implementations are only available on x86 processors, and
+ * AVX2 only on those which support it.
+ */
+enum ChecksumKernel
+{
+  CHECKSUM_SCALAR,
+  CHECKSUM_SSE2,
+  CHECKSUM_AVX2
+};
+
+/**
+ * \ingroup packet
+ * \param data the bytes to sum
+ * \param size the number of bytes
+ * \returns the one's complement sum of the 16 bit words of the bytes
+ *
+ * This is the sum of the Internet checksum (RFC 1071), folded to 16 bits
+ * and not complemented, with the words read in the order of
+ * Buffer::Iterator::ReadU16; an odd last byte is the low byte of a last
+ * word.  The fastest kernel the processor supports computes it.
+ */
+uint16_t OnesComplementSum (uint8_t const *data, uint32_t size);
+
+/**
+ * \ingroup packet
+ * \param data the bytes to sum
+ * \param size the number of bytes
+ * \param kernel the implementation to use, which must be supported
+ * \returns the one's complement sum of the 16 bit words of the bytes
+ */
+uint16_t OnesComplementSum (uint8_t const *data, uint32_t size, ChecksumKernel kernel);
+
+/**
+ * \ingroup packet
+ * \returns true if the processor can run the kernel
+ */
+bool IsChecksumKernelSupported (ChecksumKernel kernel);
+
+/**
+ * \ingroup packet
+ * \returns the one's complement sum of two 16 bit words
+ */
+inline uint16_t
+OnesComplementAdd (uint16_t a, uint16_t b)
+{
+  uint32_t sum = uint32_t (a) + b;
+  return (sum & 0xffff) + (sum >> 16);
+}
+
+/**
+ * \ingroup packet
+ * \param checksum a checksum, as stored in a header
+ * \param oldWord a 16 bit word of the header covered by the checksum
+ * \param newWord the new value of the word
+ * \returns the checksum of the header with the new word
+ *
+ * This is equation 3 of RFC 1624, HC' = ~(~HC + ~m + m'), which does not
+ * need the rest of the header.  The checksum and the words may be read
+ * in either byte order, as long as it is the same for all three.
+ */
+inline uint16_t
+ChecksumUpdate (uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+{
+  uint16_t sum = OnesComplementAdd (~checksum, ~oldWord);
+  return ~OnesComplementAdd (sum, newWord);
+}
+
+} // namespace ns3
+
+#endif /* CHECKSUM_H */
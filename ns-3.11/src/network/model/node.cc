@@ -102,6 +102,12 @@ Node::GetSystemId (void) const
   return m_sid;
 }
 
+void
+Node::SetSystemId (uint32_t systemId)
+{
+  m_sid = systemId;
+}
+
 uint32_t
 Node::AddDevice (Ptr<NetDevice> device)
 {
@@ -134,6 +140,7 @@ Node::AddApplication (Ptr<Application> application)
   uint32_t index = m_applications.size ();
   m_applications.push_back (application);
   application->SetNode (this);
+  application->m_index = index;
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &Application::Start, application);
   return index;
@@ -145,6 +152,22 @@ Node::GetApplication (uint32_t index) const
                  " is out of range (only have " << m_applications.size () << " applications).");
   return m_applications[index];
 }
+void
+Node::RemoveApplication (Ptr<Application> application)
+{
+  uint32_t index = application->m_index;
+  NS_ASSERT_MSG (index < m_applications.size () && m_applications[index] == application,
+                 "Application is not associated to node " << m_id);
+  application->m_startEvent.Cancel ();
+  application->m_stopEvent.Cancel ();
+  application->DoStopApplication ();
+  m_applications[index] = m_applications.back ();
+  m_applications[index]->m_index = index;
+  m_applications.pop_back ();
+  // The application may be running the current event
+  Simulator::ScheduleNow (&Application::Dispose, application);
+}
+
 uint32_t 
 Node::GetNApplications (void) const
 {
@@ -83,6 +83,14 @@ public:
    *          to this node.
    */
   uint32_t GetSystemId (void) const;
+  /**
+   * \param systemId the system id for parallel simulations to
+   *        associate to this node.
+   *
+   * This must be done before the simulation starts, and before the
+   * routes of a distributed simulation are computed.
+   */
+  void SetSystemId (uint32_t systemId);
 
   /**
    * \param device NetDevice to associate to this node.
@@ -123,6 +131,20 @@ public:
    */
   Ptr<Application> GetApplication (uint32_t index) const;
 
+  /**
+   * \param application Application to remove from this node.
+   *
+   * Cancel the start and stop of the application, stop it if it
+   * is running and dispose of it once the current event has completed,
+   * so that an application may remove itself.  The last application of
+   * the list takes the index of the removed one: removing an application
+   * takes a constant time, whatever the number of applications.
+   *
+   * The application must not be used by the callbacks of its sockets
+   * once it has stopped.
+   */
+  void RemoveApplication (Ptr<Application> application);
+
   /**
    * \returns the number of applications associated to this Node.
    */
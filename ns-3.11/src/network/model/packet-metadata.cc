@@ -22,8 +22,10 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
 #include "packet-metadata.h"
 #include "buffer.h"
+#include "packet-pool.h"
 #include "header.h"
 #include "trailer.h"
 
@@ -36,16 +38,6 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -570,68 +562,26 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  uint32_t n = std::max<uint32_t> (m_maxSize, 10);
+  uint32_t bytes = sizeof (struct Data) + n - 10;
+  struct PacketMetadata::Data *data = static_cast<struct PacketMetadata::Data *> (PacketPool::Allocate (PacketPool::METADATA, bytes));
+  // the rest of the block is free room for the items, as far as the
+  // 16 bit offsets reach
+  data->m_size = std::min<uint32_t> (PacketPool::GetBlockSize (bytes) - sizeof (struct Data) + 10, 0xfffe);
+  data->m_count = 1;
+  data->m_dirtyEnd = 0;
+  NS_LOG_LOGIC ("create alloc size="<<data->m_size);
+  return data;
 }
 
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
+  NS_LOG_LOGIC ("recycle size="<<data->m_size);
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketPool::Deallocate (PacketPool::METADATA, data, sizeof (struct Data) + data->m_size - 10);
 }
 
-struct PacketMetadata::Data *
-PacketMetadata::Allocate (uint32_t n)
-{
-  uint32_t size = sizeof (struct Data);
-  if (n <= 10)
-    {
-      n = 10;
-    }
-  size += n - 10;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
-  data->m_count = 1;
-  data->m_dirtyEnd = 0;
-  return data;
-}
-void 
-PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
-{
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
-}
-
-
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 {
@@ -284,13 +284,6 @@ private:
     uint64_t packetUid;
   };
 
-  class DataFreeList : public std::vector<struct Data *>
-  {
-public:
-    ~DataFreeList ();
-  };
-
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
@@ -324,10 +317,7 @@ public:
 
   static struct PacketMetadata::Data *Create (uint32_t size);
   static void Recycle (struct PacketMetadata::Data *data);
-  static struct PacketMetadata::Data *Allocate (uint32_t n);
-  static void Deallocate (struct PacketMetadata::Data *data);
 
-  static DataFreeList m_freeList;
   static bool m_enable;
   static bool m_enableChecking;
 
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "packet-pool.h"
+#include "ns3/assert.h"
+#include "ns3/core-config.h"
+#include <new>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+// Without thread-local storage, the pools are only safe when the
+// simulator cannot be driven by several threads.
+#if defined (HAVE_TLS)
+#define PACKET_POOL_ENABLED 1
+#define PACKET_POOL_STORAGE static __thread
+#if defined (HAVE_PTHREAD_H)
+#define PACKET_POOL_THREAD_EXIT 1
+#endif
+#elif !defined (HAVE_PTHREAD_H)
+#define PACKET_POOL_ENABLED 1
+#define PACKET_POOL_STORAGE static
+#endif
+
+namespace ns3 {
+
+namespace {
+
+// Blocks up to the first limit are rounded to a multiple of the
+// granularity, larger blocks to a power of two up to 64 KiB
+const uint32_t PACKET_POOL_GRANULARITY = 16;
+const uint32_t PACKET_POOL_SMALL_CLASSES = 16;
+const uint32_t PACKET_POOL_SMALL_LIMIT = PACKET_POOL_GRANULARITY * PACKET_POOL_SMALL_CLASSES;
+const uint32_t PACKET_POOL_CLASSES = PACKET_POOL_SMALL_CLASSES + 8;
+// Bytes of released blocks kept for reuse per size class; the others
+// go back to the system, so that a thread releasing the blocks
+// allocated by another one does not hoard them.
+const uint32_t PACKET_POOL_MAX_FREE_BYTES = 1 << 20;
+
+struct PacketPoolBlock
+{
+  PacketPoolBlock *m_next;
+};
+
+struct PacketPoolState
+{
+  PacketPoolBlock *m_free[PACKET_POOL_CLASSES]; // released blocks
+  uint32_t m_freeBytes[PACKET_POOL_CLASSES];
+  PacketPool::Stats m_stats[PacketPool::KIND_COUNT];
+  bool m_atExit;
+};
+
+#ifdef PACKET_POOL_ENABLED
+PACKET_POOL_STORAGE PacketPoolState g_packetPool;
+#else
+PacketPoolState g_packetPool;
+#endif
+
+#ifdef PACKET_POOL_THREAD_EXIT
+void
+ReleasePacketPool (void *p)
+{
+  PacketPoolState *pool = static_cast<PacketPoolState *> (p);
+  for (uint32_t i = 0; i < PACKET_POOL_CLASSES; i++)
+    {
+      while (pool->m_free[i] != 0)
+        {
+          PacketPoolBlock *block = pool->m_free[i];
+          pool->m_free[i] = block->m_next;
+          ::operator delete (block);
+        }
+      pool->m_freeBytes[i] = 0;
+    }
+}
+
+pthread_key_t g_packetPoolKey;
+pthread_once_t g_packetPoolKeyOnce = PTHREAD_ONCE_INIT;
+
+void
+CreatePacketPoolKey (void)
+{
+  pthread_key_create (&g_packetPoolKey, &ReleasePacketPool);
+}
+
+// Give the released blocks of the calling thread back to the system
+// when it exits
+void
+ReleasePacketPoolAtExit (PacketPoolState &pool)
+{
+  pool.m_atExit = true;
+  pthread_once (&g_packetPoolKeyOnce, &CreatePacketPoolKey);
+  pthread_setspecific (g_packetPoolKey, &pool);
+}
+#endif
+
+// The size class of the blocks of size bytes, PACKET_POOL_CLASSES if
+// they are too large for the pool
+uint32_t
+GetSizeClass (uint32_t size)
+{
+  if (size <= PACKET_POOL_SMALL_LIMIT)
+    {
+      return size == 0 ? 0 : (size - 1) / PACKET_POOL_GRANULARITY;
+    }
+  uint32_t sizeClass = PACKET_POOL_SMALL_CLASSES;
+  for (uint32_t blockSize = PACKET_POOL_SMALL_LIMIT * 2; blockSize < size; blockSize <<= 1)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+uint32_t
+GetClassSize (uint32_t sizeClass)
+{
+  if (sizeClass < PACKET_POOL_SMALL_CLASSES)
+    {
+      return (sizeClass + 1) * PACKET_POOL_GRANULARITY;
+    }
+  return PACKET_POOL_SMALL_LIMIT << (sizeClass - PACKET_POOL_SMALL_CLASSES + 1);
+}
+
+void
+AddBytes (PacketPool::Stats &stats, int64_t bytes)
+{
+  stats.bytesInUse += bytes;
+  if (stats.bytesInUse > stats.peakBytesInUse)
+    {
+      stats.peakBytesInUse = stats.bytesInUse;
+    }
+}
+
+} // anonymous namespace
+
+uint32_t
+PacketPool::GetBlockSize (uint32_t size)
+{
+  uint32_t sizeClass = GetSizeClass (size);
+  if (sizeClass < PACKET_POOL_CLASSES)
+    {
+      return GetClassSize (sizeClass);
+    }
+  return size;
+}
+
+void *
+PacketPool::Allocate (enum Kind kind, uint32_t size)
+{
+  NS_ASSERT (kind < KIND_COUNT);
+  PacketPoolState &pool = g_packetPool;
+  Stats &stats = pool.m_stats[kind];
+  uint32_t blockSize = GetBlockSize (size);
+  AddBytes (stats, blockSize);
+#ifdef PACKET_POOL_ENABLED
+  uint32_t sizeClass = GetSizeClass (size);
+  if (sizeClass < PACKET_POOL_CLASSES)
+    {
+      PacketPoolBlock *block = pool.m_free[sizeClass];
+      if (block != 0)
+        {
+          pool.m_free[sizeClass] = block->m_next;
+          pool.m_freeBytes[sizeClass] -= blockSize;
+          stats.recycles++;
+          return block;
+        }
+    }
+#endif
+  stats.allocations++;
+  return ::operator new (blockSize);
+}
+
+void
+PacketPool::Deallocate (enum Kind kind, void *block, uint32_t size)
+{
+  NS_ASSERT (kind < KIND_COUNT);
+  PacketPoolState &pool = g_packetPool;
+  AddBytes (pool.m_stats[kind], -int64_t (GetBlockSize (size)));
+#ifdef PACKET_POOL_ENABLED
+  uint32_t sizeClass = GetSizeClass (size);
+  if (sizeClass < PACKET_POOL_CLASSES
+      && pool.m_freeBytes[sizeClass] + GetClassSize (sizeClass) <= PACKET_POOL_MAX_FREE_BYTES)
+    {
+#ifdef PACKET_POOL_THREAD_EXIT
+      if (!pool.m_atExit)
+        {
+          ReleasePacketPoolAtExit (pool);
+        }
+#endif
+      PacketPoolBlock *b = static_cast<PacketPoolBlock *> (block);
+      b->m_next = pool.m_free[sizeClass];
+      pool.m_free[sizeClass] = b;
+      pool.m_freeBytes[sizeClass] += GetClassSize (sizeClass);
+      return;
+    }
+#endif
+  ::operator delete (block);
+}
+
+struct PacketPool::Stats
+PacketPool::GetStats (enum Kind kind)
+{
+  NS_ASSERT (kind < KIND_COUNT);
+  return g_packetPool.m_stats[kind];
+}
+
+uint64_t
+PacketPool::GetFreeBytes (void)
+{
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < PACKET_POOL_CLASSES; i++)
+    {
+      bytes += g_packetPool.m_freeBytes[i];
+    }
+  return bytes;
+}
+
+uint32_t
+PacketPool::GetMaxFreeBytes (void)
+{
+  return PACKET_POOL_MAX_FREE_BYTES;
+}
+
+void
+PacketPool::ResetPeak (void)
+{
+  for (uint32_t kind = 0; kind < KIND_COUNT; kind++)
+    {
+      Stats &stats = g_packetPool.m_stats[kind];
+      stats.peakBytesInUse = stats.bytesInUse;
+    }
+}
+
+} // namespace ns3
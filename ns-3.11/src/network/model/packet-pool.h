@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief The memory of the bytes, metadata and tags of packets
+ *
+ * The bytes of a Buffer, the items of a PacketMetadata and the tags of
+ * a PacketTagList are allocated in blocks of a few size classes: 16 byte
+ * steps up to 256 bytes, then powers of two up to 64 KiB.  Larger blocks
+ * come from the system allocator.  A released block is kept on a free
+ * list of the thread which releases it, for the next block of its size
+ * class that thread allocates.  Each thread keeps at most
+ * GetMaxFreeBytes of released blocks per size class and gives the others
+ * back to the system, as well as all of them when it exits.
+ *
+ * Each thread keeps its own statistics: a block released by another
+ * thread than the one which allocated it counts in the statistics of
+ * the thread which released it.
+ */
+class PacketPool
+{
+public:
+  /**
+   * The users of the pool, which have separate statistics
+   */
+  enum Kind
+  {
+    BUFFER_DATA,
+    METADATA,
+    PACKET_TAGS,
+    KIND_COUNT
+  };
+
+  /**
+   * The statistics of a kind of block, for the calling thread
+   */
+  struct Stats
+  {
+    /// blocks of memory not used by a block before
+    uint64_t allocations;
+    /// blocks of memory released by a block of the same size class
+    uint64_t recycles;
+    /// bytes of the blocks not released yet
+    int64_t bytesInUse;
+    /// the largest value bytesInUse took
+    int64_t peakBytesInUse;
+  };
+
+  /**
+   * \param kind the user of the block
+   * \param size the number of bytes needed
+   * \returns a block of at least GetBlockSize (size) bytes
+   */
+  static void *Allocate (enum Kind kind, uint32_t size);
+  /**
+   * \param kind the user of the block
+   * \param block a block returned by Allocate
+   * \param size the size given to Allocate, or the block size
+   */
+  static void Deallocate (enum Kind kind, void *block, uint32_t size);
+  /**
+   * \param size a number of bytes
+   * \returns the number of bytes of the blocks allocated for size bytes
+   *
+   * A user may store up to this number of bytes in its block, and give
+   * it back to Deallocate.
+   */
+  static uint32_t GetBlockSize (uint32_t size);
+  /**
+   * \param kind a user of the pool
+   * \returns the statistics of the calling thread for this user
+   */
+  static struct Stats GetStats (enum Kind kind);
+  /**
+   * \returns the number of bytes of the released blocks the calling
+   *          thread keeps for reuse
+   */
+  static uint64_t GetFreeBytes (void);
+  /**
+   * \returns the largest number of bytes of released blocks of one size
+   *          class a thread keeps
+   */
+  static uint32_t GetMaxFreeBytes (void);
+  /**
+   * Start the peak of the statistics of the calling thread over, from
+   * the bytes in use now.
+   */
+  static void ResetPeak (void);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_H */
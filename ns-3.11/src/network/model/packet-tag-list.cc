@@ -20,157 +20,274 @@
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "packet-pool.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
 #include <string.h>
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
 namespace ns3 {
 
-#ifdef USE_FREE_LIST
+namespace {
 
-struct PacketTagList::TagData *PacketTagList::g_free = 0;
-uint32_t PacketTagList::g_nfree = 0;
+// The header of a tag stored out of line, followed by its bytes
+struct OverflowEntry
+{
+  TypeId tid;
+  uint16_t size;
+};
+
+uint32_t
+GetEntrySize (uint32_t size)
+{
+  return (sizeof (struct OverflowEntry) + size + 3) & ~3U;
+}
+
+} // anonymous namespace
+
+struct PacketTagList::Overflow *
+PacketTagList::AllocOverflow (uint32_t size)
+{
+  NS_LOG_FUNCTION (size);
+  uint32_t bytes = size - 4 + sizeof (struct Overflow);
+  void *block = PacketPool::Allocate (PacketPool::PACKET_TAGS, bytes);
+  struct Overflow *overflow = static_cast<struct Overflow *> (block);
+  overflow->count = 1;
+  overflow->used = 0;
+  overflow->size = PacketPool::GetBlockSize (bytes) + 4 - sizeof (struct Overflow);
+  return overflow;
+}
+
+void
+PacketTagList::FreeOverflow (struct Overflow *overflow)
+{
+  NS_LOG_FUNCTION (overflow);
+  NS_ASSERT (overflow->count == 0);
+  PacketPool::Deallocate (PacketPool::PACKET_TAGS, overflow,
+                          overflow->size - 4 + sizeof (struct Overflow));
+}
 
-struct PacketTagList::TagData *
-PacketTagList::AllocData (void) const
+uint8_t *
+PacketTagList::Find (TypeId tid, uint32_t *size) const
 {
-  NS_LOG_FUNCTION (g_nfree);
-  struct PacketTagList::TagData *retval;
-  if (g_free != 0) 
+  if ((m_mask & GetMaskBit (tid)) == 0)
     {
-      retval = g_free;
-      g_free = g_free->m_next;
-      g_nfree--;
-    } 
-  else 
+      return 0;
+    }
+  for (uint32_t i = 0; i < m_nSlots; i++)
     {
-      retval = new struct PacketTagList::TagData ();
+      if (m_slots[i].tid == tid)
+        {
+          *size = m_slots[i].size;
+          return const_cast<uint8_t *> (m_slots[i].data);
+        }
+    }
+  if (m_overflow == 0)
+    {
+      return 0;
     }
-  return retval;
+  for (uint32_t offset = 0; offset < m_overflow->used; )
+    {
+      struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[offset]);
+      if (entry->tid == tid)
+        {
+          *size = entry->size;
+          return reinterpret_cast<uint8_t *> (entry + 1);
+        }
+      offset += GetEntrySize (entry->size);
+    }
+  return 0;
 }
 
-void
-PacketTagList::FreeData (struct TagData *data) const
+uint8_t *
+PacketTagList::Reserve (TypeId tid, uint32_t size)
 {
-  NS_LOG_FUNCTION (g_nfree << data);
-  if (g_nfree > 1000) 
+  m_mask |= GetMaskBit (tid);
+  if (size <= PACKET_TAG_MAX_SIZE && m_nSlots < PACKET_TAG_INLINE_SLOTS)
     {
-      delete data;
-      return;
+      struct TagSlot &slot = m_slots[m_nSlots];
+      m_nSlots++;
+      slot.tid = tid;
+      slot.size = size;
+      return slot.data;
+    }
+  NS_ASSERT_MSG (size <= 0xffff, "Packet tags are limited to 65535 bytes");
+  uint32_t entrySize = GetEntrySize (size);
+  uint32_t used = m_overflow == 0 ? 0 : m_overflow->used;
+  if (m_overflow == 0 || m_overflow->count > 1 || used + entrySize > m_overflow->size)
+    {
+      // Copy the tags to a block of our own, large enough for the new
+      // tag and for a few more
+      struct Overflow *overflow = AllocOverflow (std::max (used + entrySize, 2 * used));
+      if (m_overflow != 0)
+        {
+          memcpy (overflow->data, m_overflow->data, used);
+          overflow->used = used;
+          m_overflow->count--;
+          if (m_overflow->count == 0)
+            {
+              FreeOverflow (m_overflow);
+            }
+        }
+      m_overflow = overflow;
     }
-  g_nfree++;
-  data->next = g_free;
-  data->tid = TypeId ();
-  g_free = data;
+  struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[used]);
+  entry->tid = tid;
+  entry->size = size;
+  m_overflow->used += entrySize;
+  return reinterpret_cast<uint8_t *> (entry + 1);
 }
-#else
-struct PacketTagList::TagData *
-PacketTagList::AllocData (void) const
+
+void
+PacketTagList::RemoveOverflowEntry (uint32_t offset)
 {
-  NS_LOG_FUNCTION_NOARGS ();
-  struct PacketTagList::TagData *retval;
-  retval = new struct PacketTagList::TagData ();
-  return retval;
+  struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[offset]);
+  uint32_t entrySize = GetEntrySize (entry->size);
+  uint32_t used = m_overflow->used - entrySize;
+  uint32_t after = used - offset;
+  if (used == 0)
+    {
+      m_overflow->count--;
+      if (m_overflow->count == 0)
+        {
+          FreeOverflow (m_overflow);
+        }
+      m_overflow = 0;
+    }
+  else if (m_overflow->count > 1)
+    {
+      // the other copies of the packet keep the tag
+      struct Overflow *overflow = AllocOverflow (used);
+      memcpy (overflow->data, m_overflow->data, offset);
+      memcpy (overflow->data + offset, m_overflow->data + offset + entrySize, after);
+      overflow->used = used;
+      m_overflow->count--;
+      m_overflow = overflow;
+    }
+  else
+    {
+      memmove (m_overflow->data + offset, m_overflow->data + offset + entrySize, after);
+      m_overflow->used = used;
+    }
 }
 
 void
-PacketTagList::FreeData (struct TagData *data) const
+PacketTagList::UpdateMask (void)
 {
-  NS_LOG_FUNCTION (data);
-  delete data;
+  m_mask = 0;
+  for (uint32_t i = 0; i < m_nSlots; i++)
+    {
+      m_mask |= GetMaskBit (m_slots[i].tid);
+    }
+  if (m_overflow == 0)
+    {
+      return;
+    }
+  for (uint32_t offset = 0; offset < m_overflow->used; )
+    {
+      struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[offset]);
+      m_mask |= GetMaskBit (entry->tid);
+      offset += GetEntrySize (entry->size);
+    }
 }
-#endif
 
 bool
 PacketTagList::Remove (Tag &tag)
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  bool found = false;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  if ((m_mask & GetMaskBit (tid)) == 0)
     {
-      if (cur->tid == tid) 
+      return false;
+    }
+  for (uint32_t i = 0; i < m_nSlots; i++)
+    {
+      if (m_slots[i].tid == tid)
         {
-          found = true;
-          tag.Deserialize (TagBuffer (cur->data, cur->data+PACKET_TAG_MAX_SIZE));
+          tag.Deserialize (TagBuffer (m_slots[i].data, m_slots[i].data + m_slots[i].size));
+          // keep the other tags in the order they were added
+          for (uint32_t j = i + 1; j < m_nSlots; j++)
+            {
+              m_slots[j - 1] = m_slots[j];
+            }
+          m_nSlots--;
+          UpdateMask ();
+          return true;
         }
     }
-  if (!found) 
+  if (m_overflow == 0)
     {
       return false;
     }
-  struct TagData *start = 0;
-  struct TagData **prevNext = &start;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (uint32_t offset = 0; offset < m_overflow->used; )
     {
-      if (cur->tid == tid) 
+      struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[offset]);
+      if (entry->tid == tid)
         {
-          /**
-           * XXX
-           * Note: I believe that we could optimize this to
-           * avoid copying each TagData located after the target id
-           * and just link the already-copied list to the next tag.
-           */
-          continue;
+          uint8_t *data = reinterpret_cast<uint8_t *> (entry + 1);
+          tag.Deserialize (TagBuffer (data, data + entry->size));
+          RemoveOverflowEntry (offset);
+          UpdateMask ();
+          return true;
         }
-      struct TagData *copy = AllocData ();
-      copy->tid = cur->tid;
-      copy->count = 1;
-      copy->next = 0;
-      memcpy (copy->data, cur->data, PACKET_TAG_MAX_SIZE);
-      *prevNext = copy;
-      prevNext = &copy->next;
-    }
-  *prevNext = 0;
-  RemoveAll ();
-  m_next = start;
-  return true;
+      offset += GetEntrySize (entry->size);
+    }
+  return false;
 }
 
 void 
 PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint32_t size;
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
-    {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
-    }
-  struct TagData *head = AllocData ();
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= PACKET_TAG_MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data+tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  NS_ASSERT (Find (tid, &size) == 0);
+  size = tag.GetSerializedSize ();
+  uint8_t *data = const_cast<PacketTagList *> (this)->Reserve (tid, size);
+  tag.Serialize (TagBuffer (data, data + size));
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  uint32_t size;
+  uint8_t *data = Find (tag.GetInstanceTypeId (), &size);
+  if (data == 0)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data+PACKET_TAG_MAX_SIZE));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
+  tag.Deserialize (TagBuffer (data, data + size));
+  return true;
 }
 
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
+bool
+PacketTagList::Get (uint32_t *position, struct TagData *data) const
 {
-  return m_next;
+  if (*position < m_nSlots)
+    {
+      const struct TagSlot &slot = m_slots[*position];
+      data->tid = slot.tid;
+      data->size = slot.size;
+      data->data = slot.data;
+      (*position)++;
+      return true;
+    }
+  uint32_t offset = *position - m_nSlots;
+  if (m_overflow == 0 || offset >= m_overflow->used)
+    {
+      return false;
+    }
+  struct OverflowEntry *entry = reinterpret_cast<struct OverflowEntry *> (&m_overflow->data[offset]);
+  data->tid = entry->tid;
+  data->size = entry->size;
+  data->data = reinterpret_cast<uint8_t *> (entry + 1);
+  *position += GetEntrySize (entry->size);
+  return true;
 }
 
 } // namespace ns3
@@ -31,19 +31,37 @@ class Tag;
 /**
  * \ingroup constants
  * \brief Tag maximum size
- * The maximum size (in bytes) of a Tag is stored
- * in this constant.
+ * The maximum size (in bytes) of a Tag stored in the packet itself.
+ * Larger tags are stored out of line.
  */
 #define PACKET_TAG_MAX_SIZE 20
 
+/**
+ * \ingroup constants
+ * \brief Number of tags stored in the packet itself
+ */
+#define PACKET_TAG_INLINE_SLOTS 4
+
+/**
+ * The packet tags of a packet.
+ *
+ * The first PACKET_TAG_INLINE_SLOTS tags of up to PACKET_TAG_MAX_SIZE
+ * bytes are stored in slots of the list itself, and copied with it.
+ * Other tags, of any size, are stored in a block shared by the copies
+ * of the list until one of them changes it.  A bit per type of tag
+ * tells whether a tag may be stored, so looking for a tag the packet
+ * does not have is constant-time.
+ */
 class PacketTagList 
 {
 public:
+  /**
+   * The serialized bytes of a tag, as seen by PacketTagIterator
+   */
   struct TagData {
-    uint8_t data[PACKET_TAG_MAX_SIZE];
-    struct TagData *next;
     TypeId tid;
-    uint32_t count;
+    uint32_t size;
+    const uint8_t *data;
   };
 
   inline PacketTagList ();
@@ -56,18 +74,43 @@ public:
   bool Peek (Tag &tag) const;
   inline void RemoveAll (void);
 
-  const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \param position the position of a tag, 0 for the first one; set to
+   *        the position of the next tag
+   * \param data set to the tag at this position
+   * \returns false if there is no tag at this position
+   */
+  bool Get (uint32_t *position, struct TagData *data) const;
 
 private:
+  struct TagSlot {
+    TypeId tid;
+    uint16_t size;
+    uint8_t data[PACKET_TAG_MAX_SIZE];
+  };
+  /* The tags which do not fit in the slots: each one is the type and
+   * the size of the tag followed by its bytes, and padded to a multiple
+   * of 4 bytes.
+   */
+  struct Overflow {
+    uint32_t count;
+    uint32_t used;
+    uint32_t size;
+    uint8_t data[4];
+  };
 
-  bool Remove (TypeId tid);
-  struct PacketTagList::TagData *AllocData (void) const;
-  void FreeData (struct TagData *data) const;
-
-  static struct PacketTagList::TagData *g_free;
-  static uint32_t g_nfree;
-
-  struct TagData *m_next;
+  static inline uint32_t GetMaskBit (TypeId tid);
+  uint8_t *Find (TypeId tid, uint32_t *size) const;
+  uint8_t *Reserve (TypeId tid, uint32_t size);
+  void RemoveOverflowEntry (uint32_t offset);
+  void UpdateMask (void);
+  static struct Overflow *AllocOverflow (uint32_t size);
+  static void FreeOverflow (struct Overflow *overflow);
+
+  uint32_t m_mask;
+  uint32_t m_nSlots;
+  struct Overflow *m_overflow;
+  struct TagSlot m_slots[PACKET_TAG_INLINE_SLOTS];
 };
 
 } // namespace ns3
@@ -78,17 +121,31 @@ private:
 
 namespace ns3 {
 
+uint32_t
+PacketTagList::GetMaskBit (TypeId tid)
+{
+  return 1U << (tid.GetUid () & 31);
+}
+
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_mask (0),
+    m_nSlots (0),
+    m_overflow (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_mask (o.m_mask),
+    m_nSlots (o.m_nSlots),
+    m_overflow (o.m_overflow)
 {
-  if (m_next != 0)
+  for (uint32_t i = 0; i < m_nSlots; i++)
+    {
+      m_slots[i] = o.m_slots[i];
+    }
+  if (m_overflow != 0)
     {
-      m_next->count++;
+      m_overflow->count++;
     }
 }
 
@@ -96,15 +153,21 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
+  if (o.m_overflow != 0)
+    {
+      o.m_overflow->count++;
+    }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_mask = o.m_mask;
+  m_nSlots = o.m_nSlots;
+  m_overflow = o.m_overflow;
+  for (uint32_t i = 0; i < m_nSlots; i++)
     {
-      m_next->count++;
+      m_slots[i] = o.m_slots[i];
     }
   return *this;
 }
@@ -117,25 +180,17 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  if (m_overflow != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
+      m_overflow->count--;
+      if (m_overflow->count == 0)
         {
-          FreeData (prev);
+          FreeOverflow (m_overflow);
         }
-      prev = cur;
-    }
-  if (prev != 0) 
-    {
-      FreeData (prev);
+      m_overflow = 0;
     }
-  m_next = 0;
+  m_nSlots = 0;
+  m_mask = 0;
 }
 
 } // namespace ns3
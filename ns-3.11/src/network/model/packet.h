@@ -134,8 +134,8 @@ public:
     void GetTag (Tag &tag) const;
 private:
     friend class PacketTagIterator;
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data;
+    Item (const struct PacketTagList::TagData &data);
+    struct PacketTagList::TagData m_data;
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -147,8 +147,9 @@ private:
   Item Next (void);
 private:
   friend class Packet;
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;
+  uint32_t m_position;
 };
 
 /**
@@ -334,6 +335,18 @@ public:
    */
   void RemoveAtStart (uint32_t size);
 
+  /**
+   * \returns an iterator on the start of the packet, through which the
+   *          bytes of the packet can be overwritten in place.
+   *
+   * This lets a protocol update a few fields of a header it has already
+   * added, such as the TTL of an IPv4 header, without removing and
+   * serializing it again. The bytes are copied first if they are
+   * shared with copies of this packet, which thus never see the
+   * change. The size of the packet and its metadata are unchanged.
+   */
+  Buffer::Iterator BeginWrite (void);
+
   /**
    * If you try to change the content of the buffer
    * returned by this method, you will die.
@@ -557,6 +570,7 @@ private:
           const PacketTagList &packetTagList, const PacketMetadata &metadata);
 
   uint32_t Deserialize (uint8_t const*buffer, uint32_t size);
+  static uint32_t AllocateUid (void);
 
   Buffer m_buffer;
   ByteTagList m_byteTagList;
@@ -447,6 +447,61 @@ SocketIpTtlTag::Print (std::ostream &os) const
 }
 
 
+SocketIpTosTag::SocketIpTosTag ()
+{
+}
+
+void
+SocketIpTosTag::SetTos (uint8_t tos)
+{
+  m_tos = tos;
+}
+
+uint8_t
+SocketIpTosTag::GetTos (void) const
+{
+  return m_tos;
+}
+
+NS_OBJECT_ENSURE_REGISTERED (SocketIpTosTag);
+
+TypeId
+SocketIpTosTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SocketIpTosTag")
+    .SetParent<Tag> ()
+    .AddConstructor<SocketIpTosTag> ()
+  ;
+  return tid;
+}
+TypeId
+SocketIpTosTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SocketIpTosTag::GetSerializedSize (void) const
+{
+  return 1;
+}
+void
+SocketIpTosTag::Serialize (TagBuffer i) const
+{
+  i.WriteU8 (m_tos);
+}
+void
+SocketIpTosTag::Deserialize (TagBuffer i)
+{
+  m_tos = i.ReadU8 ();
+}
+void
+SocketIpTosTag::Print (std::ostream &os) const
+{
+  os << "Tos=" << (uint32_t) m_tos;
+}
+
+
 SocketSetDontFragmentTag::SocketSetDontFragmentTag ()
 {
 }
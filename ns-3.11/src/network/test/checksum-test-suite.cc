@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/checksum.h"
+#include "ns3/buffer.h"
+#include <vector>
+
+namespace ns3 {
+
+// The byte at a time sum Buffer::Iterator::CalculateIpChecksum used to do
+static uint16_t
+ReferenceSum (uint8_t const *data, uint32_t size)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i + 1 < size; i += 2)
+    {
+      sum += data[i] | (data[i + 1] << 8);
+    }
+  if (size & 1)
+    {
+      sum += data[size - 1];
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
+static std::vector<uint8_t>
+RandomBytes (uint32_t size, uint32_t seed)
+{
+  std::vector<uint8_t> bytes (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      bytes[i] = seed >> 16;
+    }
+  return bytes;
+}
+
+/**
+ * Every kernel the processor supports gives the sum of the byte at a
+ * time loop, whatever the size and the alignment of the bytes.
+ */
+class ChecksumKernelTestCase : public TestCase
+{
+public:
+  ChecksumKernelTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+ChecksumKernelTestCase::ChecksumKernelTestCase ()
+  : TestCase ("Check the one's complement sum kernels")
+{
+}
+
+void
+ChecksumKernelTestCase::DoRun (void)
+{
+  // All ones exercises the carries
+  std::vector<uint8_t> ones (70000, 0xff);
+  std::vector<uint8_t> random = RandomBytes (70000, 1);
+  uint32_t sizes[] = { 0, 1, 2, 3, 15, 16, 17, 20, 31, 32, 33, 63, 64, 65, 100, 255, 1500, 9000, 65535, 69000 };
+  ChecksumKernel kernels[] = { CHECKSUM_SCALAR, CHECKSUM_SSE2, CHECKSUM_AVX2 };
+  for (uint32_t k = 0; k < sizeof (kernels) / sizeof (kernels[0]); k++)
+    {
+      if (!IsChecksumKernelSupported (kernels[k]))
+        {
+          continue;
+        }
+      for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+        {
+          for (uint32_t offset = 0; offset < 4; offset++)
+            {
+              uint8_t const *data = &random[offset];
+              NS_TEST_ASSERT_MSG_EQ (OnesComplementSum (data, sizes[s], kernels[k]), ReferenceSum (data, sizes[s]),
+                                     "kernel " << kernels[k] << " size " << sizes[s] << " offset " << offset);
+              data = &ones[offset];
+              NS_TEST_ASSERT_MSG_EQ (OnesComplementSum (data, sizes[s], kernels[k]), ReferenceSum (data, sizes[s]),
+                                     "kernel " << kernels[k] << " size " << sizes[s] << " offset " << offset);
+            }
+        }
+    }
+  for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (OnesComplementSum (&random[1], sizes[s]), ReferenceSum (&random[1], sizes[s]),
+                             "size " << sizes[s]);
+    }
+}
+
+/**
+ * Buffer::Iterator::CalculateIpChecksum sums the bytes around the zero
+ * area of a buffer as the byte at a time loop, from any position.
+ */
+class BufferChecksumTestCase : public TestCase
+{
+public:
+  BufferChecksumTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+BufferChecksumTestCase::BufferChecksumTestCase ()
+  : TestCase ("Check the checksum of buffers with a zero area")
+{
+}
+
+void
+BufferChecksumTestCase::DoRun (void)
+{
+  uint32_t sizes[] = { 0, 1, 2, 3, 40, 41, 150 };
+  for (uint32_t a = 0; a < sizeof (sizes) / sizeof (sizes[0]); a++)
+    {
+      for (uint32_t z = 0; z < sizeof (sizes) / sizeof (sizes[0]); z++)
+        {
+          for (uint32_t b = 0; b < sizeof (sizes) / sizeof (sizes[0]); b++)
+            {
+              Buffer buffer (sizes[z]);
+              std::vector<uint8_t> start = RandomBytes (sizes[a] + 1, a + 1);
+              std::vector<uint8_t> end = RandomBytes (sizes[b] + 1, b + 100);
+              buffer.AddAtStart (sizes[a]);
+              buffer.Begin ().Write (&start[0], sizes[a]);
+              buffer.AddAtEnd (sizes[b]);
+              Buffer::Iterator i = buffer.End ();
+              i.Prev (sizes[b]);
+              i.Write (&end[0], sizes[b]);
+
+              uint32_t size = buffer.GetSize ();
+              std::vector<uint8_t> bytes (size + 1);
+              buffer.CopyData (&bytes[0], size);
+              for (uint32_t from = 0; from < 3 && from <= size; from++)
+                {
+                  for (uint32_t cut = 0; cut < 3 && cut <= size - from; cut++)
+                    {
+                      uint32_t n = size - from - cut;
+                      i = buffer.Begin ();
+                      i.Next (from);
+                      uint16_t checksum = i.CalculateIpChecksum (n, 0x1234);
+                      NS_TEST_ASSERT_MSG_EQ (i.GetDistanceFrom (buffer.Begin ()), from + n,
+                                             "The iterator should move past the bytes summed");
+                      uint16_t expected = ~OnesComplementAdd (ReferenceSum (&bytes[from], n), 0x1234);
+                      NS_TEST_ASSERT_MSG_EQ (checksum, expected,
+                                             "sizes " << sizes[a] << "/" << sizes[z] << "/" << sizes[b]
+                                                      << " from " << from << " bytes " << n);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The incremental update of RFC 1624 gives the checksum computed again.
+ */
+class ChecksumUpdateTestCase : public TestCase
+{
+public:
+  ChecksumUpdateTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+ChecksumUpdateTestCase::ChecksumUpdateTestCase ()
+  : TestCase ("Check the incremental checksum update")
+{
+}
+
+void
+ChecksumUpdateTestCase::DoRun (void)
+{
+  for (uint32_t seed = 0; seed < 100; seed++)
+    {
+      std::vector<uint8_t> header = RandomBytes (20, seed);
+      header[10] = 0;
+      header[11] = 0;
+      uint16_t checksum = ~OnesComplementSum (&header[0], 20);
+      uint32_t word = seed % 10;
+      if (word == 5)
+        {
+          continue; // the checksum itself
+        }
+      uint16_t oldWord = header[2 * word] | (header[2 * word + 1] << 8);
+      header[2 * word] -= seed;
+      uint16_t newWord = header[2 * word] | (header[2 * word + 1] << 8);
+      uint16_t expected = ~OnesComplementSum (&header[0], 20);
+      NS_TEST_ASSERT_MSG_EQ (ChecksumUpdate (checksum, oldWord, newWord), expected,
+                             "The update should give the checksum of the new header");
+    }
+}
+
+class ChecksumTestSuite : public TestSuite
+{
+public:
+  ChecksumTestSuite ();
+};
+
+ChecksumTestSuite::ChecksumTestSuite ()
+  : TestSuite ("checksum", UNIT)
+{
+  AddTestCase (new ChecksumKernelTestCase);
+  AddTestCase (new BufferChecksumTestCase);
+  AddTestCase (new ChecksumUpdateTestCase);
+}
+
+static ChecksumTestSuite g_checksumTestSuite;
+
+} // namespace ns3
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "ns3/packet.h"
+#include "ns3/packet-pool.h"
 #include "ns3/test.h"
 #include <string>
 #include <stdarg.h>
@@ -420,6 +421,57 @@ PacketTest::DoRun (void)
     NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), false, "trivial");
   }
 
+  {
+    // more tags than the packet has slots for, and tags larger than
+    // the slots
+    Packet p;
+    p.AddPacketTag (ATestTag<1> ());
+    p.AddPacketTag (ATestTag<64> ());
+    p.AddPacketTag (ATestTag<2> ());
+    p.AddPacketTag (ATestTag<3> ());
+    p.AddPacketTag (ATestTag<4> ());
+    p.AddPacketTag (ATestTag<5> ());
+    p.AddPacketTag (ATestTag<200> ());
+    Packet copy = p;
+    copy.AddPacketTag (ATestTag<6> ());
+    ATestTag<64> big;
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (big), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (big.m_error, false, "The bytes of a large tag should be kept");
+    ATestTag<5> overflow;
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (overflow), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (overflow.m_error, false, "trivial");
+    ATestTag<2> inlined;
+    NS_TEST_EXPECT_MSG_EQ (copy.RemovePacketTag (inlined), true, "trivial");
+
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (big), true, "The copy should not change the tags of the packet");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (overflow), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (inlined), true, "trivial");
+    ATestTag<6> added;
+    NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (added), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (added), true, "trivial");
+    ATestTag<200> huge;
+    NS_TEST_EXPECT_MSG_EQ (copy.PeekPacketTag (huge), true, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (huge.m_error, false, "trivial");
+
+    // the tags in the slots come first, then the others
+    uint32_t sizes[] = { 1, 2, 3, 4, 64, 5, 200 };
+    uint32_t n = 0;
+    PacketTagIterator i = p.GetPacketTagIterator ();
+    while (i.HasNext () && n < 7)
+      {
+        PacketTagIterator::Item item = i.Next ();
+        ATestTagBase *tag = dynamic_cast<ATestTagBase *> (item.GetTypeId ().GetConstructor () ());
+        item.GetTag (*tag);
+        NS_TEST_EXPECT_MSG_EQ (tag->m_error, false, "trivial");
+        NS_TEST_EXPECT_MSG_EQ (dynamic_cast<Tag *> (tag)->GetSerializedSize (), sizes[n],
+                               "The tags should be iterated in the order they are stored");
+        delete tag;
+        n++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (i.HasNext (), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (n, 7, "trivial");
+  }
+
   {
     // bug 572
     Ptr<Packet> tmp = Create<Packet> (1000);
@@ -436,6 +488,69 @@ PacketTest::DoRun (void)
   }
 }
 //-----------------------------------------------------------------------------
+/**
+ * The bytes, metadata and tags of a packet are returned to the pool with
+ * the packet, and reused by the next packets.
+ */
+class PacketPoolTest : public TestCase
+{
+public:
+  PacketPoolTest ();
+  virtual void DoRun (void);
+private:
+  void CreatePackets (uint32_t n);
+};
+
+PacketPoolTest::PacketPoolTest ()
+  : TestCase ("Check the packet memory pool statistics")
+{
+}
+
+void
+PacketPoolTest::CreatePackets (uint32_t n)
+{
+  std::vector<uint8_t> payload (1000, 0x55);
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (&payload[0], payload.size ());
+      p->AddHeader (ATestHeader<20> ());
+      // too large for the slots of the packet, so stored in the pool
+      p->AddPacketTag (ATestTag<40> ());
+      packets.push_back (p);
+    }
+}
+
+void
+PacketPoolTest::DoRun (void)
+{
+  PacketPool::Kind kinds[] = { PacketPool::BUFFER_DATA, PacketPool::METADATA, PacketPool::PACKET_TAGS };
+  PacketPool::Stats before[3];
+  // the first packets may need fresh memory
+  CreatePackets (100);
+  PacketPool::ResetPeak ();
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      before[k] = PacketPool::GetStats (kinds[k]);
+      NS_TEST_ASSERT_MSG_EQ (before[k].peakBytesInUse, before[k].bytesInUse, "ResetPeak should start the peak over");
+    }
+
+  CreatePackets (100);
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      PacketPool::Stats after = PacketPool::GetStats (kinds[k]);
+      NS_TEST_ASSERT_MSG_EQ (after.allocations, before[k].allocations,
+                             "kind " << k << ": the packets should reuse the memory of the first ones");
+      NS_TEST_ASSERT_MSG_EQ ((after.recycles >= before[k].recycles + 100), true, "kind " << k);
+      NS_TEST_ASSERT_MSG_EQ (after.bytesInUse, before[k].bytesInUse, "kind " << k << ": all blocks released");
+      NS_TEST_ASSERT_MSG_EQ ((after.peakBytesInUse >= before[k].bytesInUse + 100 * 16), true, "kind " << k);
+    }
+  PacketPool::Stats bytes = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  NS_TEST_ASSERT_MSG_EQ ((bytes.peakBytesInUse >= bytes.bytesInUse + 100 * 1020), true, "The bytes of the packets");
+  NS_TEST_ASSERT_MSG_EQ (PacketPool::GetBlockSize (1020), 1024, "Size classes are powers of two above 256 bytes");
+  NS_TEST_ASSERT_MSG_EQ (PacketPool::GetBlockSize (40), 48, "Size classes are 16 byte steps up to 256 bytes");
+}
+//-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
 public:
@@ -446,6 +561,7 @@ PacketTestSuite::PacketTestSuite ()
   : TestSuite ("packet", UNIT)
 {
   AddTestCase (new PacketTest);
+  AddTestCase (new PacketPoolTest);
 }
 
 static PacketTestSuite g_packetTestSuite;
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/red-queue.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+
+namespace ns3 {
+
+class RedQueueTestCase : public TestCase
+{
+public:
+  RedQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+RedQueueTestCase::RedQueueTestCase ()
+  : TestCase ("Sanity check on the red queue implementation")
+{
+}
+void
+RedQueueTestCase::DoRun (void)
+{
+  // Instantaneous threshold of two packets
+  Ptr<RedQueue> queue = CreateObject<RedQueue> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QW", DoubleValue (1)), true,
+                         "Verify that we can actually set the attribute");
+  queue->SetTh (2, 2);
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      queue->Enqueue (Create<Packet> (100));
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 2, "Packets above the threshold are dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedDrop, 2, "No protocol to mark, so both were dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedMark, 0, "No protocol to mark");
+  queue->Dequeue ();
+  queue->Enqueue (Create<Packet> (100));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 2, "The queue accepts packets again below the threshold");
+
+  // The average moves slowly: a burst above MaxTh goes through
+  queue = CreateObject<RedQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (10));
+  for (uint32_t i = 0; i < 12; ++i)
+    {
+      queue->Enqueue (Create<Packet> (100));
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 10, "Only the queue limit dropped packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().qLimDrop, 2, "Two packets exceeded the limit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().unforcedDrop + queue->GetStats ().forcedDrop, 0,
+                         "The average stayed below MinTh");
+  NS_TEST_EXPECT_MSG_EQ_TOL (queue->GetAverage (), 0.1291, 0.0001,
+                             "Average of the queue lengths 0 to 10, 10 seen by the packets");
+}
+
+static class RedQueueTestSuite : public TestSuite
+{
+public:
+  RedQueueTestSuite ()
+    : TestSuite ("red-queue", UNIT)
+  {
+    AddTestCase (new RedQueueTestCase ());
+  }
+} g_redQueueTestSuite;
+
+} // namespace ns3
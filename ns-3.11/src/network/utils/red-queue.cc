@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/trace-source-accessor.h"
+#include "red-queue.h"
+
+NS_LOG_COMPONENT_DEFINE ("RedQueue");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (RedQueue);
+
+TypeId RedQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RedQueue")
+    .SetParent<Queue> ()
+    .AddConstructor<RedQueue> ()
+    .AddAttribute ("Mode",
+                   "Whether to use Bytes or Packets for the queue size, its limit and the thresholds.",
+                   EnumValue (PACKETS),
+                   MakeEnumAccessor (&RedQueue::SetMode),
+                   MakeEnumChecker (BYTES, "Bytes",
+                                    PACKETS, "Packets"))
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets accepted by this RedQueue.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&RedQueue::m_maxPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxBytes",
+                   "The maximum number of bytes accepted by this RedQueue.",
+                   UintegerValue (100 * 65535),
+                   MakeUintegerAccessor (&RedQueue::m_maxBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MinTh",
+                   "Average queue length below which no packet is signalled",
+                   DoubleValue (5),
+                   MakeDoubleAccessor (&RedQueue::m_minTh),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxTh",
+                   "Average queue length above which every packet is signalled",
+                   DoubleValue (15),
+                   MakeDoubleAccessor (&RedQueue::m_maxTh),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxP",
+                   "Signalling probability when the average queue length reaches MaxTh",
+                   DoubleValue (0.02),
+                   MakeDoubleAccessor (&RedQueue::m_maxP),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("QW",
+                   "Weight of the instantaneous queue length in its average",
+                   DoubleValue (0.002),
+                   MakeDoubleAccessor (&RedQueue::m_qW),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("UseEcn",
+                   "Mark the packets signalled instead of dropping them, when they allow it",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueue::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UseHardDrop",
+                   "Drop the packets signalled above MaxTh even when they could be marked",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RedQueue::m_useHardDrop),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("Mark", "Mark a packet instead of dropping it.",
+                     MakeTraceSourceAccessor (&RedQueue::m_traceMark))
+  ;
+
+  return tid;
+}
+
+RedQueue::RedQueue () :
+  Queue (),
+  m_packets (),
+  m_bytesInQueue (0),
+  m_qAvg (0),
+  m_count (-1),
+  m_uv (0.0, 1.0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_stats.unforcedDrop = 0;
+  m_stats.forcedDrop = 0;
+  m_stats.qLimDrop = 0;
+  m_stats.unforcedMark = 0;
+  m_stats.forcedMark = 0;
+}
+
+RedQueue::~RedQueue ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+RedQueue::SetMode (enum Mode mode)
+{
+  NS_LOG_FUNCTION (mode);
+  m_mode = mode;
+}
+
+RedQueue::Mode
+RedQueue::GetMode (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_mode;
+}
+
+void
+RedQueue::SetTh (double minTh, double maxTh)
+{
+  NS_LOG_FUNCTION (this << minTh << maxTh);
+  NS_ASSERT (minTh <= maxTh);
+  m_minTh = minTh;
+  m_maxTh = maxTh;
+}
+
+double
+RedQueue::GetAverage (void) const
+{
+  return m_qAvg;
+}
+
+RedQueue::Stats
+RedQueue::GetStats (void) const
+{
+  return m_stats;
+}
+
+bool
+RedQueue::Mark (Ptr<Packet> p)
+{
+  return false;
+}
+
+bool
+RedQueue::Signal (bool& forced)
+{
+  double q = (m_mode == BYTES) ? m_bytesInQueue : m_packets.size ();
+  m_qAvg = (1 - m_qW) * m_qAvg + m_qW * q;
+  forced = false;
+
+  if (m_qAvg < m_minTh)
+    {
+      m_count = -1;
+      return false;
+    }
+  if (m_qAvg >= m_maxTh)
+    {
+      m_count = 0;
+      forced = true;
+      return true;
+    }
+  // Early signal, spread uniformly between two signals
+  m_count++;
+  double pb = m_maxP * (m_qAvg - m_minTh) / (m_maxTh - m_minTh);
+  double pa = (m_count * pb >= 1) ? 1.0 : pb / (1 - m_count * pb);
+  if (m_uv.GetValue () < pa)
+    {
+      m_count = 0;
+      return true;
+    }
+  return false;
+}
+
+bool
+RedQueue::DoEnqueue (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  bool forced;
+  bool signal = Signal (forced);
+
+  if (m_mode == PACKETS && (m_packets.size () >= m_maxPackets))
+    {
+      NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
+      m_stats.qLimDrop++;
+      Drop (p);
+      return false;
+    }
+
+  if (m_mode == BYTES && (m_bytesInQueue + p->GetSize () >= m_maxBytes))
+    {
+      NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
+      m_stats.qLimDrop++;
+      Drop (p);
+      return false;
+    }
+
+  if (signal)
+    {
+      if (m_useEcn && !(forced && m_useHardDrop) && Mark (p))
+        {
+          NS_LOG_LOGIC ("Average " << m_qAvg << " -- marking pkt");
+          if (forced)
+            {
+              m_stats.forcedMark++;
+            }
+          else
+            {
+              m_stats.unforcedMark++;
+            }
+          m_traceMark (p);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Average " << m_qAvg << " -- dropping pkt");
+          if (forced)
+            {
+              m_stats.forcedDrop++;
+            }
+          else
+            {
+              m_stats.unforcedDrop++;
+            }
+          Drop (p);
+          return false;
+        }
+    }
+
+  m_bytesInQueue += p->GetSize ();
+  m_packets.push (p);
+
+  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
+  return true;
+}
+
+Ptr<Packet>
+RedQueue::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_packets.empty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Packet> p = m_packets.front ();
+  m_packets.pop ();
+  m_bytesInQueue -= p->GetSize ();
+
+  NS_LOG_LOGIC ("Popped " << p);
+
+  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
+
+  return p;
+}
+
+Ptr<const Packet>
+RedQueue::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_packets.empty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  return m_packets.front ();
+}
+
+} // namespace ns3
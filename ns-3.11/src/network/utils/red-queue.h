@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RED_QUEUE_H
+#define RED_QUEUE_H
+
+#include <queue>
+#include "ns3/packet.h"
+#include "ns3/queue.h"
+#include "ns3/random-variable.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief A Random Early Detection queue
+ *
+ * The queue keeps an exponentially weighted moving average of its
+ * length, updated at each arrival with the weight QW. Below MinTh
+ * packets are accepted; between MinTh and MaxTh they are signalled
+ * with a probability that grows linearly up to MaxP and with the
+ * number of packets accepted since the last signal (Floyd and Jacobson,
+ * 1993); above MaxTh every packet is signalled. A packet is signalled
+ * by marking it if UseEcn is set and Mark () succeeds, and by dropping
+ * it otherwise. Packets that would exceed MaxPackets or MaxBytes are
+ * always dropped.
+ *
+ * Setting QW to 1 and MinTh equal to MaxTh turns the queue into the
+ * instantaneous threshold marker used by DCTCP.
+ *
+ * This class does not know the protocols of the packets it holds, so
+ * Mark () always fails here: subclasses that can set the congestion
+ * experienced codepoint of a network protocol override it.
+ */
+class RedQueue : public Queue {
+public:
+  static TypeId GetTypeId (void);
+  RedQueue ();
+  virtual ~RedQueue ();
+
+  /**
+   * Enumeration of the modes supported in the class.
+   */
+  enum Mode {
+    ILLEGAL,     /**< Mode not set */
+    PACKETS,     /**< Use number of packets for queue size and thresholds */
+    BYTES,       /**< Use number of bytes for queue size and thresholds */
+  };
+
+  /**
+   * \brief The congestion signals given by the queue since its creation
+   */
+  struct Stats
+  {
+    uint32_t unforcedDrop;  //!< Early drops between MinTh and MaxTh
+    uint32_t forcedDrop;    //!< Drops above MaxTh
+    uint32_t qLimDrop;      //!< Drops because the queue was full
+    uint32_t unforcedMark;  //!< Early marks between MinTh and MaxTh
+    uint32_t forcedMark;    //!< Marks above MaxTh
+  };
+
+  void SetMode (RedQueue::Mode mode);
+  RedQueue::Mode GetMode (void);
+
+  /**
+   * \param minTh the minimum threshold, in packets or bytes
+   * \param maxTh the maximum threshold, in packets or bytes
+   */
+  void SetTh (double minTh, double maxTh);
+
+  /**
+   * \returns the average queue length, in packets or bytes
+   */
+  double GetAverage (void) const;
+
+  /**
+   * \returns the congestion signals given so far
+   */
+  Stats GetStats (void) const;
+
+protected:
+  /**
+   * \param p the packet to mark
+   * \returns true if the congestion experienced codepoint could be set
+   *          in the packet, false if it has to be dropped instead
+   *
+   * The packet is modified in place. The default implementation knows no
+   * protocol and returns false.
+   */
+  virtual bool Mark (Ptr<Packet> p);
+
+private:
+  virtual bool DoEnqueue (Ptr<Packet> p);
+  virtual Ptr<Packet> DoDequeue (void);
+  virtual Ptr<const Packet> DoPeek (void) const;
+
+  /**
+   * \returns true if the packet arriving must be marked or dropped
+   * \param forced set to true if the average is above MaxTh
+   */
+  bool Signal (bool& forced);
+
+  std::queue<Ptr<Packet> > m_packets;
+  uint32_t m_maxPackets;
+  uint32_t m_maxBytes;
+  uint32_t m_bytesInQueue;
+  Mode     m_mode;
+
+  double m_minTh;
+  double m_maxTh;
+  double m_maxP;
+  double m_qW;
+  bool m_useEcn;
+  bool m_useHardDrop;
+
+  double m_qAvg;     //!< Average queue length
+  int32_t m_count;   //!< Packets accepted since the last signal, -1 below MinTh
+  UniformVariable m_uv;
+  Stats m_stats;
+
+  TracedCallback<Ptr<const Packet> > m_traceMark;
+};
+
+} // namespace ns3
+
+#endif /* RED_QUEUE_H */
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/packet.h"
+#include "ns3/fast-point-to-point-net-device.h"
+#include "ns3/fast-point-to-point-channel.h"
+#include "ns3/trace-helper.h"
+#include "fast-point-to-point-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("FastPointToPointHelper");
+
+namespace ns3 {
+
+FastPointToPointHelper::FastPointToPointHelper ()
+{
+  m_deviceFactory.SetTypeId ("ns3::FastPointToPointNetDevice");
+  m_channelFactory.SetTypeId ("ns3::FastPointToPointChannel");
+}
+
+void
+FastPointToPointHelper::SetDeviceAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_deviceFactory.Set (n1, v1);
+}
+
+void
+FastPointToPointHelper::SetChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_channelFactory.Set (n1, v1);
+}
+
+void
+FastPointToPointHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
+{
+  Ptr<FastPointToPointNetDevice> device = nd->GetObject<FastPointToPointNetDevice> ();
+  if (device == 0)
+    {
+      NS_LOG_INFO ("FastPointToPointHelper::EnablePcapInternal(): Device " << device <<
+                   " not of type ns3::FastPointToPointNetDevice");
+      return;
+    }
+
+  PcapHelper pcapHelper;
+
+  std::string filename;
+  if (explicitFilename)
+    {
+      filename = prefix;
+    }
+  else
+    {
+      filename = pcapHelper.GetFilenameFromDevice (prefix, device);
+    }
+
+  //
+  // The device frames the packets it hands to its sniffers with a PPP
+  // header, as soon as a sniffer is connected.
+  //
+  Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (filename, std::ios::out,
+                                                     PcapHelper::DLT_PPP);
+  pcapHelper.HookDefaultSink<FastPointToPointNetDevice> (device, "PromiscSniffer", file);
+}
+
+void
+FastPointToPointHelper::EnableAsciiInternal (
+  Ptr<OutputStreamWrapper> stream,
+  std::string prefix,
+  Ptr<NetDevice> nd,
+  bool explicitFilename)
+{
+  Ptr<FastPointToPointNetDevice> device = nd->GetObject<FastPointToPointNetDevice> ();
+  if (device == 0)
+    {
+      NS_LOG_INFO ("FastPointToPointHelper::EnableAsciiInternal(): Device " << device <<
+                   " not of type ns3::FastPointToPointNetDevice");
+      return;
+    }
+
+  Packet::EnablePrinting ();
+
+  //
+  // The device has no queue object: its MacTx, PhyTxBegin and MacTxDrop
+  // trace sources provide the "+", "-" and "d" events.
+  //
+  if (stream == 0)
+    {
+      AsciiTraceHelper asciiTraceHelper;
+
+      std::string filename;
+      if (explicitFilename)
+        {
+          filename = prefix;
+        }
+      else
+        {
+          filename = asciiTraceHelper.GetFilenameFromDevice (prefix, device);
+        }
+
+      Ptr<OutputStreamWrapper> theStream = asciiTraceHelper.CreateFileStream (filename);
+      asciiTraceHelper.HookDefaultReceiveSinkWithoutContext<FastPointToPointNetDevice> (device, "MacRx", theStream);
+      asciiTraceHelper.HookDefaultEnqueueSinkWithoutContext<FastPointToPointNetDevice> (device, "MacTx", theStream);
+      asciiTraceHelper.HookDefaultDequeueSinkWithoutContext<FastPointToPointNetDevice> (device, "PhyTxBegin", theStream);
+      asciiTraceHelper.HookDefaultDropSinkWithoutContext<FastPointToPointNetDevice> (device, "MacTxDrop", theStream);
+      asciiTraceHelper.HookDefaultDropSinkWithoutContext<FastPointToPointNetDevice> (device, "PhyRxDrop", theStream);
+      return;
+    }
+
+  std::ostringstream oss;
+  oss << "/NodeList/" << nd->GetNode ()->GetId () << "/DeviceList/" << nd->GetIfIndex ()
+      << "/$ns3::FastPointToPointNetDevice/";
+  std::string path = oss.str ();
+  Config::Connect (path + "MacRx", MakeBoundCallback (&AsciiTraceHelper::DefaultReceiveSinkWithContext, stream));
+  Config::Connect (path + "MacTx", MakeBoundCallback (&AsciiTraceHelper::DefaultEnqueueSinkWithContext, stream));
+  Config::Connect (path + "PhyTxBegin", MakeBoundCallback (&AsciiTraceHelper::DefaultDequeueSinkWithContext, stream));
+  Config::Connect (path + "MacTxDrop", MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+  Config::Connect (path + "PhyRxDrop", MakeBoundCallback (&AsciiTraceHelper::DefaultDropSinkWithContext, stream));
+}
+
+NetDeviceContainer
+FastPointToPointHelper::Install (NodeContainer c)
+{
+  NS_ASSERT (c.GetN () == 2);
+  return Install (c.Get (0), c.Get (1));
+}
+
+NetDeviceContainer
+FastPointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
+{
+  NS_ABORT_MSG_IF (a->GetSystemId () != b->GetSystemId (),
+                   "FastPointToPointHelper::Install(): the nodes must be in the same partition");
+
+  Ptr<FastPointToPointNetDevice> devA = m_deviceFactory.Create<FastPointToPointNetDevice> ();
+  devA->SetAddress (Mac48Address::Allocate ());
+  a->AddDevice (devA);
+  Ptr<FastPointToPointNetDevice> devB = m_deviceFactory.Create<FastPointToPointNetDevice> ();
+  devB->SetAddress (Mac48Address::Allocate ());
+  b->AddDevice (devB);
+
+  Ptr<FastPointToPointChannel> channel = m_channelFactory.Create<FastPointToPointChannel> ();
+  devA->Attach (channel);
+  devB->Attach (channel);
+
+  NetDeviceContainer container;
+  container.Add (devA);
+  container.Add (devB);
+  return container;
+}
+
+} // namespace ns3
@@ -30,6 +30,10 @@
 #include "ns3/names.h"
 #include "ns3/mpi-interface.h"
 #include "ns3/mpi-receiver.h"
+#include "ns3/core-config.h"
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+#include "ns3/multithreaded-simulator-impl.h"
+#endif
 
 #include "ns3/trace-helper.h"
 #include "point-to-point-helper.h"
@@ -236,10 +240,24 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
   b->AddDevice (devB);
   Ptr<Queue> queueB = m_queueFactory.Create<Queue> ();
   devB->SetQueue (queueB);
+  // With priority flow control, every priority gets its own queue
+  if (devA->IsPfcEnabled () || devB->IsPfcEnabled ())
+    {
+      for (uint8_t i = 1; i < PfcHeader::PRIORITIES; ++i)
+        {
+          devA->SetPriorityQueue (i, m_queueFactory.Create<Queue> ());
+          devB->SetPriorityQueue (i, m_queueFactory.Create<Queue> ());
+        }
+    }
   // If MPI is enabled, we need to see if both nodes have the same system id 
   // (rank), and the rank is the same as this instance.  If both are true, 
   //use a normal p2p channel, otherwise use a remote channel
+  // Without MPI, nodes with different system ids are in different
+  // partitions only if the multithreaded simulator is selected, and it
+  // needs a remote channel between them. Any other simulator gets a
+  // normal channel, which keeps the packet tags.
   bool useNormalChannel = true;
+  bool useMpiReceiver = false;
   Ptr<PointToPointChannel> channel = 0;
   if (MpiInterface::IsEnabled ())
     {
@@ -249,8 +267,15 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
       if (n1SystemId != currSystemId || n2SystemId != currSystemId) 
         {
           useNormalChannel = false;
+          useMpiReceiver = true;
         }
     }
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+  else if (a->GetSystemId () != b->GetSystemId () && MultithreadedSimulatorImpl::IsEnabled ())
+    {
+      useNormalChannel = false;
+    }
+#endif
   if (useNormalChannel)
     {
       channel = m_channelFactory.Create<PointToPointChannel> ();
@@ -258,6 +283,9 @@ PointToPointHelper::Install (Ptr<Node> a, Ptr<Node> b)
   else
     {
       channel = m_remoteChannelFactory.Create<PointToPointRemoteChannel> ();
+    }
+  if (useMpiReceiver)
+    {
       Ptr<MpiReceiver> mpiRecA = CreateObject<MpiReceiver> ();
       Ptr<MpiReceiver> mpiRecB = CreateObject<MpiReceiver> ();
       mpiRecA->SetReceiveCallback (MakeCallback (&PointToPointNetDevice::Receive, devA));
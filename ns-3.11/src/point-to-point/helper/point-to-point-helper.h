@@ -69,6 +69,8 @@ public:
    *
    * Set the type of queue to create and associated to each
    * PointToPointNetDevice created through PointToPointHelper::Install.
+   * Devices with priority flow control enabled get one such queue per
+   * priority.
    */
   void SetQueue (std::string type,
                  std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
@@ -0,0 +1,504 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+#include "ns3/data-rate.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-remote-channel.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/core-config.h"
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+#include "ns3/multithreaded-simulator-impl.h"
+#endif
+#include "point-to-point-partition-helper.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointPartitionHelper");
+
+namespace ns3 {
+
+PointToPointPartitionHelper::PointToPointPartitionHelper ()
+  : m_tolerance (0.05),
+    m_lookAhead (0),
+    m_cutLinks (0)
+{
+  m_channelFactory.SetTypeId ("ns3::PointToPointChannel");
+  m_remoteChannelFactory.SetTypeId ("ns3::PointToPointRemoteChannel");
+}
+
+void
+PointToPointPartitionHelper::SetImbalanceTolerance (double tolerance)
+{
+  m_tolerance = tolerance;
+}
+
+void
+PointToPointPartitionHelper::SetChannelType (std::string type)
+{
+  m_channelFactory.SetTypeId (type);
+}
+
+uint32_t
+PointToPointPartitionHelper::Find (std::vector<uint32_t> &parent, uint32_t v) const
+{
+  while (parent[v] != v)
+    {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+  return v;
+}
+
+void
+PointToPointPartitionHelper::Partition (NodeContainer c, uint32_t nPartitions)
+{
+  NS_LOG_FUNCTION (this << nPartitions);
+  NS_ASSERT (nPartitions > 0);
+  if (MpiInterface::IsEnabled () && nPartitions != MpiInterface::GetSize ())
+    {
+      NS_FATAL_ERROR ("A distributed simulation needs one partition per MPI rank");
+    }
+
+  uint32_t n = c.GetN ();
+  std::map<uint32_t, uint32_t> vertexOf;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      vertexOf[c.Get (v)->GetId ()] = v;
+    }
+
+  // The nodes joined by anything else than a point-to-point link with
+  // a delay are merged before the links are looked at.
+  std::vector<uint32_t> parent (n);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      parent[v] = v;
+    }
+  std::vector<uint32_t> degree (n, 0);
+  std::vector<double> rate (n, 0.0);
+  double maxRate = 0.0;
+  std::vector<struct Link> links;
+  std::set<Channel *> seen;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      Ptr<Node> node = c.Get (v);
+      for (uint32_t i = 0; i < node->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = node->GetDevice (i);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          degree[v]++;
+          if (DynamicCast<PointToPointNetDevice> (device) != 0)
+            {
+              DataRateValue dataRate;
+              device->GetAttribute ("DataRate", dataRate);
+              rate[v] += dataRate.Get ().GetBitRate ();
+              maxRate = std::max (maxRate, static_cast<double> (dataRate.Get ().GetBitRate ()));
+            }
+          if (!seen.insert (PeekPointer (channel)).second)
+            {
+              continue;
+            }
+          std::vector<uint32_t> ends;
+          for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+            {
+              std::map<uint32_t, uint32_t>::const_iterator end =
+                vertexOf.find (channel->GetDevice (j)->GetNode ()->GetId ());
+              if (end != vertexOf.end ())
+                {
+                  ends.push_back (end->second);
+                }
+            }
+          Ptr<PointToPointChannel> p2pChannel = DynamicCast<PointToPointChannel> (channel);
+          if (p2pChannel != 0 && channel->GetNDevices () == 2 && ends.size () == 2)
+            {
+              TimeValue delay;
+              p2pChannel->GetAttribute ("Delay", delay);
+              if (delay.Get ().IsStrictlyPositive ())
+                {
+                  struct Link link;
+                  link.m_a = ends[0];
+                  link.m_b = ends[1];
+                  link.m_delay = delay.Get ().GetTimeStep ();
+                  link.m_channel = p2pChannel;
+                  links.push_back (link);
+                  continue;
+                }
+            }
+          for (uint32_t j = 1; j < ends.size (); ++j)
+            {
+              parent[Find (parent, ends[j])] = Find (parent, ends[0]);
+            }
+        }
+    }
+
+  // The event load of a node grows with the number and the rates of its links.
+  std::vector<double> load (n);
+  double total = 0.0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      load[v] = degree[v] + (maxRate > 0.0 ? rate[v] / maxRate : 0.0);
+      if (load[v] == 0.0)
+        {
+          load[v] = 1.0;
+        }
+      total += load[v];
+    }
+  double limit = (1.0 + m_tolerance) * total / nPartitions;
+
+  // Keep inside the partitions all the links shorter than the largest
+  // delay which still lets the groups of nodes be balanced.
+  std::vector<int64_t> delays;
+  for (std::vector<struct Link>::const_iterator i = links.begin (); i != links.end (); ++i)
+    {
+      delays.push_back (i->m_delay);
+    }
+  std::sort (delays.begin (), delays.end (), std::greater<int64_t> ());
+  delays.erase (std::unique (delays.begin (), delays.end ()), delays.end ());
+  std::vector<uint32_t> root;
+  for (uint32_t d = 0; d < delays.size (); ++d)
+    {
+      std::vector<uint32_t> candidate = parent;
+      for (std::vector<struct Link>::const_iterator i = links.begin (); i != links.end (); ++i)
+        {
+          if (i->m_delay < delays[d])
+            {
+              candidate[Find (candidate, i->m_b)] = Find (candidate, i->m_a);
+            }
+        }
+      std::map<uint32_t, double> groupLoad;
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          groupLoad[Find (candidate, v)] += load[v];
+        }
+      double largest = 0.0;
+      for (std::map<uint32_t, double>::const_iterator i = groupLoad.begin (); i != groupLoad.end (); ++i)
+        {
+          largest = std::max (largest, i->second);
+        }
+      root = candidate;
+      if (groupLoad.size () >= nPartitions && largest <= limit)
+        {
+          NS_LOG_LOGIC ("keep the links shorter than " << delays[d] << " inside the partitions");
+          break;
+        }
+    }
+  if (root.empty ())
+    {
+      root = parent;
+    }
+
+  // contract the groups of nodes into the vertices of a smaller graph
+  std::vector<uint32_t> groupOf (n);
+  std::map<uint32_t, uint32_t> groupOfRoot;
+  std::vector<double> groupLoad;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      uint32_t r = Find (root, v);
+      std::map<uint32_t, uint32_t>::iterator found = groupOfRoot.find (r);
+      if (found == groupOfRoot.end ())
+        {
+          found = groupOfRoot.insert (std::make_pair (r, groupLoad.size ())).first;
+          groupLoad.push_back (0.0);
+        }
+      groupOf[v] = found->second;
+      groupLoad[found->second] += load[v];
+    }
+  std::vector<std::map<uint32_t, uint32_t> > adjacency (groupLoad.size ());
+  for (std::vector<struct Link>::const_iterator i = links.begin (); i != links.end (); ++i)
+    {
+      uint32_t a = groupOf[i->m_a];
+      uint32_t b = groupOf[i->m_b];
+      if (a != b)
+        {
+          adjacency[a][b]++;
+          adjacency[b][a]++;
+        }
+    }
+
+  std::vector<uint32_t> partitionOfGroup;
+  Split (groupLoad, adjacency, nPartitions, partitionOfGroup);
+
+  m_loads.assign (nPartitions, 0.0);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      uint32_t partition = partitionOfGroup[groupOf[v]];
+      c.Get (v)->SetSystemId (partition);
+      m_loads[partition] += load[v];
+    }
+  // As with the PointToPointHelper, the cut links need a remote channel
+  // only if the partitions are run in parallel
+  bool parallel = MpiInterface::IsEnabled ();
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+  parallel = parallel || MultithreadedSimulatorImpl::IsEnabled ();
+#endif
+  m_cutLinks = 0;
+  m_lookAhead = 0;
+  for (std::vector<struct Link>::const_iterator i = links.begin (); i != links.end (); ++i)
+    {
+      bool cut = c.Get (i->m_a)->GetSystemId () != c.Get (i->m_b)->GetSystemId ();
+      if (cut)
+        {
+          m_cutLinks++;
+          if (m_lookAhead == 0 || i->m_delay < m_lookAhead)
+            {
+              m_lookAhead = i->m_delay;
+            }
+        }
+      Replace (*i, cut && parallel);
+    }
+}
+
+void
+PointToPointPartitionHelper::Split (const std::vector<double> &load,
+                                    const std::vector<std::map<uint32_t, uint32_t> > &adjacency,
+                                    uint32_t nPartitions, std::vector<uint32_t> &partition) const
+{
+  uint32_t n = load.size ();
+  const uint32_t unassigned = nPartitions;
+  partition.assign (n, unassigned);
+  std::vector<double> partitionLoad (nPartitions, 0.0);
+  std::vector<uint32_t> partitionSize (nPartitions, 0);
+  std::vector<uint32_t> degree (n, 0);
+  double remaining = 0.0;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      for (std::map<uint32_t, uint32_t>::const_iterator i = adjacency[v].begin (); i != adjacency[v].end (); ++i)
+        {
+          degree[v] += i->second;
+        }
+      remaining += load[v];
+    }
+
+  // Grow the partitions one after the other, each from the edge of the
+  // nodes already assigned, always taking in the node with the most
+  // links into the partition and the fewest links out of it.
+  std::vector<uint32_t> toAssigned (n, 0);
+  uint32_t left = n;
+  for (uint32_t p = 0; p < nPartitions && left > 0; ++p)
+    {
+      double target = remaining / (nPartitions - p);
+      std::vector<uint32_t> toPartition (n, 0);
+      while (left > 0)
+        {
+          uint32_t best = n;
+          int64_t bestGain = 0;
+          for (uint32_t v = 0; v < n; ++v)
+            {
+              if (partition[v] != unassigned)
+                {
+                  continue;
+                }
+              int64_t gain;
+              if (partitionSize[p] == 0)
+                {
+                  // seed next to the previous partitions, on the periphery
+                  gain = static_cast<int64_t> (toAssigned[v]) * n - degree[v];
+                }
+              else if (toPartition[v] == 0)
+                {
+                  continue;
+                }
+              else
+                {
+                  gain = 2 * static_cast<int64_t> (toPartition[v]) - degree[v];
+                }
+              if (best == n || gain > bestGain)
+                {
+                  best = v;
+                  bestGain = gain;
+                }
+            }
+          if (best == n)
+            {
+              // the partition is not connected to the rest: seed it again
+              for (uint32_t v = 0; v < n && best == n; ++v)
+                {
+                  if (partition[v] == unassigned)
+                    {
+                      best = v;
+                    }
+                }
+            }
+          if (p + 1 < nPartitions && partitionSize[p] > 0
+              && partitionLoad[p] + load[best] - target > target - partitionLoad[p])
+            {
+              break;
+            }
+          partition[best] = p;
+          partitionLoad[p] += load[best];
+          partitionSize[p]++;
+          remaining -= load[best];
+          left--;
+          for (std::map<uint32_t, uint32_t>::const_iterator i = adjacency[best].begin ();
+               i != adjacency[best].end (); ++i)
+            {
+              toPartition[i->first] += i->second;
+              toAssigned[i->first] += i->second;
+            }
+          if (p + 1 < nPartitions && partitionLoad[p] >= target)
+            {
+              break;
+            }
+        }
+    }
+
+  // Move the nodes on the borders to the partition they have the most
+  // links with, as long as the load stays balanced.
+  double total = 0.0;
+  for (uint32_t p = 0; p < nPartitions; ++p)
+    {
+      total += partitionLoad[p];
+    }
+  double limit = (1.0 + m_tolerance) * total / nPartitions;
+  for (uint32_t pass = 0; pass < 8; ++pass)
+    {
+      bool moved = false;
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          uint32_t from = partition[v];
+          if (partitionSize[from] == 1)
+            {
+              continue;
+            }
+          std::map<uint32_t, int64_t> links;
+          for (std::map<uint32_t, uint32_t>::const_iterator i = adjacency[v].begin (); i != adjacency[v].end (); ++i)
+            {
+              links[partition[i->first]] += i->second;
+            }
+          uint32_t to = from;
+          int64_t bestGain = 0;
+          for (std::map<uint32_t, int64_t>::const_iterator i = links.begin (); i != links.end (); ++i)
+            {
+              int64_t gain = i->second - links[from];
+              if (i->first != from && gain > bestGain
+                  && partitionLoad[i->first] + load[v] <= limit)
+                {
+                  to = i->first;
+                  bestGain = gain;
+                }
+            }
+          if (to != from)
+            {
+              partition[v] = to;
+              partitionLoad[from] -= load[v];
+              partitionLoad[to] += load[v];
+              partitionSize[from]--;
+              partitionSize[to]++;
+              moved = true;
+            }
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+}
+
+void
+PointToPointPartitionHelper::Replace (const struct Link &link, bool remote)
+{
+  Ptr<PointToPointChannel> channel = link.m_channel;
+  bool isRemote = DynamicCast<PointToPointRemoteChannel> (channel) != 0;
+  Ptr<PointToPointChannel> replacement = channel;
+  if (remote && !isRemote)
+    {
+      replacement = m_remoteChannelFactory.Create<PointToPointChannel> ();
+    }
+  else if (!remote && isRemote)
+    {
+      replacement = m_channelFactory.Create<PointToPointChannel> ();
+    }
+  if (replacement != channel)
+    {
+      NS_LOG_LOGIC ("replace channel " << channel << " by " << replacement);
+      replacement->SetAttribute ("Delay", TimeValue (TimeStep (link.m_delay)));
+    }
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      Ptr<PointToPointNetDevice> device = DynamicCast<PointToPointNetDevice> (channel->GetDevice (i));
+      if (replacement != channel)
+        {
+          device->Attach (replacement);
+        }
+      if (remote && MpiInterface::IsEnabled () && device->GetObject<MpiReceiver> () == 0)
+        {
+          Ptr<MpiReceiver> mpiRec = CreateObject<MpiReceiver> ();
+          mpiRec->SetReceiveCallback (MakeCallback (&PointToPointNetDevice::Receive, device));
+          device->AggregateObject (mpiRec);
+        }
+    }
+}
+
+Time
+PointToPointPartitionHelper::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+uint32_t
+PointToPointPartitionHelper::GetCutLinkCount (void) const
+{
+  return m_cutLinks;
+}
+
+std::vector<double>
+PointToPointPartitionHelper::GetPartitionLoads (void) const
+{
+  return m_loads;
+}
+
+double
+PointToPointPartitionHelper::GetPredictedSpeedup (void) const
+{
+  double total = 0.0;
+  double largest = 0.0;
+  for (std::vector<double>::const_iterator i = m_loads.begin (); i != m_loads.end (); ++i)
+    {
+      total += *i;
+      largest = std::max (largest, *i);
+    }
+  if (largest == 0.0)
+    {
+      return 1.0;
+    }
+  return total / largest;
+}
+
+void
+PointToPointPartitionHelper::Print (std::ostream &os) const
+{
+  os << "Partitions: " << m_loads.size () << std::endl;
+  os << "Cut links: " << m_cutLinks << std::endl;
+  os << "Lookahead: " << GetLookAhead ().GetSeconds () << "s" << std::endl;
+  os << "Loads:";
+  for (std::vector<double>::const_iterator i = m_loads.begin (); i != m_loads.end (); ++i)
+    {
+      os << " " << *i;
+    }
+  os << std::endl;
+  os << "Predicted speedup: " << GetPredictedSpeedup () << std::endl;
+}
+
+} // namespace ns3
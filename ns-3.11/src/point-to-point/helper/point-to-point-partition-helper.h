@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef POINT_TO_POINT_PARTITION_HELPER_H
+#define POINT_TO_POINT_PARTITION_HELPER_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ns3/object-factory.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class PointToPointChannel;
+class PointToPointNetDevice;
+
+/**
+ * \brief Split a topology into the partitions of a parallel simulation
+ *
+ * The helper assigns a system id to each node of a topology, for the
+ * DistributedSimulatorImpl (one MPI rank per partition) or the
+ * MultithreadedSimulatorImpl (one logical process per partition). Only
+ * point-to-point links with a non-zero delay are ever cut; the nodes
+ * joined by any other channel stay together.
+ *
+ * The lookahead of a parallel simulation is the smallest delay of the
+ * links it cuts, so the helper first picks the largest link delay which
+ * still lets the nodes be split into balanced partitions, keeping the
+ * shorter links inside the partitions. It then grows the partitions
+ * over the graph, balancing the estimated event load of the nodes (the
+ * sum of the data rates of their links, which also grows with their
+ * degree), and refines them to cut as few links as possible.
+ *
+ * When MPI is enabled or the SimulatorImplementationType global value
+ * selects the MultithreadedSimulatorImpl, the point-to-point channels
+ * of the cut links are replaced by PointToPointRemoteChannel objects
+ * (with the MpiReceiver needed by a distributed simulation when MPI is
+ * enabled); with any other simulator, the system ids do not split the
+ * simulation and the links stay plain. Remote channels which need not
+ * be remote are replaced by plain ones; the trace sinks connected to a
+ * replaced channel are lost. The partitioning must therefore be done
+ * once the topology is built, before the routes are computed and the
+ * traces are connected.
+ */
+class PointToPointPartitionHelper
+{
+public:
+  PointToPointPartitionHelper ();
+
+  /**
+   * \param tolerance fraction by which the load of a partition may
+   *        exceed the mean load of the partitions (0.05 by default)
+   */
+  void SetImbalanceTolerance (double tolerance);
+
+  /**
+   * \param type the type of the channels which replace the remote
+   *        channels of the links which are no longer cut
+   */
+  void SetChannelType (std::string type);
+
+  /**
+   * \param c the nodes of the topology
+   * \param nPartitions the number of partitions
+   *
+   * Set the system id of each node to its partition, in [0, nPartitions).
+   */
+  void Partition (NodeContainer c, uint32_t nPartitions);
+
+  /**
+   * \returns the smallest delay of the cut links, which is the lookahead
+   *          of the parallel simulation
+   */
+  Time GetLookAhead (void) const;
+  /**
+   * \returns the number of cut links
+   */
+  uint32_t GetCutLinkCount (void) const;
+  /**
+   * \returns the estimated load of each partition
+   */
+  std::vector<double> GetPartitionLoads (void) const;
+  /**
+   * \returns the speedup the load balance allows at best: the total load
+   *          divided by the load of the busiest partition
+   */
+  double GetPredictedSpeedup (void) const;
+
+  /**
+   * \param os output stream
+   *
+   * Print the results of the last partitioning.
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  struct Link
+  {
+    uint32_t m_a;
+    uint32_t m_b;
+    int64_t m_delay;
+    Ptr<PointToPointChannel> m_channel;
+  };
+
+  uint32_t Find (std::vector<uint32_t> &parent, uint32_t v) const;
+  void Split (const std::vector<double> &load,
+              const std::vector<std::map<uint32_t, uint32_t> > &adjacency,
+              uint32_t nPartitions, std::vector<uint32_t> &partition) const;
+  void Replace (const struct Link &link, bool remote);
+
+  ObjectFactory m_channelFactory;
+  ObjectFactory m_remoteChannelFactory;
+  double m_tolerance;
+  int64_t m_lookAhead;
+  uint32_t m_cutLinks;
+  std::vector<double> m_loads;
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_PARTITION_HELPER_H */
@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fast-point-to-point-channel.h"
+#include "fast-point-to-point-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("FastPointToPointChannel");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FastPointToPointChannel);
+
+TypeId
+FastPointToPointChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FastPointToPointChannel")
+    .SetParent<Channel> ()
+    .AddConstructor<FastPointToPointChannel> ()
+    .AddAttribute ("Delay", "Transmission delay through the channel",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&FastPointToPointChannel::m_delay),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+FastPointToPointChannel::FastPointToPointChannel ()
+  : Channel (),
+    m_delay (Seconds (0.)),
+    m_nDevices (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < N_DEVICES; ++i)
+    {
+      m_wire[i].pending = false;
+    }
+}
+
+void
+FastPointToPointChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < N_DEVICES; ++i)
+    {
+      m_wire[i].src = 0;
+      m_wire[i].dst = 0;
+      m_wire[i].inFlight.Clear ();
+    }
+  Channel::DoDispose ();
+}
+
+void
+FastPointToPointChannel::Attach (Ptr<FastPointToPointNetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  NS_ASSERT_MSG (m_nDevices < N_DEVICES, "Only two devices permitted");
+  NS_ASSERT (device != 0);
+
+  m_wire[m_nDevices++].src = device;
+  if (m_nDevices == N_DEVICES)
+    {
+      m_wire[0].dst = m_wire[1].src;
+      m_wire[1].dst = m_wire[0].src;
+    }
+}
+
+void
+FastPointToPointChannel::TransmitStart (Ptr<Packet> p, uint16_t protocol,
+                                        FastPointToPointNetDevice *src, Time txTime)
+{
+  NS_LOG_FUNCTION (this << p << src);
+  NS_ASSERT_MSG (m_nDevices == N_DEVICES, "Both devices must be attached");
+
+  uint32_t wire = (src == PeekPointer (m_wire[0].src)) ? 0 : 1;
+  Wire &w = m_wire[wire];
+  Time delay = txTime + m_delay;
+  InFlight inFlight;
+  inFlight.packet = p;
+  inFlight.protocol = protocol;
+  inFlight.arrival = (Simulator::Now () + delay).GetTimeStep ();
+  w.inFlight.Push (inFlight);
+
+  if (!w.pending)
+    {
+      w.pending = true;
+      Simulator::ScheduleWithContext (w.dst->GetNode ()->GetId (), delay,
+                                      &FastPointToPointChannel::Deliver, this, wire);
+    }
+}
+
+void
+FastPointToPointChannel::Deliver (uint32_t wire)
+{
+  NS_LOG_FUNCTION (this << wire);
+  Wire &w = m_wire[wire];
+  w.pending = false;
+
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  while (!w.inFlight.IsEmpty () && w.inFlight.Front ().arrival <= now)
+    {
+      Ptr<Packet> p = w.inFlight.Front ().packet;
+      uint16_t protocol = w.inFlight.Front ().protocol;
+      w.inFlight.Pop ();
+      w.dst->Receive (p, protocol);
+    }
+
+  //
+  // The event runs in the context of the receiver, and so does the next.
+  //
+  if (!w.inFlight.IsEmpty () && !w.pending)
+    {
+      w.pending = true;
+      Simulator::Schedule (TimeStep (w.inFlight.Front ().arrival - now),
+                           &FastPointToPointChannel::Deliver, this, wire);
+    }
+}
+
+Time
+FastPointToPointChannel::GetDelay (void) const
+{
+  return m_delay;
+}
+
+Ptr<FastPointToPointNetDevice>
+FastPointToPointChannel::GetPeer (const FastPointToPointNetDevice *device) const
+{
+  return (device == PeekPointer (m_wire[0].src)) ? m_wire[1].src : m_wire[0].src;
+}
+
+uint32_t
+FastPointToPointChannel::GetNDevices (void) const
+{
+  return m_nDevices;
+}
+
+Ptr<NetDevice>
+FastPointToPointChannel::GetDevice (uint32_t i) const
+{
+  NS_ASSERT (i < N_DEVICES);
+  return m_wire[i].src;
+}
+
+} // namespace ns3
@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FAST_POINT_TO_POINT_CHANNEL_H
+#define FAST_POINT_TO_POINT_CHANNEL_H
+
+#include "ns3/channel.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "fast-point-to-point-ring.h"
+
+namespace ns3 {
+
+class FastPointToPointNetDevice;
+
+/**
+ * \ingroup point-to-point
+ * \brief The channel of the FastPointToPointNetDevice
+ *
+ * Like the PointToPointChannel, the channel has two wires, one per
+ * direction, and delivers each packet to the peer once its last bit has
+ * propagated.  Instead of one event per packet, each wire keeps its
+ * packets in flight in order and schedules a single event, for the
+ * arrival of the oldest one; that event delivers every packet due and
+ * schedules the next arrival.  A burst of back-to-back packets thus keeps
+ * one event in the scheduler at a time, however many packets the delay
+ * of the link holds.
+ *
+ * Both devices must belong to nodes of the same partition of the
+ * simulator, as no remote version of this channel exists.
+ */
+class FastPointToPointChannel : public Channel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FastPointToPointChannel ();
+
+  /**
+   * \brief Attach a given netdevice to this channel
+   * \param device pointer to the netdevice to attach to the channel
+   */
+  void Attach (Ptr<FastPointToPointNetDevice> device);
+
+  /**
+   * \brief Transmit a packet over this channel
+   * \param p the packet, without a PPP header
+   * \param protocol the Ethernet protocol number of the packet
+   * \param src the device transmitting the packet
+   * \param txTime the transmission time of the packet
+   */
+  void TransmitStart (Ptr<Packet> p, uint16_t protocol, FastPointToPointNetDevice *src, Time txTime);
+
+  /**
+   * \returns the propagation delay of the channel
+   */
+  Time GetDelay (void) const;
+
+  /**
+   * \param device a device attached to this channel
+   * \returns the other device attached to this channel
+   */
+  Ptr<FastPointToPointNetDevice> GetPeer (const FastPointToPointNetDevice *device) const;
+
+  virtual uint32_t GetNDevices (void) const;
+  virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  static const uint32_t N_DEVICES = 2;
+
+  /**
+   * A packet propagating on a wire.
+   */
+  struct InFlight
+  {
+    Ptr<Packet> packet;
+    uint16_t protocol;
+    int64_t arrival;    //!< Time step at which the last bit arrives
+  };
+
+  /**
+   * A direction of the link.
+   */
+  struct Wire
+  {
+    Ptr<FastPointToPointNetDevice> src;
+    Ptr<FastPointToPointNetDevice> dst;
+    FastPointToPointRing<InFlight> inFlight;
+    bool pending;       //!< An event will deliver the oldest packet in flight
+  };
+
+  /**
+   * Deliver the packets of a wire which have arrived, and schedule the
+   * arrival of the next one.
+   */
+  void Deliver (uint32_t wire);
+
+  Time m_delay;
+  uint32_t m_nDevices;
+  Wire m_wire[N_DEVICES];
+};
+
+} // namespace ns3
+
+#endif /* FAST_POINT_TO_POINT_CHANNEL_H */
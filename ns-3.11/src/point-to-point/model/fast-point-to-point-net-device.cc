@@ -0,0 +1,469 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/error-model.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "fast-point-to-point-net-device.h"
+#include "fast-point-to-point-channel.h"
+#include "ppp-header.h"
+
+NS_LOG_COMPONENT_DEFINE ("FastPointToPointNetDevice");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FastPointToPointNetDevice);
+
+TypeId
+FastPointToPointNetDevice::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FastPointToPointNetDevice")
+    .SetParent<NetDevice> ()
+    .AddConstructor<FastPointToPointNetDevice> ()
+    .AddAttribute ("Mtu", "The MAC-level Maximum Transmission Unit",
+                   UintegerValue (DEFAULT_MTU),
+                   MakeUintegerAccessor (&FastPointToPointNetDevice::SetMtu,
+                                         &FastPointToPointNetDevice::GetMtu),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("Address",
+                   "The MAC address of this device.",
+                   Mac48AddressValue (Mac48Address ("ff:ff:ff:ff:ff:ff")),
+                   MakeMac48AddressAccessor (&FastPointToPointNetDevice::m_address),
+                   MakeMac48AddressChecker ())
+    .AddAttribute ("DataRate",
+                   "The default data rate for point to point links",
+                   DataRateValue (DataRate ("32768b/s")),
+                   MakeDataRateAccessor (&FastPointToPointNetDevice::SetDataRate,
+                                         &FastPointToPointNetDevice::GetDataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("ReceiveErrorModel",
+                   "The receiver error model used to simulate packet loss",
+                   PointerValue (),
+                   MakePointerAccessor (&FastPointToPointNetDevice::m_receiveErrorModel),
+                   MakePointerChecker<ErrorModel> ())
+    .AddAttribute ("InterframeGap",
+                   "The time to wait between packet (frame) transmissions",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&FastPointToPointNetDevice::m_tInterframeGap),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets waiting for transmission in the device.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&FastPointToPointNetDevice::m_maxPackets),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("MacTx",
+                     "Trace source indicating a packet has arrived for transmission by this device",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_macTxTrace))
+    .AddTraceSource ("MacTxDrop",
+                     "Trace source indicating a packet has been dropped by the device before transmission",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_macTxDropTrace))
+    .AddTraceSource ("MacPromiscRx",
+                     "A packet has been received by this device and is being forwarded up the local "
+                     "protocol stack.  This is a promiscuous trace,",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_macPromiscRxTrace))
+    .AddTraceSource ("MacRx",
+                     "A packet has been received by this device and is being forwarded up the local "
+                     "protocol stack.  This is a non-promiscuous trace,",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_macRxTrace))
+    .AddTraceSource ("PhyTxBegin",
+                     "Trace source indicating a packet has begun transmitting over the channel",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_phyTxBeginTrace))
+    .AddTraceSource ("PhyRxEnd",
+                     "Trace source indicating a packet has been completely received by the device",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_phyRxEndTrace))
+    .AddTraceSource ("PhyRxDrop",
+                     "Trace source indicating a packet has been dropped by the device during reception",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_phyRxDropTrace))
+    .AddTraceSource ("Sniffer",
+                     "Trace source simulating a non-promiscuous packet sniffer attached to the device",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_snifferTrace))
+    .AddTraceSource ("PromiscSniffer",
+                     "Trace source simulating a promiscuous packet sniffer attached to the device",
+                     MakeTraceSourceAccessor (&FastPointToPointNetDevice::m_promiscSnifferTrace))
+  ;
+  return tid;
+}
+
+FastPointToPointNetDevice::FastPointToPointNetDevice ()
+  : m_ifIndex (0),
+    m_mtu (DEFAULT_MTU),
+    m_linkUp (false),
+    m_bps (DataRate ("32768b/s")),
+    m_maxPackets (100),
+    m_txEnd (Seconds (0))
+{
+  NS_LOG_FUNCTION (this);
+  UpdateTxTimes ();
+}
+
+FastPointToPointNetDevice::~FastPointToPointNetDevice ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+FastPointToPointNetDevice::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_node = 0;
+  m_channel = 0;
+  m_receiveErrorModel = 0;
+  m_queue.Clear ();
+  m_txCompleteEvent.Cancel ();
+  NetDevice::DoDispose ();
+}
+
+void
+FastPointToPointNetDevice::SetDataRate (DataRate bps)
+{
+  NS_LOG_FUNCTION (this << bps);
+  m_bps = bps;
+  UpdateTxTimes ();
+}
+
+DataRate
+FastPointToPointNetDevice::GetDataRate (void) const
+{
+  return m_bps;
+}
+
+void
+FastPointToPointNetDevice::SetInterframeGap (Time t)
+{
+  NS_LOG_FUNCTION (this << t);
+  m_tInterframeGap = t;
+}
+
+void
+FastPointToPointNetDevice::UpdateTxTimes (void)
+{
+  //
+  // The packets carry no PPP header, but the wire does: their time
+  // includes it, as with the PointToPointNetDevice.
+  //
+  uint32_t ppp = PppHeader ().GetSerializedSize ();
+  m_txTimes.resize (m_mtu + 1);
+  for (uint32_t size = 0; size < m_txTimes.size (); ++size)
+    {
+      m_txTimes[size] = Seconds (m_bps.CalculateTxTime (size + ppp));
+    }
+}
+
+Time
+FastPointToPointNetDevice::GetTxTime (uint32_t size) const
+{
+  if (size < m_txTimes.size ())
+    {
+      return m_txTimes[size];
+    }
+  return Seconds (m_bps.CalculateTxTime (size + PppHeader ().GetSerializedSize ()));
+}
+
+bool
+FastPointToPointNetDevice::Attach (Ptr<FastPointToPointChannel> ch)
+{
+  NS_LOG_FUNCTION (this << ch);
+  m_channel = ch;
+  m_channel->Attach (this);
+
+  //
+  // This device is up whenever it is attached to a channel, like the
+  // PointToPointNetDevice.
+  //
+  m_linkUp = true;
+  m_linkChangeCallbacks ();
+  return true;
+}
+
+void
+FastPointToPointNetDevice::SetReceiveErrorModel (Ptr<ErrorModel> em)
+{
+  NS_LOG_FUNCTION (this << em);
+  m_receiveErrorModel = em;
+}
+
+uint32_t
+FastPointToPointNetDevice::GetQueueSize (void) const
+{
+  return m_queue.GetSize ();
+}
+
+bool
+FastPointToPointNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << packet << protocolNumber);
+
+  if (!m_linkUp)
+    {
+      m_macTxDropTrace (packet);
+      return false;
+    }
+
+  m_macTxTrace (packet);
+
+  //
+  // An idle wire takes the packet right away.  Otherwise the packet waits,
+  // and the end of the transmission in progress is scheduled if it was not
+  // yet, to send the next packet.
+  //
+  if (m_queue.IsEmpty () && Simulator::Now () >= m_txEnd)
+    {
+      TransmitStart (packet, protocolNumber);
+      return true;
+    }
+  if (m_queue.GetSize () >= m_maxPackets)
+    {
+      NS_LOG_LOGIC ("Queue full, dropping the packet");
+      m_macTxDropTrace (packet);
+      return false;
+    }
+  Pending pending;
+  pending.packet = packet;
+  pending.protocol = protocolNumber;
+  m_queue.Push (pending);
+  if (!m_txCompleteEvent.IsRunning ())
+    {
+      m_txCompleteEvent = Simulator::Schedule (m_txEnd - Simulator::Now (),
+                                               &FastPointToPointNetDevice::TransmitComplete, this);
+    }
+  return true;
+}
+
+void
+FastPointToPointNetDevice::TransmitStart (Ptr<Packet> p, uint16_t protocol)
+{
+  NS_LOG_FUNCTION (this << p);
+  Sniff (p, protocol);
+  m_phyTxBeginTrace (p);
+
+  Time txTime = GetTxTime (p->GetSize ());
+  m_txEnd = Simulator::Now () + txTime + m_tInterframeGap;
+  m_channel->TransmitStart (p, protocol, this, txTime);
+}
+
+void
+FastPointToPointNetDevice::TransmitComplete (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_ASSERT (!m_queue.IsEmpty ());
+
+  Ptr<Packet> p = m_queue.Front ().packet;
+  uint16_t protocol = m_queue.Front ().protocol;
+  m_queue.Pop ();
+  TransmitStart (p, protocol);
+  if (!m_queue.IsEmpty ())
+    {
+      m_txCompleteEvent = Simulator::Schedule (m_txEnd - Simulator::Now (),
+                                               &FastPointToPointNetDevice::TransmitComplete, this);
+    }
+}
+
+void
+FastPointToPointNetDevice::Sniff (Ptr<const Packet> p, uint16_t protocol) const
+{
+  if (m_snifferTrace.IsEmpty () && m_promiscSnifferTrace.IsEmpty ())
+    {
+      return;
+    }
+  PppHeader ppp;
+  switch (protocol)
+    {
+    case 0x0800: ppp.SetProtocol (0x0021); break;   //IPv4
+    case 0x86DD: ppp.SetProtocol (0x0057); break;   //IPv6
+    default: NS_ASSERT_MSG (false, "PPP Protocol number not defined!");
+    }
+  Ptr<Packet> framed = p->Copy ();
+  framed->AddHeader (ppp);
+  m_snifferTrace (framed);
+  m_promiscSnifferTrace (framed);
+}
+
+void
+FastPointToPointNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol)
+{
+  NS_LOG_FUNCTION (this << packet << protocol);
+
+  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet))
+    {
+      m_phyRxDropTrace (packet);
+      return;
+    }
+
+  Sniff (packet, protocol);
+  m_phyRxEndTrace (packet);
+
+  if (!m_promiscCallback.IsNull ())
+    {
+      m_macPromiscRxTrace (packet);
+      m_promiscCallback (this, packet, protocol, GetRemote (), GetAddress (), NetDevice::PACKET_HOST);
+    }
+
+  m_macRxTrace (packet);
+  m_rxCallback (this, packet, protocol, GetRemote ());
+}
+
+Address
+FastPointToPointNetDevice::GetRemote (void) const
+{
+  return m_channel->GetPeer (this)->GetAddress ();
+}
+
+void
+FastPointToPointNetDevice::SetIfIndex (const uint32_t index)
+{
+  m_ifIndex = index;
+}
+
+uint32_t
+FastPointToPointNetDevice::GetIfIndex (void) const
+{
+  return m_ifIndex;
+}
+
+Ptr<Channel>
+FastPointToPointNetDevice::GetChannel (void) const
+{
+  return m_channel;
+}
+
+void
+FastPointToPointNetDevice::SetAddress (Address address)
+{
+  m_address = Mac48Address::ConvertFrom (address);
+}
+
+Address
+FastPointToPointNetDevice::GetAddress (void) const
+{
+  return m_address;
+}
+
+bool
+FastPointToPointNetDevice::SetMtu (uint16_t mtu)
+{
+  NS_LOG_FUNCTION (this << mtu);
+  m_mtu = mtu;
+  UpdateTxTimes ();
+  return true;
+}
+
+uint16_t
+FastPointToPointNetDevice::GetMtu (void) const
+{
+  return m_mtu;
+}
+
+bool
+FastPointToPointNetDevice::IsLinkUp (void) const
+{
+  return m_linkUp;
+}
+
+void
+FastPointToPointNetDevice::AddLinkChangeCallback (Callback<void> callback)
+{
+  m_linkChangeCallbacks.ConnectWithoutContext (callback);
+}
+
+bool
+FastPointToPointNetDevice::IsBroadcast (void) const
+{
+  return true;
+}
+
+Address
+FastPointToPointNetDevice::GetBroadcast (void) const
+{
+  return Mac48Address ("ff:ff:ff:ff:ff:ff");
+}
+
+bool
+FastPointToPointNetDevice::IsMulticast (void) const
+{
+  return true;
+}
+
+Address
+FastPointToPointNetDevice::GetMulticast (Ipv4Address multicastGroup) const
+{
+  return Mac48Address ("01:00:5e:00:00:00");
+}
+
+Address
+FastPointToPointNetDevice::GetMulticast (Ipv6Address addr) const
+{
+  return Mac48Address ("33:33:00:00:00:00");
+}
+
+bool
+FastPointToPointNetDevice::IsPointToPoint (void) const
+{
+  return true;
+}
+
+bool
+FastPointToPointNetDevice::IsBridge (void) const
+{
+  return false;
+}
+
+bool
+FastPointToPointNetDevice::SendFrom (Ptr<Packet> packet, const Address &source,
+                                     const Address &dest, uint16_t protocolNumber)
+{
+  return false;
+}
+
+Ptr<Node>
+FastPointToPointNetDevice::GetNode (void) const
+{
+  return m_node;
+}
+
+void
+FastPointToPointNetDevice::SetNode (Ptr<Node> node)
+{
+  m_node = node;
+}
+
+bool
+FastPointToPointNetDevice::NeedsArp (void) const
+{
+  return false;
+}
+
+void
+FastPointToPointNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
+{
+  m_rxCallback = cb;
+}
+
+void
+FastPointToPointNetDevice::SetPromiscReceiveCallback (NetDevice::PromiscReceiveCallback cb)
+{
+  m_promiscCallback = cb;
+}
+
+bool
+FastPointToPointNetDevice::SupportsSendFrom (void) const
+{
+  return false;
+}
+
+} // namespace ns3
@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FAST_POINT_TO_POINT_NET_DEVICE_H
+#define FAST_POINT_TO_POINT_NET_DEVICE_H
+
+#include <vector>
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/mac48-address.h"
+#include "ns3/event-id.h"
+#include "fast-point-to-point-ring.h"
+
+namespace ns3 {
+
+class FastPointToPointChannel;
+class ErrorModel;
+
+/**
+ * \ingroup point-to-point
+ * \brief A point-to-point device trimmed for large switched fabrics
+ *
+ * The device models the same link as the PointToPointNetDevice, with the
+ * same timing: a packet takes the transmission time of its bytes and of
+ * a PPP header, then the delay of the channel.  It does the work of each
+ * packet more cheaply:
+ *
+ * - the transmission times of the packet sizes up to the MTU are computed
+ *   when the data rate or the MTU is set, instead of for each packet;
+ * - the packets wait in a ring of slots owned by the device, bounded by
+ *   the MaxPackets attribute, instead of a separate Queue object;
+ * - the PPP header is only added to the packets handed to the Sniffer and
+ *   PromiscSniffer trace sources, so that pcap traces read the same as
+ *   with the PointToPointNetDevice; the protocol number travels along
+ *   the packet in the channel otherwise;
+ * - the end of a transmission is only scheduled when a packet waits to
+ *   be sent after it, and the FastPointToPointChannel delivers the
+ *   packets with one event per wire at a time.
+ *
+ * Because a transmission may end without an event, the device has no
+ * PhyTxEnd trace source.  It has no priority flow control either.
+ */
+class FastPointToPointNetDevice : public NetDevice
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FastPointToPointNetDevice ();
+  virtual ~FastPointToPointNetDevice ();
+
+  /**
+   * \param bps the data rate at which this device transmits
+   */
+  void SetDataRate (DataRate bps);
+
+  /**
+   * \returns the data rate at which this device transmits
+   */
+  DataRate GetDataRate (void) const;
+
+  /**
+   * \param t the minimum time between the end of a transmission and the
+   *        start of the next one
+   */
+  void SetInterframeGap (Time t);
+
+  /**
+   * \param ch the channel to attach this device to
+   */
+  bool Attach (Ptr<FastPointToPointChannel> ch);
+
+  /**
+   * \param em the error model applied to the packets received
+   */
+  void SetReceiveErrorModel (Ptr<ErrorModel> em);
+
+  /**
+   * \returns the number of packets waiting for transmission
+   */
+  uint32_t GetQueueSize (void) const;
+
+  /**
+   * Receive a packet from the channel, once its last bit has arrived.
+   *
+   * \param p the packet, without a PPP header
+   * \param protocol the Ethernet protocol number of the packet
+   */
+  void Receive (Ptr<Packet> p, uint16_t protocol);
+
+  // The remaining methods are documented in ns3::NetDevice*
+
+  virtual void SetIfIndex (const uint32_t index);
+  virtual uint32_t GetIfIndex (void) const;
+  virtual Ptr<Channel> GetChannel (void) const;
+  virtual void SetAddress (Address address);
+  virtual Address GetAddress (void) const;
+  virtual bool SetMtu (const uint16_t mtu);
+  virtual uint16_t GetMtu (void) const;
+  virtual bool IsLinkUp (void) const;
+  virtual void AddLinkChangeCallback (Callback<void> callback);
+  virtual bool IsBroadcast (void) const;
+  virtual Address GetBroadcast (void) const;
+  virtual bool IsMulticast (void) const;
+  virtual Address GetMulticast (Ipv4Address multicastGroup) const;
+  virtual Address GetMulticast (Ipv6Address addr) const;
+  virtual bool IsPointToPoint (void) const;
+  virtual bool IsBridge (void) const;
+  virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
+  virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  virtual Ptr<Node> GetNode (void) const;
+  virtual void SetNode (Ptr<Node> node);
+  virtual bool NeedsArp (void) const;
+  virtual void SetReceiveCallback (NetDevice::ReceiveCallback cb);
+  virtual void SetPromiscReceiveCallback (PromiscReceiveCallback cb);
+  virtual bool SupportsSendFrom (void) const;
+
+private:
+  FastPointToPointNetDevice& operator = (const FastPointToPointNetDevice &);
+  FastPointToPointNetDevice (const FastPointToPointNetDevice &);
+
+  virtual void DoDispose (void);
+
+  /**
+   * A packet waiting for transmission.
+   */
+  struct Pending
+  {
+    Ptr<Packet> packet;
+    uint16_t protocol;
+  };
+
+  /**
+   * Start sending a packet down the wire, now.
+   */
+  void TransmitStart (Ptr<Packet> p, uint16_t protocol);
+
+  /**
+   * End the transmission in progress and start sending the next packet.
+   */
+  void TransmitComplete (void);
+
+  /**
+   * \returns the transmission time of a packet of the given size, with
+   * its PPP header
+   */
+  Time GetTxTime (uint32_t size) const;
+
+  /**
+   * Compute the transmission time of every packet size up to the MTU.
+   */
+  void UpdateTxTimes (void);
+
+  /**
+   * Fire the sniffer trace sources with a copy of the packet framed by
+   * its PPP header, as a PointToPointNetDevice would have sent it.
+   */
+  void Sniff (Ptr<const Packet> p, uint16_t protocol) const;
+
+  Address GetRemote (void) const;
+
+  Ptr<Node> m_node;
+  Ptr<FastPointToPointChannel> m_channel;
+  Mac48Address m_address;
+  uint32_t m_ifIndex;
+  uint16_t m_mtu;
+  bool m_linkUp;
+  DataRate m_bps;
+  Time m_tInterframeGap;
+  Ptr<ErrorModel> m_receiveErrorModel;
+
+  std::vector<Time> m_txTimes;      //!< Transmission times, by packet size
+  FastPointToPointRing<Pending> m_queue;
+  uint32_t m_maxPackets;
+  Time m_txEnd;                     //!< End of the transmission in progress
+  EventId m_txCompleteEvent;        //!< Scheduled while packets wait
+
+  NetDevice::ReceiveCallback m_rxCallback;
+  NetDevice::PromiscReceiveCallback m_promiscCallback;
+  TracedCallback<> m_linkChangeCallbacks;
+
+  TracedCallback<Ptr<const Packet> > m_macTxTrace;
+  TracedCallback<Ptr<const Packet> > m_macTxDropTrace;
+  TracedCallback<Ptr<const Packet> > m_macPromiscRxTrace;
+  TracedCallback<Ptr<const Packet> > m_macRxTrace;
+  TracedCallback<Ptr<const Packet> > m_phyTxBeginTrace;
+  TracedCallback<Ptr<const Packet> > m_phyRxEndTrace;
+  TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
+  TracedCallback<Ptr<const Packet> > m_snifferTrace;
+  TracedCallback<Ptr<const Packet> > m_promiscSnifferTrace;
+
+  static const uint16_t DEFAULT_MTU = 1500;
+};
+
+} // namespace ns3
+
+#endif /* FAST_POINT_TO_POINT_NET_DEVICE_H */
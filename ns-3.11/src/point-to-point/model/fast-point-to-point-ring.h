@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FAST_POINT_TO_POINT_RING_H
+#define FAST_POINT_TO_POINT_RING_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief A first-in first-out ring of slots
+ *
+ * The slots are allocated when the ring grows, doubling its size, and
+ * reused afterwards: once the ring has reached the depth of the traffic,
+ * pushing and popping an item allocates nothing.  The fast point-to-point
+ * device queues its packets in a ring, and the fast channel keeps the
+ * packets in flight on each wire in another.
+ */
+template <typename T>
+class FastPointToPointRing
+{
+public:
+  FastPointToPointRing ()
+    : m_slots (4),
+      m_head (0),
+      m_size (0)
+  {
+  }
+
+  bool IsEmpty (void) const
+  {
+    return m_size == 0;
+  }
+
+  uint32_t GetSize (void) const
+  {
+    return m_size;
+  }
+
+  T &Front (void)
+  {
+    NS_ASSERT (m_size > 0);
+    return m_slots[m_head];
+  }
+
+  void Push (const T &item)
+  {
+    if (m_size == m_slots.size ())
+      {
+        Grow ();
+      }
+    m_slots[(m_head + m_size) & (m_slots.size () - 1)] = item;
+    m_size++;
+  }
+
+  /**
+   * Release the first item, resetting its slot so that the ring does not
+   * keep its references alive.
+   */
+  void Pop (void)
+  {
+    NS_ASSERT (m_size > 0);
+    m_slots[m_head] = T ();
+    m_head = (m_head + 1) & (m_slots.size () - 1);
+    m_size--;
+  }
+
+  void Clear (void)
+  {
+    while (m_size > 0)
+      {
+        Pop ();
+      }
+  }
+
+private:
+  void Grow (void)
+  {
+    // The number of slots stays a power of two to wrap with a mask
+    std::vector<T> slots (m_slots.size () * 2);
+    for (uint32_t i = 0; i < m_size; ++i)
+      {
+        slots[i] = m_slots[(m_head + i) & (m_slots.size () - 1)];
+      }
+    m_slots.swap (slots);
+    m_head = 0;
+  }
+
+  std::vector<T> m_slots;
+  uint32_t m_head;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* FAST_POINT_TO_POINT_RING_H */
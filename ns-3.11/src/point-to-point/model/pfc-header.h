@@ -0,0 +1,90 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PFC_HEADER_H
+#define PFC_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point
+ * \brief Packet header of a Priority Flow Control PAUSE frame
+ *
+ * This is the MAC control frame of IEEE 802.1Qbb: an opcode (0x0101),
+ * a class-enable vector with one bit per priority and, for each of the
+ * eight priorities, the time for which the peer must stop transmitting
+ * packets of that priority, in quanta of 512 bit times.  A quanta of
+ * zero for an enabled priority lets the peer resume immediately.
+ *
+ * The frame is carried by the point-to-point devices behind a PppHeader
+ * whose protocol is the MAC control Ethertype, 0x8808.
+ */
+class PfcHeader : public Header
+{
+public:
+  /**
+   * \brief Construct a PFC header with no priority enabled.
+   */
+  PfcHeader ();
+  virtual ~PfcHeader ();
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Enable a priority and set its pause time
+   *
+   * \param priority the priority, from 0 to 7
+   * \param quanta the pause time, in quanta of 512 bit times
+   */
+  void SetQuanta (uint8_t priority, uint16_t quanta);
+
+  /**
+   * \param priority the priority, from 0 to 7
+   * \return the pause time of the priority, in quanta of 512 bit times
+   */
+  uint16_t GetQuanta (uint8_t priority) const;
+
+  /**
+   * \param priority the priority, from 0 to 7
+   * \return true if the frame carries a pause time for the priority
+   */
+  bool IsEnabled (uint8_t priority) const;
+
+  /**
+   * \brief The number of priorities of 802.1Qbb
+   */
+  static const uint8_t PRIORITIES = 8;
+
+  /**
+   * \brief The MAC control Ethertype, used as the PPP protocol of the frame
+   */
+  static const uint16_t PROTOCOL = 0x8808;
+
+private:
+  uint16_t m_classEnable;           //!< One bit per priority
+  uint16_t m_quanta[PRIORITIES];    //!< Pause time of each priority
+};
+
+} // namespace ns3
+
+#endif /* PFC_HEADER_H */
@@ -24,7 +24,10 @@
 #include "ns3/error-model.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/tag.h"
 #include "ns3/mpi-interface.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
@@ -36,6 +39,73 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (PointToPointNetDevice);
 
+/**
+ * \brief The device which received a packet and its priority, kept on the
+ * packet to charge its bytes to that device while the node queues it.
+ */
+class PfcIngressTag : public Tag
+{
+public:
+  PfcIngressTag ()
+    : m_nodeId (0), m_ifIndex (0), m_priority (0)
+  {
+  }
+  PfcIngressTag (uint32_t nodeId, uint32_t ifIndex, uint8_t priority)
+    : m_nodeId (nodeId), m_ifIndex (ifIndex), m_priority (priority)
+  {
+  }
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::PfcIngressTag")
+      .SetParent<Tag> ()
+      .AddConstructor<PfcIngressTag> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 9;
+  }
+  virtual void Serialize (TagBuffer i) const
+  {
+    i.WriteU32 (m_nodeId);
+    i.WriteU32 (m_ifIndex);
+    i.WriteU8 (m_priority);
+  }
+  virtual void Deserialize (TagBuffer i)
+  {
+    m_nodeId = i.ReadU32 ();
+    m_ifIndex = i.ReadU32 ();
+    m_priority = i.ReadU8 ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "node=" << m_nodeId << " if=" << m_ifIndex << " priority=" << (uint32_t) m_priority;
+  }
+  uint32_t GetNodeId (void) const
+  {
+    return m_nodeId;
+  }
+  uint32_t GetIfIndex (void) const
+  {
+    return m_ifIndex;
+  }
+  uint8_t GetPriority (void) const
+  {
+    return m_priority;
+  }
+private:
+  uint32_t m_nodeId;
+  uint32_t m_ifIndex;
+  uint8_t m_priority;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (PfcIngressTag);
+
 TypeId 
 PointToPointNetDevice::GetTypeId (void)
 {
@@ -78,6 +148,32 @@ PointToPointNetDevice::GetTypeId (void)
                    MakePointerAccessor (&PointToPointNetDevice::m_queue),
                    MakePointerChecker<Queue> ())
 
+    //
+    // Priority flow control (IEEE 802.1Qbb).
+    //
+    .AddAttribute ("PfcEnabled",
+                   "Whether to queue packets per priority and to pause the peer when the node "
+                   "holds too many of the packets received from it",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::SetPfcEnabled,
+                                        &PointToPointNetDevice::IsPfcEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PfcXoffThreshold",
+                   "The bytes of a priority received and queued on the node above which the peer is paused",
+                   UintegerValue (30000),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_pfcXoff),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PfcXonThreshold",
+                   "The bytes of a priority received and queued on the node below which the peer resumes",
+                   UintegerValue (15000),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_pfcXon),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PfcPauseQuanta",
+                   "The pause time requested in the PAUSE frames, in quanta of 512 bit times",
+                   UintegerValue (0xffff),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_pfcQuanta),
+                   MakeUintegerChecker<uint16_t> (1))
+
     //
     // Trace sources at the "top" of the net device, where packets transition
     // to/from higher layers.
@@ -139,6 +235,17 @@ PointToPointNetDevice::GetTypeId (void)
     .AddTraceSource ("PromiscSniffer", 
                      "Trace source simulating a promiscuous packet sniffer attached to the device",
                      MakeTraceSourceAccessor (&PointToPointNetDevice::m_promiscSnifferTrace))
+
+    //
+    // Trace sources of the priority flow control.
+    //
+    .AddTraceSource ("PfcPauseSent",
+                     "Trace source indicating a PAUSE frame has been sent to the peer, with its priority and quanta",
+                     MakeTraceSourceAccessor (&PointToPointNetDevice::m_pfcPauseSentTrace))
+    .AddTraceSource ("PfcPaused",
+                     "Trace source indicating the transmission of a priority paused by the peer resumes, "
+                     "with the priority and the duration of the pause",
+                     MakeTraceSourceAccessor (&PointToPointNetDevice::m_pfcPausedTrace))
   ;
   return tid;
 }
@@ -149,14 +256,35 @@ PointToPointNetDevice::PointToPointNetDevice ()
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_currentPkt (0),
+    m_pfcEnabled (false)
 {
   NS_LOG_FUNCTION (this);
+  for (uint8_t i = 0; i < PfcHeader::PRIORITIES; ++i)
+    {
+      m_pfc[i].paused = false;
+      m_pfc[i].ingressBytes = 0;
+      m_pfc[i].xoff = false;
+    }
 }
 
 PointToPointNetDevice::~PointToPointNetDevice ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  SetPfcEnabled (false);
+}
+
+uint32_t PointToPointNetDevice::g_nPfcDevices = 0;
+
+void
+PointToPointNetDevice::SetPfcEnabled (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  if (enabled != m_pfcEnabled)
+    {
+      g_nPfcDevices += enabled ? 1 : -1;
+    }
+  m_pfcEnabled = enabled;
 }
 
 void
@@ -174,6 +302,11 @@ PointToPointNetDevice::ProcessHeader (Ptr<Packet> p, uint16_t& param)
   NS_LOG_FUNCTION_NOARGS ();
   PppHeader ppp;
   p->RemoveHeader (ppp);
+  if (ppp.GetProtocol () == PfcHeader::PROTOCOL)
+    {
+      // A PAUSE frame from a peer with priority flow control
+      return false;
+    }
   param = PppToEther (ppp.GetProtocol ());
   return true;
 }
@@ -186,6 +319,16 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  for (uint8_t i = 0; i < PfcHeader::PRIORITIES; ++i)
+    {
+      m_pfc[i].queue = 0;
+      m_pfc[i].resumeEvent.Cancel ();
+      m_pfc[i].refreshEvent.Cancel ();
+    }
+  while (!m_controlQueue.empty ())
+    {
+      m_controlQueue.pop ();
+    }
   NetDevice::DoDispose ();
 }
 
@@ -217,6 +360,23 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   NS_ASSERT_MSG (m_txMachineState == READY, "Must be READY to transmit");
   m_txMachineState = BUSY;
   m_currentPkt = p;
+
+  //
+  // The packet leaves the node: release its bytes from the device which
+  // received it.  Only the devices with priority flow control tag the
+  // packets they receive.
+  //
+  PfcIngressTag tag;
+  if (g_nPfcDevices != 0 && p->RemovePacketTag (tag) && tag.GetNodeId () == m_node->GetId ())
+    {
+      Ptr<PointToPointNetDevice> ingress =
+        DynamicCast<PointToPointNetDevice> (m_node->GetDevice (tag.GetIfIndex ()));
+      if (ingress != 0)
+        {
+          ingress->ReleaseIngress (tag.GetPriority (), p->GetSize ());
+        }
+    }
+
   m_phyTxBeginTrace (m_currentPkt);
 
   Time txTime = Seconds (m_bps.CalculateTxTime (p->GetSize ()));
@@ -252,13 +412,21 @@ PointToPointNetDevice::TransmitComplete (void)
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
 
-  Ptr<Packet> p = m_queue->Dequeue ();
+  TransmitNext ();
+}
+
+bool
+PointToPointNetDevice::TransmitNext (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  Ptr<Packet> p = Dequeue ();
   if (p == 0)
     {
       //
       // No packet was on the queue, so we just exit.
       //
-      return;
+      return false;
     }
 
   //
@@ -266,7 +434,223 @@ PointToPointNetDevice::TransmitComplete (void)
   //
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
-  TransmitStart (p);
+  return TransmitStart (p);
+}
+
+bool
+PointToPointNetDevice::Enqueue (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  Ptr<Queue> queue = m_pfcEnabled ? GetEgressQueue (GetPriority (p)) : m_queue;
+  if (!queue->Enqueue (p))
+    {
+      return false;
+    }
+
+  PfcIngressTag tag;
+  if (g_nPfcDevices != 0 && p->PeekPacketTag (tag) && tag.GetNodeId () == m_node->GetId ())
+    {
+      Ptr<PointToPointNetDevice> ingress =
+        DynamicCast<PointToPointNetDevice> (m_node->GetDevice (tag.GetIfIndex ()));
+      if (ingress != 0)
+        {
+          ingress->ChargeIngress (tag.GetPriority (), p->GetSize ());
+        }
+    }
+  return true;
+}
+
+Ptr<Packet>
+PointToPointNetDevice::Dequeue (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  if (!m_controlQueue.empty ())
+    {
+      Ptr<Packet> p = m_controlQueue.front ();
+      m_controlQueue.pop ();
+      return p;
+    }
+  if (!m_pfcEnabled)
+    {
+      return m_queue->Dequeue ();
+    }
+  for (int i = PfcHeader::PRIORITIES - 1; i >= 0; --i)
+    {
+      Ptr<Queue> queue = (i == 0) ? m_queue : m_pfc[i].queue;
+      if (m_pfc[i].paused || queue == 0 || queue->IsEmpty ())
+        {
+          continue;
+        }
+      return queue->Dequeue ();
+    }
+  return 0;
+}
+
+uint8_t
+PointToPointNetDevice::GetPriority (Ptr<const Packet> p)
+{
+  //
+  // The PPP protocol, then the version and the type of service of the
+  // IPv4 header.
+  //
+  if (p->GetSize () < 4)
+    {
+      return 0;
+    }
+  uint8_t buf[4];
+  p->CopyData (buf, 4);
+  if (buf[0] == 0x00 && buf[1] == 0x21 && (buf[2] >> 4) == 4)
+    {
+      return buf[3] >> 5;
+    }
+  return 0;
+}
+
+Ptr<Queue>
+PointToPointNetDevice::GetEgressQueue (uint8_t priority)
+{
+  NS_ASSERT (priority < PfcHeader::PRIORITIES);
+  if (priority == 0)
+    {
+      return m_queue;
+    }
+  if (m_pfc[priority].queue == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_queue->GetInstanceTypeId ());
+      m_pfc[priority].queue = factory.Create<Queue> ();
+    }
+  return m_pfc[priority].queue;
+}
+
+void
+PointToPointNetDevice::ChargeIngress (uint8_t priority, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority << bytes);
+  PfcClass &pfc = m_pfc[priority];
+  pfc.ingressBytes += bytes;
+  if (m_pfcEnabled && !pfc.xoff && pfc.ingressBytes >= m_pfcXoff)
+    {
+      NS_LOG_LOGIC ("Priority " << (uint32_t) priority << " above XOFF, pausing the peer");
+      pfc.xoff = true;
+      SendPause (priority, m_pfcQuanta);
+    }
+}
+
+void
+PointToPointNetDevice::ReleaseIngress (uint8_t priority, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority << bytes);
+  PfcClass &pfc = m_pfc[priority];
+  NS_ASSERT (pfc.ingressBytes >= bytes);
+  pfc.ingressBytes -= bytes;
+  if (pfc.xoff && pfc.ingressBytes <= m_pfcXon)
+    {
+      NS_LOG_LOGIC ("Priority " << (uint32_t) priority << " below XON, resuming the peer");
+      pfc.xoff = false;
+      pfc.refreshEvent.Cancel ();
+      SendPause (priority, 0);
+    }
+}
+
+void
+PointToPointNetDevice::SendPause (uint8_t priority, uint16_t quanta)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority << quanta);
+
+  PfcHeader pfc;
+  pfc.SetQuanta (priority, quanta);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (pfc);
+  PppHeader ppp;
+  ppp.SetProtocol (PfcHeader::PROTOCOL);
+  p->AddHeader (ppp);
+  m_controlQueue.push (p);
+  m_pfcPauseSentTrace (priority, quanta);
+
+  if (quanta > 0)
+    {
+      //
+      // Refresh the pause halfway through, so that the peer does not
+      // resume while the node still holds too many packets.
+      //
+      Time refresh = Seconds (m_bps.CalculateTxTime (64) * quanta / 2);
+      m_pfc[priority].refreshEvent.Cancel ();
+      m_pfc[priority].refreshEvent =
+        Simulator::Schedule (refresh, &PointToPointNetDevice::RefreshPause, this, priority);
+    }
+
+  if (m_txMachineState == READY)
+    {
+      TransmitNext ();
+    }
+}
+
+void
+PointToPointNetDevice::RefreshPause (uint8_t priority)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority);
+  if (m_pfc[priority].xoff)
+    {
+      SendPause (priority, m_pfcQuanta);
+    }
+}
+
+void
+PointToPointNetDevice::ReceivePause (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+
+  PppHeader ppp;
+  p->RemoveHeader (ppp);
+  PfcHeader pfc;
+  p->RemoveHeader (pfc);
+
+  //
+  // The quanta is the transmission time of 512 bits on this link.
+  //
+  double quantum = m_bps.CalculateTxTime (64);
+  for (uint8_t i = 0; i < PfcHeader::PRIORITIES; ++i)
+    {
+      if (!pfc.IsEnabled (i))
+        {
+          continue;
+        }
+      if (pfc.GetQuanta (i) == 0)
+        {
+          Resume (i);
+          continue;
+        }
+      if (!m_pfc[i].paused)
+        {
+          NS_LOG_LOGIC ("Priority " << (uint32_t) i << " paused by the peer");
+          m_pfc[i].paused = true;
+          m_pfc[i].pauseStart = Simulator::Now ();
+        }
+      m_pfc[i].resumeEvent.Cancel ();
+      m_pfc[i].resumeEvent = Simulator::Schedule (Seconds (quantum * pfc.GetQuanta (i)),
+                                                  &PointToPointNetDevice::Resume, this, i);
+    }
+}
+
+void
+PointToPointNetDevice::Resume (uint8_t priority)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority);
+  PfcClass &pfc = m_pfc[priority];
+  if (!pfc.paused)
+    {
+      return;
+    }
+  pfc.paused = false;
+  pfc.resumeEvent.Cancel ();
+  m_pfcPausedTrace (priority, Simulator::Now () - pfc.pauseStart);
+  if (m_txMachineState == READY)
+    {
+      TransmitNext ();
+    }
 }
 
 bool
@@ -294,6 +678,48 @@ PointToPointNetDevice::SetQueue (Ptr<Queue> q)
   m_queue = q;
 }
 
+void
+PointToPointNetDevice::SetPriorityQueue (uint8_t priority, Ptr<Queue> queue)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) priority << queue);
+  NS_ASSERT (priority < PfcHeader::PRIORITIES);
+  if (priority == 0)
+    {
+      m_queue = queue;
+    }
+  else
+    {
+      m_pfc[priority].queue = queue;
+    }
+}
+
+Ptr<Queue>
+PointToPointNetDevice::GetPriorityQueue (uint8_t priority) const
+{
+  NS_ASSERT (priority < PfcHeader::PRIORITIES);
+  return (priority == 0) ? m_queue : m_pfc[priority].queue;
+}
+
+bool
+PointToPointNetDevice::IsPfcEnabled (void) const
+{
+  return m_pfcEnabled;
+}
+
+bool
+PointToPointNetDevice::IsPaused (uint8_t priority) const
+{
+  NS_ASSERT (priority < PfcHeader::PRIORITIES);
+  return m_pfc[priority].paused;
+}
+
+uint32_t
+PointToPointNetDevice::GetIngressBytes (uint8_t priority) const
+{
+  NS_ASSERT (priority < PfcHeader::PRIORITIES);
+  return m_pfc[priority].ingressBytes;
+}
+
 void
 PointToPointNetDevice::SetReceiveErrorModel (Ptr<ErrorModel> em)
 {
@@ -326,13 +752,36 @@ PointToPointNetDevice::Receive (Ptr<Packet> packet)
       m_promiscSnifferTrace (packet);
       m_phyRxEndTrace (packet);
 
+      //
+      // PAUSE frames stop here.  Remember which device received the other
+      // packets and their priority, to charge them to this device while
+      // the node queues them.
+      //
+      if (m_pfcEnabled)
+        {
+          PppHeader ppp;
+          packet->PeekHeader (ppp);
+          if (ppp.GetProtocol () == PfcHeader::PROTOCOL)
+            {
+              ReceivePause (packet);
+              return;
+            }
+          PfcIngressTag tag;
+          packet->RemovePacketTag (tag);
+          packet->AddPacketTag (PfcIngressTag (m_node->GetId (), m_ifIndex, GetPriority (packet)));
+        }
+
       //
       // Strip off the point-to-point protocol header and forward this packet
       // up the protocol stack.  Since this is a simple point-to-point link,
       // there is no difference in what the promisc callback sees and what the
-      // normal receive callback sees.
+      // normal receive callback sees.  A device without priority flow
+      // control ignores the PAUSE frames.
       //
-      ProcessHeader (packet, protocol);
+      if (!ProcessHeader (packet, protocol))
+        {
+          return;
+        }
 
       if (!m_promiscCallback.IsNull ())
         {
@@ -487,6 +936,20 @@ PointToPointNetDevice::Send (
 
   m_macTxTrace (packet);
 
+  if (m_pfcEnabled)
+    {
+      if (!Enqueue (packet))
+        {
+          m_macTxDropTrace (packet);
+          return false;
+        }
+      if (m_txMachineState == READY)
+        {
+          TransmitNext ();
+        }
+      return true;
+    }
+
   //
   // If there's a transmission in progress, we enque the packet for later
   // transmission; otherwise we send it now.
@@ -497,7 +960,7 @@ PointToPointNetDevice::Send (
       // Even if the transmitter is immediately available, we still enqueue and
       // dequeue the packet to hit the tracing hooks.
       //
-      if (m_queue->Enqueue (packet) == true)
+      if (Enqueue (packet) == true)
         {
           packet = m_queue->Dequeue ();
           m_snifferTrace (packet);
@@ -513,7 +976,7 @@ PointToPointNetDevice::Send (
     }
   else
     {
-      return m_queue->Enqueue (packet);
+      return Enqueue (packet);
     }
 }
 
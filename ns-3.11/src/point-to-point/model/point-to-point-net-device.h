@@ -20,6 +20,7 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <string.h>
+#include <queue>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -30,6 +31,8 @@
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
+#include "ns3/event-id.h"
+#include "pfc-header.h"
 
 namespace ns3 {
 
@@ -54,6 +57,20 @@ class ErrorModel;
  * Key parameters or objects that can be specified for this device 
  * include a queue, data rate, and interframe transmission gap (the 
  * propagation delay is set in the PointToPointChannel).
+ *
+ * The device optionally implements the Priority Flow Control of IEEE
+ * 802.1Qbb (attribute PfcEnabled).  Packets are then classified in eight
+ * priorities from the precedence bits of their IPv4 type of service, and
+ * queued in one transmit queue per priority, served in strict priority
+ * order (7 first).  On the receive side the device counts, per priority,
+ * the bytes it received which are still queued for transmission on the
+ * other point-to-point devices of the node.  When this count reaches
+ * PfcXoffThreshold the device sends a PAUSE frame to its peer, which
+ * stops transmitting that priority; the PAUSE is refreshed while the
+ * count stays above PfcXonThreshold and cancelled when it drops below.
+ * Only the point-to-point devices of the node release the bytes counted
+ * against an ingress device, so a node forwarding the traffic of a
+ * PFC-enabled device to other kinds of devices should not enable PFC.
  */
 class PointToPointNetDevice : public NetDevice
 {
@@ -120,6 +137,43 @@ public:
    */
   Ptr<Queue> GetQueue (void) const;
 
+  /**
+   * Attach the transmit queue of a priority.
+   *
+   * When priority flow control is enabled, the device keeps one transmit
+   * queue per priority.  The queue of priority 0 is the one set by
+   * SetQueue ().  A priority without a queue gets a queue of the same
+   * type as the queue of priority 0 the first time it is used.
+   *
+   * @param priority the priority, from 0 to 7
+   * @param queue Ptr to the new queue.
+   */
+  void SetPriorityQueue (uint8_t priority, Ptr<Queue> queue);
+
+  /**
+   * @param priority the priority, from 0 to 7
+   * @returns Ptr to the transmit queue of the priority, if any.
+   */
+  Ptr<Queue> GetPriorityQueue (uint8_t priority) const;
+
+  /**
+   * @returns true if priority flow control is enabled on this device.
+   */
+  bool IsPfcEnabled (void) const;
+
+  /**
+   * @param priority the priority, from 0 to 7
+   * @returns true if the peer has paused the transmission of the priority.
+   */
+  bool IsPaused (uint8_t priority) const;
+
+  /**
+   * @param priority the priority, from 0 to 7
+   * @returns the number of bytes of the priority received by this device
+   * and still queued on the point-to-point devices of the node.
+   */
+  uint32_t GetIngressBytes (uint8_t priority) const;
+
   /**
    * Attach a receive ErrorModel to the PointToPointNetDevice.
    *
@@ -246,6 +300,80 @@ private:
    */
   void TransmitComplete (void);
 
+  /**
+   * Dequeue the next packet to transmit, if any, and start sending it.
+   *
+   * @returns true if a packet was sent successfully
+   */
+  bool TransmitNext (void);
+
+  /**
+   * Queue a packet for transmission, in the queue of its priority if
+   * priority flow control is enabled, and charge it to the device it was
+   * received from.
+   *
+   * @param p the packet, with its PPP header
+   * @returns false if the queue dropped the packet
+   */
+  bool Enqueue (Ptr<Packet> p);
+
+  /**
+   * @returns the next packet to transmit: a PAUSE frame if any, else a
+   * packet from the highest priority not paused by the peer.
+   */
+  Ptr<Packet> Dequeue (void);
+
+  /**
+   * @param p a packet with its PPP header
+   * @returns the priority of the packet, from the precedence of its IPv4
+   * type of service, or 0 for the other protocols
+   */
+  static uint8_t GetPriority (Ptr<const Packet> p);
+
+  /**
+   * @param priority the priority, from 0 to 7
+   * @returns the transmit queue of the priority, created if needed
+   */
+  Ptr<Queue> GetEgressQueue (uint8_t priority);
+
+  /**
+   * Count the bytes of a packet received by this device which have been
+   * queued on a device of the node, and pause the peer if needed.
+   */
+  void ChargeIngress (uint8_t priority, uint32_t bytes);
+
+  /**
+   * Release the bytes of a packet received by this device which have
+   * left the queue of a device of the node, and resume the peer if needed.
+   */
+  void ReleaseIngress (uint8_t priority, uint32_t bytes);
+
+  /**
+   * Queue a PAUSE frame for a priority in front of the data packets.
+   *
+   * @param priority the priority, from 0 to 7
+   * @param quanta the pause time, 0 to let the peer resume
+   */
+  void SendPause (uint8_t priority, uint16_t quanta);
+
+  /**
+   * Send the PAUSE frame again before the peer resumes, while the
+   * ingress bytes of the priority are above the XON threshold.
+   */
+  void RefreshPause (uint8_t priority);
+
+  /**
+   * Honor a PAUSE frame received from the peer.
+   *
+   * @param p the PAUSE frame, with its PPP header
+   */
+  void ReceivePause (Ptr<Packet> p);
+
+  /**
+   * Let the transmission of a paused priority resume.
+   */
+  void Resume (uint8_t priority);
+
   void NotifyLinkUp (void);
 
   /**
@@ -292,6 +420,47 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  /**
+   * The state of a priority of the priority flow control.
+   */
+  struct PfcClass
+  {
+    Ptr<Queue> queue;       //!< Transmit queue, unused for priority 0
+    bool paused;            //!< Transmission paused by the peer
+    Time pauseStart;        //!< Time at which the peer paused the transmission
+    EventId resumeEvent;    //!< End of the pause requested by the peer
+    uint32_t ingressBytes;  //!< Bytes received and queued on the node
+    bool xoff;              //!< A PAUSE frame has been sent to the peer
+    EventId refreshEvent;   //!< Next refresh of the PAUSE sent to the peer
+  };
+
+  void SetPfcEnabled (bool enabled);
+
+  bool m_pfcEnabled;
+  /// Number of devices with priority flow control, which tag the packets
+  static uint32_t g_nPfcDevices;
+  uint32_t m_pfcXoff;
+  uint32_t m_pfcXon;
+  uint16_t m_pfcQuanta;
+  PfcClass m_pfc[PfcHeader::PRIORITIES];
+
+  /**
+   * The PAUSE frames waiting for transmission, sent before any packet.
+   */
+  std::queue<Ptr<Packet> > m_controlQueue;
+
+  /**
+   * The trace source fired when the device sends a PAUSE frame, with the
+   * priority and the quanta requested.
+   */
+  TracedCallback<uint8_t, uint16_t> m_pfcPauseSentTrace;
+
+  /**
+   * The trace source fired when the transmission of a priority paused by
+   * the peer resumes, with the priority and the duration of the pause.
+   */
+  TracedCallback<uint8_t, Time> m_pfcPausedTrace;
+
   /**
    * Error model for receive packet events
    */
@@ -26,6 +26,8 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/tag.h"
+#include "ns3/core-config.h"
 
 using namespace std;
 
@@ -53,6 +55,34 @@ PointToPointRemoteChannel::~PointToPointRemoteChannel ()
 {
 }
 
+#ifdef NS3_MULTITHREADED
+// Rebuild the packet so that the copy shares no buffer, whose counts
+// are not atomic, with the packet of the sender, then add its packet
+// tags to the copy. The byte tags are lost.
+static Ptr<Packet>
+CopyToOtherThread (Ptr<const Packet> p)
+{
+  uint32_t serializedSize = p->GetSerializedSize ();
+  uint8_t *buffer = new uint8_t[serializedSize];
+  p->Serialize (buffer, serializedSize);
+  Ptr<Packet> copy = Create<Packet> (buffer, serializedSize, true);
+  delete [] buffer;
+  PacketTagIterator i = p->GetPacketTagIterator ();
+  while (i.HasNext ())
+    {
+      PacketTagIterator::Item item = i.Next ();
+      NS_ASSERT (item.GetTypeId ().HasConstructor ());
+      Callback<ObjectBase *> constructor = item.GetTypeId ().GetConstructor ();
+      Tag *tag = dynamic_cast<Tag *> (constructor ());
+      NS_ASSERT (tag != 0);
+      item.GetTag (*tag);
+      copy->AddPacketTag (*tag);
+      delete tag;
+    }
+  return copy;
+}
+#endif
+
 bool
 PointToPointRemoteChannel::TransmitStart (
   Ptr<Packet> p,
@@ -67,13 +97,30 @@ PointToPointRemoteChannel::TransmitStart (
   uint32_t wire = src == GetSource (0) ? 0 : 1;
   Ptr<PointToPointNetDevice> dst = GetDestination (wire);
 
+  if (MpiInterface::IsEnabled ())
+    {
 #ifdef NS3_MPI
-  // Calculate the rxTime (absolute)
-  Time rxTime = Simulator::Now () + txTime + GetDelay ();
-  MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+      // Calculate the rxTime (absolute)
+      Time rxTime = Simulator::Now () + txTime + GetDelay ();
+      MpiInterface::SendPacket (p, rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
+#else
+      NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+#endif
+    }
+  else
+    {
+      // Both nodes are in this process, in different partitions of the
+      // multithreaded simulator: the receiver gets its own copy of the
+      // packet, which keeps the packet tags. Only when the partitions
+      // run on several threads must the copy share no buffer.
+#ifdef NS3_MULTITHREADED
+      Ptr<Packet> copy = CopyToOtherThread (p);
 #else
-  NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
+      Ptr<Packet> copy = p->Copy ();
 #endif
+      Simulator::ScheduleWithContext (dst->GetNode ()->GetId (), txTime + GetDelay (),
+                                      &PointToPointNetDevice::Receive, dst, copy);
+    }
   return true;
 }
 
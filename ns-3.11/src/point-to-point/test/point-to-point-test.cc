@@ -3,6 +3,30 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-partition-helper.h"
+#include "ns3/point-to-point-remote-channel.h"
+#include "ns3/fast-point-to-point-net-device.h"
+#include "ns3/fast-point-to-point-helper.h"
+#include "ns3/ppp-header.h"
+#include "ns3/pfc-header.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/node-container.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/core-config.h"
+#include "ns3/event-impl.h"
+#include "ns3/packet-pool.h"
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+#include "ns3/multithreaded-simulator-impl.h"
+#endif
+
+#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -55,6 +79,750 @@ PointToPointTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+/**
+ * Packets forwarded both ways along a chain of nodes, each one in its
+ * own partition, must arrive at the same times with the multithreaded
+ * simulator as with the default simulator, and keep their packet tags.
+ *
+ * Unless ns-3 is configured with --enable-multithreaded-simulator, the
+ * partitions all run on one thread: the test then checks the
+ * partitioning and the synchronization, but not real concurrency.
+ */
+class PointToPointMultithreadedTest : public TestCase
+{
+public:
+  PointToPointMultithreadedTest ();
+
+  virtual void DoRun (void);
+
+private:
+  typedef std::vector<std::vector<int64_t> > Arrivals;
+
+  void RunChain (std::string simulator, Arrivals &arrivals);
+  void Send (Ptr<NetDevice> device);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::map<Ptr<NetDevice>, Ptr<NetDevice> > m_forward;
+  Arrivals *m_arrivals;
+};
+
+PointToPointMultithreadedTest::PointToPointMultithreadedTest ()
+  : TestCase ("Forwarding across the partitions of the multithreaded simulator")
+{
+}
+
+void
+PointToPointMultithreadedTest::Send (Ptr<NetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (500);
+  p->AddPacketTag (FlowIdTag (device->GetNode ()->GetId ()));
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
+                                        uint16_t protocol, const Address &from)
+{
+  FlowIdTag tag;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (tag), true, "The packet keeps its tag");
+  (*m_arrivals)[device->GetNode ()->GetId ()].push_back (Simulator::Now ().GetTimeStep ());
+  std::map<Ptr<NetDevice>, Ptr<NetDevice> >::const_iterator next = m_forward.find (device);
+  if (next != m_forward.end ())
+    {
+      next->second->Send (p->Copy (), next->second->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedTest::RunChain (std::string simulator, Arrivals &arrivals)
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue (simulator));
+  const uint32_t nNodes = 4;
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      nodes.Add (CreateObject<Node> (i));
+    }
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  std::vector<NetDeviceContainer> links;
+  for (uint32_t i = 0; i + 1 < nNodes; ++i)
+    {
+      p2p.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (1 + i % 2)));
+      links.push_back (p2p.Install (nodes.Get (i), nodes.Get (i + 1)));
+    }
+  for (uint32_t i = 0; i < links.size (); ++i)
+    {
+      for (uint32_t j = 0; j < 2; ++j)
+        {
+          links[i].Get (j)->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedTest::Receive, this));
+        }
+      if (i + 1 < links.size ())
+        {
+          m_forward[links[i].Get (1)] = links[i + 1].Get (0);
+          m_forward[links[i + 1].Get (0)] = links[i].Get (1);
+        }
+    }
+  arrivals.assign (nNodes, std::vector<int64_t> ());
+  m_arrivals = &arrivals;
+  for (uint32_t i = 0; i < 50; ++i)
+    {
+      Time t = Seconds (1.0) + MicroSeconds (300 * i);
+      Simulator::ScheduleWithContext (0, t, &PointToPointMultithreadedTest::Send, this,
+                                      links.front ().Get (0));
+      Simulator::ScheduleWithContext (nNodes - 1, t, &PointToPointMultithreadedTest::Send, this,
+                                      links.back ().Get (1));
+    }
+  Simulator::Stop (Seconds (2.0));
+  Simulator::Run ();
+  m_forward.clear ();
+}
+
+void
+PointToPointMultithreadedTest::DoRun (void)
+{
+  Arrivals expected;
+  RunChain ("ns3::DefaultSimulatorImpl", expected);
+  Simulator::Destroy ();
+
+  Arrivals arrivals;
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (4));
+  RunChain ("ns3::MultithreadedSimulatorImpl", arrivals);
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "The global value selects the multithreaded simulator");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), 4, "One partition per system id");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), MilliSeconds (1), "Smallest delay between partitions");
+#ifdef NS3_MULTITHREADED
+  NS_TEST_EXPECT_MSG_LT (1, impl->GetThreadCount (), "The partitions run on several threads");
+#else
+  NS_TEST_EXPECT_MSG_EQ (impl->GetThreadCount (), 1, "Without the option, one thread runs every partition");
+#endif
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (2.0), "Stopped by the global event");
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (0));
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  for (uint32_t i = 0; i < expected.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (arrivals[i].size (), expected[i].size (), "Packets received by node " << i);
+      for (uint32_t j = 0; j < expected[i].size () && j < arrivals[i].size (); ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (arrivals[i][j], expected[i][j], "Arrival " << j << " at node " << i);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (expected[0].size (), 50, "Every packet crossed the chain");
+}
+
+/**
+ * An event of a node stops the multithreaded simulator: the simulation
+ * time must be the time of that event, and a second run must resume
+ * the events of every partition from there, each one exactly once.
+ */
+class PointToPointMultithreadedStopTest : public TestCase
+{
+public:
+  PointToPointMultithreadedStopTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void Tick (uint32_t node);
+
+  std::vector<std::vector<int64_t> > m_times;
+};
+
+PointToPointMultithreadedStopTest::PointToPointMultithreadedStopTest ()
+  : TestCase ("Stop the multithreaded simulator from an event of a node")
+{
+}
+
+void
+PointToPointMultithreadedStopTest::Tick (uint32_t node)
+{
+  m_times[node].push_back (Simulator::Now ().GetTimeStep ());
+  if (node == 0 && Simulator::Now () == MilliSeconds (1500))
+    {
+      Simulator::Stop ();
+    }
+}
+
+void
+PointToPointMultithreadedStopTest::DoRun (void)
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (0));
+  nodes.Add (CreateObject<Node> (1));
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  p2p.Install (nodes);
+
+  const uint32_t nTicks = 200;
+  m_times.assign (2, std::vector<int64_t> ());
+  for (uint32_t i = 0; i < nTicks; ++i)
+    {
+      for (uint32_t node = 0; node < 2; ++node)
+        {
+          Simulator::ScheduleWithContext (node, Seconds (1.0) + MicroSeconds (5000 * i + 7 * node),
+                                          &PointToPointMultithreadedStopTest::Tick, this, node);
+        }
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MilliSeconds (1500), "The simulation stops at the time of the Stop");
+  Simulator::Run ();
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  for (uint32_t node = 0; node < 2; ++node)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_times[node].size (), nTicks, "Every event of node " << node << " runs once");
+      for (uint32_t i = 1; i < m_times[node].size (); ++i)
+        {
+          NS_TEST_EXPECT_MSG_LT (m_times[node][i - 1], m_times[node][i], "The events of node " << node << " run in order");
+        }
+    }
+}
+
+/**
+ * A burst of packets bounced between two partitions of the
+ * multithreaded simulator: whatever thread deletes the events and the
+ * packets, the memory it keeps for the next ones stays bounded.
+ */
+class PointToPointMultithreadedPoolTest : public TestCase
+{
+public:
+  PointToPointMultithreadedPoolTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void Send (Ptr<NetDevice> device, Ptr<Packet> p);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  uint32_t m_received;
+};
+
+PointToPointMultithreadedPoolTest::PointToPointMultithreadedPoolTest ()
+  : TestCase ("Bound the memory pools under the multithreaded simulator")
+{
+}
+
+void
+PointToPointMultithreadedPoolTest::Send (Ptr<NetDevice> device, Ptr<Packet> p)
+{
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointMultithreadedPoolTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
+                                            uint16_t protocol, const Address &from)
+{
+  m_received++;
+  if (device->GetNode ()->GetId () == 1)
+    {
+      device->Send (p->Copy (), device->GetBroadcast (), protocol);
+    }
+  return true;
+}
+
+void
+PointToPointMultithreadedPoolTest::DoRun (void)
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (2));
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (0));
+  nodes.Add (CreateObject<Node> (1));
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  p2p.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (100000));
+  NetDeviceContainer devices = p2p.Install (nodes);
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&PointToPointMultithreadedPoolTest::Receive, this));
+    }
+
+  // Every event and packet is alive at once, several times more than a
+  // thread keeps
+  const uint32_t nPackets = 5 * EventImpl::GetMaxFreeCount ();
+  std::vector<uint8_t> payload (500, 0x55);
+  m_received = 0;
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      Simulator::ScheduleWithContext (0, Seconds (1.0), &PointToPointMultithreadedPoolTest::Send, this,
+                                      devices.Get (0), Create<Packet> (&payload[0], payload.size ()));
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (0));
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 2 * nPackets, "Every packet crossed the partitions both ways");
+  // The events of this simulation fall in a few size classes
+  NS_TEST_EXPECT_MSG_LT (EventImpl::GetFreeCount (), 4 * EventImpl::GetMaxFreeCount (),
+                         "The deleted events kept for reuse are bounded");
+  // The bytes of the packets alone are ten times more than that
+  NS_TEST_EXPECT_MSG_LT (PacketPool::GetFreeBytes (), 4 * (uint64_t)PacketPool::GetMaxFreeBytes (),
+                         "The released blocks kept for reuse are bounded");
+}
+#endif /* HAVE_PTHREAD_H && HAVE_TLS */
+
+/**
+ * Without MPI and with the default simulator, a link between nodes with
+ * different system ids is a normal link: the packets keep their tags.
+ */
+class PointToPointSystemIdTest : public TestCase
+{
+public:
+  PointToPointSystemIdTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void Send (Ptr<NetDevice> device);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  uint32_t m_received;
+  uint32_t m_tagged;
+};
+
+PointToPointSystemIdTest::PointToPointSystemIdTest ()
+  : TestCase ("Packet tags cross a link between system ids with the default simulator")
+{
+}
+
+void
+PointToPointSystemIdTest::Send (Ptr<NetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddPacketTag (FlowIdTag (7));
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointSystemIdTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p,
+                                   uint16_t protocol, const Address &from)
+{
+  m_received++;
+  FlowIdTag tag;
+  if (p->PeekPacketTag (tag) && tag.GetFlowId () == 7)
+    {
+      m_tagged++;
+    }
+  return true;
+}
+
+void
+PointToPointSystemIdTest::DoRun (void)
+{
+  m_received = 0;
+  m_tagged = 0;
+  Simulator::SetImplementation (CreateObject<DefaultSimulatorImpl> ());
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (0));
+  nodes.Add (CreateObject<Node> (1));
+  PointToPointHelper p2p;
+  NetDeviceContainer devices = p2p.Install (nodes);
+  NS_TEST_EXPECT_MSG_EQ ((DynamicCast<PointToPointRemoteChannel> (devices.Get (0)->GetChannel ()) == 0), true,
+                         "The link is a normal link");
+  devices.Get (1)->SetReceiveCallback (MakeCallback (&PointToPointSystemIdTest::Receive, this));
+  Simulator::Schedule (Seconds (1.0), &PointToPointSystemIdTest::Send, this, devices.Get (0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 1, "The packet crossed the link");
+  NS_TEST_EXPECT_MSG_EQ (m_tagged, 1, "The packet kept its tag");
+}
+
+/**
+ * Split two stars joined by a long link: the cut link uses a remote
+ * channel only if the simulator runs the partitions in parallel.
+ */
+class PointToPointPartitionTest : public TestCase
+{
+public:
+  PointToPointPartitionTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void Partition (bool parallel);
+};
+
+PointToPointPartitionTest::PointToPointPartitionTest ()
+  : TestCase ("Partition two stars joined by a long link")
+{
+}
+
+void
+PointToPointPartitionTest::Partition (bool parallel)
+{
+  NodeContainer hubs;
+  hubs.Create (2);
+  NodeContainer leaves[2];
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NodeContainer all;
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      leaves[i].Create (3);
+      for (uint32_t j = 0; j < 3; ++j)
+        {
+          p2p.Install (hubs.Get (i), leaves[i].Get (j));
+        }
+      all.Add (leaves[i]);
+    }
+  all.Add (hubs);
+  p2p.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  NetDeviceContainer core = p2p.Install (hubs);
+
+  PointToPointPartitionHelper partition;
+  partition.Partition (all, 2);
+
+  NS_TEST_EXPECT_MSG_EQ (partition.GetCutLinkCount (), 1, "Only the link between the hubs is cut");
+  NS_TEST_EXPECT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (10), "The lookahead is the delay of the long link");
+  NS_TEST_EXPECT_MSG_EQ_TOL (partition.GetPredictedSpeedup (), 2.0, 0.001, "The stars have the same load");
+  NS_TEST_EXPECT_MSG_NE (hubs.Get (0)->GetSystemId (), hubs.Get (1)->GetSystemId (), "The hubs are split");
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      for (uint32_t j = 0; j < 3; ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (leaves[i].Get (j)->GetSystemId (), hubs.Get (i)->GetSystemId (),
+                                 "A leaf stays with its hub");
+          Ptr<Channel> channel = leaves[i].Get (j)->GetDevice (0)->GetChannel ();
+          NS_TEST_EXPECT_MSG_EQ ((DynamicCast<PointToPointRemoteChannel> (channel) == 0), true,
+                                 "The links inside a partition are plain");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((DynamicCast<PointToPointRemoteChannel> (core.Get (0)->GetChannel ()) != 0), parallel,
+                         "The cut link uses a remote channel only in a parallel simulation");
+  NS_TEST_EXPECT_MSG_EQ ((core.Get (0)->GetChannel () == core.Get (1)->GetChannel ()), true,
+                         "Both ends of the cut link are attached to the same channel");
+
+  Simulator::Destroy ();
+}
+
+void
+PointToPointPartitionTest::DoRun (void)
+{
+  Partition (false);
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::MultithreadedSimulatorImpl"));
+  Partition (true);
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+#endif
+}
+
+/**
+ * A node forwards a burst from a fast link to a slow link with a short
+ * queue: the queue overflows unless priority flow control pauses the
+ * sender, and the PAUSE frames carry the priority of the packets.
+ */
+class PointToPointPfcTest : public TestCase
+{
+public:
+  PointToPointPfcTest (bool pfc);
+
+  virtual void DoRun (void);
+
+private:
+  void Send (Ptr<NetDevice> device);
+  bool Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void Drop (Ptr<const Packet> p);
+  void PauseSent (uint8_t priority, uint16_t quanta);
+  void Paused (uint8_t priority, Time duration);
+
+  bool m_pfc;
+  Ptr<NetDevice> m_egress;
+  uint32_t m_received;
+  uint32_t m_dropped;
+  uint32_t m_pauses;
+  uint32_t m_resumes;
+  uint32_t m_otherPriority;
+  Time m_pausedTime;
+};
+
+PointToPointPfcTest::PointToPointPfcTest (bool pfc)
+  : TestCase (pfc ? "Priority flow control avoids the overflow of a slow link"
+                  : "Without priority flow control a slow link overflows"),
+    m_pfc (pfc)
+{
+}
+
+void
+PointToPointPfcTest::Send (Ptr<NetDevice> device)
+{
+  // An IPv4 header with the type of service of priority 5
+  uint8_t buf[1000] = { 0 };
+  buf[0] = 0x45;
+  buf[1] = 0xa0;
+  device->Send (Create<Packet> (buf, sizeof (buf)), device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointPfcTest::Forward (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_egress->Send (p->Copy (), m_egress->GetBroadcast (), protocol);
+  return true;
+}
+
+bool
+PointToPointPfcTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointPfcTest::Drop (Ptr<const Packet> p)
+{
+  m_dropped++;
+}
+
+void
+PointToPointPfcTest::PauseSent (uint8_t priority, uint16_t quanta)
+{
+  if (priority != 5)
+    {
+      m_otherPriority++;
+    }
+  if (quanta > 0)
+    {
+      m_pauses++;
+    }
+  else
+    {
+      m_resumes++;
+    }
+}
+
+void
+PointToPointPfcTest::Paused (uint8_t priority, Time duration)
+{
+  if (priority != 5)
+    {
+      m_otherPriority++;
+    }
+  m_pausedTime += duration;
+}
+
+void
+PointToPointPfcTest::DoRun (void)
+{
+  m_received = 0;
+  m_dropped = 0;
+  m_pauses = 0;
+  m_resumes = 0;
+  m_otherPriority = 0;
+  m_pausedTime = Seconds (0);
+
+  NodeContainer nodes;
+  nodes.Create (3);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("PfcEnabled", BooleanValue (m_pfc));
+  p2p.SetDeviceAttribute ("PfcXoffThreshold", UintegerValue (10000));
+  p2p.SetDeviceAttribute ("PfcXonThreshold", UintegerValue (5000));
+  p2p.SetChannelAttribute ("Delay", StringValue ("10us"));
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (1000));
+  NetDeviceContainer fast = p2p.Install (nodes.Get (0), nodes.Get (1));
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("1Mbps"));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (20));
+  NetDeviceContainer slow = p2p.Install (nodes.Get (1), nodes.Get (2));
+
+  m_egress = slow.Get (0);
+  fast.Get (0)->SetReceiveCallback (MakeCallback (&PointToPointPfcTest::Receive, this));
+  fast.Get (1)->SetReceiveCallback (MakeCallback (&PointToPointPfcTest::Forward, this));
+  slow.Get (0)->SetReceiveCallback (MakeCallback (&PointToPointPfcTest::Receive, this));
+  slow.Get (1)->SetReceiveCallback (MakeCallback (&PointToPointPfcTest::Receive, this));
+
+  Ptr<PointToPointNetDevice> egress = DynamicCast<PointToPointNetDevice> (m_egress);
+  for (uint8_t i = 0; i < PfcHeader::PRIORITIES; ++i)
+    {
+      Ptr<Queue> queue = egress->GetPriorityQueue (i);
+      if (queue != 0)
+        {
+          queue->TraceConnectWithoutContext ("Drop", MakeCallback (&PointToPointPfcTest::Drop, this));
+        }
+    }
+  fast.Get (1)->TraceConnectWithoutContext ("PfcPauseSent", MakeCallback (&PointToPointPfcTest::PauseSent, this));
+  fast.Get (0)->TraceConnectWithoutContext ("PfcPaused", MakeCallback (&PointToPointPfcTest::Paused, this));
+
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0), &PointToPointPfcTest::Send, this, fast.Get (0));
+    }
+
+  Simulator::Run ();
+
+  Ptr<PointToPointNetDevice> ingress = DynamicCast<PointToPointNetDevice> (fast.Get (1));
+  NS_TEST_EXPECT_MSG_EQ (m_received + m_dropped, 200, "Every packet is received or dropped");
+  NS_TEST_EXPECT_MSG_EQ (ingress->GetIngressBytes (5), 0, "No packet left queued on the node");
+  NS_TEST_EXPECT_MSG_EQ (m_otherPriority, 0, "Only the priority of the packets is paused");
+  if (m_pfc)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_dropped, 0, "The sender is paused before the queue overflows");
+      NS_TEST_EXPECT_MSG_LT (0, m_pauses, "PAUSE frames sent");
+      NS_TEST_EXPECT_MSG_EQ (m_resumes, m_pauses, "Every PAUSE cancelled when the queue drained");
+      NS_TEST_EXPECT_MSG_LT (Seconds (0), m_pausedTime, "The sender has been paused");
+      NS_TEST_EXPECT_MSG_EQ (DynamicCast<PointToPointNetDevice> (fast.Get (0))->IsPaused (5), false,
+                             "The sender resumed");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_LT (0, m_dropped, "The slow link queue overflows");
+      NS_TEST_EXPECT_MSG_EQ (m_pauses, 0, "No PAUSE frames");
+
+      // A device without priority flow control ignores a PAUSE frame
+      Ptr<Packet> pause = Create<Packet> ();
+      PfcHeader pfc;
+      pfc.SetQuanta (5, 0xffff);
+      pause->AddHeader (pfc);
+      PppHeader ppp;
+      ppp.SetProtocol (PfcHeader::PROTOCOL);
+      pause->AddHeader (ppp);
+      uint32_t received = m_received;
+      ingress->SetReceiveCallback (MakeCallback (&PointToPointPfcTest::Receive, this));
+      ingress->Receive (pause);
+      NS_TEST_EXPECT_MSG_EQ (m_received, received, "The PAUSE frame is not passed up");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * The FastPointToPointNetDevice delivers a burst which overflows its queue
+ * at the same times as the PointToPointNetDevice, and frames the packets
+ * of its sniffers with a PPP header.
+ */
+class FastPointToPointTest : public TestCase
+{
+public:
+  FastPointToPointTest ();
+
+  virtual void DoRun (void);
+
+private:
+  void Run (bool fast);
+  void Send (Ptr<NetDevice> device, uint32_t size);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  void Sniff (Ptr<const Packet> p);
+
+  std::vector<int64_t> m_arrivals;
+  std::vector<uint32_t> m_sizes;
+  uint32_t m_dropped;
+  uint32_t m_sniffed;
+  uint32_t m_badFrames;
+};
+
+FastPointToPointTest::FastPointToPointTest ()
+  : TestCase ("The fast point-to-point device has the timing of the PointToPointNetDevice")
+{
+}
+
+void
+FastPointToPointTest::Send (Ptr<NetDevice> device, uint32_t size)
+{
+  if (!device->Send (Create<Packet> (size), device->GetBroadcast (), 0x800))
+    {
+      m_dropped++;
+    }
+}
+
+bool
+FastPointToPointTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_arrivals.push_back (Simulator::Now ().GetTimeStep ());
+  m_sizes.push_back (p->GetSize ());
+  return true;
+}
+
+void
+FastPointToPointTest::Sniff (Ptr<const Packet> p)
+{
+  m_sniffed++;
+  PppHeader ppp;
+  p->PeekHeader (ppp);
+  if (ppp.GetProtocol () != 0x0021)
+    {
+      m_badFrames++;
+    }
+}
+
+void
+FastPointToPointTest::Run (bool fast)
+{
+  m_arrivals.clear ();
+  m_sizes.clear ();
+  m_dropped = 0;
+  m_sniffed = 0;
+  m_badFrames = 0;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  NetDeviceContainer devices;
+  if (fast)
+    {
+      FastPointToPointHelper p2p;
+      p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+      p2p.SetDeviceAttribute ("MaxPackets", UintegerValue (10));
+      p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+      devices = p2p.Install (nodes);
+      devices.Get (1)->TraceConnectWithoutContext ("PromiscSniffer",
+                                                   MakeCallback (&FastPointToPointTest::Sniff, this));
+    }
+  else
+    {
+      PointToPointHelper p2p;
+      p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+      p2p.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (10));
+      p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+      devices = p2p.Install (nodes);
+    }
+  devices.Get (1)->SetReceiveCallback (MakeCallback (&FastPointToPointTest::Receive, this));
+
+  // A burst of 30 packets which overflows the queue, then packets spaced
+  // by less and more than their transmission time
+  for (uint32_t i = 0; i < 30; ++i)
+    {
+      Simulator::Schedule (Seconds (1.0), &FastPointToPointTest::Send, this,
+                           devices.Get (0), 100 + (i * 397) % 1400);
+    }
+  for (uint32_t i = 0; i < 20; ++i)
+    {
+      Simulator::Schedule (Seconds (2.0) + MicroSeconds (700 * i), &FastPointToPointTest::Send, this,
+                           devices.Get (0), 1000);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+FastPointToPointTest::DoRun (void)
+{
+  Run (false);
+  std::vector<int64_t> arrivals = m_arrivals;
+  std::vector<uint32_t> sizes = m_sizes;
+  uint32_t dropped = m_dropped;
+
+  Run (true);
+  NS_TEST_EXPECT_MSG_EQ (m_dropped, dropped, "Same packets dropped");
+  NS_TEST_EXPECT_MSG_LT (0, m_dropped, "The burst overflows the queue");
+  NS_TEST_EXPECT_MSG_EQ (m_arrivals.size (), arrivals.size (), "Same packets received");
+  for (uint32_t i = 0; i < arrivals.size () && i < m_arrivals.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_arrivals[i], arrivals[i], "Arrival time of packet " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_sizes[i], sizes[i], "Size of packet " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_sniffed, m_arrivals.size (), "Every packet received is sniffed");
+  NS_TEST_EXPECT_MSG_EQ (m_badFrames, 0, "The sniffed packets have a PPP header");
+}
+
 //-----------------------------------------------------------------------------
 class PointToPointTestSuite : public TestSuite
 {
@@ -66,6 +834,16 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest);
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_TLS)
+  AddTestCase (new PointToPointMultithreadedTest);
+  AddTestCase (new PointToPointMultithreadedStopTest);
+  AddTestCase (new PointToPointMultithreadedPoolTest);
+#endif
+  AddTestCase (new PointToPointSystemIdTest);
+  AddTestCase (new PointToPointPartitionTest);
+  AddTestCase (new PointToPointPfcTest (true));
+  AddTestCase (new PointToPointPfcTest (false));
+  AddTestCase (new FastPointToPointTest);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite;
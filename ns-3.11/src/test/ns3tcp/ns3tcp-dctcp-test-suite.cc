@@ -0,0 +1,355 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/test.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/ppp-header.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-red-queue.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Ns3DctcpTest");
+
+// ===========================================================================
+// The threshold queue marks ECN-capable IPv4 packets behind a PPP header,
+// and drops the others
+// ===========================================================================
+//
+class Ns3Ipv4RedQueueTestCase : public TestCase
+{
+public:
+  Ns3Ipv4RedQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ptr<Packet> CreateDatagram (Ipv4Header::EcnType ecn);
+};
+
+Ns3Ipv4RedQueueTestCase::Ns3Ipv4RedQueueTestCase ()
+  : TestCase ("Check that Ipv4RedQueue marks ECN-capable packets above its threshold")
+{
+}
+
+Ptr<Packet>
+Ns3Ipv4RedQueueTestCase::CreateDatagram (Ipv4Header::EcnType ecn)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (Ipv4Address ("10.1.1.1"));
+  ipHeader.SetDestination (Ipv4Address ("10.1.1.2"));
+  ipHeader.SetProtocol (6);
+  ipHeader.SetPayloadSize (p->GetSize ());
+  ipHeader.SetTtl (64);
+  ipHeader.SetTos (0xb8);
+  ipHeader.SetEcn (ecn);
+  ipHeader.EnableChecksum ();
+  p->AddHeader (ipHeader);
+  PppHeader ppp;
+  ppp.SetProtocol (0x0021);
+  p->AddHeader (ppp);
+  return p;
+}
+
+void
+Ns3Ipv4RedQueueTestCase::DoRun (void)
+{
+  Ptr<Ipv4RedQueue> queue = CreateObject<Ipv4RedQueue> ();
+  queue->SetAttribute ("UseEcn", BooleanValue (true));
+  queue->SetAttribute ("QW", DoubleValue (1));
+  queue->SetTh (1, 1);
+
+  Ptr<Packet> first = CreateDatagram (Ipv4Header::ECN_ECT0);
+  Ptr<Packet> second = CreateDatagram (Ipv4Header::ECN_ECT1);
+  uint32_t size = second->GetSize ();
+  bool accepted = queue->Enqueue (first);
+  NS_TEST_EXPECT_MSG_EQ (accepted, true, "Below the threshold");
+  accepted = queue->Enqueue (second);
+  NS_TEST_EXPECT_MSG_EQ (accepted, true, "Above the threshold, marked");
+  accepted = queue->Enqueue (CreateDatagram (Ipv4Header::ECN_NotECT));
+  NS_TEST_EXPECT_MSG_EQ (accepted, false, "Above the threshold, not ECN-capable, dropped");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedMark, 1, "One packet marked");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().forcedDrop, 1, "One packet dropped");
+
+  Ptr<Packet> p = queue->Dequeue ();
+  PppHeader ppp;
+  Ipv4Header ipHeader;
+  ipHeader.EnableChecksum ();
+  p->RemoveHeader (ppp);
+  p->RemoveHeader (ipHeader);
+  NS_TEST_EXPECT_MSG_EQ (ipHeader.GetEcn (), Ipv4Header::ECN_ECT0, "First packet left alone");
+
+  p = queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (p->GetUid (), second->GetUid (), "Second packet marked in place");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), size, "Size unchanged");
+  ipHeader = Ipv4Header ();
+  ipHeader.EnableChecksum ();
+  p->RemoveHeader (ppp);
+  p->RemoveHeader (ipHeader);
+  NS_TEST_EXPECT_MSG_EQ (ppp.GetProtocol (), 0x0021, "PPP header kept");
+  NS_TEST_EXPECT_MSG_EQ (ipHeader.GetEcn (), Ipv4Header::ECN_CE, "Second packet marked");
+  NS_TEST_EXPECT_MSG_EQ (ipHeader.GetTos (), 0xbb, "DSCP kept");
+  NS_TEST_EXPECT_MSG_EQ (ipHeader.IsChecksumOk (), true, "Checksum updated");
+}
+
+// ===========================================================================
+// A bulk transfer through a threshold marking queue: the data is ECN-capable,
+// the queue marks instead of dropping, and the sender reacts to the echoes
+//
+//         node 0                 node 1
+//   +----------------+    +----------------+
+//   |   TCP source   |    |   TCP server   |
+//   +----------------+    +----------------+
+//   |    10.1.1.1    |    |    10.1.1.2    |
+//   +----------------+    +----------------+
+//   | point-to-point |    | point-to-point |
+//   +----------------+    +----------------+
+//           |                     |
+//           +---------------------+
+//               10 Mbps, 1 ms
+//
+// ===========================================================================
+//
+class Ns3TcpEcnTestCase : public TestCase
+{
+public:
+  Ns3TcpEcnTestCase (std::string socketType);
+
+private:
+  virtual void DoRun (void);
+  void SourceHandleSend (Ptr<Socket> sock, uint32_t available);
+  void ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from);
+  void ServerHandleRecv (Ptr<Socket> sock);
+  void ServerIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void SourceIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void QueueEnqueue (Ptr<const Packet> packet);
+  void AlphaChange (double oldValue, double newValue);
+
+  std::string m_socketType;
+  uint32_t m_totalBytes;
+  uint32_t m_sourceTxBytes;
+  uint32_t m_serverRxBytes;
+  uint32_t m_notEctSegments;
+  uint32_t m_ceSegments;
+  uint32_t m_cwrSegments;
+  uint32_t m_eceAcks;
+  uint32_t m_maxQueue;
+  double m_alpha;
+  Ptr<Queue> m_queue;
+};
+
+Ns3TcpEcnTestCase::Ns3TcpEcnTestCase (std::string socketType)
+  : TestCase ("Check ECN with " + socketType + " through a threshold marking queue"),
+    m_socketType (socketType),
+    m_totalBytes (2000000),
+    m_sourceTxBytes (0),
+    m_serverRxBytes (0),
+    m_notEctSegments (0),
+    m_ceSegments (0),
+    m_cwrSegments (0),
+    m_eceAcks (0),
+    m_maxQueue (0),
+    m_alpha (1)
+{
+}
+
+void
+Ns3TcpEcnTestCase::DoRun (void)
+{
+  bool dctcp = (m_socketType == "ns3::TcpDctcp");
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  p2p.SetQueue ("ns3::Ipv4RedQueue",
+                "UseEcn", BooleanValue (true),
+                "MinTh", DoubleValue (10),
+                "MaxTh", DoubleValue (10),
+                "QW", DoubleValue (1));
+  NetDeviceContainer devices = p2p.Install (nodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      nodes.Get (i)->GetObject<TcpL4Protocol> ()->SetAttribute (
+        "SocketType", TypeIdValue (TypeId::LookupByName (m_socketType)));
+    }
+  m_queue = DynamicCast<PointToPointNetDevice> (devices.Get (0))->GetQueue ();
+  m_queue->TraceConnectWithoutContext ("Enqueue", MakeCallback (&Ns3TcpEcnTestCase::QueueEnqueue, this));
+  nodes.Get (1)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&Ns3TcpEcnTestCase::ServerIpv4Rx, this));
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&Ns3TcpEcnTestCase::SourceIpv4Rx, this));
+
+  // TcpDctcp offers ECN by itself
+  Ptr<Socket> server = nodes.Get (1)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  server->SetAttribute ("SegmentSize", UintegerValue (1448));
+  server->SetAttribute ("Ecn", BooleanValue (!dctcp));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 50000));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&Ns3TcpEcnTestCase::ServerHandleConnectionCreated, this));
+
+  Ptr<Socket> source = nodes.Get (0)->GetObject<TcpSocketFactory> ()->CreateSocket ();
+  source->SetAttribute ("SegmentSize", UintegerValue (1448));
+  source->SetAttribute ("Ecn", BooleanValue (!dctcp));
+  source->SetAttribute ("SndBufSize", UintegerValue (256000));
+  source->SetSendCallback (MakeCallback (&Ns3TcpEcnTestCase::SourceHandleSend, this));
+  if (dctcp)
+    {
+      source->TraceConnectWithoutContext ("Alpha", MakeCallback (&Ns3TcpEcnTestCase::AlphaChange, this));
+    }
+  source->Connect (InetSocketAddress (Ipv4Address ("10.1.1.2"), 50000));
+
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_serverRxBytes, m_totalBytes, "Server received all bytes");
+  NS_TEST_EXPECT_MSG_EQ (m_notEctSegments, 0, "Every data segment was ECN-capable");
+  Ptr<RedQueue> red = DynamicCast<RedQueue> (m_queue);
+  RedQueue::Stats stats = red->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ ((stats.forcedMark > 0), true, "The queue marked packets");
+  NS_TEST_EXPECT_MSG_EQ (stats.forcedMark, m_ceSegments, "The server saw the marks");
+  NS_TEST_EXPECT_MSG_EQ (stats.forcedDrop + stats.unforcedDrop + stats.qLimDrop, 0, "Nothing was dropped");
+  NS_TEST_EXPECT_MSG_EQ ((m_eceAcks > 0), true, "The server echoed the marks");
+  NS_TEST_EXPECT_MSG_EQ ((m_cwrSegments > 0), true, "The source reduced its window");
+  NS_TEST_EXPECT_MSG_LT (m_maxQueue, 40u, "The queue stayed short");
+  if (dctcp)
+    {
+      NS_TEST_EXPECT_MSG_LT (m_alpha, 1.0, "Only part of the bytes were marked");
+      NS_TEST_EXPECT_MSG_LT (0.0, m_alpha, "Some of the bytes were marked");
+    }
+  Simulator::Destroy ();
+}
+
+void
+Ns3TcpEcnTestCase::SourceHandleSend (Ptr<Socket> sock, uint32_t available)
+{
+  while (sock->GetTxAvailable () > 0 && m_sourceTxBytes < m_totalBytes)
+    {
+      uint32_t toSend = std::min (m_totalBytes - m_sourceTxBytes, sock->GetTxAvailable ());
+      int sent = sock->Send (Create<Packet> (toSend));
+      NS_TEST_EXPECT_MSG_EQ ((sent != -1), true, "Error during send ?");
+      m_sourceTxBytes += sent;
+    }
+  if (m_sourceTxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+Ns3TcpEcnTestCase::ServerHandleConnectionCreated (Ptr<Socket> sock, const Address &from)
+{
+  sock->SetRecvCallback (MakeCallback (&Ns3TcpEcnTestCase::ServerHandleRecv, this));
+}
+
+void
+Ns3TcpEcnTestCase::ServerHandleRecv (Ptr<Socket> sock)
+{
+  while (sock->GetRxAvailable () > 0)
+    {
+      m_serverRxBytes += sock->Recv ()->GetSize ();
+    }
+  if (m_serverRxBytes == m_totalBytes)
+    {
+      sock->Close ();
+    }
+}
+
+void
+Ns3TcpEcnTestCase::ServerIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if (tcpHeader.GetFlags () & TcpHeader::CWR)
+    {
+      m_cwrSegments++;
+    }
+  if (ipHeader.GetEcn () == Ipv4Header::ECN_CE)
+    {
+      m_ceSegments++;
+    }
+  else if (p->GetSize () > 0 && ipHeader.GetEcn () == Ipv4Header::ECN_NotECT)
+    {
+      m_notEctSegments++;
+    }
+}
+
+void
+Ns3TcpEcnTestCase::SourceIpv4Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  if ((tcpHeader.GetFlags () & (TcpHeader::SYN | TcpHeader::ECE)) == TcpHeader::ECE)
+    {
+      m_eceAcks++;
+    }
+}
+
+void
+Ns3TcpEcnTestCase::QueueEnqueue (Ptr<const Packet> packet)
+{
+  m_maxQueue = std::max (m_maxQueue, m_queue->GetNPackets () + 1);
+}
+
+void
+Ns3TcpEcnTestCase::AlphaChange (double oldValue, double newValue)
+{
+  m_alpha = newValue;
+}
+
+class Ns3TcpDctcpTestSuite : public TestSuite
+{
+public:
+  Ns3TcpDctcpTestSuite ();
+};
+
+Ns3TcpDctcpTestSuite::Ns3TcpDctcpTestSuite ()
+  : TestSuite ("ns3-tcp-dctcp", SYSTEM)
+{
+  AddTestCase (new Ns3Ipv4RedQueueTestCase);
+  AddTestCase (new Ns3TcpEcnTestCase ("ns3::TcpNewReno"));
+  AddTestCase (new Ns3TcpEcnTestCase ("ns3::TcpDctcp"));
+}
+
+static Ns3TcpDctcpTestSuite ns3TcpDctcpTestSuite;
@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Sum the same bytes with the byte at a time loop checksums used to be
+// computed with, with each checksum kernel the processor supports, and
+// with Buffer::Iterator::CalculateIpChecksum, and report their speed.
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/checksum.h"
+#include "ns3/buffer.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static uint16_t
+ByteLoopSum (uint8_t const *data, uint32_t size)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i + 1 < size; i += 2)
+    {
+      sum += data[i] | (data[i + 1] << 8);
+    }
+  if (size & 1)
+    {
+      sum += data[size - 1];
+    }
+  while (sum >> 16)
+    {
+      sum = (sum & 0xffff) + (sum >> 16);
+    }
+  return sum;
+}
+
+static void
+Report (char const *name, uint32_t size, uint32_t n, uint64_t deltaMs, uint32_t check)
+{
+  double mbps = size;
+  mbps *= n;
+  mbps /= 1000;
+  mbps /= std::max<uint64_t> (deltaMs, 1);
+  std::cout << name << " size=" << size << " " << mbps << " MB/s"
+            << " (check " << check << ")" << std::endl;
+}
+
+static void
+RunBench (uint32_t size, uint32_t n)
+{
+  std::vector<uint8_t> bytes (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      bytes[i] = i * 7 + 3;
+    }
+  SystemWallClockMs time;
+  uint32_t check;
+
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      check += ByteLoopSum (&bytes[0], size);
+    }
+  Report ("ByteLoop", size, n, time.End (), check);
+
+  ChecksumKernel kernels[] = { CHECKSUM_SCALAR, CHECKSUM_SSE2, CHECKSUM_AVX2 };
+  char const *names[] = { "Scalar", "Sse2", "Avx2" };
+  for (uint32_t k = 0; k < sizeof (kernels) / sizeof (kernels[0]); k++)
+    {
+      if (!IsChecksumKernelSupported (kernels[k]))
+        {
+          continue;
+        }
+      check = 0;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          check += OnesComplementSum (&bytes[0], size, kernels[k]);
+        }
+      Report (names[k], size, n, time.End (), check);
+    }
+
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  buffer.Begin ().Write (&bytes[0], size);
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      check += uint16_t (~buffer.Begin ().CalculateIpChecksum (size));
+    }
+  Report ("Buffer", size, n, time.End (), check);
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--n="));
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of 1500 byte packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-checksum with n=" << n << std::endl;
+
+  uint32_t sizes[] = { 12, 20, 40, 576, 1500, 9000 };
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+      // Sum as many bytes for every size
+      RunBench (sizes[i], uint64_t (n) * 1500 / sizes[i]);
+    }
+
+  return 0;
+}
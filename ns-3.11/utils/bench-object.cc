@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Perform on a node with an internet stack the GetObject calls a
+// forwarded packet costs, with Object::GetObject and with the scan of
+// the aggregates GetObject used to do, and report their speed.
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/internet-stack-helper.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+// Look for an aggregate of type T the way GetObject used to: try the
+// first aggregate, then walk the TypeId chain of each aggregate.
+template <typename T>
+static Ptr<T>
+ScanGetObject (Ptr<const Object> object)
+{
+  Object::AggregateIterator i = object->GetAggregateIterator ();
+  Ptr<const Object> first = i.Next ();
+  T *result = dynamic_cast<T *> (const_cast<Object *> (PeekPointer (first)));
+  if (result != 0)
+    {
+      return result;
+    }
+  TypeId tid = T::GetTypeId ();
+  TypeId objectTid = Object::GetTypeId ();
+  i = object->GetAggregateIterator ();
+  while (i.HasNext ())
+    {
+      Ptr<const Object> current = i.Next ();
+      TypeId cur = current->GetInstanceTypeId ();
+      while (cur != tid && cur != objectTid)
+        {
+          cur = cur.GetParent ();
+        }
+      if (cur == tid)
+        {
+          return static_cast<T *> (const_cast<Object *> (PeekPointer (current)));
+        }
+    }
+  return 0;
+}
+
+static void
+Report (char const *name, uint32_t n, uint64_t deltaMs, uint32_t check)
+{
+  double nsPerPacket = deltaMs;
+  nsPerPacket *= 1000000;
+  nsPerPacket /= n;
+  std::cout << name << " " << nsPerPacket << " ns/packet"
+            << " (check " << check << ")" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--n="));
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-object with n=" << n << std::endl;
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper stack;
+  stack.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+
+  // The lookups of a packet forwarded by the node: its trace sinks find
+  // the Ipv4 and the Ipv4L3Protocol of the node, the routing finds the
+  // node of its Ipv4, and the L4 demux finds the TcpL4Protocol.
+  SystemWallClockMs time;
+  uint32_t check;
+
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      check += ScanGetObject<Ipv4> (node) != 0;
+      check += ScanGetObject<Ipv4L3Protocol> (node) != 0;
+      check += ScanGetObject<Node> (ipv4) != 0;
+      check += ScanGetObject<TcpL4Protocol> (node) != 0;
+    }
+  Report ("Scan", n, time.End (), check);
+
+  check = 0;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      check += node->GetObject<Ipv4> () != 0;
+      check += node->GetObject<Ipv4L3Protocol> () != 0;
+      check += ipv4->GetObject<Node> () != 0;
+      check += node->GetObject<TcpL4Protocol> () != 0;
+    }
+  Report ("GetObject", n, time.End (), check);
+
+  node->Dispose ();
+  return 0;
+}
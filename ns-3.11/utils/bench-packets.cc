@@ -20,6 +20,7 @@
 #include "ns3/system-wall-clock-ms.h"
 #include "ns3/packet.h"
 #include "ns3/packet-metadata.h"
+#include "ns3/packet-pool.h"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -286,5 +287,14 @@ int main (int argc, char *argv[])
   runBench (&benchC, n, "c");
   runBench (&benchD, n, "d");
 
+  char const *kinds[] = { "bytes", "metadata", "tags" };
+  for (uint32_t k = 0; k < PacketPool::KIND_COUNT; k++)
+    {
+      PacketPool::Stats stats = PacketPool::GetStats (PacketPool::Kind (k));
+      std::cout << kinds[k] << " allocations=" << stats.allocations
+                << " recycles=" << stats.recycles
+                << " peak bytes=" << stats.peakBytesInUse << std::endl;
+    }
+
   return 0;
 }
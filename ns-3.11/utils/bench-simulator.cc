@@ -34,6 +34,7 @@ class Bench
 public:
   Bench ();
   void ReadDistribution (std::istream &istream);
+  void MakeDistribution (uint32_t n);
   void SetTotal (uint32_t total);
   void RunBench (void);
 private:
@@ -75,11 +76,23 @@ Bench::ReadDistribution (std::istream &input)
     }
 }
 
+// Hold model with exponentially distributed increments of mean 100us
+void
+Bench::MakeDistribution (uint32_t n)
+{
+  ExponentialVariable delay (100e-6);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_distribution.push_back ((uint64_t) (delay.GetValue () * 1000000000));
+    }
+}
+
 void
 Bench::RunBench (void) 
 {
   SystemWallClockMs time;
   double init, simu;
+  m_n = 0;
   time.Start ();
   for (std::vector<uint64_t>::const_iterator i = m_distribution.begin ();
        i != m_distribution.end (); i++) 
@@ -91,10 +104,14 @@ Bench::RunBench (void)
 
   m_current = m_distribution.begin ();
 
+  uint64_t allocated = EventImpl::GetAllocatedCount ();
+  uint64_t recycled = EventImpl::GetRecycledCount ();
   time.Start ();
   Simulator::Run ();
   simu = time.End ();
   simu /= 1000;
+  allocated = EventImpl::GetAllocatedCount () - allocated;
+  recycled = EventImpl::GetRecycledCount () - recycled;
 
   std::cout <<
       "init n=" << m_distribution.size () << ", time=" << init << "s" << std::endl <<
@@ -102,7 +119,8 @@ Bench::RunBench (void)
       "init " << ((double)m_distribution.size ()) / init << " insert/s, avg insert=" <<
       init / ((double)m_distribution.size ())<< "s" << std::endl <<
       "simu " << ((double)m_n) / simu<< " hold/s, avg hold=" << 
-      simu / ((double)m_n) << "s" << std::endl
+      simu / ((double)m_n) << "s" << std::endl <<
+      "simu events allocated=" << allocated << ", recycled=" << recycled << std::endl
       ;
 }
 
@@ -135,6 +153,13 @@ PrintHelp (void)
   std::cout << "      --list: use std::list scheduler"<<std::endl;
   std::cout << "      --map: use std::map cheduler"<<std::endl;
   std::cout << "      --heap: use Binary Heap scheduler"<<std::endl;
+  std::cout << "      --calendar: use Calendar scheduler"<<std::endl;
+  std::cout << "      --ns2calendar: use ns-2 Calendar scheduler"<<std::endl;
+  std::cout << "      --ladder: use Ladder scheduler"<<std::endl;
+  std::cout << "      --all: run the benchmark with each scheduler in turn"<<std::endl;
+  std::cout << "      --n=N: run the benchmark N times"<<std::endl;
+  std::cout << "      --total=N: number of events to hold"<<std::endl;
+  std::cout << "  A filename of the form \"exp:N\" generates N exponentially distributed delays." << std::endl;
   std::cout << "      --debug: enable some debugging"<<std::endl;
 }
 
@@ -151,14 +176,21 @@ int main (int argc, char *argv[])
     }
   argc-=2;
   argv+= 2;
+  uint32_t generate = 0;
   if (strcmp (filename, "-") == 0) 
     {
       input = &std::cin;
     } 
+  else if (strncmp (filename, "exp:", strlen ("exp:")) == 0)
+    {
+      input = 0;
+      generate = atoi (filename + strlen ("exp:"));
+    }
   else 
     {
       input = new std::ifstream (filename);
     }
+  std::vector<std::string> schedulers;
   while (argc > 0) 
     {
       ObjectFactory factory;
@@ -174,7 +206,7 @@ int main (int argc, char *argv[])
         } 
       else if (strcmp ("--map", argv[0]) == 0) 
         {
-          factory.SetTypeId ("ns3::HeapScheduler");
+          factory.SetTypeId ("ns3::MapScheduler");
           Simulator::SetScheduler (factory);
         } 
       else if (strcmp ("--calendar", argv[0]) == 0)
@@ -182,6 +214,25 @@ int main (int argc, char *argv[])
           factory.SetTypeId ("ns3::CalendarScheduler");
           Simulator::SetScheduler (factory);
         }
+      else if (strcmp ("--ns2calendar", argv[0]) == 0)
+        {
+          factory.SetTypeId ("ns3::Ns2CalendarScheduler");
+          Simulator::SetScheduler (factory);
+        }
+      else if (strcmp ("--ladder", argv[0]) == 0)
+        {
+          factory.SetTypeId ("ns3::LadderScheduler");
+          Simulator::SetScheduler (factory);
+        }
+      else if (strcmp ("--all", argv[0]) == 0)
+        {
+          schedulers.push_back ("ns3::ListScheduler");
+          schedulers.push_back ("ns3::MapScheduler");
+          schedulers.push_back ("ns3::HeapScheduler");
+          schedulers.push_back ("ns3::CalendarScheduler");
+          schedulers.push_back ("ns3::Ns2CalendarScheduler");
+          schedulers.push_back ("ns3::LadderScheduler");
+        }
       else if (strcmp ("--debug", argv[0]) == 0) 
         {
           g_debug = true;
@@ -199,11 +250,33 @@ int main (int argc, char *argv[])
       argv++;
   }
   Bench *bench = new Bench ();
-  bench->ReadDistribution (*input);
+  if (input)
+    {
+      bench->ReadDistribution (*input);
+    }
+  else
+    {
+      bench->MakeDistribution (generate);
+    }
   bench->SetTotal (total);
-  for (uint32_t i = 0; i < n; i++)
+  if (schedulers.empty ())
     {
-      bench->RunBench ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          bench->RunBench ();
+        }
+    }
+  for (std::vector<std::string>::const_iterator s = schedulers.begin (); s != schedulers.end (); ++s)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (*s);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          std::cout << *s << std::endl;
+          Simulator::SetScheduler (factory);
+          bench->RunBench ();
+          Simulator::Destroy ();
+        }
     }
 
   return 0;
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Feed the two TcpRxBuffer storage schemes with the same synthetic
+// trace of reordered and duplicated segments and report their speed.
+
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static const uint32_t g_segmentSize = 1460;
+
+// Sequence of segment indexes: each window of 'depth' segments is sent in
+// a random order, and one segment in 'dupEvery' is sent twice.
+static std::vector<uint32_t>
+MakeTrace (uint32_t n, uint32_t depth, uint32_t dupEvery)
+{
+  std::vector<uint32_t> trace;
+  srand (1);
+  for (uint32_t start = 0; start < n; start += depth)
+    {
+      uint32_t end = std::min (n, start + depth);
+      std::vector<uint32_t> window;
+      for (uint32_t i = start; i < end; i++)
+        {
+          window.push_back (i);
+        }
+      std::random_shuffle (window.begin (), window.end ());
+      for (uint32_t i = 0; i < window.size (); i++)
+        {
+          trace.push_back (window[i]);
+          if (dupEvery && (window[i] % dupEvery) == 0)
+            {
+              trace.push_back (window[i]);
+            }
+        }
+    }
+  return trace;
+}
+
+static void
+RunBench (const std::vector<uint32_t> &trace, uint32_t depth,
+          TcpRxBuffer::StorageMode mode, char const *name)
+{
+  TcpRxBuffer buffer;
+  buffer.SetStorageMode (mode);
+  buffer.SetMaxBufferSize ((depth + 1) * g_segmentSize);
+  uint8_t payload[g_segmentSize];
+  memset (payload, 0x5a, sizeof (payload));
+  uint64_t delivered = 0;
+  uint32_t maxBlocks = 0;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (std::vector<uint32_t>::const_iterator i = trace.begin (); i != trace.end (); ++i)
+    {
+      TcpHeader header;
+      header.SetSequenceNumber (SequenceNumber32 (*i * g_segmentSize));
+      buffer.Add (Create<Packet> (payload, g_segmentSize), header);
+      maxBlocks = std::max<uint32_t> (maxBlocks, buffer.GetSackList ().size ());
+      Ptr<Packet> p = buffer.Extract (buffer.Available ());
+      if (p != 0)
+        {
+          delivered += p->GetSize ();
+        }
+    }
+  uint64_t deltaMs = time.End ();
+  double ps = trace.size ();
+  ps *= 1000;
+  ps /= std::max<uint64_t> (deltaMs, 1);
+  std::cout << name << " depth=" << depth << " " << ps << " segments/s"
+            << " delivered=" << delivered << " maxBlocks=" << maxBlocks << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t dupEvery = 50;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--n="));
+          iss >> n;
+        }
+      if (strncmp ("--dup=", argv[0],strlen ("--dup=")) == 0)
+        {
+          std::istringstream iss (argv[0] + strlen ("--dup="));
+          iss >> dupEvery;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of segments must be specified " <<
+        "by command-line argument --n=(number of segments)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-tcp-rx-buffer with n=" << n << std::endl;
+
+  uint32_t depths[] = { 1, 8, 64, 512 };
+  for (uint32_t i = 0; i < sizeof (depths) / sizeof (depths[0]); i++)
+    {
+      std::vector<uint32_t> trace = MakeTrace (n, depths[i], dupEvery);
+      RunBench (trace, depths[i], TcpRxBuffer::PACKET_MAP, "PacketMap");
+      RunBench (trace, depths[i], TcpRxBuffer::BYTE_RING, "ByteRing");
+    }
+
+  return 0;
+}